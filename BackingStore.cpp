@@ -0,0 +1,135 @@
+//BackingStore.cpp
+//
+//Sparse row storage backed by an anonymous mmap
+//
+
+#include "BackingStore.h"
+#include "Checkpoint.h"
+#include "DataPacket.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <vector>
+
+namespace DRAMSim
+{
+	BackingStore::BackingStore(uint64_t numRows, size_t rowBytes)
+	{
+		//keep rows on cache line boundaries
+		rowStride = (rowBytes + 63) & ~(size_t)63;
+		size_t pageBytes = sysconf(_SC_PAGESIZE);
+		mappedBytes = (numRows * rowStride + pageBytes - 1) / pageBytes * pageBytes;
+
+		void *mapping = mmap(NULL, mappedBytes, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (mapping == MAP_FAILED)
+		{
+			ERROR("Cannot map "<<mappedBytes<<" bytes of row storage: "<<strerror(errno));
+			exit(-1);
+		}
+		base = (byte *)mapping;
+	}
+
+	BackingStore::~BackingStore()
+	{
+		//packets still in flight outlive the mapping
+		detachViews(base, mappedBytes);
+		munmap(base, mappedBytes);
+	}
+
+	void BackingStore::addView(DataPacket *view)
+	{
+		views.push_back(view);
+	}
+
+	void BackingStore::removeView(DataPacket *view)
+	{
+		for (size_t i=0; i<views.size(); i++)
+		{
+			if (views[i] == view)
+			{
+				views[i] = views.back();
+				views.pop_back();
+				return;
+			}
+		}
+	}
+
+	void BackingStore::detachViews(const byte *start, size_t numBytes)
+	{
+		for (size_t i=0; i<views.size(); )
+		{
+			const byte *data = views[i]->getData();
+			if (data + views[i]->getNumBytes() > start && data < start + numBytes)
+			{
+				//removes it from views
+				views[i]->detach();
+			}
+			else
+			{
+				i++;
+			}
+		}
+	}
+
+	uint64_t BackingStore::residentBytes() const
+	{
+		size_t pageBytes = sysconf(_SC_PAGESIZE);
+		std::vector<unsigned char> resident(mappedBytes / pageBytes);
+		if (mincore(base, mappedBytes, &resident[0]) != 0)
+		{
+			return 0;
+		}
+		uint64_t pages = 0;
+		for (size_t i=0; i<resident.size(); i++)
+		{
+			pages += resident[i] & 1;
+		}
+		return pages * pageBytes;
+	}
+
+	void BackingStore::checkpoint(Checkpoint &cp)
+	{
+		cp.region(base, mappedBytes);
+
+		size_t pageBytes = sysconf(_SC_PAGESIZE);
+		uint64_t numPages = mappedBytes / pageBytes;
+		cp.io(numPages);
+		if (numPages != mappedBytes / pageBytes)
+		{
+			ERROR("Checkpoint has a backing store of "<<numPages<<" pages instead of "<<mappedBytes / pageBytes);
+			exit(-1);
+		}
+
+		//page numbers and contents, ended by numPages
+		uint64_t page;
+		if (cp.isSaving())
+		{
+			std::vector<unsigned char> resident(numPages);
+			if (mincore(base, mappedBytes, &resident[0]) != 0)
+			{
+				ERROR("Cannot find the populated rows: "<<strerror(errno));
+				exit(-1);
+			}
+			std::vector<byte> zeros(pageBytes, 0);
+			for (page=0; page<numPages; page++)
+			{
+				byte *data = base + page * pageBytes;
+				if ((resident[page] & 1) && memcmp(data, &zeros[0], pageBytes) != 0)
+				{
+					cp.io(page);
+					cp.bytes(data, pageBytes);
+				}
+			}
+			cp.io(numPages);
+		}
+		else
+		{
+			for (cp.io(page); page < numPages; cp.io(page))
+			{
+				cp.bytes(base + page * pageBytes, pageBytes);
+			}
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#ifndef BACKINGSTORE_H
+#define BACKINGSTORE_H
+
+//BackingStore.h
+//
+//Row storage for DATA_STORAGE builds, one per channel. All rows of the
+//channel live in a single anonymous mapping that is reserved up front but
+//not committed (MAP_NORESERVE), so the kernel only populates the pages that
+//are actually written and unwritten rows read back as zeros. A row is found
+//by direct indexing, there is no per-row allocation or lookup tree.
+//
+//Reads hand out data packets that are views of the rows. The store keeps
+//track of them and turns them into copies before a row is changed
+//(copy-on-write), so a read never sees data written after it.
+//
+
+#include "SystemConfiguration.h"
+#include <vector>
+
+namespace DRAMSim
+{
+	class Checkpoint;
+	class DataPacket;
+
+	class BackingStore
+	{
+	public:
+		BackingStore(uint64_t numRows, size_t rowBytes);
+		~BackingStore();
+
+		byte *getRow(uint64_t index) const
+		{
+			return base + index * rowStride;
+		}
+
+		//a row that is about to change; the views of it become copies
+		byte *getRowForWrite(uint64_t index)
+		{
+			if (!views.empty())
+			{
+				detachViews(getRow(index), rowStride);
+			}
+			return getRow(index);
+		}
+
+		//the data packets that are views of the rows
+		void addView(DataPacket *view);
+		void removeView(DataPacket *view);
+
+		//bytes of the mapping the kernel has populated so far
+		uint64_t residentBytes() const;
+
+		//the populated pages that are not all zeros; also registers the
+		//mapping for the data packets that are views of its rows
+		void checkpoint(Checkpoint &cp);
+
+	private:
+		//not copyable, it owns the mapping
+		BackingStore(const BackingStore &other);
+		BackingStore &operator=(const BackingStore &other);
+		void detachViews(const byte *start, size_t numBytes);
+
+		byte *base;
+		size_t rowStride;
+		size_t mappedBytes;
+		//only the reads in flight, a handful per channel
+		std::vector<DataPacket *> views;
+	};
+}
+
+#endif
@@ -32,7 +32,10 @@
 
 #include "Bank.h"
 #include "BusPacket.h"
+#include "BitOps.h"
+#include "EccKernels.h"
 #include <string.h> // for memcpy
+#include <algorithm>
 #include <assert.h>
 
 
@@ -45,9 +48,14 @@ namespace DRAMSim
 		// have been removed (i.e. the lower 6 bits for BL=8 and the lower 5 bits
 		// for BL=4) plus the column offset
 
-		uint64_t transactionMask = TRANS_DATA_BYTES - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
+#ifdef DATA_RELIABILITY_ECC
+		// an encoded line (data + check bits) is always written whole
+		unsigned byteOffset = 0;
+#else
+		uint64_t transactionMask = config.TRANS_DATA_BYTES - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
 		unsigned byteOffset = busPacket->data->getAddr() & transactionMask;
-		unsigned columnOffset = (busPacket->column * DEVICE_WIDTH)/8;
+#endif
+		unsigned columnOffset = busPacket->column * config.TRANS_DATA_BYTES;
 		unsigned offset = columnOffset + byteOffset;
 
 		DEBUG("[DPKT] "<< *(busPacket->data) << " \t r="<<busPacket->row<<" c="<<busPacket->column<<" byte offset="<< byteOffset<< "-> "<<offset);
@@ -55,38 +63,208 @@ namespace DRAMSim
 		return offset;
 	}
 
-	void Bank::write(const BusPacket *busPacket)
+	// work out which cells a write of numBytes at byteOffset programs and optionally store it.
+	// With Flip-N-Write each word is stored inverted when that flips fewer cells (flip bit included).
+	void Bank::programLine(byte *rowData, unsigned byteOffset, const byte *newData, size_t numBytes,
+			bool store, uint64_t &setBits, uint64_t &resetBits)
+	{
+		byte *flags = rowData + ROW_BYTES;
+		const byte *cells = newData;
+
+		if (config.FLIP_N_WRITE && byteOffset % FNW_WORD_BYTES == 0 && numBytes % FNW_WORD_BYTES == 0)
+		{
+			size_t numWords = numBytes / FNW_WORD_BYTES;
+			wordFlips.resize(numWords);
+			encodedLine.resize(numBytes);
+			countWordFlips(rowData + byteOffset, newData, numBytes, &wordFlips[0]);
+
+			for (size_t w=0; w<numWords; w++)
+			{
+				unsigned word = byteOffset / FNW_WORD_BYTES + w;
+				bool flipped = (flags[word/8] >> (word%8)) & 1;
+				unsigned plainCost = wordFlips[w] + (flipped ? 1 : 0);
+				unsigned invertCost = FNW_WORD_BYTES*8 - wordFlips[w] + (flipped ? 0 : 1);
+				bool invert = invertCost < plainCost;
+
+				for (size_t b=0; b<FNW_WORD_BYTES; b++)
+				{
+					size_t i = w*FNW_WORD_BYTES + b;
+					encodedLine[i] = invert ? ~newData[i] : newData[i];
+				}
+				if (invert != flipped)
+				{
+					if (invert)
+						setBits++;
+					else
+						resetBits++;
+					if (store)
+						flags[word/8] ^= (1 << (word%8));
+				}
+			}
+			cells = &encodedLine[0];
+		}
+		else if (config.FLIP_N_WRITE)
+		{
+			// unaligned write, store it plain
+			for (size_t i=0; i<numBytes; i+=FNW_WORD_BYTES)
+			{
+				unsigned word = (byteOffset + i) / FNW_WORD_BYTES;
+				if ((flags[word/8] >> (word%8)) & 1)
+				{
+					resetBits++;
+					if (store)
+						flags[word/8] &= ~(1 << (word%8));
+				}
+			}
+		}
+
+		countCellFlips(rowData + byteOffset, cells, numBytes, setBits, resetBits);
+		if (store)
+		{
+			memcpy(rowData + byteOffset, cells, numBytes);
+		}
+	}
+
+	bool Bank::previewWrite(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits)
 	{
+		setBits = 0;
+		resetBits = 0;
+		if (busPacket->data == NULL)
+		{
+			if (!busPacket->isSETWRITE && busPacket->busPacketType != BusPacket::SET_WRITE)
+			{
+				return false;
+			}
+			unsigned offset = busPacket->column * config.TRANS_DATA_BYTES + (busPacket->physicalAddress & (config.TRANS_DATA_BYTES - 1));
+			if (offset < ROW_BYTES)
+			{
+				setBits = countOnes(getRow(busPacket->row) + offset, std::min((size_t)config.TRANS_DATA_BYTES, (size_t)(ROW_BYTES - offset)));
+			}
+			return true;
+		}
+
 		unsigned byteOffset = getByteOffsetInRow(busPacket);
-		RowMapType::iterator it;
-		it = rowEntries.find(busPacket->row);
-		byte *rowData;
-		if (it == rowEntries.end())
+		size_t transactionSize = busPacket->data->getNumBytes();
+		if (byteOffset + transactionSize > ROW_BYTES)
 		{
-			// row doesn't exist yet, allocate it
-			rowData = (byte *)calloc((NUM_COLS*DEVICE_WIDTH)/8,sizeof(byte));
-			rowEntries[busPacket->row] = rowData;
+			return false;
 		}
-		else
+		programLine(getRow(busPacket->row), byteOffset, busPacket->data->getData(), transactionSize, false, setBits, resetBits);
+		return true;
+	}
+
+	void Bank::write(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits)
+	{
+		// a SET_WRITE from the partial queue carries no data, it only finishes
+		// the SET pulses of the cells already holding a 1
+		if (busPacket->data == NULL)
 		{
-			rowData = it->second;
+			previewWrite(busPacket, setBits, resetBits);
+			return;
 		}
 
+		setBits = 0;
+		resetBits = 0;
+		unsigned byteOffset = getByteOffsetInRow(busPacket);
+		byte *rowData = getRowForWrite(busPacket->row);
 
 	#ifdef DATA_RELIABILITY_ECC
-		size_t transactionSize = TRANS_DATA_BYTES;
+		size_t transactionSize = config.TRANS_DATA_BYTES;
 	#else
 		size_t transactionSize = busPacket->data->getNumBytes();
 	#endif
 
 		// if we out of bound a row, this is a problem
-		if (byteOffset + transactionSize > NUM_COLS*DEVICE_WIDTH)
+		if (byteOffset + transactionSize > ROW_BYTES)
 		{
 			ERROR("Transaction out of bounds a row, check alignment of the address");
 			exit(-1);
 		}
-		// copy data to the row
-		memcpy(rowData + byteOffset, busPacket->data->getData(), transactionSize);
+		// only the cells whose value changes are programmed
+		programLine(rowData, byteOffset, busPacket->data->getData(), transactionSize, true, setBits, resetBits);
+		if (faults != NULL)
+		{
+			// bus errors on the way in end up in the cells as well
+			faults->transfer(firstRow / config.NUM_ROWS, rowData + byteOffset, transactionSize);
+			faults->programmed(firstRow + busPacket->row, busPacket->column, rowData + byteOffset, transactionSize);
+		}
+	}
+
+	void Bank::scrub(const BusPacket *busPacket, unsigned &correctedWords, unsigned &uncorrectableWords)
+	{
+		correctedWords = 0;
+		uncorrectableWords = 0;
+		size_t numBytes = config.TRANS_DATA_BYTES;
+		unsigned start = busPacket->column * config.TRANS_DATA_BYTES;
+		byte *rowData = getRowForWrite(busPacket->row);
+		if (start + numBytes > ROW_BYTES)
+		{
+			return;
+		}
+		if (faults != NULL)
+		{
+			faults->drift(firstRow + busPacket->row, busPacket->column, rowData + start, numBytes);
+		}
+
+	#ifdef DATA_RELIABILITY_ECC
+		// read, correct and write back what the code can repair
+		encodedLine.resize(numBytes);
+		copyLine(rowData, start, numBytes, &encodedLine[0]);
+		std::vector<byte> line(numBytes);
+		#ifdef DATA_RELIABILITY_CHIPKILL
+		chipkillDeinterleave(&encodedLine[0], &line[0], config.DEVICE_WIDTH, numBytes * 8);
+		secdedCheck(&line[0], numBytes / SECDED_CODE_BYTES, true, correctedWords, uncorrectableWords);
+		chipkillInterleave(&line[0], &encodedLine[0], config.DEVICE_WIDTH, numBytes * 8);
+		#else
+		secdedCheck(&encodedLine[0], numBytes / SECDED_CODE_BYTES, true, correctedWords, uncorrectableWords);
+		#endif
+		if (correctedWords > 0)
+		{
+			// programLine reuses encodedLine as scratch
+			line = encodedLine;
+			uint64_t setBits = 0, resetBits = 0;
+			programLine(rowData, start, &line[0], numBytes, true, setBits, resetBits);
+		}
+	#endif
+
+		if (faults != NULL)
+		{
+			faults->programmed(firstRow + busPacket->row, busPacket->column, rowData + start, numBytes);
+		}
+	}
+
+	bool Bank::hasFlippedWords(const byte *rowData, unsigned start, size_t numBytes) const
+	{
+		if (!config.FLIP_N_WRITE)
+		{
+			return false;
+		}
+		const byte *flags = rowData + ROW_BYTES;
+		for (size_t word = start / FNW_WORD_BYTES; word <= (start + numBytes - 1) / FNW_WORD_BYTES; word++)
+		{
+			if ((flags[word/8] >> (word%8)) & 1)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void Bank::copyLine(const byte *rowData, unsigned start, size_t numBytes, byte *dest) const
+	{
+		memcpy(dest, rowData + start, numBytes);
+		if (hasFlippedWords(rowData, start, numBytes))
+		{
+			const byte *flags = rowData + ROW_BYTES;
+			for (size_t i=0; i<numBytes; i++)
+			{
+				unsigned word = (start + i) / FNW_WORD_BYTES;
+				if ((flags[word/8] >> (word%8)) & 1)
+				{
+					dest[i] = ~dest[i];
+				}
+			}
+		}
 	}
 
 
@@ -95,28 +273,33 @@ namespace DRAMSim
 		assert(busPacket->data == NULL);
 
 
+		size_t numBytes = config.TRANS_DATA_BYTES;
 		busPacket->busPacketType = BusPacket::DATA;
-		busPacket->data = new DataPacket(NULL, SUBARRAY_DATA_BYTES*busPacket->len, busPacket->physicalAddress);
+		busPacket->data = new DataPacket(NULL, numBytes, busPacket->physicalAddress);
 
-		RowMapType::iterator it = rowEntries.find(busPacket->row);
-		if (it != rowEntries.end())
+		// rows that were never written read back as zeros; drift changes the row
+		byte *rowData = faults != NULL ? getRowForWrite(busPacket->row) : getRow(busPacket->row);
+		unsigned start = busPacket->column * config.TRANS_DATA_BYTES;
+		if (faults != NULL)
 		{
-			byte *rowData = it->second;
-			byte *dataBuf = (byte *)calloc(sizeof(byte), SUBARRAY_DATA_BYTES*busPacket->len);
-			memcpy(dataBuf, rowData + (busPacket->column*DEVICE_WIDTH)/8, SUBARRAY_DATA_BYTES*busPacket->len);
-			busPacket->data->setData(dataBuf, SUBARRAY_DATA_BYTES*busPacket->len, false);
-			DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
+			faults->drift(firstRow + busPacket->row, busPacket->column, rowData + start, numBytes);
 		}
-		else
+
+	#ifndef DATA_RELIABILITY_ECC
+		// the stored bytes are the data, hand out a view of the row instead of a copy
+		if (!hasFlippedWords(rowData, start, numBytes))
 		{
-#ifdef RETURN_TRANSACTIONS
-			byte *dataBuf = (byte *)calloc(sizeof(byte), SUBARRAY_DATA_BYTES*busPacket->len);
-			busPacket->data->setData(dataBuf, SUBARRAY_DATA_BYTES*busPacket->len, false);
+			busPacket->data->setView(rowData + start, numBytes, store);
 			DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
-#endif
+			return;
 		}
+	#endif
 
-
+		// the ECC decoder works in place and Flip-N-Write words have to be inverted back, so copy
+		byte *dataBuf = (byte *)malloc(numBytes);
+		copyLine(rowData, start, numBytes, dataBuf);
+		busPacket->data->setData(dataBuf, numBytes, false);
+		DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
 	}
 
 } // end of namespace DRAMSim
@@ -34,7 +34,14 @@
 #include "SystemConfiguration.h"
 #include "BankState.h"
 #include "BusPacket.h"
-#include <map>
+#include "BitOps.h"
+#include "BackingStore.h"
+#include "FaultInjector.h"
+
+//a row across all the devices of the rank; bus packet columns count whole transactions
+#define ROW_BYTES ((config.NUM_COLS*config.DEVICE_WIDTH*config.NUM_DEVICES)/8)
+//one Flip-N-Write flag bit per FNW_WORD_BYTES of a row
+#define FNW_FLAG_BYTES (ROW_BYTES/FNW_WORD_BYTES/8 + 1)
 
 namespace DRAMSim
 {
@@ -42,18 +49,43 @@ namespace DRAMSim
 	{
 	public:
 		//functions
-		Bank() {};
+		//the bank's rows are rows firstRow.. of the channel's backing store
+		Bank(const Config &config, BackingStore *store, uint64_t firstRow, FaultInjector *faults = NULL) :
+			config(config), store(store), firstRow(firstRow), faults(faults) {};
 		void read(BusPacket *busPacket);
-		void write(const BusPacket *busPacket);
+		// setBits/resetBits return how many cells the write flipped to 1 and to 0
+		void write(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits);
+		// drift scrub: reprogram the line, with ECC after correcting it (counts are ECC words)
+		void scrub(const BusPacket *busPacket, unsigned &correctedWords, unsigned &uncorrectableWords);
+		// counts what write() would program without storing; false if there is nothing to compare
+		bool previewWrite(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits);
 
 		//fields
 		BankState currentState;
 
 	private:
 		unsigned getByteOffsetInRow(const BusPacket *busPacket);
-		typedef std::map<uint64_t, byte *> RowMapType;
-
-		RowMapType rowEntries;
+		byte *getRow(unsigned row) const
+		{
+			return store->getRow(firstRow + row);
+		}
+		//the views handed out by earlier reads of the row become copies
+		byte *getRowForWrite(unsigned row)
+		{
+			return store->getRowForWrite(firstRow + row);
+		}
+		void programLine(byte *rowData, unsigned byteOffset, const byte *newData, size_t numBytes,
+				bool store, uint64_t &setBits, uint64_t &resetBits);
+		bool hasFlippedWords(const byte *rowData, unsigned start, size_t numBytes) const;
+		// the stored line with Flip-N-Write words inverted back
+		void copyLine(const byte *rowData, unsigned start, size_t numBytes, byte *dest) const;
+		const Config &config;
+		BackingStore *store;
+		uint64_t firstRow;
+		FaultInjector *faults; //NULL unless errors are injected
+		//scratch space for Flip-N-Write
+		std::vector<unsigned> wordFlips;
+		std::vector<byte> encodedLine;
 	};
 }
 
@@ -33,6 +33,7 @@
 //
 
 #include "BankState.h"
+#include "Checkpoint.h"
 
 namespace DRAMSim
 {
@@ -77,4 +78,17 @@ namespace DRAMSim
 		PRINT("    nextPowerUp    : " << nextPowerUp );
 	}
 
+	void BankState::checkpoint(Checkpoint &cp)
+	{
+		cp.io(currentBankState);
+		cp.io(openRowAddress);
+		cp.io(nextRead);
+		cp.io(nextWrite);
+		cp.io(nextActivate);
+		cp.io(nextPrecharge);
+		cp.io(nextPowerUp);
+		cp.io(lastCommand);
+		cp.io(stateChangeCountdown);
+	}
+
 }
@@ -41,6 +41,7 @@
 #include "SimulatorIO.h"
 namespace DRAMSim
 {
+	class Checkpoint;
 
 	class BankState
 	{
@@ -69,6 +70,7 @@ namespace DRAMSim
 		//Functions
 		BankState();
 		void print();
+		void checkpoint(Checkpoint &cp);
 	};
 }
 
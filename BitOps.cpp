@@ -0,0 +1,186 @@
+//BitOps.cpp
+//
+//XOR/popcount kernels. The generic versions work 8 bytes at a time; the AVX2
+//versions count 32 bytes at a time with the nibble lookup table method
+//(vpshufb) and are only built/used on x86 CPUs that support them.
+//
+
+#include "BitOps.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define BITOPS_X86
+	#include <immintrin.h>
+#endif
+
+namespace DRAMSim
+{
+
+	static inline uint64_t load64(const byte *p)
+	{
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+
+	static void countCellFlipsGeneric(const byte *stored, const byte *data, size_t numBytes, uint64_t &setBits, uint64_t &resetBits)
+	{
+		size_t i = 0;
+		for (; i + 8 <= numBytes; i += 8)
+		{
+			uint64_t o = load64(stored + i);
+			uint64_t d = load64(data + i);
+			uint64_t changed = o ^ d;
+			setBits += __builtin_popcountll(changed & d);
+			resetBits += __builtin_popcountll(changed & o);
+		}
+		for (; i < numBytes; i++)
+		{
+			byte changed = stored[i] ^ data[i];
+			setBits += __builtin_popcount(changed & data[i]);
+			resetBits += __builtin_popcount(changed & stored[i]);
+		}
+	}
+
+	static void countWordFlipsGeneric(const byte *stored, const byte *data, size_t numBytes, unsigned *wordFlips)
+	{
+		for (size_t i = 0; i < numBytes; i += FNW_WORD_BYTES)
+		{
+			uint32_t o, d;
+			memcpy(&o, stored + i, FNW_WORD_BYTES);
+			memcpy(&d, data + i, FNW_WORD_BYTES);
+			wordFlips[i / FNW_WORD_BYTES] = __builtin_popcount(o ^ d);
+		}
+	}
+
+	static uint64_t countOnesGeneric(const byte *data, size_t numBytes)
+	{
+		uint64_t ones = 0;
+		size_t i = 0;
+		for (; i + 8 <= numBytes; i += 8)
+		{
+			ones += __builtin_popcountll(load64(data + i));
+		}
+		for (; i < numBytes; i++)
+		{
+			ones += __builtin_popcount(data[i]);
+		}
+		return ones;
+	}
+
+#ifdef BITOPS_X86
+
+	//per byte popcount of 32 bytes
+	__attribute__((target("avx2")))
+	static inline __m256i popcount8(__m256i v)
+	{
+		const __m256i lookup = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,
+		                                        0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+		const __m256i lowMask = _mm256_set1_epi8(0x0f);
+		__m256i lo = _mm256_and_si256(v, lowMask);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowMask);
+		return _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi));
+	}
+
+	__attribute__((target("avx2")))
+	static inline uint64_t sum64(__m256i v)
+	{
+		return (uint64_t)_mm256_extract_epi64(v, 0) + (uint64_t)_mm256_extract_epi64(v, 1)
+		     + (uint64_t)_mm256_extract_epi64(v, 2) + (uint64_t)_mm256_extract_epi64(v, 3);
+	}
+
+	__attribute__((target("avx2")))
+	static void countCellFlipsAVX2(const byte *stored, const byte *data, size_t numBytes, uint64_t &setBits, uint64_t &resetBits)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i setAcc = zero, resetAcc = zero;
+		size_t i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i o = _mm256_loadu_si256((const __m256i *)(stored + i));
+			__m256i d = _mm256_loadu_si256((const __m256i *)(data + i));
+			__m256i changed = _mm256_xor_si256(o, d);
+			setAcc = _mm256_add_epi64(setAcc, _mm256_sad_epu8(popcount8(_mm256_and_si256(changed, d)), zero));
+			resetAcc = _mm256_add_epi64(resetAcc, _mm256_sad_epu8(popcount8(_mm256_and_si256(changed, o)), zero));
+		}
+		setBits += sum64(setAcc);
+		resetBits += sum64(resetAcc);
+		countCellFlipsGeneric(stored + i, data + i, numBytes - i, setBits, resetBits);
+	}
+
+	__attribute__((target("avx2")))
+	static void countWordFlipsAVX2(const byte *stored, const byte *data, size_t numBytes, unsigned *wordFlips)
+	{
+		const __m256i ones8 = _mm256_set1_epi8(1);
+		const __m256i ones16 = _mm256_set1_epi16(1);
+		size_t i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i o = _mm256_loadu_si256((const __m256i *)(stored + i));
+			__m256i d = _mm256_loadu_si256((const __m256i *)(data + i));
+			__m256i perByte = popcount8(_mm256_xor_si256(o, d));
+			//byte counts -> 16 bit pair sums -> 32 bit word sums
+			__m256i perWord = _mm256_madd_epi16(_mm256_maddubs_epi16(perByte, ones8), ones16);
+			_mm256_storeu_si256((__m256i *)(wordFlips + i / FNW_WORD_BYTES), perWord);
+		}
+		countWordFlipsGeneric(stored + i, data + i, numBytes - i, wordFlips + i / FNW_WORD_BYTES);
+	}
+
+	__attribute__((target("avx2")))
+	static uint64_t countOnesAVX2(const byte *data, size_t numBytes)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		__m256i acc = zero;
+		size_t i = 0;
+		for (; i + 32 <= numBytes; i += 32)
+		{
+			__m256i d = _mm256_loadu_si256((const __m256i *)(data + i));
+			acc = _mm256_add_epi64(acc, _mm256_sad_epu8(popcount8(d), zero));
+		}
+		return sum64(acc) + countOnesGeneric(data + i, numBytes - i);
+	}
+
+	static bool hasAVX2()
+	{
+		static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+		return avx2;
+	}
+
+#endif
+
+	void countCellFlips(const byte *stored, const byte *data, size_t numBytes, uint64_t &setBits, uint64_t &resetBits)
+	{
+#ifdef BITOPS_X86
+		if (hasAVX2())
+		{
+			countCellFlipsAVX2(stored, data, numBytes, setBits, resetBits);
+			return;
+		}
+#endif
+		countCellFlipsGeneric(stored, data, numBytes, setBits, resetBits);
+	}
+
+	void countWordFlips(const byte *stored, const byte *data, size_t numBytes, unsigned *wordFlips)
+	{
+#ifdef BITOPS_X86
+		if (hasAVX2())
+		{
+			countWordFlipsAVX2(stored, data, numBytes, wordFlips);
+			return;
+		}
+#endif
+		countWordFlipsGeneric(stored, data, numBytes, wordFlips);
+	}
+
+	uint64_t countOnes(const byte *data, size_t numBytes)
+	{
+#ifdef BITOPS_X86
+		if (hasAVX2())
+		{
+			return countOnesAVX2(data, numBytes);
+		}
+#endif
+		return countOnesGeneric(data, numBytes);
+	}
+
+} // namespace DRAMSim
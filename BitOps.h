@@ -0,0 +1,28 @@
+#ifndef BITOPS_H
+#define BITOPS_H
+
+//BitOps.h
+//
+//XOR/popcount kernels used to compare the stored and incoming contents of a
+//PCM line (data-comparison write, Flip-N-Write, cell energy accounting).
+//On x86 an AVX2 version is picked at run time when the CPU supports it.
+//
+
+#include "SystemConfiguration.h"
+
+namespace DRAMSim
+{
+	//Flip-N-Write keeps one flip bit per word of this size
+	#define FNW_WORD_BYTES 4
+
+	//add the cells that change when 'data' overwrites 'stored' to setBits (0->1) and resetBits (1->0)
+	void countCellFlips(const byte *stored, const byte *data, size_t numBytes, uint64_t &setBits, uint64_t &resetBits);
+
+	//popcount(stored ^ data) of every FNW_WORD_BYTES word; numBytes must be a multiple of FNW_WORD_BYTES
+	void countWordFlips(const byte *stored, const byte *data, size_t numBytes, unsigned *wordFlips);
+
+	//number of 1 bits in data
+	uint64_t countOnes(const byte *data, size_t numBytes);
+}
+
+#endif
@@ -35,6 +35,8 @@
 //
 #include "SimulatorIO.h"
 #include "BusPacket.h"
+#include "EccKernels.h"
+#include "Checkpoint.h"
 #include <cmath>
 
 
@@ -53,7 +55,10 @@ using std::dec;
 		column(col),
 		data(dat),
 		len(len), 
-		isSETWRITE(isSetWrite)	{}
+		isSETWRITE(isSetWrite),
+		writeRecovery(0),
+		isScrub(false),
+		dirtyMask(0)	{}
 
 	void BusPacket::print(uint64_t currentClockCycle, bool dataStart)
 	{
@@ -62,41 +67,38 @@ using std::dec;
 			return;
 		}
 
-		if (VERIFICATION_OUTPUT)
+		switch (busPacketType)
 		{
-			switch (busPacketType)
-			{
-			case READ:
-				SimulatorIO::verifyFile << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
-				break;
-			case READ_P:
-				SimulatorIO::verifyFile << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
-				break;
-			case WRITE:
-				SimulatorIO::verifyFile << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
-				break;
-			case WRITE_P:
-				SimulatorIO::verifyFile << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
-				break;
-			case ACTIVATE:
-				SimulatorIO::verifyFile << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
-				break;
-			case PRECHARGE:
-				SimulatorIO::verifyFile << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
-				break;
-			case REFRESH:
-				SimulatorIO::verifyFile << currentClockCycle <<": refresh (" << rank << ");"<<endl;
-				break;
-			case DATA:
-				//TODO: data verification?
-				break;
-			case SET_WRITE:
-				//TODO
-				break;
-			default:
-				ERROR("Trying to print unknown kind of bus packet");
-				exit(-1);
-			}
+		case READ:
+			SimulatorIO::verifyFile << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",0);"<<endl;
+			break;
+		case READ_P:
+			SimulatorIO::verifyFile << currentClockCycle << ": read ("<<rank<<","<<bank<<","<<column<<",1);"<<endl;
+			break;
+		case WRITE:
+			SimulatorIO::verifyFile << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",0 , 0, 'h0);"<<endl;
+			break;
+		case WRITE_P:
+			SimulatorIO::verifyFile << currentClockCycle << ": write ("<<rank<<","<<bank<<","<<column<<",1, 0, 'h0);"<<endl;
+			break;
+		case ACTIVATE:
+			SimulatorIO::verifyFile << currentClockCycle <<": activate (" << rank << "," << bank << "," << row <<");"<<endl;
+			break;
+		case PRECHARGE:
+			SimulatorIO::verifyFile << currentClockCycle <<": precharge (" << rank << "," << bank << "," << row <<");"<<endl;
+			break;
+		case REFRESH:
+			SimulatorIO::verifyFile << currentClockCycle <<": refresh (" << rank << ");"<<endl;
+			break;
+		case DATA:
+			//TODO: data verification?
+			break;
+		case SET_WRITE:
+			//TODO
+			break;
+		default:
+			ERROR("Trying to print unknown kind of bus packet");
+			exit(-1);
 		}
 	}
 	void BusPacket::print()
@@ -168,336 +170,145 @@ using std::dec;
 		PRINTN("'" << dec);
 	}
 
+	void BusPacket::checkpoint(Checkpoint &cp)
+	{
+		cp.io(busPacketType);
+		cp.io(physicalAddress);
+		cp.io(rank);
+		cp.io(bank);
+		cp.io(row);
+		cp.io(column);
+		cp.io(len);
+		cp.io(isSETWRITE);
+		cp.io(writeRecovery);
+		cp.io(isScrub);
+		cp.io(dirtyMask);
+		cp.io(data);
+	}
+
 
 #ifdef DATA_RELIABILITY_ECC
 
 
-	void BusPacket::DATA_ENCODE()
+	void BusPacket::DATA_ENCODE(const Config &config)
 	{
 		ECC_HAMMING_SECDED(ENCODE);
 
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(ENCODE);
+		CHIPKILL(ENCODE, config.DEVICE_WIDTH);
 #endif
 	}
 
-	void BusPacket::DATA_DECODE()
+	void BusPacket::DATA_DECODE(const Config &config)
 	{
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(DECODE);
+		CHIPKILL(DECODE, config.DEVICE_WIDTH);
 #endif
 
 		ECC_HAMMING_SECDED(DECODE);
 	}
 
-	bool BusPacket::DATA_CHECK()
+	bool BusPacket::DATA_CHECK(const Config &config)
 	{
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(DECODE);
+		CHIPKILL(DECODE, config.DEVICE_WIDTH);
 #endif
 
 		bool result = ECC_HAMMING_SECDED(CHECK);
 
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(ENCODE);
+		CHIPKILL(ENCODE, config.DEVICE_WIDTH);
 #endif
 		return result;
 	}
 
-	bool BusPacket::DATA_CORRECTION()
+	bool BusPacket::DATA_CORRECTION(const Config &config, unsigned &correctedWords, unsigned &uncorrectableWords)
 	{
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(DECODE);
+		CHIPKILL(DECODE, config.DEVICE_WIDTH);
 #endif
 
-		bool result = ECC_HAMMING_SECDED(CORRECTION);
+		bool result = ECC_HAMMING_SECDED(CORRECTION, correctedWords, uncorrectableWords);
 
 #ifdef DATA_RELIABILITY_CHIPKILL
-		CHIPKILL(ENCODE);
+		CHIPKILL(ENCODE, config.DEVICE_WIDTH);
 #endif
 		return result;
 	}
 
 
-	bool BusPacket::ECC_HAMMING_SECDED(RELIABLE_OP eccop, int n, int m)
+	bool BusPacket::ECC_HAMMING_SECDED(RELIABLE_OP eccop)
+	{
+		unsigned corrected = 0;
+		unsigned uncorrectable = 0;
+		return ECC_HAMMING_SECDED(eccop, corrected, uncorrectable);
+	}
+
+	bool BusPacket::ECC_HAMMING_SECDED(RELIABLE_OP eccop, unsigned &correctedWords, unsigned &uncorrectableWords)
 	{
 		if (data->getData() == NULL) return true;
 
-		int c = n - m;
-		int dataBytes = JEDEC_DATA_BUS_BITS * BL / 8;
-		int eccDataBytes = ECC_DATA_BUS_BITS * BL / 8;
-		int l = eccDataBytes*8 / n;
-		int r = eccDataBytes*8 % n;
-		l = (r == 0) ? l : (l + 1);
+		size_t dataBytes = JEDEC_DATA_BITS / 8;
+		size_t eccDataBytes = ECC_DATA_BITS / 8;
+		size_t words = eccDataBytes / SECDED_CODE_BYTES;
 
 		switch (eccop)
 		{
 		case ENCODE:
 		{
-			bitset<JEDEC_DATA_BITS> plainDataBits;
-			bitset<ECC_DATA_BITS> eccDataBits;
-			bitset<ECC_CHECK_BITS> eccCheckBits;
-			BitsfromByteArray(plainDataBits,dataBytes);
-
-			for (int iLoop=0; iLoop < l; iLoop++)
-			{
-				eccCheckBits.reset();
-				for (int iCheck = 0; iCheck < c-1; iCheck++)
-				{
-					int checkBitCounter = (iCheck == 0) ? (2) : (iCheck + 1);
-					int positionIncrement = pow(2.0, iCheck);
-					int iCounter = 1;
-					int iData = POSITION_REVISE(iCheck) + iCounter;
-
-					bool first = true;
-
-					while (iData < m - 1)
-					{
-						if (first == true)
-						{
-							eccCheckBits[iCheck] = plainDataBits[iLoop*m + iData];
-							first = false;
-						}
-						else
-						{
-							eccCheckBits[iCheck] = eccCheckBits[iCheck]^plainDataBits[iLoop*m + iData];
-						}
-
-						iData++;
-						iCounter++;
-						if (iCounter % positionIncrement == 0)
-						{
-							iData += positionIncrement;
-							iCounter = 0;
-						}
-						while ( iData > POSITION_REVISE(checkBitCounter) )
-						{
-							checkBitCounter++;
-							iData--;
-						}
-					}
-				} // end of iCheck
-
-				for (int iData = 0; iData < n-1; iData++)
-				{
-					int iCheck = iData - m;
-					if (iCheck < 0)
-					{
-						eccDataBits[iLoop*n + iData] = plainDataBits[iLoop*m + iData];
-					}
-					else
-					{
-						eccDataBits[iLoop*n + iData] = eccCheckBits[iCheck];
-					}
-
-					if (iData == 0)
-					{
-						eccDataBits[iLoop*n + (n-1)] = eccDataBits[iLoop*n + iData];
-					}
-					else
-					{
-						eccDataBits[iLoop*n + (n-1)] = eccDataBits[iLoop*n + (n-1)] ^ eccDataBits[iLoop*n + iData];
-					}
-				}
-
-			} // end of iLoop
-			data->setData(BitstoByteArray(eccDataBits), eccDataBytes, false);
-
+			byte *eccData = (byte *)calloc(eccDataBytes, sizeof(byte));
+			secdedEncode(data->getData(), eccData, words);
+			data->setData(eccData, eccDataBytes, false);
 			return true;
-			break;
 		}
 		case DECODE:
 		{
-			bitset<ECC_DATA_BITS> eccDataBits;
-			bitset<JEDEC_DATA_BITS> plainDataBits;
-			BitsfromByteArray(eccDataBits,eccDataBytes);
-
-			for (int iLoop = 0; iLoop < l; iLoop++)
-			{
-				for (int iData = 0; iData < m; iData++)
-				{
-					plainDataBits[iLoop*m + iData] = eccDataBits[iLoop*n + iData];
-				}
-			}
-			data->setData(BitstoByteArray(plainDataBits), dataBytes, false);
-
+			byte *plainData = (byte *)calloc(dataBytes, sizeof(byte));
+			secdedDecode(data->getData(), plainData, words);
+			data->setData(plainData, dataBytes, false);
 			return true;
-			break;
 		}
 		case CHECK:
 		case CORRECTION:
 		{
-			int wordErrorNum = 0;
-			int dataErrorNum = 0;
-			bool noError = true;
-			bool killError = true;
-
-			bitset<ECC_CHECK_BITS> eccCheckBits;
-			bitset<ECC_DATA_BITS> eccDataBits;
-			BitsfromByteArray(eccDataBits,eccDataBytes);
-
-
-			for (int iLoop=0; iLoop < l; iLoop++)
+			if (eccop == CORRECTION)
 			{
-				int iErrorPosition = 0;
-
-				for (int iCheck = 0; iCheck < c; iCheck++)
-				{
-					eccCheckBits[iCheck] = eccDataBits[iLoop*n + m + iCheck];
-					iErrorPosition = (eccCheckBits[iCheck] == 1) ? (iErrorPosition + pow(2.0,iCheck)) : iErrorPosition;
-				}
-
-				if (eccCheckBits[c-1] == 0 && iErrorPosition == 0)
-				{
-					wordErrorNum = 0;
-				}
-				else if (eccCheckBits[c-1] == 1 && iErrorPosition != 0)
-				{
-					noError = false;
-					wordErrorNum = 1;
-				}
-				else if (eccCheckBits[c-1] == 0 && iErrorPosition != 0)
-				{
-					noError = false;
-					killError = false;
-					wordErrorNum = 2;
-				}
-				else if (eccCheckBits[c-1] == 1 && iErrorPosition == 0)
-				{
-					noError = false;
-					killError = false;
-					wordErrorNum = 3;
-				}
-				else
-				{
-					noError = false;
-					killError = false;
-					wordErrorNum = 3;
-				}
-
-				if (eccop == CORRECTION && wordErrorNum == 1)
-				{
-					if (isPowerOfTwo(iErrorPosition))
-					{
-						iErrorPosition = m + dramsim_log2(iErrorPosition);
-					}
-					else
-					{
-						int checkBitCounter = 0;
-						while (--iErrorPosition > POSITION_REVISE(checkBitCounter) )
-						{
-							checkBitCounter++;
-						}
-					}
-					eccDataBits[iLoop*n + iErrorPosition].flip();
-				}
-
-				dataErrorNum += wordErrorNum;
-				wordErrorNum = 0;
+				//never repair the stored row through a view
+				data->detach();
 			}
+			secdedCheck(data->getData(), words, eccop == CORRECTION, correctedWords, uncorrectableWords);
 
 			if (eccop == CHECK)
-				return noError;
-			else
-				if (eccop == CORRECTION)
-					data->setData(BitstoByteArray(eccDataBits), eccDataBytes, false);
-				return killError;
-
-			break;
+				return correctedWords == 0 && uncorrectableWords == 0;
+			return uncorrectableWords == 0;
 		}
 		default:
 			DEBUG("Invalid ECC Operation Type");
 			return false;
-			break;
-		}
-		DEBUG("Unexpected Executing Location");
-		return false;
-	}
-
-
-	byte *BusPacket::BitstoByteArray(bitset<JEDEC_DATA_BITS> &bits)
-	{
-		int len=bits.size()/8;
-		byte *bytes = (byte *)calloc(len, sizeof(byte));
-		for (int j=0;j<len;++j)
-		{
-			bytes[j]=0;
-		}
-		for (size_t i=0; i<bits.size(); i++)
-		{
-			if (bits.test(i))
-			{
-				bytes[i/8] |= 1<<(7-i%8);
-			}
 		}
-		return bytes;
-	}
-
-
-	byte *BusPacket::BitstoByteArray(bitset<ECC_DATA_BITS> &bits)
-	{
-		int len=bits.size()/8;
-		byte *bytes = (byte *)calloc(len, sizeof(byte));
-		for (int j=0;j<len;++j)
-		{
-			bytes[j]=0;
-		}
-		for (size_t i=0; i<bits.size(); i++)
-		{
-			if (bits.test(i))
-			{
-				bytes[i/8] |= 1<<(7-i%8);
-			}
-		}
-		return bytes;
 	}
 
 #ifdef DATA_RELIABILITY_CHIPKILL
-	void BusPacket::CHIPKILL(RELIABLE_OP op)
+	void BusPacket::CHIPKILL(RELIABLE_OP op, unsigned deviceWidth)
 	{
 		if (data->getData() == NULL) return;
 
-		int chipkillDataBytes = ECC_DATA_BITS / 8;
-		int loop = BL;
+		size_t chipkillDataBytes = ECC_DATA_BITS / 8;
 
 		switch (op)
 		{
 		case ENCODE:
 		{
-			bitset<ECC_DATA_BITS> chipkillDataBits;
-			bitset<ECC_DATA_BITS> eccDataBits;
-			BitsfromByteArray(eccDataBits,chipkillDataBytes);
-
-			for (int iLoop=0; iLoop < loop; iLoop++)
-			{
-				for (int iWord = 0; iWord < (int)(DEVICE_WIDTH); iWord++)
-				{
-					for (int iData = 0; iData < ECC_WORD_BITS; iData++)
-					{
-						chipkillDataBits[iData*DEVICE_WIDTH + iWord] = eccDataBits[iWord*ECC_WORD_BITS + iData];
-					}
-				}
-			}
-			data->setData(BitstoByteArray(chipkillDataBits), chipkillDataBytes, false);
+			byte *chipkillData = (byte *)calloc(chipkillDataBytes, sizeof(byte));
+			chipkillInterleave(data->getData(), chipkillData, deviceWidth, ECC_DATA_BITS);
+			data->setData(chipkillData, chipkillDataBytes, false);
 			break;
 		}
 		case DECODE:
 		{
-			bitset<ECC_DATA_BITS> chipkillDataBits;
-			bitset<ECC_DATA_BITS> eccDataBits;
-			BitsfromByteArray(chipkillDataBits,chipkillDataBytes);
-
-			for (int iLoop=0; iLoop < loop; iLoop++)
-			{
-				for (int iWord = 0; iWord < (int)(DEVICE_WIDTH); iWord++)
-				{
-					for (int iData = 0; iData < ECC_WORD_BITS; iData++)
-					{
-						eccDataBits[iWord*ECC_WORD_BITS + iData] = chipkillDataBits[iData*DEVICE_WIDTH + iWord];
-					}
-				}
-			}
-			data->setData(BitstoByteArray(eccDataBits), chipkillDataBytes, false);
+			byte *eccData = (byte *)calloc(chipkillDataBytes, sizeof(byte));
+			chipkillDeinterleave(data->getData(), eccData, deviceWidth, ECC_DATA_BITS);
+			data->setData(eccData, chipkillDataBytes, false);
 			break;
 		}
 		case CHECK:
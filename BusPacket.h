@@ -31,12 +31,12 @@
 #ifndef BUSPACKET_H
 #define BUSPACKET_H
 
-#include <bitset>
 #include "SystemConfiguration.h"
 #include "DataPacket.h"
 
 namespace DRAMSim
 {
+	class Checkpoint;
 	class BusPacket
 	{
 		BusPacket();
@@ -66,6 +66,9 @@ namespace DRAMSim
 
 		size_t len;
 		bool isSETWRITE;
+		unsigned writeRecovery; //cycles the cells of a write take to program (tWR or SET), set by the controller when it issues the write
+		bool isScrub; //drift scrub rewrite issued by the controller itself
+		uint64_t dirtyMask; //the 8 byte words a write programs, 0 for the whole line (PARTIAL_WRITE)
 		//void *data;
 		DataPacket *data;
 
@@ -73,8 +76,10 @@ namespace DRAMSim
 		BusPacket(BusPacketType packtype, unsigned rk, unsigned bk=0, unsigned rw=0, unsigned col=0, uint64_t physicalAddr=0, DataPacket *dat=NULL, size_t len=LEN_DEF,bool isSETWRITE=false);
 
 		void print();
+		//verification output line (the caller checks VERIFICATION_OUTPUT)
 		void print(uint64_t currentClockCycle, bool dataStart);
 		void printData() const;
+		void checkpoint(Checkpoint &cp);
 
 
 #ifdef DATA_RELIABILITY_ECC
@@ -89,7 +94,7 @@ namespace DRAMSim
 
 
 #ifdef DATA_RELIABILITY_CHIPKILL
-	void CHIPKILL(RELIABLE_OP op);
+	void CHIPKILL(RELIABLE_OP op, unsigned deviceWidth);
 
 	#define ECC_WORD_BITS 72
 	#define ECC_CHECK_BITS 8
@@ -102,32 +107,15 @@ namespace DRAMSim
 #endif
 
 
-	#define POSITION_REVISE(i) ((int)pow(2.0, i) - i - 2)
-	#define CHECKBIT_POSITION(i) ((int)pow(2.0, i) - 1)
+	void DATA_ENCODE(const Config &config);
+	void DATA_DECODE(const Config &config);
 
-	void DATA_ENCODE();
-	void DATA_DECODE();
+	bool DATA_CHECK(const Config &config);
+	//correct single bit errors in place; the counts are in 72 bit ECC words
+	bool DATA_CORRECTION(const Config &config, unsigned &correctedWords, unsigned &uncorrectableWords);
 
-	bool DATA_CHECK();
-	bool DATA_CORRECTION();
-
-	bool ECC_HAMMING_SECDED(RELIABLE_OP eccop, int n = 72, int m = 64);
-
-
-
-	byte *BitstoByteArray(bitset<JEDEC_DATA_BITS> &bits);
-	byte *BitstoByteArray(bitset<ECC_DATA_BITS> &bits);
-
-
-#define BitsfromByteArray(BITS,LEN)		 		\
-		byte *bytes = data->getData();			\
-		for (int i=0; i<LEN*8; i++)				\
-		{										\
-			if ((bytes[i/8]&(1<<(7-i%8))) > 0)	\
-			{									\
-				BITS.set(i);					\
-			}									\
-		}
+	bool ECC_HAMMING_SECDED(RELIABLE_OP eccop);
+	bool ECC_HAMMING_SECDED(RELIABLE_OP eccop, unsigned &correctedWords, unsigned &uncorrectableWords);
 
 #endif
 
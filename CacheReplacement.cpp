@@ -0,0 +1,146 @@
+#include "CacheReplacement.h"
+
+BlSim::ReplacementPolicy* BlSim::ReplacementPolicy::Create(const std::string &name, uint32_t set_count) {
+    if (name == "lru") {
+        return new LruPolicy();
+    } else if (name == "write_aware") {
+        return new WriteAwareLruPolicy();
+    } else if (name == "srrip") {
+        return new RripPolicy(RripPolicy::STATIC, set_count);
+    } else if (name == "brrip") {
+        return new RripPolicy(RripPolicy::BIMODAL, set_count);
+    } else if (name == "drrip") {
+        return new RripPolicy(RripPolicy::DYNAMIC, set_count);
+    }
+    return NULL;
+}
+
+void BlSim::LruPolicy::Reset(uint32_t set, uint8_t *repl, uint32_t way_count) {
+    for (uint32_t i = 0; i < way_count; i++) {
+        repl[i] = i;
+    }
+}
+
+void BlSim::LruPolicy::Promote(uint8_t *repl, uint32_t way_count, uint32_t way) {
+    uint8_t age = repl[way];
+    for (uint32_t i = 0; i < way_count; i++) {
+        repl[i] += repl[i] < age;
+    }
+    repl[way] = 0;
+}
+
+uint32_t BlSim::LruPolicy::Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count) {
+    uint32_t way = 0;
+    while (repl[way] != way_count - 1) {
+        way++;
+    }
+    return way;
+}
+
+void BlSim::LruPolicy::Invalidate(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+    uint8_t age = repl[way];
+    for (uint32_t i = 0; i < way_count; i++) {
+        repl[i] -= repl[i] > age;
+    }
+    repl[way] = way_count - 1;
+}
+
+/*
+ * The LRU half of the set is the clean first region: its oldest clean block
+ * goes before any dirty one, so a dirty block stays longer and may be
+ * written again before it is written back.
+ */
+uint32_t BlSim::WriteAwareLruPolicy::Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count) {
+    uint32_t window = way_count > 1 ? way_count / 2 : 1;
+    uint32_t victim = way_count;
+    uint32_t lru = 0;
+    for (uint32_t i = 0; i < way_count; i++) {
+        if (repl[i] == way_count - 1) {
+            lru = i;
+        }
+        if (!dirty[i] && repl[i] >= way_count - window
+            && (victim == way_count || repl[i] > repl[victim])) {
+            victim = i;
+        }
+    }
+    return victim == way_count ? lru : victim;
+}
+
+BlSim::RripPolicy::RripPolicy(Mode mode, uint32_t set_count) :
+    m_mode(mode),
+    m_psel((PSEL_MAX + 1) / 2),
+    m_bimodal_count(0) {
+    m_dueling_period = set_count / LEADER_SETS;
+    if (m_dueling_period < 2) {
+        m_dueling_period = 2;
+    }
+}
+
+const char* BlSim::RripPolicy::Name() const {
+    switch (m_mode) {
+        case STATIC:
+            return "srrip";
+        case BIMODAL:
+            return "brrip";
+        default:
+            return "drrip";
+    }
+}
+
+void BlSim::RripPolicy::Reset(uint32_t set, uint8_t *repl, uint32_t way_count) {
+    for (uint32_t i = 0; i < way_count; i++) {
+        repl[i] = RRPV_MAX;
+    }
+}
+
+// the first way predicted to be re-referenced in the distant future,
+// the whole set ages until there is one
+uint32_t BlSim::RripPolicy::Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count) {
+    while (true) {
+        for (uint32_t i = 0; i < way_count; i++) {
+            if (repl[i] == RRPV_MAX) {
+                return i;
+            }
+        }
+        for (uint32_t i = 0; i < way_count; i++) {
+            repl[i]++;
+        }
+    }
+}
+
+bool BlSim::RripPolicy::UseBimodal(uint32_t set) {
+    if (m_mode != DYNAMIC) {
+        return m_mode == BIMODAL;
+    }
+    // a miss in a leader set is a vote against its policy
+    uint32_t slot = set % m_dueling_period;
+    if (slot == 0) {
+        if (m_psel < PSEL_MAX) {
+            m_psel++;
+        }
+        return false;
+    }
+    if (slot == m_dueling_period / 2) {
+        if (m_psel > 0) {
+            m_psel--;
+        }
+        return true;
+    }
+    return m_psel > PSEL_MAX / 2;
+}
+
+void BlSim::RripPolicy::Insert(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+    repl[way] = RRPV_MAX - 1;
+    if (UseBimodal(set)) {
+        // the throttle is a counter, not a coin, so runs can be repeated
+        m_bimodal_count = (m_bimodal_count + 1) % BIMODAL_PERIOD;
+        if (m_bimodal_count != 0) {
+            repl[way] = RRPV_MAX;
+        }
+    }
+}
+
+void BlSim::RripPolicy::Serialize(DRAMSim::Checkpoint &cp) {
+    cp.io(m_psel);
+    cp.io(m_bimodal_count);
+}
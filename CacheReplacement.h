@@ -0,0 +1,109 @@
+#ifndef CACHE_REPLACEMENT_H_
+#define CACHE_REPLACEMENT_H_
+
+#include <stdint.h>
+#include <string>
+#include "Checkpoint.h"
+
+namespace BlSim {
+
+    /*
+     * How a set of a BlSim::Cache picks its victim. The policy owns one
+     * byte of state per way (m_repl of the set): the age for LRU, the
+     * re-reference prediction value (RRPV) for the RRIP family. Empty ways
+     * are filled before a policy is asked for a victim.
+     *
+     *   lru          true LRU
+     *   srrip        static RRIP, inserts at a long re-reference interval
+     *   brrip        bimodal RRIP, inserts at a distant interval, one in 32 long
+     *   drrip        SRRIP or BRRIP, chosen by set dueling
+     *   write_aware  LRU, but the oldest clean block of the LRU half is
+     *                evicted before a dirty one (clean first LRU)
+     *
+     * RRIP is from Jaleel et al., ISCA 2010; 2 bit RRPVs, a 10 bit PSEL and
+     * 32 leader sets of each kind.
+     */
+    class ReplacementPolicy {
+        public:
+            virtual ~ReplacementPolicy() {}
+
+            // NULL if name is not one of the policies above
+            static ReplacementPolicy* Create(const std::string &name, uint32_t set_count);
+
+            virtual const char* Name() const = 0;
+            // the state of an empty set
+            virtual void Reset(uint32_t set, uint8_t *repl, uint32_t way_count) = 0;
+            virtual void Hit(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) = 0;
+            // the way to evict from a full set
+            virtual uint32_t Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count) = 0;
+            // a block was loaded into way after a miss
+            virtual void Insert(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) = 0;
+            // way was emptied, it is the first to be filled again
+            virtual void Invalidate(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) = 0;
+            // the state that is not per way (the PSEL, the bimodal throttle)
+            virtual void Serialize(DRAMSim::Checkpoint &cp) {}
+    };
+
+    class LruPolicy : public ReplacementPolicy {
+        public:
+            virtual const char* Name() const { return "lru"; }
+            virtual void Reset(uint32_t set, uint8_t *repl, uint32_t way_count);
+            virtual void Hit(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+                Promote(repl, way_count, way);
+            }
+            virtual uint32_t Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count);
+            virtual void Insert(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+                Promote(repl, way_count, way);
+            }
+            virtual void Invalidate(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way);
+
+        protected:
+            // make way the MRU one (age 0), the younger ways age by one
+            static void Promote(uint8_t *repl, uint32_t way_count, uint32_t way);
+    };
+
+    class WriteAwareLruPolicy : public LruPolicy {
+        public:
+            virtual const char* Name() const { return "write_aware"; }
+            virtual uint32_t Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count);
+    };
+
+    class RripPolicy : public ReplacementPolicy {
+        public:
+            enum Mode {
+                STATIC,
+                BIMODAL,
+                DYNAMIC
+            };
+
+            RripPolicy(Mode mode, uint32_t set_count);
+
+            virtual const char* Name() const;
+            virtual void Reset(uint32_t set, uint8_t *repl, uint32_t way_count);
+            virtual void Hit(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+                repl[way] = 0;
+            }
+            virtual uint32_t Victim(uint32_t set, uint8_t *repl, const uint64_t *dirty, uint32_t way_count);
+            virtual void Insert(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way);
+            virtual void Invalidate(uint32_t set, uint8_t *repl, uint32_t way_count, uint32_t way) {
+                repl[way] = RRPV_MAX;
+            }
+            virtual void Serialize(DRAMSim::Checkpoint &cp);
+
+        protected:
+            static const uint8_t RRPV_MAX = 3;
+            static const uint32_t PSEL_MAX = 1023;
+            static const uint32_t BIMODAL_PERIOD = 32;
+            static const uint32_t LEADER_SETS = 32;
+
+            Mode m_mode;
+            uint32_t m_dueling_period; //one leader set of each kind per period
+            uint32_t m_psel;           //counts up on SRRIP leader misses
+            uint32_t m_bimodal_count;
+
+            // whether the next insertion into set is bimodal
+            bool UseBimodal(uint32_t set);
+    };
+
+}
+#endif
@@ -0,0 +1,260 @@
+//Checkpoint.cpp
+//
+//Binary snapshot of the simulation state
+//
+
+#include "Checkpoint.h"
+#include "Transaction.h"
+#include "BusPacket.h"
+#include "DataPacket.h"
+#include <errno.h>
+#include <string.h>
+
+#define CHECKPOINT_MAGIC "DRAMSim2 checkpoint"
+#define CHECKPOINT_VERSION 9
+
+namespace DRAMSim
+{
+	Checkpoint::Checkpoint(const string &filename, bool saving) :
+		filename(filename),
+		saving(saving)
+	{
+		file = fopen(filename.c_str(), saving ? "wb" : "rb");
+		if (file == NULL)
+		{
+			ERROR("Cannot open checkpoint "<<filename<<": "<<strerror(errno));
+			exit(-1);
+		}
+		string magic = CHECKPOINT_MAGIC;
+		uint32_t version = CHECKPOINT_VERSION;
+		check(magic);
+		io(version);
+		if (version != CHECKPOINT_VERSION)
+		{
+			ERROR(filename<<" is a version "<<version<<" checkpoint, this simulator reads version "<<CHECKPOINT_VERSION);
+			exit(-1);
+		}
+	}
+
+	Checkpoint::~Checkpoint()
+	{
+		if (saving && fflush(file) != 0)
+		{
+			ERROR("Cannot write checkpoint "<<filename<<": "<<strerror(errno));
+			exit(-1);
+		}
+		fclose(file);
+	}
+
+	void Checkpoint::bytes(void *data, size_t numBytes)
+	{
+		size_t done = saving ? fwrite(data, 1, numBytes, file) : fread(data, 1, numBytes, file);
+		if (done != numBytes)
+		{
+			if (saving)
+			{
+				ERROR("Cannot write checkpoint "<<filename<<": "<<strerror(errno));
+			}
+			else
+			{
+				ERROR("Checkpoint "<<filename<<" is truncated");
+			}
+			exit(-1);
+		}
+	}
+
+	void Checkpoint::io(string &s)
+	{
+		uint64_t size = s.size();
+		io(size);
+		if (!saving)
+		{
+			s.resize(size);
+		}
+		if (size > 0)
+		{
+			bytes(&s[0], size);
+		}
+	}
+
+	void Checkpoint::io(std::vector<bool> &v)
+	{
+		uint64_t size = v.size();
+		io(size);
+		if (!saving)
+		{
+			v.assign(size, false);
+		}
+		for (size_t i=0; i<v.size(); i++)
+		{
+			bool bit = v[i];
+			io(bit);
+			v[i] = bit;
+		}
+	}
+
+	void Checkpoint::check(const string &description)
+	{
+		string saved = description;
+		io(saved);
+		if (saved != description)
+		{
+			//report the first line that differs
+			size_t start = 0;
+			while (start < saved.size() && start < description.size())
+			{
+				size_t end = description.find('\n', start);
+				if (end == string::npos || saved.compare(start, end - start + 1, description, start, end - start + 1) != 0)
+				{
+					break;
+				}
+				start = end + 1;
+			}
+			ERROR("Checkpoint "<<filename<<" was taken with another build, configuration or trace: '"
+					<<saved.substr(start, saved.find('\n', start) - start)<<"' instead of '"
+					<<description.substr(start, description.find('\n', start) - start)<<"'");
+			exit(-1);
+		}
+	}
+
+	void Checkpoint::section(const string &name)
+	{
+		string saved = name;
+		io(saved);
+		if (saved != name)
+		{
+			ERROR("Checkpoint "<<filename<<" is out of step: expected "<<name<<", found "<<saved);
+			exit(-1);
+		}
+	}
+
+	bool Checkpoint::reference(void *&object)
+	{
+		uint64_t id;
+		if (saving)
+		{
+			if (object == NULL)
+			{
+				id = 0;
+				io(id);
+				return false;
+			}
+			std::map<const void *, uint64_t>::iterator it = savedObjects.find(object);
+			if (it != savedObjects.end())
+			{
+				id = it->second;
+				io(id);
+				return false;
+			}
+			id = savedObjects.size() + 1;
+			savedObjects[object] = id;
+			io(id);
+			return true;
+		}
+
+		io(id);
+		if (id == 0)
+		{
+			object = NULL;
+			return false;
+		}
+		if (id <= restoredObjects.size())
+		{
+			object = restoredObjects[id-1];
+			return false;
+		}
+		if (id != restoredObjects.size() + 1)
+		{
+			ERROR("Checkpoint "<<filename<<" refers to object "<<id<<" before it is stored");
+			exit(-1);
+		}
+		return true;
+	}
+
+	void Checkpoint::restored(void *object)
+	{
+		restoredObjects.push_back(object);
+	}
+
+	void Checkpoint::io(Transaction *&trans)
+	{
+		void *object = trans;
+		if (!reference(object))
+		{
+			trans = (Transaction *)object;
+			return;
+		}
+		if (!saving)
+		{
+			trans = new Transaction(Transaction::DATA_READ, 0, NULL);
+			restored(trans);
+		}
+		trans->checkpoint(*this);
+	}
+
+	void Checkpoint::io(BusPacket *&packet)
+	{
+		void *object = packet;
+		if (!reference(object))
+		{
+			packet = (BusPacket *)object;
+			return;
+		}
+		if (!saving)
+		{
+			packet = new BusPacket(BusPacket::READ, 0);
+			restored(packet);
+		}
+		packet->checkpoint(*this);
+	}
+
+	void Checkpoint::io(DataPacket *&packet)
+	{
+		void *object = packet;
+		if (!reference(object))
+		{
+			packet = (DataPacket *)object;
+			return;
+		}
+		if (!saving)
+		{
+			packet = new DataPacket();
+			restored(packet);
+		}
+		packet->checkpoint(*this);
+	}
+
+	void Checkpoint::region(byte *base, size_t numBytes)
+	{
+		regions.push_back(std::make_pair(base, numBytes));
+	}
+
+	void Checkpoint::ioView(byte *&p)
+	{
+		uint64_t index = 0, offset = 0;
+		if (saving)
+		{
+			while (index < regions.size() && (p < regions[index].first || p >= regions[index].first + regions[index].second))
+			{
+				index++;
+			}
+			if (index == regions.size())
+			{
+				ERROR("A data packet is a view of memory no backing store owns");
+				exit(-1);
+			}
+			offset = p - regions[index].first;
+		}
+		io(index);
+		io(offset);
+		if (!saving)
+		{
+			if (index >= regions.size() || offset >= regions[index].second)
+			{
+				ERROR("Checkpoint "<<filename<<" has a view outside of the backing stores");
+				exit(-1);
+			}
+			p = regions[index].first + offset;
+		}
+	}
+}
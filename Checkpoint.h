@@ -0,0 +1,174 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+//Checkpoint.h
+//
+//Binary snapshot of a whole simulation, so that a warmed up state can be saved
+//once and every measurement run restored from it instead of simulating the
+//warmup again.
+//
+//A stateful class has a checkpoint(Checkpoint &cp) method that passes each of
+//its fields to cp.io(); the same method saves and restores, so the two
+//directions cannot disagree on the layout. io() takes numbers and enums as
+//they are in memory, classes through their own checkpoint() method, and the
+//standard containers element by element.
+//
+//Transactions, bus packets and data packets are met through pointers, often
+//more than once (an ACT and its WRITE share the transaction's data). Each
+//object is written the first time it is met and referenced by number after
+//that, so restoring gives back the same sharing, and NULL stays NULL. Data
+//packets that are views of a backing store row are written as an offset into
+//the store, which has to be registered with region() before.
+//
+//A checkpoint only fits the build, configuration and trace it was taken with;
+//the header check() of each side has to be the same, otherwise the restore
+//stops with an error.
+//
+
+#include "SystemConfiguration.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <map>
+#include <type_traits>
+
+namespace DRAMSim
+{
+	using std::string;
+
+	class Transaction;
+	class BusPacket;
+	class DataPacket;
+
+	class Checkpoint
+	{
+	public:
+		//saving writes filename, otherwise it is read
+		Checkpoint(const string &filename, bool saving);
+		~Checkpoint();
+
+		bool isSaving() const
+		{
+			return saving;
+		}
+
+		//the text describing what the checkpoint belongs to (build, config, trace)
+		void check(const string &description);
+		//a named mark between parts, a restore that gets out of step stops at the first one
+		void section(const string &name);
+
+		void bytes(void *data, size_t numBytes);
+
+		template<typename T> void io(T &value)
+		{
+			ioValue(value, typename std::is_class<T>::type());
+		}
+		void io(string &s);
+		void io(std::vector<bool> &v);
+		void io(Transaction *&trans);
+		void io(BusPacket *&packet);
+		void io(DataPacket *&packet);
+
+		template<typename T> void io(std::vector<T> &v)
+		{
+			uint64_t size = v.size();
+			io(size);
+			if (!saving)
+			{
+				v.clear();
+				v.resize(size);
+			}
+			for (size_t i=0; i<v.size(); i++)
+			{
+				io(v[i]);
+			}
+		}
+		template<typename T> void io(std::list<T> &l)
+		{
+			uint64_t size = l.size();
+			io(size);
+			if (!saving)
+			{
+				l.clear();
+				l.resize(size);
+			}
+			for (typename std::list<T>::iterator it = l.begin(); it != l.end(); it++)
+			{
+				io(*it);
+			}
+		}
+		template<typename T> void io(std::deque<T> &d)
+		{
+			uint64_t size = d.size();
+			io(size);
+			if (!saving)
+			{
+				d.clear();
+				d.resize(size);
+			}
+			for (size_t i=0; i<d.size(); i++)
+			{
+				io(d[i]);
+			}
+		}
+		template<typename K, typename V> void io(std::map<K,V> &m)
+		{
+			uint64_t size = m.size();
+			io(size);
+			if (saving)
+			{
+				for (typename std::map<K,V>::iterator it = m.begin(); it != m.end(); it++)
+				{
+					K key = it->first;
+					io(key);
+					io(it->second);
+				}
+			}
+			else
+			{
+				m.clear();
+				for (uint64_t i=0; i<size; i++)
+				{
+					K key;
+					io(key);
+					io(m[key]);
+				}
+			}
+		}
+
+		//memory that data packets may be views of (a backing store); the
+		//regions have to be registered in the same order on both sides
+		void region(byte *base, size_t numBytes);
+		//a pointer into one of the regions
+		void ioView(byte *&p);
+
+	private:
+		template<typename T> void ioValue(T &value, std::true_type)
+		{
+			value.checkpoint(*this);
+		}
+		template<typename T> void ioValue(T &value, std::false_type)
+		{
+			static_assert(!std::is_pointer<T>::value, "objects behind a pointer need their own io()");
+			bytes(&value, sizeof(T));
+		}
+		//writes/reads the number of an object; true if its contents follow
+		bool reference(void *&object);
+		void restored(void *object);
+
+		//not copyable, it owns the file
+		Checkpoint(const Checkpoint &other);
+		Checkpoint &operator=(const Checkpoint &other);
+
+		string filename;
+		FILE *file;
+		bool saving;
+		std::map<const void *, uint64_t> savedObjects;
+		std::vector<void *> restoredObjects;
+		std::vector<std::pair<byte *, size_t> > regions;
+	};
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "ClockDomain.h"
 #include "Callback.h"
+#include "Checkpoint.h"
 
 namespace DRAMSim
 {
@@ -66,4 +67,10 @@ namespace DRAMSim
 		}
 	}
 
+	void ClockDomain::checkpoint(Checkpoint &cp)
+	{
+		cp.io(clockcycle);
+		cp.io(counter);
+	}
+
 } // end of namespace DRAMSim
@@ -9,6 +9,7 @@
 
 namespace DRAMSim
 {
+	class Checkpoint;
 
 	class ClockDomain
 	{
@@ -23,6 +24,8 @@ namespace DRAMSim
 		ClockDomain(ClockUpdateCB *callback, uint64_t clock = 0);
 
 		void tick();
+		//the cycle and the counter; the frequency comes from the config
+		void checkpoint(Checkpoint &cp);
 	};
 }
 
@@ -36,34 +36,36 @@
 #include "CommandQueue.h"
 #include "MemoryController.h"
 #include "Rank.h"
+#include "Checkpoint.h"
 #include <assert.h>
 
 namespace DRAMSim {
 using std::cout;
-CommandQueue::CommandQueue(vector<vector<BankState> > &states) :
-		bankStates(states), nextBank(0), nextRank(0), nextBankPRE(0), nextRankPRE(
+CommandQueue::CommandQueue(vector<vector<BankState> > &states,
+		const Config &config, ClockDomain *clockDomainDRAM) :
+		bankStates(states), config(config), clockDomainDRAM(clockDomainDRAM), nextBank(0), nextRank(0), nextBankPRE(0), nextRankPRE(
 				0), refreshRank(0), refreshWaiting(false), sendAct(true) {
 
 	//use numBankQueus below to create queue structure
 	size_t numBankQueues;
-	if (queuingStructure == PerRank) {
+	if (config.queuingStructure == PerRank) {
 		numBankQueues = 1;
-	} else if (queuingStructure == PerRankPerBank) {
-		numBankQueues = NUM_BANKS;
+	} else if (config.queuingStructure == PerRankPerBank) {
+		numBankQueues = config.NUM_BANKS;
 	} else {
 		ERROR("== Error - Unknown queuing structure");
 		exit(0);
 	}
 
 	//vector of counters used to ensure rows don't stay open too long
-	rowAccessCounters = vector<vector<unsigned> >(NUM_RANKS,
-			vector<unsigned>(NUM_BANKS, 0));
+	rowAccessCounters = vector<vector<unsigned> >(config.NUM_RANKS,
+			vector<unsigned>(config.NUM_BANKS, 0));
 
 	//create queue based on the structure we want
 	BusPacket1D actualQueue;
 	BusPacket2D perBankQueue = BusPacket2D();
 	queues = BusPacket3D();
-	for (size_t rank = 0; rank < NUM_RANKS; rank++) {
+	for (size_t rank = 0; rank < config.NUM_RANKS; rank++) {
 		//this loop will run only once for per-rank and NUM_BANKS times for per-rank-per-bank
 		for (size_t bank = 0; bank < numBankQueues; bank++) {
 			actualQueue = BusPacket1D();
@@ -78,8 +80,8 @@ CommandQueue::CommandQueue(vector<vector<BankState> > &states) :
 	//
 	//countdown vector will have decrementing counters starting at tFAW
 	//  when the 0th element reaches 0, remove it
-	tFAWCountdown.reserve(NUM_RANKS);
-	for (size_t i = 0; i < NUM_RANKS; i++) {
+	tFAWCountdown.reserve(config.NUM_RANKS);
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
 		//init the empty vectors here so we don't seg fault later
 		tFAWCountdown.push_back(vector<unsigned>());
 	}
@@ -87,11 +89,11 @@ CommandQueue::CommandQueue(vector<vector<BankState> > &states) :
 
 CommandQueue::~CommandQueue() {
 	//ERROR("COMMAND QUEUE destructor");
-	size_t bankMax = NUM_RANKS;
-	if (queuingStructure == PerRank) {
+	size_t bankMax = config.NUM_RANKS;
+	if (config.queuingStructure == PerRank) {
 		bankMax = 1;
 	}
-	for (size_t r = 0; r < NUM_RANKS; r++) {
+	for (size_t r = 0; r < config.NUM_RANKS; r++) {
 		for (size_t b = 0; b < bankMax; b++) {
 			for (size_t i = 0; i < queues[r][b].size(); i++) {
 				delete (queues[r][b][i]);
@@ -105,18 +107,18 @@ CommandQueue::~CommandQueue() {
 void CommandQueue::enqueue(BusPacket *newBusPacket) {
 	unsigned rank = newBusPacket->rank;
 	unsigned bank = newBusPacket->bank;
-	if (queuingStructure == PerRank) {
+	if (config.queuingStructure == PerRank) {
 		queues[rank][0].push_back(newBusPacket);
-		if (queues[rank][0].size() > CMD_QUEUE_DEPTH) {
+		if (queues[rank][0].size() > config.CMD_QUEUE_DEPTH) {
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR(
 					"						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
 			exit(0);
 		}
-	} else if (queuingStructure == PerRankPerBank) {
+	} else if (config.queuingStructure == PerRankPerBank) {
 		//TODO:if current transaction has a access with the same address, then release it.
 		queues[rank][bank].push_back(newBusPacket);
-		if (queues[rank][bank].size() > CMD_QUEUE_DEPTH) {
+		if (queues[rank][bank].size() > config.CMD_QUEUE_DEPTH) {
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR(
 					"						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
@@ -132,18 +134,18 @@ void CommandQueue::insert(BusPacket *newBusPacket) {
 	unsigned rank = newBusPacket->rank;
 	unsigned bank = newBusPacket->bank;
 
-	if (queuingStructure == PerRank) {
+	if (config.queuingStructure == PerRank) {
 		queues[rank][0].insert(queues[rank][0].begin(),1,newBusPacket);
-		if (queues[rank][0].size() > CMD_QUEUE_DEPTH) {
+		if (queues[rank][0].size() > config.CMD_QUEUE_DEPTH) {
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR(
 					"						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
 			exit(0);
 		}
-	} else if (queuingStructure == PerRankPerBank) {
+	} else if (config.queuingStructure == PerRankPerBank) {
 		//TODO:if current transaction has a access with the same address, then release it.
 		queues[rank][bank].insert(queues[rank][bank].begin(),1,newBusPacket);
-		if (queues[rank][bank].size() > CMD_QUEUE_DEPTH) {
+		if (queues[rank][bank].size() > config.CMD_QUEUE_DEPTH) {
 			ERROR("== Error - Enqueued more than allowed in command queue");
 			ERROR(
 					"						Need to call .hasRoomFor(int numberToEnqueue, unsigned rank, unsigned bank) first");
@@ -158,13 +160,13 @@ void CommandQueue::insert(BusPacket *newBusPacket) {
 //Removes the next item from the command queue based on the system's
 //command scheduling policy
 bool CommandQueue::pop(BusPacket **busPacket) {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 	//this can be done here because pop() is called every clock cycle by the parent MemoryController
 	//	figures out the sliding window requirement for tFAW
 	//
 	//deal with tFAW book-keeping
 	//	each rank has it's own counter since the restriction is on a device level
-	for (size_t i = 0; i < NUM_RANKS; i++) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
 		//decrement all the counters we have going
 		for (size_t j = 0; j < tFAWCountdown[i].size(); j++) {
 			tFAWCountdown[i][j]--;
@@ -184,13 +186,13 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 	 Otherwise, it starts looking for rows to close (in open page)
 	 */
 
-	if (rowBufferPolicy == ClosePage) {
+	if (config.rowBufferPolicy == ClosePage) {
 		bool sendingREF = false;
 		//if the memory controller set the flags signaling that we need to issue a refresh
 		if (refreshWaiting) {
 			bool foundActiveOrTooEarly = false;
 			//look for an open bank
-			for (size_t b = 0; b < NUM_BANKS; b++) {
+			for (size_t b = 0; b < config.NUM_BANKS; b++) {
 				vector<BusPacket *> &queue = getCommandQueue(refreshRank, b);
 				//checks to make sure that all banks are idle
 				if (bankStates[refreshRank][b].currentBankState
@@ -254,7 +256,7 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 				//		refresh logic above has sent one out (ie, letting banks close)
 				if (!queue.empty()
 						&& !((nextRank == refreshRank) && refreshWaiting)) {
-					if (queuingStructure == PerRank) {
+					if (config.queuingStructure == PerRank) {
 
 						//search from beginning to find first issuable bus packet
 						for (size_t i = 0; i < queue.size(); i++) {
@@ -291,8 +293,8 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 					break;
 
 				//rank round robin
-				if (queuingStructure == PerRank) {
-					nextRank = (nextRank + 1) % NUM_RANKS;
+				if (config.queuingStructure == PerRank) {
+					nextRank = (nextRank + 1) % config.NUM_RANKS;
 					if (startingRank == nextRank) {
 						break;
 					}
@@ -308,12 +310,12 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 			if (!foundIssuable)
 				return false;
 		}
-	} else if (rowBufferPolicy == OpenPage) {
+	} else if (config.rowBufferPolicy == OpenPage) {
 		bool sendingREForPRE = false;
 		if (refreshWaiting) {
 			bool sendREF = true;
 			//make sure all banks idle and timing met for a REF
-			for (size_t b = 0; b < NUM_BANKS; b++) {
+			for (size_t b = 0; b < config.NUM_BANKS; b++) {
 				//if a bank is active we can't send a REF yet
 				if (bankStates[refreshRank][b].currentBankState
 						== BankState::RowActive) {
@@ -445,8 +447,8 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 					break;
 
 				//rank round robin
-				if (queuingStructure == PerRank) {
-					nextRank = (nextRank + 1) % NUM_RANKS;
+				if (config.queuingStructure == PerRank) {
+					nextRank = (nextRank + 1) % config.NUM_RANKS;
 					if (startingRank == nextRank) {
 						break;
 					}
@@ -487,7 +489,7 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 						//if nothing found going to that bank and row or too many accesses have happend, close it
 						if (!found
 								|| rowAccessCounters[nextRankPRE][nextBankPRE]
-										== TOTAL_ROW_ACCESSES) {
+										== config.TOTAL_ROW_ACCESSES) {
 							if (currentClockCycle
 									>= bankStates[nextRankPRE][nextBankPRE].nextPrecharge) {
 								sendingPRE = true;
@@ -513,7 +515,7 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 	//  posted-cas is enabled when AL>0
 	//  when sendAct is true, when don't want to increment our indexes
 	//  so we send the column access that is paid with this act
-	if (AL > 0 && sendAct) {
+	if (config.AL > 0 && sendAct) {
 		sendAct = false;
 	} else {
 		sendAct = true;
@@ -522,7 +524,7 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 
 	//if its an activate, add a tfaw counter
 	if ((*busPacket)->busPacketType == BusPacket::ACTIVATE) {
-		tFAWCountdown[(*busPacket)->rank].push_back(tFAW);
+		tFAWCountdown[(*busPacket)->rank].push_back(config.tFAW);
 	}
 
 	return true;
@@ -532,26 +534,26 @@ bool CommandQueue::pop(BusPacket **busPacket) {
 bool CommandQueue::hasRoomFor(unsigned numberToEnqueue, unsigned rank,
 		unsigned bank) {
 	vector<BusPacket *> &queue = getCommandQueue(rank, bank);
-	return (CMD_QUEUE_DEPTH - queue.size() >= numberToEnqueue);
+	return (config.CMD_QUEUE_DEPTH - queue.size() >= numberToEnqueue);
 }
 
 //prints the contents of the command queue
 void CommandQueue::print() {
-	if (queuingStructure == PerRank) {
+	if (config.queuingStructure == PerRank) {
 		PRINT(std::endl << "== Printing Per Rank Queue");
-		for (size_t i = 0; i < NUM_RANKS; i++) {
+		for (size_t i = 0; i < config.NUM_RANKS; i++) {
 			PRINT(" = Rank " << i << "  size : " << queues[i][0].size());
 			for (size_t j = 0; j < queues[i][0].size(); j++) {
 				PRINTN("    "<< j << "]");
 				queues[i][0][j]->print();
 			}
 		}
-	} else if (queuingStructure == PerRankPerBank) {
+	} else if (config.queuingStructure == PerRankPerBank) {
 		PRINT("\n== Printing Per Rank, Per Bank Queue");
 
-		for (size_t i = 0; i < NUM_RANKS; i++) {
+		for (size_t i = 0; i < config.NUM_RANKS; i++) {
 			PRINT(" = Rank " << i);
-			for (size_t j = 0; j < NUM_BANKS; j++) {
+			for (size_t j = 0; j < config.NUM_BANKS; j++) {
 				PRINT("    Bank "<< j << "   size : " << queues[i][j].size());
 
 				for (size_t k = 0; k < queues[i][j].size(); k++) {
@@ -563,6 +565,19 @@ void CommandQueue::print() {
 	}
 }
 
+void CommandQueue::checkpoint(Checkpoint &cp) {
+	cp.io(queues);
+	cp.io(nextBank);
+	cp.io(nextRank);
+	cp.io(nextBankPRE);
+	cp.io(nextRankPRE);
+	cp.io(refreshRank);
+	cp.io(refreshWaiting);
+	cp.io(tFAWCountdown);
+	cp.io(rowAccessCounters);
+	cp.io(sendAct);
+}
+
 /**
  * return a reference to the queue for a given rank, bank. Since we
  * don't always have a per bank queuing structure, sometimes the bank
@@ -570,9 +585,9 @@ void CommandQueue::print() {
  */
 vector<BusPacket *> &CommandQueue::getCommandQueue(unsigned rank,
 		unsigned bank) {
-	if (queuingStructure == PerRankPerBank) {
+	if (config.queuingStructure == PerRankPerBank) {
 		return queues[rank][bank];
-	} else if (queuingStructure == PerRank) {
+	} else if (config.queuingStructure == PerRank) {
 		return queues[rank][0];
 	} else {
 		ERROR("Unknown queue structure");
@@ -583,7 +598,7 @@ vector<BusPacket *> &CommandQueue::getCommandQueue(unsigned rank,
 
 //checks if busPacket is allowed to be issued
 bool CommandQueue::isIssuable(BusPacket *busPacket) {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	switch (busPacket->busPacketType) {
 	case BusPacket::REFRESH:
@@ -613,7 +628,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket) {
 				&& busPacket->row
 						== bankStates[busPacket->rank][busPacket->bank].openRowAddress
 				&& rowAccessCounters[busPacket->rank][busPacket->bank]
-						< TOTAL_ROW_ACCESSES) {
+						< config.TOTAL_ROW_ACCESSES) {
 			return true;
 		} else {
 			return false;
@@ -628,7 +643,7 @@ bool CommandQueue::isIssuable(BusPacket *busPacket) {
 				&& busPacket->row
 						== bankStates[busPacket->rank][busPacket->bank].openRowAddress
 				&& rowAccessCounters[busPacket->rank][busPacket->bank]
-						< TOTAL_ROW_ACCESSES) {
+						< config.TOTAL_ROW_ACCESSES) {
 			return true;
 		} else {
 			return false;
@@ -655,10 +670,10 @@ bool CommandQueue::isIssuable(BusPacket *busPacket) {
 
 //figures out if a rank's queue is empty
 bool CommandQueue::isEmpty(unsigned rank) {
-	if (queuingStructure == PerRank) {
+	if (config.queuingStructure == PerRank) {
 		return queues[rank][0].empty();
-	} else if (queuingStructure == PerRankPerBank) {
-		for (size_t i = 0; i < NUM_BANKS; i++) {
+	} else if (config.queuingStructure == PerRankPerBank) {
+		for (size_t i = 0; i < config.NUM_BANKS; i++) {
 			if (!queues[rank][i].empty())
 				return false;
 		}
@@ -672,9 +687,9 @@ bool CommandQueue::isEmpty(unsigned rank) {
 
 //figures out if a bank's queue is empty libing
 bool CommandQueue::isbankEmpty(unsigned rank, unsigned bank) {
-	if (queuingStructure == PerRankPerBank) {
+	if (config.queuingStructure == PerRankPerBank) {
 		if (!queues[rank][bank].empty()) {
-			if(SET_IDLE){
+			if(config.SET_IDLE){
 				for(size_t i =0; i<queues[rank][bank].size();i++){
 					BusPacket *packet =queues[rank][bank][i];
 					if(packet->busPacketType==BusPacket::ACTIVATE){
@@ -717,23 +732,23 @@ void CommandQueue::needRefresh(unsigned rank) {
  */
 
 void CommandQueue::nextRankAndBank(unsigned &rank, unsigned &bank) {
-	if (schedulingPolicy == RankThenBankRoundRobin) {
+	if (config.schedulingPolicy == RankThenBankRoundRobin) {
 		rank++;
-		if (rank == NUM_RANKS) {
+		if (rank == config.NUM_RANKS) {
 			rank = 0;
 			bank++;
-			if (bank == NUM_BANKS) {
+			if (bank == config.NUM_BANKS) {
 				bank = 0;
 			}
 		}
 	}
 	//bank-then-rank round robin
-	else if (schedulingPolicy == BankThenRankRoundRobin) {
+	else if (config.schedulingPolicy == BankThenRankRoundRobin) {
 		bank++;
-		if (bank == NUM_BANKS) {
+		if (bank == config.NUM_BANKS) {
 			bank = 0;
 			rank++;
-			if (rank == NUM_RANKS) {
+			if (rank == config.NUM_RANKS) {
 				rank = 0;
 			}
 		}
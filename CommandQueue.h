@@ -40,10 +40,12 @@
 #include "BankState.h"
 #include "Transaction.h"
 #include "SystemConfiguration.h"
+#include "ClockDomain.h"
 
 using std::vector;
 using std::cout;
 namespace DRAMSim {
+class Checkpoint;
 class CommandQueue {
 	CommandQueue();
 public:
@@ -53,7 +55,7 @@ public:
 	typedef vector<BusPacket2D> BusPacket3D;
 
 	//functions
-	CommandQueue(vector<vector<BankState> > &states);
+	CommandQueue(vector<vector<BankState> > &states, const Config &config, ClockDomain *clockDomainDRAM);
 	virtual ~CommandQueue();
 
 	void enqueue(BusPacket *newBusPacket);
@@ -69,12 +71,16 @@ public:
 	void print();
 	void update(); //SimulatorObject requirement
 	vector<BusPacket *> &getCommandQueue(unsigned rank, unsigned bank);
+	//the bank states belong to the controller, which saves them
+	void checkpoint(Checkpoint &cp);
 
 	//fields
 
 	BusPacket3D queues; // 3D array of BusPacket pointers
 	vector<vector<BankState> > &bankStates;
 private:
+	const Config &config;
+	ClockDomain *clockDomainDRAM;
 	void nextRankAndBank(unsigned &rank, unsigned &bank);
 	//fields
 	unsigned nextBank;
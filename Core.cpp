@@ -0,0 +1,315 @@
+//Core.cpp
+//
+//Open and closed loop replay of the trace of a core
+//
+
+#include "Core.h"
+#include "PrintMacros.h"
+#include <algorithm>
+
+namespace DRAMSim
+{
+	using std::endl;
+
+	uint32_t Core::cacheOperation(const Transaction *t)
+	{
+		return t->transactionType == Transaction::DATA_WRITE ? BlSim::MEM_WRITE : BlSim::MEM_READ;
+	}
+
+	Core::Core(unsigned id, const Config &config, SimulatorIO *simIO, BlSim::CacheHierarchy *cache,
+			const std::vector<BlSim::Prefetcher*> &prefetchers, MemorySystem *memorySystem,
+			TransactionReceiver *transReceiver, Sampler *sampler) :
+		id(id),
+		closedLoop(config.CORE_MODEL == "closed_loop"),
+		width(config.CORE_WIDTH),
+		robSize(config.CORE_ROB),
+		mshrCount(config.CORE_MSHR),
+		simIO(simIO),
+		cache(cache),
+		prefetchers(prefetchers),
+		memorySystem(memorySystem),
+		transReceiver(transReceiver),
+		sampler(sampler),
+		trans(NULL),
+		transMissed(false),
+		traceDone(false),
+		instruction(0),
+		nextInstruction(0),
+		dispatched(0),
+		retired(0),
+		warmupCycle(0),
+		instructions(0),
+		cycles(0),
+		readMisses(0),
+		robStallCycles(0),
+		mshrStallCycles(0),
+		memoryStallCycles(0)
+	{
+		if (closedLoop && (width == 0 || robSize == 0 || mshrCount == 0))
+		{
+			ERROR("CORE_WIDTH, CORE_ROB and CORE_MSHR must not be zero");
+			exit(-1);
+		}
+	}
+
+	Core::~Core()
+	{
+		delete trans;
+	}
+
+	bool Core::validModel(const Config &config)
+	{
+		return config.CORE_MODEL == "open_loop" || config.CORE_MODEL == "closed_loop";
+	}
+
+	bool Core::done() const
+	{
+		return traceDone && trans == NULL && (!closedLoop || retired == dispatched);
+	}
+
+	void Core::update(uint64_t clockCycle)
+	{
+		if (closedLoop)
+		{
+			replayClosedLoop(clockCycle);
+		}
+		else
+		{
+			replayOpenLoop(clockCycle);
+		}
+	}
+
+	bool Core::fetch(uint64_t clockCycle)
+	{
+		if (traceDone)
+		{
+			return false;
+		}
+		trans = closedLoop ? simIO->nextTrans(id) : simIO->nextTrans();
+		if (trans == NULL)
+		{
+			traceDone = true;
+			return false;
+		}
+		if (sampler != NULL)
+		{
+			sampler->fetched(*transReceiver, clockCycle);
+		}
+		instruction = std::max(trans->timeTraced, nextInstruction);
+		nextInstruction = instruction + 1;
+		return true;
+	}
+
+	void Core::replayOpenLoop(uint64_t clockCycle)
+	{
+		bool hit = false;
+		bool stalled = false;
+		if (trans == NULL)
+		{
+			//the window is complete, nothing is fetched until the next period
+			if (sampler != NULL && sampler->windowFetched())
+			{
+				return;
+			}
+			if (!fetch(clockCycle))
+			{
+				return;
+			}
+		}
+
+		BlSim::Prefetcher *prefetcher = prefetchers[trans->source];
+		if (clockCycle >= trans->timeTraced)
+		{
+			//a miss the memory system refused is not looked up again, the cache
+			//has already allocated its block
+			if (!transMissed)
+			{
+				hit = cache->Access(trans->source, trans->address, cacheOperation(trans), clockCycle);
+				//a block the prefetcher brought in needs no memory access
+				if (!hit && prefetcher != NULL
+						&& prefetcher->Demand(trans->address, cacheOperation(trans), clockCycle))
+				{
+					hit = true;
+				}
+			}
+
+			if (!hit)
+			{
+				if (memorySystem->addTransaction(trans))
+				{
+					transReceiver->addPending(trans, clockCycle);
+					// the memory system accepted our request so now it takes ownership of it
+					trans = NULL;
+					transMissed = false;
+				}
+				else
+				{
+					stalled = true;
+					transMissed = true;
+				}
+			}
+			else
+			{
+				delete trans;
+				trans = NULL;
+			}
+		}
+
+		//prefetches only use the cycles the demand does not wait for the memory system
+		for (size_t i = 0; i < prefetchers.size() && !stalled; i++)
+		{
+			if (prefetchers[i] != NULL)
+			{
+				prefetchers[i]->Issue(clockCycle);
+			}
+		}
+	}
+
+	void Core::replayClosedLoop(uint64_t clockCycle)
+	{
+		if (done())
+		{
+			return;
+		}
+		bool measured = clockCycle > warmupCycle;
+		bool stalled = false;
+		BlSim::Prefetcher *prefetcher = prefetchers[id];
+
+		//retire up to the oldest read miss
+		uint64_t limit = missInstructions.empty() ? dispatched : std::min(dispatched, missInstructions.front());
+		uint64_t retiring = std::min((uint64_t) width, limit - retired);
+		retired += retiring;
+		if (measured)
+		{
+			instructions += retiring;
+			cycles++;
+		}
+
+		//dispatch the instructions up to the next record, then the record
+		unsigned slots = width;
+		while (slots > 0)
+		{
+			if (trans == NULL && !fetch(clockCycle))
+			{
+				break;
+			}
+			if (dispatched >= retired + robSize)
+			{
+				robStallCycles += measured;
+				break;
+			}
+			if (dispatched < instruction)
+			{
+				uint64_t n = std::min((uint64_t) slots, instruction - dispatched);
+				n = std::min(n, retired + robSize - dispatched);
+				dispatched += n;
+				slots -= n;
+				continue;
+			}
+
+			bool read = trans->transactionType == Transaction::DATA_READ;
+			uint64_t address = trans->address;
+			if (!transMissed && read && missInstructions.size() >= mshrCount && !cache->Holds(id, address))
+			{
+				mshrStallCycles += measured;
+				break;
+			}
+			bool hit = false;
+			bool waits = false;
+			if (!transMissed)
+			{
+				hit = cache->Access(id, address, cacheOperation(trans), clockCycle);
+				if (!hit && prefetcher != NULL
+						&& prefetcher->Demand(address, cacheOperation(trans), clockCycle))
+				{
+					//the prefetch may still be on its way
+					hit = true;
+					waits = read && transReceiver->readPending(address, id);
+				}
+			}
+			if (!hit)
+			{
+				if (!memorySystem->addTransaction(trans))
+				{
+					transMissed = true;
+					stalled = true;
+					memoryStallCycles += measured;
+					break;
+				}
+				transReceiver->addPending(trans, clockCycle, id);
+				trans = NULL;
+				transMissed = false;
+				waits = read;
+				readMisses += measured && read;
+			}
+			else
+			{
+				delete trans;
+				trans = NULL;
+			}
+			if (waits)
+			{
+				missInstructions.push_back(instruction);
+				missAddresses.push_back(address);
+			}
+			dispatched++;
+			slots--;
+		}
+
+		if (prefetcher != NULL && !stalled)
+		{
+			prefetcher->Issue(clockCycle);
+		}
+	}
+
+	void Core::readComplete(uint64_t address)
+	{
+		//a prefetch nothing waits for has no entry
+		for (size_t i = 0; i < missAddresses.size(); i++)
+		{
+			if (missAddresses[i] == address)
+			{
+				missAddresses.erase(missAddresses.begin() + i);
+				missInstructions.erase(missInstructions.begin() + i);
+				return;
+			}
+		}
+	}
+
+	void Core::printStats(std::ostream &out)
+	{
+		if (!closedLoop)
+		{
+			return;
+		}
+		double ipc = cycles == 0 ? 0.0 : (double) instructions / cycles;
+		out << "core " << id
+				<< "\tinstructions: " << instructions
+				<< "\tcycles: " << cycles
+				<< "\tIPC: " << ipc
+				<< "\tread misses: " << readMisses
+				<< "\tROB stalls: " << robStallCycles
+				<< "\tMSHR stalls: " << mshrStallCycles
+				<< "\tmemory stalls: " << memoryStallCycles << endl;
+	}
+
+	void Core::checkpoint(Checkpoint &cp)
+	{
+		cp.io(trans);
+		cp.io(transMissed);
+		cp.io(traceDone);
+		cp.io(instruction);
+		cp.io(nextInstruction);
+		cp.io(dispatched);
+		cp.io(retired);
+		cp.io(missInstructions);
+		cp.io(missAddresses);
+		cp.io(warmupCycle);
+		cp.io(instructions);
+		cp.io(cycles);
+		cp.io(readMisses);
+		cp.io(robStallCycles);
+		cp.io(mshrStallCycles);
+		cp.io(memoryStallCycles);
+	}
+}
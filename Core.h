@@ -0,0 +1,119 @@
+#ifndef CORE_H
+#define CORE_H
+
+//Core.h
+//
+//A core replays a trace through the cache path of the trace's source. With
+//CORE_MODEL=open_loop a single core issues the records of all the traces,
+//merged by time stamp, each at its time stamp, whatever the memory system
+//does.
+//
+//With CORE_MODEL=closed_loop every trace has its own core, and the time
+//stamps number the instructions: the
+//gap between two records is the instructions the core executes between the
+//two accesses (two records with the same stamp are two instructions apart by
+//one). The core dispatches and retires up to CORE_WIDTH instructions a cycle:
+//
+//  - a read that misses the caches holds one of CORE_MSHR miss registers until
+//    the memory system returns it; with all of them held, the next read that
+//    would miss waits
+//  - an instruction retires only after the read misses before it, so the
+//    core stops dispatching once CORE_ROB instructions wait behind the oldest
+//  - writes are posted, they only wait when the memory system refuses them
+//
+//The read completions come back through the TransactionReceiver. Memory
+//that is slower thus delays the later records, and the instructions per cycle
+//of the core measure it.
+//
+
+#include "SystemConfiguration.h"
+#include "SimulatorIO.h"
+#include "MemorySystem.h"
+#include "SimpleCache.h"
+#include "Prefetcher.h"
+#include "Sampler.h"
+#include "Checkpoint.h"
+#include <deque>
+#include <ostream>
+
+namespace DRAMSim
+{
+	class Core
+	{
+	public:
+		//prefetchers holds the prefetcher of every source (NULL for PREFETCHER=none)
+		Core(unsigned id, const Config &config, SimulatorIO *simIO, BlSim::CacheHierarchy *cache,
+				const std::vector<BlSim::Prefetcher*> &prefetchers, MemorySystem *memorySystem,
+				TransactionReceiver *transReceiver, Sampler *sampler);
+		~Core();
+
+		//false unless CORE_MODEL is 'open_loop' or 'closed_loop'
+		static bool validModel(const Config &config);
+		//the cache numbers its operations the other way round than the transactions
+		static uint32_t cacheOperation(const Transaction *t);
+
+		//one CPU cycle
+		void update(uint64_t clockCycle);
+		//a read this core added came back
+		void readComplete(uint64_t address);
+		//the whole trace was issued (and, closed loop, retired)
+		bool done() const;
+		//a record was fetched and is not in the memory system yet
+		bool holdsRecord() const
+		{
+			return trans != NULL;
+		}
+
+		void setWarmupCycle(uint64_t cycle)
+		{
+			warmupCycle = cycle;
+		}
+		void printStats(std::ostream &out);
+		void checkpoint(Checkpoint &cp);
+
+	private:
+		void replayOpenLoop(uint64_t clockCycle);
+		void replayClosedLoop(uint64_t clockCycle);
+		//the next record into trans; false at the end of the trace
+		bool fetch(uint64_t clockCycle);
+
+		unsigned id;
+		bool closedLoop;
+		unsigned width;
+		unsigned robSize;
+		unsigned mshrCount;
+
+		SimulatorIO *simIO;
+		BlSim::CacheHierarchy *cache;
+		const std::vector<BlSim::Prefetcher*> &prefetchers;
+		MemorySystem *memorySystem;
+		TransactionReceiver *transReceiver;
+		Sampler *sampler; //NULL unless SAMPLE_PERIOD is set
+
+		Transaction *trans; //the next record of the trace
+		bool transMissed; //trans missed the caches and waits for the memory system to take it
+		bool traceDone;
+
+		//closed loop
+		uint64_t instruction; //the number of the instruction trans is
+		uint64_t nextInstruction; //the lowest number the next record can have
+		uint64_t dispatched;
+		uint64_t retired;
+		std::deque<uint64_t> missInstructions; //read misses in flight, oldest first
+		std::deque<uint64_t> missAddresses;
+
+		//statistics, from the warmup cycle on
+		uint64_t warmupCycle;
+		uint64_t instructions;
+		uint64_t cycles;
+		uint64_t readMisses;
+		uint64_t robStallCycles;
+		uint64_t mshrStallCycles;
+		uint64_t memoryStallCycles;
+
+		Core(const Core &other);
+		Core &operator=(const Core &other);
+	};
+}
+
+#endif
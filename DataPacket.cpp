@@ -1,4 +1,6 @@
 #include "DataPacket.h"
+#include "BackingStore.h"
+#include "Checkpoint.h"
 #include <stdio.h>
 
 namespace DRAMSim
@@ -24,15 +26,27 @@ namespace DRAMSim
 		return os;
 	}
 
-	DataPacket::DataPacket() : _data(NULL), _numBytes(0), _unalignedAddr(0)	{}
+	DataPacket::DataPacket() : _data(NULL), _numBytes(0), _unalignedAddr(0), _ownsData(true), _store(NULL)	{}
 
 
 	DataPacket::DataPacket(byte *data, size_t numBytes, uint64_t unalignedAddr) :
-				_data(data), _numBytes(numBytes), _unalignedAddr(unalignedAddr)	{}
+				_data(data), _numBytes(numBytes), _unalignedAddr(unalignedAddr), _ownsData(true), _store(NULL)	{}
 
 	DataPacket::~DataPacket()
 	{
-		if (_data) free(_data);
+		release();
+	}
+
+	// let go of the current bytes, whoever owns them
+	void DataPacket::release()
+	{
+		if (_store != NULL)
+		{
+			_store->removeView(this);
+			_store = NULL;
+		}
+		if (_data && _ownsData) free(_data);
+		_data = NULL;
 	}
 
 	// accessors
@@ -53,18 +67,48 @@ namespace DRAMSim
 
 	void DataPacket::setData(byte *data, size_t size, bool copy)
 	{
-		if (_data) free(_data);
-
+		byte *newData = data;
 		if (copy == true)
 		{
-			_data = (byte *)calloc(size,sizeof(byte));
-			memcpy(_data, data, size);
+			newData = (byte *)calloc(size,sizeof(byte));
+			memcpy(newData, data, size);
+		}
+		// released last so that a view can be turned into a copy of itself
+		if (newData != _data)
+		{
+			release();
 		}
-		else
+		else if (_store != NULL)
 		{
-			_data = data;
+			_store->removeView(this);
+			_store = NULL;
 		}
+		_data = newData;
 		_numBytes = size;
+		_ownsData = true;
+	}
+
+	void DataPacket::setView(byte *data, size_t size, BackingStore *store)
+	{
+		release();
+		_data = data;
+		_numBytes = size;
+		_ownsData = false;
+		_store = store;
+		_store->addView(this);
+	}
+
+	void DataPacket::detach()
+	{
+		if (_data && !_ownsData)
+		{
+			setData(_data, _numBytes, true);
+		}
+	}
+
+	bool DataPacket::isView() const
+	{
+		return !_ownsData;
 	}
 
 	bool DataPacket::hasNoData() const
@@ -72,4 +116,38 @@ namespace DRAMSim
 		return (_data == NULL || _numBytes == 0);
 	}
 
+	void DataPacket::checkpoint(Checkpoint &cp)
+	{
+		bool view = !_ownsData && _data != NULL;
+		bool hasData = _data != NULL;
+		cp.io(_numBytes);
+		cp.io(_unalignedAddr);
+		cp.io(view);
+		cp.io(hasData);
+		if (view)
+		{
+			if (cp.isSaving())
+			{
+				cp.ioView(_data);
+				return;
+			}
+			//the restored packet is not registered with the store, so it keeps a copy
+			byte *data = NULL;
+			cp.ioView(data);
+			_data = NULL;
+			_store = NULL;
+			setData(data, _numBytes, true);
+			return;
+		}
+		if (!cp.isSaving())
+		{
+			_data = hasData ? (byte *)calloc(_numBytes + 1, sizeof(byte)) : NULL;
+			_ownsData = true;
+		}
+		if (hasData)
+		{
+			cp.bytes(_data, _numBytes);
+		}
+	}
+
 }
@@ -12,6 +12,8 @@
 using std::ostream;
 namespace DRAMSim
 {
+	class Checkpoint;
+	class BackingStore;
 
 	class DataPacket
 	{
@@ -25,16 +27,27 @@ namespace DRAMSim
 		size_t getNumSubarray() const;
 		byte *getData() const;
 		void setData(byte *data, size_t size, bool copy = false);
+		// point at bytes of a backing store row; the store detaches the view
+		// before it changes the row, so the packet keeps what was read
+		void setView(byte *data, size_t size, BackingStore *store);
+		bool isView() const;
+		// turn a view into a copy of its bytes
+		void detach();
 		bool hasNoData() const;
+		//a view comes back as a copy of the same bytes of the restored backing store
+		void checkpoint(Checkpoint &cp);
 
 		friend ostream &operator<<(ostream &os, const DataPacket &dp);
 
 	private:
 		// Disable copying for a datapacket
 		DataPacket(const DataPacket &other);
+		void release();
 		byte *_data;
 		size_t _numBytes;
 		uint64_t _unalignedAddr;
+		bool _ownsData;
+		BackingStore *_store; //the store a view is registered with
 	};
 
 
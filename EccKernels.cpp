@@ -0,0 +1,273 @@
+//EccKernels.cpp
+//
+//SECDED and chipkill kernels. The Hamming check masks are derived once from
+//the same enumeration of data bit positions the bit-serial encoder used, then
+//every check bit is the parity (popcount & 1) of the 64 bit data word ANDed
+//with its mask. The syndrome of a word indexes a 128 entry table that names
+//the bit to flip.
+//
+
+#include "EccKernels.h"
+#include <string.h>
+
+namespace DRAMSim
+{
+	#define SECDED_CHECK_BITS 7
+	#define SECDED_PARITY_BIT (SECDED_CODE_BITS - 1)
+	#define SECDED_NO_BIT -1
+	#define POSITION_REVISE(i) ((1 << (i)) - (i) - 2)
+
+	struct SecdedTables
+	{
+		//data words are loaded big endian, so data bit i is bit 63-i of the word
+		uint64_t checkMask[SECDED_CHECK_BITS];
+		//syndrome -> codeword bit to flip, SECDED_NO_BIT when no single bit error has it
+		int syndromeBit[1 << SECDED_CHECK_BITS];
+		//check byte layout: check bit k is stored at codeword bit 64+k, MSB first
+		byte reverse[256];
+
+		SecdedTables()
+		{
+			unsigned column[64];
+			memset(column, 0, sizeof(column));
+			memset(checkMask, 0, sizeof(checkMask));
+
+			//walk the data positions covered by each check bit, skipping the
+			//positions taken by the check bits themselves; data bit i ends up
+			//at Hamming position column[i], the last one at 71
+			for (int iCheck = 0; iCheck < SECDED_CHECK_BITS; iCheck++)
+			{
+				int checkBitCounter = (iCheck == 0) ? 2 : (iCheck + 1);
+				int positionIncrement = 1 << iCheck;
+				int iCounter = 1;
+				int iData = POSITION_REVISE(iCheck) + iCounter;
+				while (iData < 64)
+				{
+					column[iData] |= 1 << iCheck;
+					iData++;
+					iCounter++;
+					if (iCounter % positionIncrement == 0)
+					{
+						iData += positionIncrement;
+						iCounter = 0;
+					}
+					while (iData > POSITION_REVISE(checkBitCounter))
+					{
+						checkBitCounter++;
+						iData--;
+					}
+				}
+			}
+
+			for (int i = 0; i < (1 << SECDED_CHECK_BITS); i++)
+			{
+				syndromeBit[i] = SECDED_NO_BIT;
+			}
+			for (int iData = 0; iData < 64; iData++)
+			{
+				for (int iCheck = 0; iCheck < SECDED_CHECK_BITS; iCheck++)
+				{
+					if (column[iData] & (1 << iCheck))
+					{
+						checkMask[iCheck] |= 1ULL << (63 - iData);
+					}
+				}
+				if (column[iData] != 0)
+				{
+					syndromeBit[column[iData]] = iData;
+				}
+			}
+			for (int iCheck = 0; iCheck < SECDED_CHECK_BITS; iCheck++)
+			{
+				syndromeBit[1 << iCheck] = 64 + iCheck;
+			}
+
+			for (int v = 0; v < 256; v++)
+			{
+				byte r = 0;
+				for (int b = 0; b < 8; b++)
+				{
+					if (v & (1 << b))
+					{
+						r |= 0x80 >> b;
+					}
+				}
+				reverse[v] = r;
+			}
+		}
+	};
+
+	static const SecdedTables &secdedTables()
+	{
+		static const SecdedTables tables;
+		return tables;
+	}
+
+	static inline uint64_t loadBigEndian64(const byte *p)
+	{
+		uint64_t v;
+		memcpy(&v, p, sizeof(v));
+		return __builtin_bswap64(v);
+	}
+
+	//check bits 0..6 of a data word, check bit k in bit k
+	static inline unsigned checkBits(const SecdedTables &t, uint64_t word)
+	{
+		unsigned c = 0;
+		for (int k = 0; k < SECDED_CHECK_BITS; k++)
+		{
+			c |= (unsigned)__builtin_parityll(word & t.checkMask[k]) << k;
+		}
+		return c;
+	}
+
+	void secdedEncode(const byte *plain, byte *coded, size_t numWords)
+	{
+		const SecdedTables &t = secdedTables();
+		for (size_t w = 0; w < numWords; w++)
+		{
+			const byte *in = plain + w * SECDED_DATA_BYTES;
+			byte *out = coded + w * SECDED_CODE_BYTES;
+			uint64_t word = loadBigEndian64(in);
+			unsigned c = checkBits(t, word);
+			//overall parity covers the data and the check bits
+			unsigned p = __builtin_parityll(word) ^ __builtin_parity(c);
+			memcpy(out, in, SECDED_DATA_BYTES);
+			out[SECDED_DATA_BYTES] = t.reverse[c | (p << SECDED_CHECK_BITS)];
+		}
+	}
+
+	void secdedDecode(const byte *coded, byte *plain, size_t numWords)
+	{
+		for (size_t w = 0; w < numWords; w++)
+		{
+			memcpy(plain + w * SECDED_DATA_BYTES, coded + w * SECDED_CODE_BYTES, SECDED_DATA_BYTES);
+		}
+	}
+
+	void secdedCheck(byte *coded, size_t numWords, bool correct, unsigned &corrected, unsigned &uncorrectable)
+	{
+		const SecdedTables &t = secdedTables();
+		for (size_t w = 0; w < numWords; w++)
+		{
+			byte *code = coded + w * SECDED_CODE_BYTES;
+			uint64_t word = loadBigEndian64(code);
+			unsigned stored = t.reverse[code[SECDED_DATA_BYTES]];
+			unsigned syndrome = (checkBits(t, word) ^ stored) & ((1 << SECDED_CHECK_BITS) - 1);
+			//parity of the whole codeword, 0 for a valid one
+			unsigned parity = __builtin_parityll(word) ^ __builtin_parity(stored);
+
+			if (syndrome == 0 && parity == 0)
+			{
+				continue;
+			}
+			if (parity == 0)
+			{
+				//even number of flipped bits
+				uncorrectable++;
+				continue;
+			}
+
+			int errorBit = (syndrome == 0) ? SECDED_PARITY_BIT : t.syndromeBit[syndrome];
+			if (errorBit == SECDED_NO_BIT)
+			{
+				//odd number of flips that looks like no single bit error
+				uncorrectable++;
+				continue;
+			}
+			corrected++;
+			if (correct)
+			{
+				code[errorBit / 8] ^= 0x80 >> (errorBit % 8);
+			}
+		}
+	}
+
+	//transpose an 8x8 bit matrix, row r in byte 7-r of x, column c in bit 7-c of a row
+	static inline uint64_t transpose8(uint64_t x)
+	{
+		uint64_t t;
+		t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+		x = x ^ t ^ (t << 7);
+		t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+		x = x ^ t ^ (t << 14);
+		t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+		x = x ^ t ^ (t << 28);
+		return x;
+	}
+
+	//OR the top 'width' bits of v into buf at bit offset 'offset'
+	static inline void insertBits(byte *buf, size_t numBytes, size_t offset, byte v, unsigned width)
+	{
+		size_t index = offset / 8;
+		unsigned shift = offset % 8;
+		unsigned window = (unsigned)v << (8 - shift);
+		buf[index] |= window >> 8;
+		if (shift + width > 8 && index + 1 < numBytes)
+		{
+			buf[index + 1] |= window & 0xff;
+		}
+	}
+
+	//the 'width' bits of buf at bit offset 'offset', in the top bits of the result
+	static inline byte extractBits(const byte *buf, size_t numBytes, size_t offset, unsigned width)
+	{
+		size_t index = offset / 8;
+		unsigned shift = offset % 8;
+		unsigned window = (unsigned)buf[index] << 8;
+		if (index + 1 < numBytes)
+		{
+			window |= buf[index + 1];
+		}
+		return (byte)((window << shift) >> 8) & (byte)(0xff << (8 - width));
+	}
+
+	//Both directions work on blocks of 8 words x 8 bits: bits b of words
+	//8g..8g+7 in the ECC layout are the bits 8g..8g+7 of chipkill row b.
+	void chipkillInterleave(const byte *ecc, byte *chipkill, unsigned deviceWidth, size_t numBits)
+	{
+		size_t numBytes = numBits / 8;
+		memset(chipkill, 0, numBytes);
+		for (unsigned g = 0; g < deviceWidth; g += 8)
+		{
+			unsigned width = (deviceWidth - g < 8) ? (deviceWidth - g) : 8;
+			for (unsigned c = 0; c < SECDED_CODE_BYTES; c++)
+			{
+				uint64_t x = 0;
+				for (unsigned r = 0; r < width; r++)
+				{
+					x |= (uint64_t)ecc[(g + r) * SECDED_CODE_BYTES + c] << (56 - 8 * r);
+				}
+				x = transpose8(x);
+				for (unsigned b = 0; b < 8; b++)
+				{
+					byte row = (byte)(x >> (56 - 8 * b));
+					insertBits(chipkill, numBytes, (size_t)(c * 8 + b) * deviceWidth + g, row, width);
+				}
+			}
+		}
+	}
+
+	void chipkillDeinterleave(const byte *chipkill, byte *ecc, unsigned deviceWidth, size_t numBits)
+	{
+		size_t numBytes = numBits / 8;
+		memset(ecc, 0, numBytes);
+		for (unsigned g = 0; g < deviceWidth; g += 8)
+		{
+			unsigned width = (deviceWidth - g < 8) ? (deviceWidth - g) : 8;
+			for (unsigned c = 0; c < SECDED_CODE_BYTES; c++)
+			{
+				uint64_t x = 0;
+				for (unsigned b = 0; b < 8; b++)
+				{
+					x |= (uint64_t)extractBits(chipkill, numBytes, (size_t)(c * 8 + b) * deviceWidth + g, width) << (56 - 8 * b);
+				}
+				x = transpose8(x);
+				for (unsigned r = 0; r < width; r++)
+				{
+					ecc[(g + r) * SECDED_CODE_BYTES + c] = (byte)(x >> (56 - 8 * r));
+				}
+			}
+		}
+	}
+}
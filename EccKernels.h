@@ -0,0 +1,43 @@
+#ifndef ECCKERNELS_H
+#define ECCKERNELS_H
+
+//EccKernels.h
+//
+//Table driven kernels behind BusPacket's DATA_RELIABILITY_ECC path.
+//
+//SECDED: every 64 bit data word is stored as 72 bits, the 8 data bytes
+//followed by one check byte (7 Hamming check bits, then the overall parity
+//bit). Bits are numbered MSB first within a byte, as everywhere in BusPacket.
+//The check bits are the parity of fixed subsets of the data bits, so they are
+//computed by XOR-ing one precomputed table entry per data byte.
+//
+//Chipkill: the ECC words are interleaved across the devices; bit i of word w
+//(w < deviceWidth) goes to bit i*deviceWidth + w, i.e. the deviceWidth x 72
+//bit matrix of the first deviceWidth words is transposed. This is done with
+//8x8 bit transposes held in a 64 bit register.
+//
+
+#include "SystemConfiguration.h"
+
+namespace DRAMSim
+{
+	#define SECDED_DATA_BYTES 8
+	#define SECDED_CODE_BYTES 9
+	#define SECDED_CODE_BITS (SECDED_CODE_BYTES*8)
+
+	//plain: numWords*8 bytes, coded: numWords*9 bytes
+	void secdedEncode(const byte *plain, byte *coded, size_t numWords);
+	void secdedDecode(const byte *coded, byte *plain, size_t numWords);
+
+	//check every word of coded; with correct set, words with a single bit
+	//error are repaired in place. Words with a single bit error are counted
+	//in corrected (whether or not they were repaired), words with a double
+	//(or detectable multi-bit) error in uncorrectable.
+	void secdedCheck(byte *coded, size_t numWords, bool correct, unsigned &corrected, unsigned &uncorrectable);
+
+	//numBits is the size of both buffers; bits outside the deviceWidth x 72 matrix are cleared
+	void chipkillInterleave(const byte *ecc, byte *chipkill, unsigned deviceWidth, size_t numBits);
+	void chipkillDeinterleave(const byte *chipkill, byte *ecc, unsigned deviceWidth, size_t numBits);
+}
+
+#endif
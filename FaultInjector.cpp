@@ -0,0 +1,155 @@
+//FaultInjector.cpp
+//
+//Seeded write, drift and bus bit error injection
+//
+
+#include "FaultInjector.h"
+#include "Checkpoint.h"
+#include <math.h>
+
+namespace DRAMSim
+{
+	static uint64_t splitmix64(uint64_t &state)
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	bool FaultInjector::enabled(const Config &config)
+	{
+		return config.FAULT_WRITE_BER > 0 || config.FAULT_DRIFT_BER > 0 || config.FAULT_BUS_BER > 0;
+	}
+
+	FaultInjector::FaultInjector(const Config &config, ClockDomain *clockDomainDRAM, unsigned channel) :
+		writeFaultsPerBank(config.NUM_RANKS * config.NUM_BANKS, 0),
+		driftFaultsPerBank(config.NUM_RANKS * config.NUM_BANKS, 0),
+		busFaultsPerBank(config.NUM_RANKS * config.NUM_BANKS, 0),
+		config(config),
+		clockDomainDRAM(clockDomainDRAM),
+		linesPerRow(config.NUM_COLS / config.BL)
+	{
+		if (config.FAULT_WRITE_BER < 0 || config.FAULT_WRITE_BER > 1 || config.FAULT_BUS_BER < 0 || config.FAULT_BUS_BER > 1 || config.FAULT_DRIFT_BER < 0)
+		{
+			ERROR("Fault rates must not be negative and bit error rates not above 1");
+			exit(-1);
+		}
+		//every channel gets its own stream so results do not depend on the interleaving
+		rngState = (uint64_t)config.FAULT_SEED * 0x100000001B3ULL + channel;
+		writeSkip = geometric(config.FAULT_WRITE_BER);
+		busSkip = geometric(config.FAULT_BUS_BER);
+	}
+
+	double FaultInjector::uniform()
+	{
+		//53 random bits, in (0,1]
+		return ((splitmix64(rngState) >> 11) + 1) * (1.0 / 9007199254740992.0);
+	}
+
+	uint64_t FaultInjector::geometric(double p)
+	{
+		if (p <= 0)
+		{
+			return UINT64_MAX;
+		}
+		if (p >= 1)
+		{
+			return 0;
+		}
+		double skip = floor(log(uniform()) / log1p(-p));
+		return skip >= 1.8e19 ? UINT64_MAX : (uint64_t)skip;
+	}
+
+	unsigned FaultInjector::inject(byte *data, size_t numBytes, double p, uint64_t &skip)
+	{
+		uint64_t bits = (uint64_t)numBytes * 8;
+		uint64_t pos = 0;
+		unsigned flips = 0;
+		while (skip < bits - pos)
+		{
+			pos += skip;
+			data[pos / 8] ^= 0x80 >> (pos % 8);
+			flips++;
+			pos++;
+			skip = geometric(p);
+		}
+		if (skip != UINT64_MAX)
+		{
+			skip -= bits - pos;
+		}
+		return flips;
+	}
+
+	void FaultInjector::programmed(uint64_t storeRow, unsigned column, byte *cells, size_t numBytes)
+	{
+		unsigned bank = storeRow / config.NUM_ROWS;
+		if (config.FAULT_WRITE_BER > 0)
+		{
+			writeFaultsPerBank[bank] += inject(cells, numBytes, config.FAULT_WRITE_BER, writeSkip);
+		}
+		if (config.FAULT_DRIFT_BER > 0)
+		{
+			//freshly programmed cells start drifting from now
+			driftedUntil[lineKey(storeRow, column)] = clockDomainDRAM->clockcycle;
+		}
+	}
+
+	void FaultInjector::drift(uint64_t storeRow, unsigned column, byte *cells, size_t numBytes)
+	{
+		if (config.FAULT_DRIFT_BER <= 0)
+		{
+			return;
+		}
+		uint64_t now = clockDomainDRAM->clockcycle;
+		//lines that were never written have been drifting since the start
+		uint64_t &since = driftedUntil[lineKey(storeRow, column)];
+		if (now <= since)
+		{
+			return;
+		}
+		double seconds = (now - since) * config.tCK * 1E-9;
+		since = now;
+
+		//P(a cell drifts within t) = 1 - exp(-rate * t); drift does not undo itself
+		double p = -expm1(-(double)config.FAULT_DRIFT_BER * seconds);
+		uint64_t skip = geometric(p);
+		driftFaultsPerBank[storeRow / config.NUM_ROWS] += inject(cells, numBytes, p, skip);
+	}
+
+	void FaultInjector::transfer(unsigned bank, byte *data, size_t numBytes)
+	{
+		if (config.FAULT_BUS_BER > 0)
+		{
+			busFaultsPerBank[bank] += inject(data, numBytes, config.FAULT_BUS_BER, busSkip);
+		}
+	}
+
+	void FaultInjector::printStats()
+	{
+		uint64_t writeFaults = 0, driftFaults = 0, busFaults = 0;
+		for (size_t i = 0; i < writeFaultsPerBank.size(); i++)
+		{
+			writeFaults += writeFaultsPerBank[i];
+			driftFaults += driftFaultsPerBank[i];
+			busFaults += busFaultsPerBank[i];
+		}
+		PRINT(" --- Fault injection (seed " << config.FAULT_SEED << ")");
+		PRINT("    injected bit errors : write " << writeFaults << "  drift " << driftFaults << "  bus " << busFaults);
+		if (config.FAULT_DRIFT_BER > 0)
+		{
+			PRINT("    lines tracked for drift : " << driftedUntil.size());
+		}
+	}
+
+	void FaultInjector::checkpoint(Checkpoint &cp)
+	{
+		cp.io(rngState);
+		cp.io(writeSkip);
+		cp.io(busSkip);
+		cp.io(driftedUntil);
+		cp.io(writeFaultsPerBank);
+		cp.io(driftFaultsPerBank);
+		cp.io(busFaultsPerBank);
+	}
+}
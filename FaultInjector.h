@@ -0,0 +1,77 @@
+#ifndef FAULTINJECTOR_H
+#define FAULTINJECTOR_H
+
+//FaultInjector.h
+//
+//Seeded bit error injection for DATA_STORAGE builds, one per channel. Three
+//kinds of errors are modeled, each with an independent per-bit probability:
+//
+//  write errors : a cell is programmed to the wrong value (FAULT_WRITE_BER
+//                 per written bit); the error stays in the stored row
+//  drift errors : a stored cell drifts across the read threshold; the
+//                 probability grows with the time since the line was last
+//                 programmed (FAULT_DRIFT_BER per bit per second). The error
+//                 stays until the line is rewritten or scrubbed
+//  bus errors   : a bit of a burst is flipped on the data bus
+//                 (FAULT_BUS_BER per transferred bit), in both directions
+//
+//Instead of drawing a random number per bit, the distance to the next faulty
+//bit is drawn from the geometric distribution, so the cost is per fault, not
+//per bit. The controller only creates an injector when one of the rates is
+//non-zero, otherwise the hooks are a NULL check.
+//
+
+#include "SystemConfiguration.h"
+#include "ClockDomain.h"
+#include <map>
+#include <vector>
+
+namespace DRAMSim
+{
+	class Checkpoint;
+
+	class FaultInjector
+	{
+	public:
+		FaultInjector(const Config &config, ClockDomain *clockDomainDRAM, unsigned channel);
+
+		//false when every rate of this config is zero
+		static bool enabled(const Config &config);
+
+		//the line 'column' of backing store row 'storeRow' was just programmed
+		void programmed(uint64_t storeRow, unsigned column, byte *cells, size_t numBytes);
+		//let the line drift up to now (before it is read or scrubbed)
+		void drift(uint64_t storeRow, unsigned column, byte *cells, size_t numBytes);
+		//a burst of bank 'bank' (rank*NUM_BANKS+bank) crosses the data bus
+		void transfer(unsigned bank, byte *data, size_t numBytes);
+
+		void printStats();
+		void checkpoint(Checkpoint &cp);
+
+		std::vector<uint64_t> writeFaultsPerBank;
+		std::vector<uint64_t> driftFaultsPerBank;
+		std::vector<uint64_t> busFaultsPerBank;
+
+	private:
+		double uniform();
+		//bits to skip before the next fault at probability p
+		uint64_t geometric(double p);
+		//flip bits of data at the given rate; skip carries the distance to the next fault across calls
+		unsigned inject(byte *data, size_t numBytes, double p, uint64_t &skip);
+		uint64_t lineKey(uint64_t storeRow, unsigned column) const
+		{
+			return storeRow * linesPerRow + column;
+		}
+
+		const Config &config;
+		ClockDomain *clockDomainDRAM;
+		uint64_t rngState;
+		uint64_t writeSkip;
+		uint64_t busSkip;
+		uint64_t linesPerRow;
+		//clock cycle up to which each line's drift has been applied
+		std::map<uint64_t, uint64_t> driftedUntil;
+	};
+}
+
+#endif
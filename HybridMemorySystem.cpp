@@ -0,0 +1,659 @@
+//HybridMemorySystem.cpp
+//
+//DRAM cache tier + PCM tier
+//
+
+#include "HybridMemorySystem.h"
+#include "Simulator.h"
+#include "Checkpoint.h"
+#include <math.h>
+
+namespace DRAMSim
+{
+	HybridMemorySystem::HybridMemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM,
+			const string &workingDirectory) :
+		MemorySystem(cfg, clockDomainCPU, clockDomainDRAM, NoChannels()),
+		dramTime(0),
+		useCounter(0),
+		readHits(0),
+		readMisses(0),
+		writeHits(0),
+		writeMisses(0),
+		tagProbes(0),
+		fills(0),
+		fillLines(0),
+		writebacks(0),
+		writebackLines(0)
+	{
+		//the hybrid keys come from the simulator's (PCM) system ini
+		string cacheDevice = config.HYBRID_CACHE_DEVICE;
+		string cacheSystem = config.HYBRID_CACHE_SYSTEM;
+		unsigned cacheMegs = config.HYBRID_CACHE_MEGS;
+		assoc = config.HYBRID_CACHE_ASSOC;
+		blockBytes = config.HYBRID_CACHE_BLOCK_BYTES;
+
+		if (config.HYBRID_TAG_STORE == "sram")
+		{
+			tagsInDRAM = false;
+		}
+		else if (config.HYBRID_TAG_STORE == "dram")
+		{
+			tagsInDRAM = true;
+		}
+		else
+		{
+			ERROR("Unknown HYBRID_TAG_STORE '"<<config.HYBRID_TAG_STORE<<"'; valid options are 'sram' or 'dram'");
+			exit(-1);
+		}
+		if (config.HYBRID_FILL_POLICY == "read_miss")
+		{
+			writeAllocate = false;
+		}
+		else if (config.HYBRID_FILL_POLICY == "all_miss")
+		{
+			writeAllocate = true;
+		}
+		else
+		{
+			ERROR("Unknown HYBRID_FILL_POLICY '"<<config.HYBRID_FILL_POLICY<<"'; valid options are 'read_miss' or 'all_miss'");
+			exit(-1);
+		}
+		if (config.HYBRID_WRITE_POLICY == "write_back")
+		{
+			writeThrough = false;
+		}
+		else if (config.HYBRID_WRITE_POLICY == "write_through")
+		{
+			writeThrough = true;
+		}
+		else
+		{
+			ERROR("Unknown HYBRID_WRITE_POLICY '"<<config.HYBRID_WRITE_POLICY<<"'; valid options are 'write_back' or 'write_through'");
+			exit(-1);
+		}
+
+		if (workingDirectory.length() > 0 && cacheDevice[0] != '/')
+		{
+			cacheDevice = workingDirectory + "/" + cacheDevice;
+		}
+		if (workingDirectory.length() > 0 && cacheSystem.length() > 0 && cacheSystem[0] != '/')
+		{
+			cacheSystem = workingDirectory + "/" + cacheSystem;
+		}
+
+		PRINT("== PCM tier ==");
+		pcm.memory = new MemorySystem(config, clockDomainCPU, clockDomainDRAM);
+		pcm.clock = clockDomainDRAM;
+		lineBytes = pcm.memory->config.TRANS_DATA_BYTES;
+		//the requests the hybrid takes are lines of the PCM tier
+		config.TRANS_DATA_BYTES = lineBytes;
+		pcmPeriod = (uint64_t)llround(config.tCK * 1000);
+
+		//the DRAM tier starts from the PCM parameters
+		PRINT("== DRAM cache tier ("<<cacheDevice<<") ==");
+		Config dramConfig = config;
+		IniReader dramIni(dramConfig);
+		dramIni.ReadIniFile(cacheDevice, IniReader::DEV_INI);
+		if (cacheSystem.length() > 0)
+		{
+			dramIni.ReadIniFile(cacheSystem, IniReader::SYS_INI);
+		}
+		else
+		{
+			dramIni.KeepKeys(IniReader::SYS_PARAM);
+		}
+		if (!dramIni.CheckIfAllSet())
+		{
+			exit(-1);
+		}
+		dramIni.InitEnumsFromStrings();
+		if (cacheSystem.length() == 0)
+		{
+			//same system ini as the PCM tier, without the PCM only features
+			dramConfig.SET_IDLE = false;
+			dramConfig.DATA_COMPARE_WRITE = false;
+			dramConfig.FLIP_N_WRITE = false;
+			dramConfig.TRACK_WEAR = false;
+			dramConfig.wearLevelingScheme = NoWearLeveling;
+		}
+		dram.clock = new ClockDomain(NULL);
+		dram.memory = new MemorySystem(dramConfig, clockDomainCPU, dram.clock);
+		const Config &dramTier = dram.memory->config;
+		dramPeriod = (uint64_t)llround(dramTier.tCK * 1000);
+		uint64_t dramBytes = (dramTier.TOTAL_STORAGE * dramTier.NUM_CHANS) << 20;
+		if (dramTier.TRANS_DATA_BYTES != lineBytes)
+		{
+			ERROR("The DRAM tier moves "<<dramTier.TRANS_DATA_BYTES<<" bytes per transaction but the PCM tier "<<lineBytes);
+			exit(-1);
+		}
+
+		if (cacheMegs != 0)
+		{
+			if (((uint64_t)cacheMegs << 20) > dramBytes)
+			{
+				ERROR("HYBRID_CACHE_MEGS="<<cacheMegs<<" is more than the DRAM tier holds ("<<(dramBytes >> 20)<<"MB)");
+				exit(-1);
+			}
+			dramBytes = (uint64_t)cacheMegs << 20;
+		}
+		if (assoc == 0 || blockBytes < lineBytes || blockBytes % lineBytes != 0 || dramBytes < (uint64_t)blockBytes * assoc)
+		{
+			ERROR("Bad hybrid cache organization: "<<assoc<<" ways of "<<blockBytes<<" byte blocks ("<<lineBytes<<" byte lines) in "<<(dramBytes >> 20)<<"MB");
+			exit(-1);
+		}
+		numSets = dramBytes / ((uint64_t)blockBytes * assoc);
+		Way invalid = {0, false, false, 0};
+		tags = vector<Way>(numSets * assoc, invalid);
+
+		pcm.memory->registerCallbacks(
+				new CallbackP3<Tier, void, unsigned, uint64_t, uint64_t>(&pcm, &Tier::readDone),
+				new CallbackP3<Tier, void, unsigned, uint64_t, uint64_t>(&pcm, &Tier::writeDone), NULL);
+		dram.memory->registerCallbacks(
+				new CallbackP3<Tier, void, unsigned, uint64_t, uint64_t>(&dram, &Tier::readDone),
+				new CallbackP3<Tier, void, unsigned, uint64_t, uint64_t>(&dram, &Tier::writeDone), NULL);
+
+		PRINT("Hybrid memory: "<<(dramBytes >> 20)<<"MB DRAM cache, "<<numSets<<" sets x "<<assoc<<" ways x "<<blockBytes
+				<<"B blocks, tags in "<<config.HYBRID_TAG_STORE<<", fill on "<<config.HYBRID_FILL_POLICY<<", "<<config.HYBRID_WRITE_POLICY);
+	}
+
+	HybridMemorySystem::~HybridMemorySystem()
+	{
+		delete dram.memory;
+		delete dram.clock;
+		delete pcm.memory;
+	}
+
+	void HybridMemorySystem::Tier::readDone(unsigned id, uint64_t address, uint64_t cycle)
+	{
+		map<uint64_t, list<Op> >::iterator it = reads.find(address);
+		if (it == reads.end())
+		{
+			return;
+		}
+		done.push_back(it->second.front());
+		it->second.pop_front();
+		if (it->second.empty())
+		{
+			reads.erase(it);
+		}
+	}
+
+	void HybridMemorySystem::Tier::writeDone(unsigned id, uint64_t address, uint64_t cycle)
+	{
+		//writes the tier makes on its own (wear leveling) are not ours
+		map<uint64_t, list<Op> >::iterator it = writes.find(address);
+		if (it == writes.end())
+		{
+			return;
+		}
+		done.push_back(it->second.front());
+		it->second.pop_front();
+		if (it->second.empty())
+		{
+			writes.erase(it);
+		}
+	}
+
+	bool HybridMemorySystem::addTransaction(Transaction *trans)
+	{
+		trans->alignAddress(lineBytes);
+		incoming.push_back(trans);
+		return true;
+	}
+
+	bool HybridMemorySystem::addTransaction(bool isWrite, uint64_t addr)
+	{
+		Transaction::TransactionType type = isWrite ? Transaction::DATA_WRITE : Transaction::DATA_READ;
+		return addTransaction(new Transaction(type,addr,NULL,LEN_DEF,clockDomainCPU->clockcycle));
+	}
+
+	bool HybridMemorySystem::willAcceptTransaction()
+	{
+		return incoming.size() < config.TRANS_QUEUE_DEPTH
+			&& dram.memory->pendingCount() < config.TRANS_QUEUE_DEPTH
+			&& pcm.memory->pendingCount() < config.TRANS_QUEUE_DEPTH;
+	}
+
+	bool HybridMemorySystem::willAcceptTransaction(uint64_t addr)
+	{
+		return willAcceptTransaction();
+	}
+
+	void HybridMemorySystem::update()
+	{
+		pcm.memory->update();
+		for (dramTime += pcmPeriod; dramTime >= dramPeriod; dramTime -= dramPeriod)
+		{
+			dram.memory->update();
+			dram.clock->clockcycle++;
+		}
+
+		while (!dram.done.empty())
+		{
+			handle(dram, dram.done.front());
+			dram.done.pop_front();
+		}
+		while (!pcm.done.empty())
+		{
+			handle(pcm, pcm.done.front());
+			pcm.done.pop_front();
+		}
+
+		//one tag lookup per cycle
+		if (!incoming.empty())
+		{
+			Transaction *trans = incoming.front();
+			incoming.pop_front();
+			access(trans, false);
+		}
+
+		Tier *tiers[] = {&dram, &pcm};
+		for (size_t i=0; i<2; i++)
+		{
+			if (tiers[i]->outgoing.empty())
+			{
+				continue;
+			}
+			//a tier with a full pending queue takes the rest in a later cycle
+			while (!tiers[i]->outgoing.empty()
+					&& tiers[i]->memory->addTransaction(tiers[i]->outgoing.front()))
+			{
+				tiers[i]->outgoing.pop_front();
+			}
+		}
+	}
+
+	void HybridMemorySystem::issue(Tier &tier, Transaction::TransactionType type, uint64_t tierAddress, DataPacket *data, const Op &op)
+	{
+		Transaction *trans = new Transaction(type, tierAddress, data, LEN_DEF, clockDomainCPU->clockcycle);
+		trans->alignAddress(lineBytes);
+		if (type == Transaction::DATA_READ)
+		{
+			tier.reads[trans->address].push_back(op);
+		}
+		else
+		{
+			tier.writes[trans->address].push_back(op);
+		}
+		tier.outgoing.push_back(trans);
+	}
+
+	uint64_t HybridMemorySystem::cacheAddress(unsigned set, unsigned way, uint64_t address) const
+	{
+		return ((uint64_t)set * assoc + way) * blockBytes + address % blockBytes;
+	}
+
+	HybridMemorySystem::Way *HybridMemorySystem::lookup(uint64_t address, unsigned &set, unsigned &way)
+	{
+		uint64_t block = address / blockBytes;
+		set = block % numSets;
+		uint64_t tag = block / numSets;
+		for (way=0; way<assoc; way++)
+		{
+			Way &w = tags[set * assoc + way];
+			if (w.valid && w.tag == tag)
+			{
+				return &w;
+			}
+		}
+		return NULL;
+	}
+
+	//an invalid way, otherwise the least recently used one
+	unsigned HybridMemorySystem::victimWay(unsigned set) const
+	{
+		unsigned way = 0;
+		for (unsigned i=0; i<assoc; i++)
+		{
+			const Way &w = tags[set * assoc + i];
+			if (!w.valid)
+			{
+				return i;
+			}
+			if (w.lastUse < tags[set * assoc + way].lastUse)
+			{
+				way = i;
+			}
+		}
+		return way;
+	}
+
+	//make room for the block of address (LRU), write back the victim and
+	//fetch the rest of the block from PCM; returns the way
+	unsigned HybridMemorySystem::allocate(uint64_t address, bool withDemandLine, bool dirty)
+	{
+		uint64_t block = address / blockBytes;
+		unsigned set = block % numSets;
+		unsigned way = victimWay(set);
+
+		Way &victim = tags[set * assoc + way];
+		if (victim.valid && victim.dirty)
+		{
+			writebacks++;
+			uint64_t victimBase = (victim.tag * numSets + set) * blockBytes;
+			for (uint64_t offset=0; offset<blockBytes; offset+=lineBytes)
+			{
+				Op op = {WritebackRead, victimBase + offset, NULL};
+				issue(dram, Transaction::DATA_READ, cacheAddress(set, way, victimBase + offset), NULL, op);
+				writebackLines++;
+			}
+		}
+
+		victim.tag = block / numSets;
+		victim.valid = true;
+		victim.dirty = dirty;
+		victim.lastUse = ++useCounter;
+		fills++;
+
+		uint64_t blockBase = block * blockBytes;
+		uint64_t demandLine = address - address % lineBytes;
+		for (uint64_t offset=0; offset<blockBytes; offset+=lineBytes)
+		{
+			if (blockBase + offset == demandLine)
+			{
+				if (withDemandLine)
+				{
+					Op op = {MigrationWrite, demandLine, NULL};
+					issue(dram, Transaction::DATA_WRITE, cacheAddress(set, way, demandLine), NULL, op);
+					fillLines++;
+				}
+				continue;
+			}
+			Op op = {FillRead, blockBase + offset, NULL};
+			issue(pcm, Transaction::DATA_READ, blockBase + offset, NULL, op);
+			fillLines++;
+		}
+		return way;
+	}
+
+	//the tag store follows the request like access() would, and each tier sees
+	//the accesses it would get; nothing is issued and no statistic counts it.
+	//A fill only touches the row of the demand line, a writeback the row of the
+	//victim's first line
+	void HybridMemorySystem::functionalAccess(bool isWrite, uint64_t addr)
+	{
+		uint64_t address = addr - addr % lineBytes;
+		unsigned set, way;
+		Way *w = lookup(address, set, way);
+		if (w != NULL)
+		{
+			w->lastUse = ++useCounter;
+			w->dirty = w->dirty || (isWrite && !writeThrough);
+		}
+		else if (!isWrite || writeAllocate)
+		{
+			uint64_t block = address / blockBytes;
+			way = victimWay(set);
+			w = &tags[set * assoc + way];
+			if (w->valid && w->dirty)
+			{
+				pcm.memory->functionalAccess(true, (w->tag * numSets + set) * blockBytes);
+			}
+			w->tag = block / numSets;
+			w->valid = true;
+			w->dirty = isWrite && !writeThrough;
+			w->lastUse = ++useCounter;
+			pcm.memory->functionalAccess(false, address);
+		}
+
+		if (w != NULL)
+		{
+			dram.memory->functionalAccess(isWrite, cacheAddress(set, way, address));
+			if (isWrite && writeThrough)
+			{
+				pcm.memory->functionalAccess(true, address);
+			}
+		}
+		else
+		{
+			pcm.memory->functionalAccess(isWrite, address);
+		}
+	}
+
+	//fills, writebacks and migrations count as well as demand requests; an op
+	//the tier memory has nothing in flight for will not complete any more
+	bool HybridMemorySystem::idle()
+	{
+		Tier *tiers[] = {&dram, &pcm};
+		for (size_t i=0; i<2; i++)
+		{
+			if (!tiers[i]->outgoing.empty() || !tiers[i]->done.empty() || !tiers[i]->memory->idle())
+			{
+				return false;
+			}
+		}
+		return incoming.empty();
+	}
+
+	//the DRAM tier's clock keeps its pace with the skipped PCM cycles
+	void HybridMemorySystem::skipCycles(uint64_t cycles)
+	{
+		uint64_t time = dramTime + cycles * pcmPeriod;
+		dram.clock->clockcycle += time / dramPeriod;
+		dramTime = time % dramPeriod;
+	}
+
+	//tagsRead: with the tags in DRAM, the probe of the set has come back
+	void HybridMemorySystem::access(Transaction *trans, bool tagsRead)
+	{
+		uint64_t address = trans->address;
+		unsigned set, way;
+		Way *w = lookup(address, set, way);
+
+		if (tagsInDRAM && !tagsRead)
+		{
+			//read the set first, the request continues once the tags are back
+			Op op = {TagProbe, address, trans};
+			issue(dram, Transaction::DATA_READ, cacheAddress(set, 0, address), NULL, op);
+			tagProbes++;
+			return;
+		}
+
+		if (trans->transactionType == Transaction::DATA_READ)
+		{
+			Op op = {DemandRead, address, NULL};
+			if (w != NULL)
+			{
+				readHits++;
+				w->lastUse = ++useCounter;
+				issue(dram, Transaction::DATA_READ, cacheAddress(set, way, address), NULL, op);
+			}
+			else
+			{
+				readMisses++;
+				issue(pcm, Transaction::DATA_READ, address, NULL, op);
+			}
+		}
+		else
+		{
+			Op op = {DemandWrite, address, NULL};
+			if (w == NULL && writeAllocate)
+			{
+				writeMisses++;
+				way = allocate(address, false, !writeThrough);
+				w = &tags[set * assoc + way];
+			}
+			else if (w != NULL)
+			{
+				writeHits++;
+				w->lastUse = ++useCounter;
+				w->dirty = w->dirty || !writeThrough;
+			}
+			else
+			{
+				writeMisses++;
+			}
+
+			if (w != NULL)
+			{
+				issue(dram, Transaction::DATA_WRITE, cacheAddress(set, way, address), trans->data, op);
+				if (writeThrough)
+				{
+					Op through = {MigrationWrite, address, NULL};
+					issue(pcm, Transaction::DATA_WRITE, address, NULL, through);
+				}
+			}
+			else
+			{
+				issue(pcm, Transaction::DATA_WRITE, address, trans->data, op);
+			}
+		}
+		delete trans;
+	}
+
+	void HybridMemorySystem::handle(Tier &tier, const Op &op)
+	{
+		unsigned set, way;
+		switch (op.type)
+		{
+		case DemandRead:
+			if (ReadDataDone != NULL)
+			{
+				(*ReadDataDone)(0, op.address, clockDomainDRAM->clockcycle);
+			}
+			if (&tier == &pcm && lookup(op.address, set, way) == NULL)
+			{
+				allocate(op.address, true, false);
+			}
+			break;
+		case DemandWrite:
+			if (WriteDataDone != NULL)
+			{
+				(*WriteDataDone)(0, op.address, clockDomainDRAM->clockcycle);
+			}
+			break;
+		case TagProbe:
+		{
+			Way *w = lookup(op.address, set, way);
+			if (op.request->transactionType == Transaction::DATA_READ && w != NULL && assoc == 1)
+			{
+				//direct mapped: the data came with the tags
+				readHits++;
+				w->lastUse = ++useCounter;
+				if (ReadDataDone != NULL)
+				{
+					(*ReadDataDone)(0, op.address, clockDomainDRAM->clockcycle);
+				}
+				delete op.request;
+				break;
+			}
+			access(op.request, true);
+			break;
+		}
+		case FillRead:
+			//the block may have been evicted again while this line was read
+			if (lookup(op.address, set, way) != NULL)
+			{
+				Op write = {MigrationWrite, op.address, NULL};
+				issue(dram, Transaction::DATA_WRITE, cacheAddress(set, way, op.address), NULL, write);
+			}
+			break;
+		case WritebackRead:
+		{
+			Op write = {MigrationWrite, op.address, NULL};
+			issue(pcm, Transaction::DATA_WRITE, op.address, NULL, write);
+			break;
+		}
+		case MigrationWrite:
+			break;
+		}
+	}
+
+	//energy used by a tier over the whole run, in pJ
+	double HybridMemorySystem::tierEnergy(Tier &tier)
+	{
+		const Config &tierConfig = tier.memory->config;
+		double energy = 0.0;
+		for (size_t c=0; c<tier.memory->memoryControllers.size(); c++)
+		{
+			MemoryController *mc = tier.memory->memoryControllers[c];
+			for (size_t r=0; r<tierConfig.NUM_RANKS; r++)
+			{
+				energy += mc->grandTotalEnergy[r] + mc->epochEnergy(r);
+			}
+		}
+		return energy;
+	}
+
+	void HybridMemorySystem::printStats(bool finalStats)
+	{
+		PRINT("######## DRAM cache tier ########");
+		dram.memory->printStats(finalStats);
+		double dramEnergy = tierEnergy(dram);
+		PRINT("######## PCM tier ########");
+		pcm.memory->printStats(finalStats);
+		double pcmEnergy = tierEnergy(pcm);
+
+		uint64_t hits = readHits + writeHits;
+		uint64_t accesses = hits + readMisses + writeMisses;
+		PRINT(" --- Hybrid memory");
+		PRINT("    reads  : "<<readHits<<" hits / "<<readMisses<<" misses");
+		PRINT("    writes : "<<writeHits<<" hits / "<<writeMisses<<" misses");
+		if (accesses > 0)
+		{
+			PRINT("    hit rate : "<<100.0 * hits / accesses<<"%");
+		}
+		if (tagsInDRAM)
+		{
+			PRINT("    tag probes : "<<tagProbes);
+		}
+		PRINT("    fills : "<<fills<<" blocks, "<<fillLines * lineBytes<<" bytes PCM -> DRAM");
+		PRINT("    writebacks : "<<writebacks<<" blocks, "<<writebackLines * lineBytes<<" bytes DRAM -> PCM");
+		PRINT("    energy : DRAM tier "<<dramEnergy / 1000.0<<" nJ, PCM tier "<<pcmEnergy / 1000.0<<" nJ");
+	}
+
+	void HybridMemorySystem::checkpointRows(Checkpoint &cp)
+	{
+		dram.memory->checkpointRows(cp);
+		pcm.memory->checkpointRows(cp);
+	}
+
+	void HybridMemorySystem::checkpoint(Checkpoint &cp)
+	{
+		dram.clock->checkpoint(cp);
+		cp.section("DRAM tier");
+		dram.memory->checkpoint(cp);
+		dram.checkpoint(cp);
+		cp.section("PCM tier");
+		pcm.memory->checkpoint(cp);
+		pcm.checkpoint(cp);
+
+		cp.section("hybrid");
+		cp.io(dramTime);
+		cp.io(incoming);
+		cp.io(tags);
+		cp.io(useCounter);
+		cp.io(readHits);
+		cp.io(readMisses);
+		cp.io(writeHits);
+		cp.io(writeMisses);
+		cp.io(tagProbes);
+		cp.io(fills);
+		cp.io(fillLines);
+		cp.io(writebacks);
+		cp.io(writebackLines);
+	}
+
+	void HybridMemorySystem::Tier::checkpoint(Checkpoint &cp)
+	{
+		cp.io(reads);
+		cp.io(writes);
+		cp.io(outgoing);
+		cp.io(done);
+	}
+
+	void HybridMemorySystem::Op::checkpoint(Checkpoint &cp)
+	{
+		cp.io(type);
+		cp.io(address);
+		cp.io(request);
+	}
+
+	void HybridMemorySystem::Way::checkpoint(Checkpoint &cp)
+	{
+		cp.io(tag);
+		cp.io(valid);
+		cp.io(dirty);
+		cp.io(lastUse);
+	}
+}
@@ -0,0 +1,125 @@
+#ifndef HYBRIDMEMORYSYSTEM_H
+#define HYBRIDMEMORYSYSTEM_H
+
+//HybridMemorySystem.h
+//
+//A DRAM cache tier in front of a PCM main memory tier. Each tier is a full
+//MemorySystem (its own channels, controllers and timing) built from its own
+//ini files; the tag store, fill and writeback policies live here.
+//
+//Each tier has its own Config. The PCM tier uses the config the hybrid is
+//created with (the simulator's ini files) and runs on the hybrid's DRAM clock
+//domain; the DRAM tier reads HYBRID_CACHE_DEVICE (and HYBRID_CACHE_SYSTEM if
+//given, otherwise it keeps the PCM tier's system parameters) and is ticked at
+//its own tCK relative to it.
+//
+
+#include "MemorySystem.h"
+#include "IniReader.h"
+#include <list>
+#include <map>
+
+namespace DRAMSim
+{
+	using std::list;
+	using std::map;
+
+	class HybridMemorySystem : public MemorySystem
+	{
+	public:
+		HybridMemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM,
+				const string &workingDirectory);
+		virtual ~HybridMemorySystem();
+
+		virtual bool addTransaction(Transaction *trans);
+		virtual bool addTransaction(bool isWrite, uint64_t addr);
+		virtual void functionalAccess(bool isWrite, uint64_t addr);
+		virtual bool idle();
+		virtual void skipCycles(uint64_t cycles);
+		virtual bool willAcceptTransaction();
+		virtual bool willAcceptTransaction(uint64_t addr);
+		virtual void update();
+		virtual void printStats(bool finalStats);
+		virtual void checkpointRows(Checkpoint &cp);
+		virtual void checkpoint(Checkpoint &cp);
+
+	private:
+		typedef enum
+		{
+			DemandRead,		//CPU read, reported when it returns
+			DemandWrite,	//CPU write, reported when it is done
+			TagProbe,		//tags kept in DRAM: read of the set before the lookup
+			FillRead,		//PCM read of a line that goes into the cache
+			WritebackRead,	//DRAM read of a dirty line that goes back to PCM
+			MigrationWrite	//second half of a fill or writeback
+		} OpType;
+
+		struct Op
+		{
+			OpType type;
+			uint64_t address;	//CPU address of the line
+			Transaction *request; //TagProbe: the request waiting for the tags
+			void checkpoint(Checkpoint &cp);
+		};
+
+		struct Way
+		{
+			uint64_t tag;
+			bool valid;
+			bool dirty;
+			uint64_t lastUse;
+			void checkpoint(Checkpoint &cp);
+		};
+
+		class Tier
+		{
+		public:
+			MemorySystem *memory;
+			ClockDomain *clock;
+			//outstanding tier transactions by tier address, in issue order
+			map<uint64_t, list<Op> > reads;
+			map<uint64_t, list<Op> > writes;
+			deque<Transaction *> outgoing;
+			//completed ops, handled on the next update
+			list<Op> done;
+			void readDone(unsigned id, uint64_t address, uint64_t cycle);
+			void writeDone(unsigned id, uint64_t address, uint64_t cycle);
+			//the outstanding ops; the memory system and the clock are saved by the hybrid
+			void checkpoint(Checkpoint &cp);
+		};
+
+		void issue(Tier &tier, Transaction::TransactionType type, uint64_t tierAddress, DataPacket *data, const Op &op);
+		void access(Transaction *trans, bool tagsRead);
+		void handle(Tier &tier, const Op &op);
+		Way *lookup(uint64_t address, unsigned &set, unsigned &way);
+		unsigned victimWay(unsigned set) const;
+		unsigned allocate(uint64_t address, bool withDemandLine, bool dirty);
+		uint64_t cacheAddress(unsigned set, unsigned way, uint64_t address) const;
+		double tierEnergy(Tier &tier);
+
+		Tier dram;
+		Tier pcm;
+		uint64_t dramTime, pcmPeriod, dramPeriod; //ps, to tick the DRAM tier at its own rate
+		deque<Transaction *> incoming;
+
+		//tag store
+		unsigned lineBytes;
+		unsigned blockBytes;
+		unsigned assoc;
+		uint64_t numSets;
+		vector<Way> tags;
+		uint64_t useCounter;
+		bool tagsInDRAM;
+		bool writeAllocate;
+		bool writeThrough;
+
+		//statistics
+		uint64_t readHits, readMisses;
+		uint64_t writeHits, writeMisses;
+		uint64_t tagProbes;
+		uint64_t fills, fillLines;
+		uint64_t writebacks, writebackLines;
+	};
+}
+
+#endif
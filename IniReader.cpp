@@ -38,86 +38,166 @@ using std::cout;
 using std::endl;
 using std::dec;
 using std::hex;
-	//Map the string names to the variables they set
-	static IniReader::ConfigMap configMap[] =
+	IniReader::IniReader(Config &config) : config(config)
 	{
-		//DEFINE_UINT_PARAM -- see IniReader.h
-		DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
-		DEFINE_UINT_PARAM(NUM_RANKS,SYS_PARAM),
-		DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
-		DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
-		DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
-		DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
-		DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
-		DEFINE_UINT_PARAM(CL,DEV_PARAM),
-		DEFINE_UINT_PARAM(AL,DEV_PARAM),
-		DEFINE_UINT_PARAM(BL,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRC,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRP,DEV_PARAM),
-		DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
-		DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
-		DEFINE_UINT_PARAM(tWR,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
-		DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
-		DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
-		DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
-		DEFINE_UINT_PARAM(tXP,DEV_PARAM),
-		DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
-		DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
-		DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
+		//Map the string names to the members of config they set
+		ConfigMap params[] =
+		{
+			//DEFINE_UINT_PARAM -- see IniReader.h
+			DEFINE_UINT_PARAM(NUM_CHANS,SYS_PARAM),
+			DEFINE_UINT_PARAM(NUM_RANKS,SYS_PARAM),
+			DEFINE_UINT_PARAM(NUM_BANKS,DEV_PARAM),
+			DEFINE_UINT_PARAM(NUM_ROWS,DEV_PARAM),
+			DEFINE_UINT_PARAM(NUM_COLS,DEV_PARAM),
+			DEFINE_UINT_PARAM(DEVICE_WIDTH,DEV_PARAM),
+			DEFINE_UINT_PARAM(REFRESH_PERIOD,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(tCK,DEV_PARAM),
+			DEFINE_UINT_PARAM(CL,DEV_PARAM),
+			DEFINE_UINT_PARAM(AL,DEV_PARAM),
+			DEFINE_UINT_PARAM(BL,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRAS,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRCD,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRRD,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRC,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRP,DEV_PARAM),
+			DEFINE_UINT_PARAM(tCCD,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRTP,DEV_PARAM),
+			DEFINE_UINT_PARAM(tWTR,DEV_PARAM),
+			DEFINE_UINT_PARAM(tWR,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRTRS,DEV_PARAM),
+			DEFINE_UINT_PARAM(tRFC,DEV_PARAM),
+			DEFINE_UINT_PARAM(tFAW,DEV_PARAM),
+			DEFINE_UINT_PARAM(tCKE,DEV_PARAM),
+			DEFINE_UINT_PARAM(tXP,DEV_PARAM),
+			DEFINE_UINT_PARAM(tCMD,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD0,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD1,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD2P,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD2Q,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD2N,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD3Pf,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD3Ps,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD3N,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD4W,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD4R,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD5,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD6,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD6L,DEV_PARAM),
+			DEFINE_UINT_PARAM(IDD7,DEV_PARAM),
+			DEFINE_FLOAT_PARAM(Vdd,DEV_PARAM),
+			//PCM cell energy (pJ/bit); DRAM devices leave these out
+			DEFINE_OPTIONAL_PARAM(WR_ENERGY_BIT,FLOAT,DEV_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(SET_ENERGY_BIT,FLOAT,DEV_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(RD_ENERGY_BIT,FLOAT,DEV_PARAM,"0"),
+			//PCM devices are not refreshed, lines older than DRIFT_WINDOW (ns) are scrubbed instead
+			DEFINE_OPTIONAL_PARAM(DEVICE_TYPE,STRING,DEV_PARAM,"DRAM"),
+			DEFINE_OPTIONAL_PARAM(DRIFT_WINDOW,FLOAT,DEV_PARAM,"0"),
+			//injected cell errors (DATA_STORAGE builds), per bit
+			DEFINE_OPTIONAL_PARAM(FAULT_WRITE_BER,FLOAT,DEV_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(FAULT_DRIFT_BER,FLOAT,DEV_PARAM,"0"),
+
+			DEFINE_UINT_PARAM(ECC_DATA_BUS_BITS,SYS_PARAM),
+			DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
+			//DEFINE_UINT_PARAM(SUBARRAY_DATA_BYTES,SYS_PARAM),
 
-		DEFINE_UINT_PARAM(ECC_DATA_BUS_BITS,SYS_PARAM),
-		DEFINE_UINT_PARAM(JEDEC_DATA_BUS_BITS,SYS_PARAM),
-		//DEFINE_UINT_PARAM(SUBARRAY_DATA_BYTES,SYS_PARAM),
+			//Memory Controller related parameters
+			DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
+			DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
+			DEFINE_OPTIONAL_PARAM(PENDING_QUEUE_DEPTH,UINT,SYS_PARAM,"0"),
 
-		//Memory Controller related parameters
-		DEFINE_UINT_PARAM(TRANS_QUEUE_DEPTH,SYS_PARAM),
-		DEFINE_UINT_PARAM(CMD_QUEUE_DEPTH,SYS_PARAM),
+			DEFINE_UINT64_PARAM(EPOCH_LENGTH,SYS_PARAM),
+			DEFINE_UINT_PARAM(HISTOGRAM_BIN_SIZE,SYS_PARAM),
+			//Power
+			DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
 
-		DEFINE_UINT64_PARAM(EPOCH_LENGTH,SYS_PARAM),
-		DEFINE_UINT_PARAM(HISTOGRAM_BIN_SIZE,SYS_PARAM),
-		//Power
-		DEFINE_BOOL_PARAM(USE_LOW_POWER,SYS_PARAM),
+			DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
+			DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
+			DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
+			DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
+			DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
+			//wear leveling
+			DEFINE_OPTIONAL_PARAM(WEAR_LEVELING,STRING,SYS_PARAM,"none"),
+			DEFINE_OPTIONAL_PARAM(TRACK_WEAR,BOOL,SYS_PARAM,"false"),
+			DEFINE_OPTIONAL_PARAM(GAP_MOVE_INTERVAL,UINT,SYS_PARAM,"100"),
+			DEFINE_OPTIONAL_PARAM(START_GAP_REGION_LINES,UINT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(WEAR_LEVELING_SEED,UINT,SYS_PARAM,"1"),
+			DEFINE_OPTIONAL_PARAM(PCM_ENDURANCE,FLOAT,SYS_PARAM,"1e8"),
+			//injected data bus errors (DATA_STORAGE builds)
+			DEFINE_OPTIONAL_PARAM(FAULT_BUS_BER,FLOAT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(FAULT_SEED,UINT,SYS_PARAM,"1"),
+			//hybrid DRAM cache + PCM
+			DEFINE_OPTIONAL_PARAM(HYBRID_CACHE_DEVICE,STRING,SYS_PARAM,""),
+			DEFINE_OPTIONAL_PARAM(HYBRID_CACHE_SYSTEM,STRING,SYS_PARAM,""),
+			DEFINE_OPTIONAL_PARAM(HYBRID_CACHE_MEGS,UINT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(HYBRID_CACHE_ASSOC,UINT,SYS_PARAM,"1"),
+			DEFINE_OPTIONAL_PARAM(HYBRID_CACHE_BLOCK_BYTES,UINT,SYS_PARAM,"64"),
+			DEFINE_OPTIONAL_PARAM(HYBRID_TAG_STORE,STRING,SYS_PARAM,"sram"),
+			DEFINE_OPTIONAL_PARAM(HYBRID_FILL_POLICY,STRING,SYS_PARAM,"read_miss"),
+			DEFINE_OPTIONAL_PARAM(HYBRID_WRITE_POLICY,STRING,SYS_PARAM,"write_back"),
+			//sampled simulation
+			DEFINE_OPTIONAL_PARAM(SAMPLE_PERIOD,UINT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(SAMPLE_WINDOW,UINT,SYS_PARAM,"1000"),
+			DEFINE_OPTIONAL_PARAM(SAMPLE_WARMUP,UINT,SYS_PARAM,"200"),
+			//cache hierarchy
+			DEFINE_OPTIONAL_PARAM(CACHE_BLOCK_BYTES,UINT,SYS_PARAM,"64"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L1_KB,UINT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L1_ASSOC,UINT,SYS_PARAM,"8"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L2_KB,UINT,SYS_PARAM,"0"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L2_ASSOC,UINT,SYS_PARAM,"8"),
+			DEFINE_OPTIONAL_PARAM(CACHE_LLC_KB,UINT,SYS_PARAM,"131072"),
+			DEFINE_OPTIONAL_PARAM(CACHE_LLC_ASSOC,UINT,SYS_PARAM,"8"),
+			DEFINE_OPTIONAL_PARAM(CACHE_INCLUSION,STRING,SYS_PARAM,"non_inclusive"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L1_REPLACEMENT,STRING,SYS_PARAM,"lru"),
+			DEFINE_OPTIONAL_PARAM(CACHE_L2_REPLACEMENT,STRING,SYS_PARAM,"lru"),
+			DEFINE_OPTIONAL_PARAM(CACHE_LLC_REPLACEMENT,STRING,SYS_PARAM,"lru"),
+			DEFINE_OPTIONAL_PARAM(PREFETCHER,STRING,SYS_PARAM,"none"),
+			DEFINE_OPTIONAL_PARAM(PREFETCH_DEGREE,UINT,SYS_PARAM,"2"),
+			DEFINE_OPTIONAL_PARAM(PREFETCH_TABLE,UINT,SYS_PARAM,"16"),
+			DEFINE_OPTIONAL_PARAM(PREFETCH_BUFFER,UINT,SYS_PARAM,"64"),
+			DEFINE_OPTIONAL_PARAM(PREFETCH_QUEUE,UINT,SYS_PARAM,"16"),
+			DEFINE_OPTIONAL_PARAM(CORE_MODEL,STRING,SYS_PARAM,"open_loop"),
+			DEFINE_OPTIONAL_PARAM(CORE_WIDTH,UINT,SYS_PARAM,"4"),
+			DEFINE_OPTIONAL_PARAM(CORE_ROB,UINT,SYS_PARAM,"128"),
+			DEFINE_OPTIONAL_PARAM(CORE_MSHR,UINT,SYS_PARAM,"8"),
+			DEFINE_OPTIONAL_PARAM(GEN_REQUESTS,UINT64,SYS_PARAM,"1000000"),
+			DEFINE_OPTIONAL_PARAM(GEN_RATE,FLOAT,SYS_PARAM,"0.1"),
+			DEFINE_OPTIONAL_PARAM(GEN_READ_FRACTION,FLOAT,SYS_PARAM,"0.7"),
+			DEFINE_OPTIONAL_PARAM(GEN_FOOTPRINT_MB,UINT,SYS_PARAM,"64"),
+			DEFINE_OPTIONAL_PARAM(GEN_STRIDE,UINT,SYS_PARAM,"4096"),
+			DEFINE_OPTIONAL_PARAM(GEN_ZIPF,FLOAT,SYS_PARAM,"0.99"),
+			DEFINE_OPTIONAL_PARAM(GEN_SEED,UINT,SYS_PARAM,"1"),
+			// debug flags
+			DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
+			DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
+			DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
+			DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
+			DEFINE_BOOL_PARAM(SET_IDLE,SYS_PARAM), //set switch on or off
+			DEFINE_BOOL_PARAM(SET_CLOSE,SYS_PARAM), 
+			DEFINE_OPTIONAL_PARAM(DATA_COMPARE_WRITE,BOOL,SYS_PARAM,"false"),
+			DEFINE_OPTIONAL_PARAM(FLIP_N_WRITE,BOOL,SYS_PARAM,"false"),
+			DEFINE_OPTIONAL_PARAM(PARTIAL_WRITE,BOOL,SYS_PARAM,"false"),
+			DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
+			DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
+			DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
+			DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
+			DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
+			{"", NULL, IniReader::UINT, IniReader::SYS_PARAM, false, NULL} // tracer value to signify end of list; if you delete it, epic fail will result
+		};
+		configMap.assign(params, params + sizeof(params) / sizeof(params[0]));
+	}
 
-		DEFINE_UINT_PARAM(TOTAL_ROW_ACCESSES,SYS_PARAM),
-		DEFINE_STRING_PARAM(ROW_BUFFER_POLICY,SYS_PARAM),
-		DEFINE_STRING_PARAM(SCHEDULING_POLICY,SYS_PARAM),
-		DEFINE_STRING_PARAM(ADDRESS_MAPPING_SCHEME,SYS_PARAM),
-		DEFINE_STRING_PARAM(QUEUING_STRUCTURE,SYS_PARAM),
-		// debug flags
-		DEFINE_BOOL_PARAM(DEBUG_TRANS_Q,SYS_PARAM),
-		DEFINE_BOOL_PARAM(DEBUG_CMD_Q,SYS_PARAM),
-		DEFINE_BOOL_PARAM(DEBUG_ADDR_MAP,SYS_PARAM),
-		DEFINE_BOOL_PARAM(DEBUG_BANKSTATE,SYS_PARAM),
-		DEFINE_BOOL_PARAM(SET_IDLE,SYS_PARAM), //set switch on or off
-		DEFINE_BOOL_PARAM(SET_CLOSE,SYS_PARAM), 
-		DEFINE_BOOL_PARAM(DEBUG_BUS,SYS_PARAM),
-		DEFINE_BOOL_PARAM(DEBUG_BANKS,SYS_PARAM),
-		DEFINE_BOOL_PARAM(DEBUG_POWER,SYS_PARAM),
-		DEFINE_BOOL_PARAM(VIS_FILE_OUTPUT,SYS_PARAM),
-		DEFINE_BOOL_PARAM(VERIFICATION_OUTPUT,SYS_PARAM),
-		{"", NULL, IniReader::UINT, IniReader::SYS_PARAM, false} // tracer value to signify end of list; if you delete it, epic fail will result
-	};
+	void IniReader::KeepKeys(ParamType type)
+	{
+		for (size_t i=0; configMap[i].variablePtr != NULL; i++)
+		{
+			if (configMap[i].parameterType == type)
+			{
+				configMap[i].wasSet = true;
+			}
+		}
+	}
 
-	void IniReader::WriteParams(std::ofstream &visDataOut, ParamType type)
+	void IniReader::WriteParams(std::ostream &visDataOut, ParamType type)
 	{
 		for (size_t i=0; configMap[i].variablePtr != NULL; i++)
 		{
@@ -155,10 +235,10 @@ using std::hex;
 		}
 		if (type == SYS_PARAM)
 		{
-			visDataOut<<"NUM_RANKS="<<NUM_RANKS <<"\n";
+			visDataOut<<"NUM_RANKS="<<config.NUM_RANKS <<"\n";
 		}
 	}
-	void IniReader::WriteValuesOut(std::ofstream &visDataOut)
+	void IniReader::WriteValuesOut(std::ostream &visDataOut)
 	{
 		visDataOut<<"!!SYSTEM_INI"<<endl;
 
@@ -357,7 +437,15 @@ using std::hex;
 		// check to make sure all parameters that we exepected were set
 		for (size_t i=0; configMap[i].variablePtr != NULL; i++)
 		{
-			if (!configMap[i].wasSet)
+			if (!configMap[i].wasSet && configMap[i].defaultValue != NULL)
+			{
+				if (DEBUG_INI_READER)
+				{
+					DEBUG("\tSetting Default: "<<configMap[i].iniKey<<"="<<configMap[i].defaultValue);
+				}
+				SetKey(configMap[i].iniKey, configMap[i].defaultValue);
+			}
+			else if (!configMap[i].wasSet)
 			{
 				DEBUG("WARNING: KEY "<<configMap[i].iniKey<<" NOT FOUND IN INI FILE.");
 				switch (configMap[i].variableType)
@@ -382,57 +470,57 @@ using std::hex;
 	}
 	void IniReader::InitEnumsFromStrings()
 	{
-		if (ADDRESS_MAPPING_SCHEME == "scheme1")
+		if (config.ADDRESS_MAPPING_SCHEME == "scheme1")
 		{
-			addressMappingScheme = Scheme1;
+			config.addressMappingScheme = Scheme1;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 1");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme2")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme2")
 		{
-			addressMappingScheme = Scheme2;
+			config.addressMappingScheme = Scheme2;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 2");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme3")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme3")
 		{
-			addressMappingScheme = Scheme3;
+			config.addressMappingScheme = Scheme3;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 3");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme4")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme4")
 		{
-			addressMappingScheme = Scheme4;
+			config.addressMappingScheme = Scheme4;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 4");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme5")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme5")
 		{
-			addressMappingScheme = Scheme5;
+			config.addressMappingScheme = Scheme5;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 5");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme6")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme6")
 		{
-			addressMappingScheme = Scheme6;
+			config.addressMappingScheme = Scheme6;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 6");
 			}
 		}
-		else if (ADDRESS_MAPPING_SCHEME == "scheme7")
+		else if (config.ADDRESS_MAPPING_SCHEME == "scheme7")
 		{
-			addressMappingScheme = Scheme7;
+			config.addressMappingScheme = Scheme7;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ADDR SCHEME: 7");
@@ -440,21 +528,21 @@ using std::hex;
 		}
 		else
 		{
-			cout << "WARNING: unknown address mapping scheme '"<<ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7'. Defaulting to scheme1"<<endl;
-			addressMappingScheme = Scheme1;
+			cout << "WARNING: unknown address mapping scheme '"<<config.ADDRESS_MAPPING_SCHEME<<"'; valid values are 'scheme1'...'scheme7'. Defaulting to scheme1"<<endl;
+			config.addressMappingScheme = Scheme1;
 		}
 
-		if (ROW_BUFFER_POLICY == "open_page")
+		if (config.ROW_BUFFER_POLICY == "open_page")
 		{
-			rowBufferPolicy = OpenPage;
+			config.rowBufferPolicy = OpenPage;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ROW BUFFER: open page");
 			}
 		}
-		else if (ROW_BUFFER_POLICY == "close_page")
+		else if (config.ROW_BUFFER_POLICY == "close_page")
 		{
-			rowBufferPolicy = ClosePage;
+			config.rowBufferPolicy = ClosePage;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("ROW BUFFER: close page");
@@ -462,21 +550,21 @@ using std::hex;
 		}
 		else
 		{
-			cout << "WARNING: unknown row buffer policy '"<<ROW_BUFFER_POLICY<<"'; valid values are 'open_page' or 'close_page', Defaulting to Close Page."<<endl;
-			rowBufferPolicy = ClosePage;
+			cout << "WARNING: unknown row buffer policy '"<<config.ROW_BUFFER_POLICY<<"'; valid values are 'open_page' or 'close_page', Defaulting to Close Page."<<endl;
+			config.rowBufferPolicy = ClosePage;
 		}
 
-		if (QUEUING_STRUCTURE == "per_rank_per_bank")
+		if (config.QUEUING_STRUCTURE == "per_rank_per_bank")
 		{
-			queuingStructure = PerRankPerBank;
+			config.queuingStructure = PerRankPerBank;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("QUEUING STRUCT: per rank per bank");
 			}
 		}
-		else if (QUEUING_STRUCTURE == "per_rank")
+		else if (config.QUEUING_STRUCTURE == "per_rank")
 		{
-			queuingStructure = PerRank;
+			config.queuingStructure = PerRank;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("QUEUING STRUCT: per rank");
@@ -484,21 +572,21 @@ using std::hex;
 		}
 		else
 		{
-			cout << "WARNING: Unknown queueing structure '"<<QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
-			queuingStructure = PerRankPerBank;
+			cout << "WARNING: Unknown queueing structure '"<<config.QUEUING_STRUCTURE<<"'; valid options are 'per_rank' and 'per_rank_per_bank', defaulting to Per Rank Per Bank"<<endl;
+			config.queuingStructure = PerRankPerBank;
 		}
 
-		if (SCHEDULING_POLICY == "rank_then_bank_round_robin")
+		if (config.SCHEDULING_POLICY == "rank_then_bank_round_robin")
 		{
-			schedulingPolicy = RankThenBankRoundRobin;
+			config.schedulingPolicy = RankThenBankRoundRobin;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("SCHEDULING: Rank Then Bank");
 			}
 		}
-		else if (SCHEDULING_POLICY == "bank_then_rank_round_robin")
+		else if (config.SCHEDULING_POLICY == "bank_then_rank_round_robin")
 		{
-			schedulingPolicy = BankThenRankRoundRobin;
+			config.schedulingPolicy = BankThenRankRoundRobin;
 			if (DEBUG_INI_READER)
 			{
 				DEBUG("SCHEDULING: Bank Then Rank");
@@ -506,8 +594,52 @@ using std::hex;
 		}
 		else
 		{
-			cout << "WARNING: Unknown scheduling policy '"<<SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin' or 'bank_then_rank_round_robin'; defaulting to Bank Then Rank Round Robin" << endl;
-			schedulingPolicy = BankThenRankRoundRobin;
+			cout << "WARNING: Unknown scheduling policy '"<<config.SCHEDULING_POLICY<<"'; valid options are 'rank_then_bank_round_robin' or 'bank_then_rank_round_robin'; defaulting to Bank Then Rank Round Robin" << endl;
+			config.schedulingPolicy = BankThenRankRoundRobin;
+		}
+
+		if (config.WEAR_LEVELING == "none")
+		{
+			config.wearLevelingScheme = NoWearLeveling;
+		}
+		else if (config.WEAR_LEVELING == "start_gap")
+		{
+			config.wearLevelingScheme = StartGap;
+			if (DEBUG_INI_READER)
+			{
+				DEBUG("WEAR LEVELING: Start-Gap");
+			}
+		}
+		else if (config.WEAR_LEVELING == "region_start_gap")
+		{
+			config.wearLevelingScheme = RandomStartGap;
+			if (DEBUG_INI_READER)
+			{
+				DEBUG("WEAR LEVELING: region based randomized Start-Gap");
+			}
+		}
+		else
+		{
+			cout << "WARNING: Unknown wear leveling '"<<config.WEAR_LEVELING<<"'; valid options are 'none', 'start_gap' or 'region_start_gap'; defaulting to none" << endl;
+			config.wearLevelingScheme = NoWearLeveling;
+		}
+
+		if (config.DEVICE_TYPE == "DRAM")
+		{
+			config.deviceType = DRAMDevice;
+		}
+		else if (config.DEVICE_TYPE == "PCM")
+		{
+			config.deviceType = PCMDevice;
+			if (DEBUG_INI_READER)
+			{
+				DEBUG("DEVICE TYPE: PCM (no refresh)");
+			}
+		}
+		else
+		{
+			cout << "WARNING: Unknown device type '"<<config.DEVICE_TYPE<<"'; valid options are 'DRAM' or 'PCM'; defaulting to DRAM" << endl;
+			config.deviceType = DRAMDevice;
 		}
 
 	}
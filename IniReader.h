@@ -36,15 +36,18 @@
 #include <sstream>
 #include <string>
 #include <map> 
+#include <vector>
 #include "SystemConfiguration.h"
 
 
 
-#define DEFINE_UINT_PARAM(name, paramtype) {#name, &name, IniReader::UINT, IniReader::paramtype, false}
-#define DEFINE_STRING_PARAM(name, paramtype) {#name, &name, IniReader::STRING, IniReader::paramtype, false}
-#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &name, IniReader::FLOAT, IniReader::paramtype, false}
-#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &name, IniReader::BOOL, IniReader::paramtype, false}
-#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &name, IniReader::UINT64, IniReader::paramtype, false}
+#define DEFINE_UINT_PARAM(name, paramtype) {#name, &config.name, IniReader::UINT, IniReader::paramtype, false, NULL}
+#define DEFINE_STRING_PARAM(name, paramtype) {#name, &config.name, IniReader::STRING, IniReader::paramtype, false, NULL}
+#define DEFINE_FLOAT_PARAM(name,paramtype) {#name, &config.name, IniReader::FLOAT, IniReader::paramtype, false, NULL}
+#define DEFINE_BOOL_PARAM(name, paramtype) {#name, &config.name, IniReader::BOOL, IniReader::paramtype, false, NULL}
+#define DEFINE_UINT64_PARAM(name, paramtype) {#name, &config.name, IniReader::UINT64, IniReader::paramtype, false, NULL}
+// optional keys fall back to defaultValue (a string, parsed like an ini value) instead of aborting when missing
+#define DEFINE_OPTIONAL_PARAM(name, vartype, paramtype, defaultValue) {#name, &config.name, IniReader::vartype, IniReader::paramtype, false, defaultValue}
 
 namespace DRAMSim
 {
@@ -66,21 +69,31 @@ namespace DRAMSim
 			VarType variableType;
 			ParamType parameterType;
 			bool wasSet;
+			const char *defaultValue; //NULL if the key is required
 		} ConfigMap;
 
 		typedef map<string, string> OverrideMap;
 		typedef OverrideMap::const_iterator OverrideIterator;
 
-		static void SetKey(string key, string value, size_t lineNumber = 0, IniType iniType = SYS_INI);
-		static void OverrideKeys(const OverrideMap *map);
-		static void ReadIniFile(string filename, IniType iniType = SYS_INI);
-		static void InitEnumsFromStrings();
-		static bool CheckIfAllSet();
-		static void WriteValuesOut(std::ofstream &visDataOut);
+		//keys are read into the given Config, which has to outlive the reader
+		IniReader(Config &config);
+
+		void SetKey(string key, string value, size_t lineNumber = 0, IniType iniType = SYS_INI);
+		void OverrideKeys(const OverrideMap *map);
+		void ReadIniFile(string filename, IniType iniType = SYS_INI);
+		void InitEnumsFromStrings();
+		bool CheckIfAllSet();
+		void WriteValuesOut(std::ostream &visDataOut);
+		//take the values of this type the config already holds (e.g. copied from
+		//another memory system's config) as set, instead of reading an ini file
+		void KeepKeys(ParamType type);
 
 	private:
-		static void WriteParams(std::ofstream &visDataOut, ParamType t);
+		void WriteParams(std::ostream &visDataOut, ParamType t);
 		static void Trim(string &str);
+
+		Config &config;
+		std::vector<ConfigMap> configMap;
 	};
 }
 
@@ -36,11 +36,9 @@
 #include "MemorySystem.h"
 #include "SimulatorIO.h"
 #include "Simulator.h"
+#include "Checkpoint.h"
 
-#define SEQUENTIAL(rank,bank) (rank*NUM_BANKS)+bank
-static uint64_t reducedcmd = 0;
-static uint64_t completedSET = 0;
-static uint64_t eraseSET = 0;
+#define SEQUENTIAL(rank,bank) (rank*config.NUM_BANKS)+bank
 #define threshold 4
 namespace DRAMSim {
 using std::max;
@@ -50,10 +48,17 @@ using std::ios;
 
 MemoryController::MemoryController(MemorySystem *parent, vector<Rank *> *ranks,
 		unsigned channel) :
-		parentMemorySystem(parent), ranks(ranks), bankStates(NUM_RANKS,
-				vector<BankState>(NUM_BANKS)), commandQueue(bankStates), poppedBusPacket(
+		config(parent->config), clockDomainCPU(parent->clockDomainCPU), clockDomainDRAM(
+				parent->clockDomainDRAM), parentMemorySystem(parent), ranks(ranks), bankStates(
+				config.NUM_RANKS, vector<BankState>(config.NUM_BANKS)), commandQueue(
+				bankStates, config, clockDomainDRAM), poppedBusPacket(
 				NULL), totalTransactions(0), refreshRank(0), csvOut(
 				SimulatorIO::verifyFile), channelID(channel) {
+	//SET_IDLE counters
+	reducedcmd = 0;
+	completedSET = 0;
+	eraseSET = 0;
+
 	//bus related fields
 	outgoingCmdPacket = NULL;
 	outgoingDataPacket = NULL;
@@ -61,45 +66,92 @@ MemoryController::MemoryController(MemorySystem *parent, vector<Rank *> *ranks,
 	cmdCyclesLeft = 0;
 
 	//reserve memory for vectors
-	transactionQueue.reserve(TRANS_QUEUE_DEPTH);
-
-	powerDown = vector<bool>(NUM_RANKS, false);
-	grandTotalBankAccesses = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	totalReadsPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	totalWritesPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-
-	fullSETPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	flushSETPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	EmergePartailSET = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	setChancePerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	lockBank = vector<bool>(NUM_RANKS * NUM_BANKS, false);
-
-	locktime = vector<vector<uint64_t> >(NUM_RANKS * NUM_BANKS);
-	Idletime = vector<vector<uint64_t> >(NUM_RANKS * NUM_BANKS);
-	bingoPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	notbingoPerBank = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
-	accurancy = vector<float>(NUM_RANKS * NUM_BANKS, 0);
+	transactionQueue.reserve(config.TRANS_QUEUE_DEPTH);
+
+	//the ranks of this channel index their rows directly in one sparse mapping
+	backingStore = NULL;
+#ifdef DATA_STORAGE
+	#ifdef DATA_STORAGE_SSA
+	backingStore = new BackingStore((uint64_t) config.NUM_RANKS * config.NUM_BANKS * NUM_SUBARRAYS * config.NUM_ROWS,
+			ROW_BYTES + FNW_FLAG_BYTES);
+	#else
+	backingStore = new BackingStore((uint64_t) config.NUM_RANKS * config.NUM_BANKS * config.NUM_ROWS,
+			ROW_BYTES + FNW_FLAG_BYTES);
+	#endif
+#endif
+	faultInjector = NULL;
+	if (FaultInjector::enabled(config)) {
+#ifdef DATA_STORAGE
+		faultInjector = new FaultInjector(config, clockDomainDRAM, channel);
+#else
+		PRINT("WARNING: fault injection needs a DATA_STORAGE build, FAULT_*_BER ignored");
+#endif
+	}
+
+	powerDown = vector<bool>(config.NUM_RANKS, false);
+	grandTotalBankAccesses = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	totalReadsPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	totalWritesPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+
+	fullSETPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	flushSETPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	EmergePartailSET = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	setBitsPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	resetBitsPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	silentWritesPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	resetOnlyWritesPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	partialWritesPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	partialBytesSavedPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+
+	//PCM cells are not refreshed; instead lines whose resistance has drifted
+	//for DRIFT_WINDOW are rewritten when their bank is idle
+	scrubbing = config.deviceType == PCMDevice && config.DRIFT_WINDOW > 0;
+	driftCycles = (uint64_t) (config.DRIFT_WINDOW / config.tCK);
+	scrubPending = vector<bool>(config.NUM_RANKS * config.NUM_BANKS, false);
+	scrubBusyUntil = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	scrubsPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	scrubCollisionsPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	maxScrubLateness = 0;
+	eccCorrectedPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	eccUncorrectablePerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	scrubCorrectedPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	scrubUncorrectablePerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	if (config.deviceType == PCMDevice && config.DRIFT_WINDOW < 0) {
+		ERROR("DRIFT_WINDOW must not be negative (got "<<config.DRIFT_WINDOW<<")");
+		exit(-1);
+	}
+	setChancePerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	lockBank = vector<bool>(config.NUM_RANKS * config.NUM_BANKS, false);
+
+	locktime = vector<vector<uint64_t> >(config.NUM_RANKS * config.NUM_BANKS);
+	Idletime = vector<vector<uint64_t> >(config.NUM_RANKS * config.NUM_BANKS);
+	bingoPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	notbingoPerBank = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
+	accurancy = vector<float>(config.NUM_RANKS * config.NUM_BANKS, 0);
 //libing	
 
-	totalReadsPerRank = vector<uint64_t>(NUM_RANKS, 0);
-	totalWritesPerRank = vector<uint64_t>(NUM_RANKS, 0);
+	totalReadsPerRank = vector<uint64_t>(config.NUM_RANKS, 0);
+	totalWritesPerRank = vector<uint64_t>(config.NUM_RANKS, 0);
 
-	writeDataCountdown.reserve(NUM_RANKS);
-	writeDataToSend.reserve(NUM_RANKS);
-	refreshCountdown.reserve(NUM_RANKS);  //per rank
+	writeDataCountdown.reserve(config.NUM_RANKS);
+	writeDataToSend.reserve(config.NUM_RANKS);
+	refreshCountdown.reserve(config.NUM_RANKS);  //per rank
 
 	//Power related packets
-	backgroundEnergy = vector<uint64_t>(NUM_RANKS, 0);
-	burstEnergy = vector<uint64_t>(NUM_RANKS, 0);
-	actpreEnergy = vector<uint64_t>(NUM_RANKS, 0);
-	refreshEnergy = vector<uint64_t>(NUM_RANKS, 0);
+	backgroundEnergy = vector<uint64_t>(config.NUM_RANKS, 0);
+	burstEnergy = vector<uint64_t>(config.NUM_RANKS, 0);
+	actpreEnergy = vector<uint64_t>(config.NUM_RANKS, 0);
+	refreshEnergy = vector<uint64_t>(config.NUM_RANKS, 0);
+	cellWriteEnergy = vector<double>(config.NUM_RANKS, 0.0);
+	cellReadEnergy = vector<double>(config.NUM_RANKS, 0.0);
+	grandTotalEnergy = vector<double>(config.NUM_RANKS, 0.0);
 
-	totalEpochLatency = vector<uint64_t>(NUM_RANKS * NUM_BANKS, 0);
+	totalEpochLatency = vector<uint64_t>(config.NUM_RANKS * config.NUM_BANKS, 0);
 
 	//staggers when each rank is due for a refresh
-	for (size_t i = 0; i < NUM_RANKS; i++) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
 		refreshCountdown.push_back(
-				(int) ((REFRESH_PERIOD / tCK) / NUM_RANKS) * (i + 1));
+				(int) ((config.REFRESH_PERIOD / config.tCK) / config.NUM_RANKS) * (i + 1));
 	}
 }
 
@@ -112,7 +164,7 @@ void MemoryController::receiveFromBus(BusPacket *bpacket) {
 		exit(0);
 	}
 
-	if (DEBUG_BUS) {
+	if (config.DEBUG_BUS) {
 		PRINTN(" -- MC Receiving From Data Bus : ");
 		bpacket->print();
 	}
@@ -129,8 +181,8 @@ void MemoryController::receiveFromBus(BusPacket *bpacket) {
 
 void MemoryController::updateBankState() {
 	//update bank states
-	for (size_t i = 0; i < NUM_RANKS; i++) {
-		for (size_t j = 0; j < NUM_BANKS; j++) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
 			if (bankStates[i][j].stateChangeCountdown > 0) {
 				//decrement counters
 				bankStates[i][j].stateChangeCountdown--;
@@ -144,7 +196,7 @@ void MemoryController::updateBankState() {
 						bankStates[i][j].currentBankState =
 								BankState::Precharging;
 						bankStates[i][j].lastCommand = BusPacket::PRECHARGE;
-						bankStates[i][j].stateChangeCountdown = tRP;
+						bankStates[i][j].stateChangeCountdown = config.tRP;
 						break;
 
 					case BusPacket::REFRESH:
@@ -161,7 +213,7 @@ void MemoryController::updateBankState() {
 }
 
 void MemoryController::updateCounter() {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	//check for outgoing command packets and handle countdowns
 	if (outgoingCmdPacket != NULL) {
@@ -180,14 +232,18 @@ void MemoryController::updateCounter() {
 		dataCyclesLeft--;
 		if (dataCyclesLeft == 0) {
 		//	outgoingDataPacket->print();
+			//the rank frees the packet, keep what the callback needs
+			uint64_t writeAddress = outgoingDataPacket->physicalAddress;
+			bool isSETWRITE = outgoingDataPacket->isSETWRITE;
+			bool isScrub = outgoingDataPacket->isScrub;
 			(*ranks)[outgoingDataPacket->rank]->receiveFromBus(
 					outgoingDataPacket);
 
 			//inform upper levels that a write is done
-			if(outgoingDataPacket->isSETWRITE==false){	
+			if(isSETWRITE==false && isScrub==false){	
 				if (parentMemorySystem->WriteDataDone != NULL) {
 					(*parentMemorySystem->WriteDataDone)(channelID,
-							outgoingDataPacket->physicalAddress, currentClockCycle);
+							writeAddress, currentClockCycle);
 				}
 			}
 			outgoingDataPacket = NULL;
@@ -207,7 +263,7 @@ void MemoryController::updateCounter() {
 
 		if (writeDataCountdown[0] == 0) {
 			//send to bus and print debug stuff
-			if (DEBUG_BUS) {
+			if (config.DEBUG_BUS) {
 				PRINTN(" -- MC Issuing On Data Bus    : ");
 				writeDataToSend[0]->print();
 			}
@@ -218,7 +274,7 @@ void MemoryController::updateCounter() {
 				exit(-1);
 			}
 			outgoingDataPacket = writeDataToSend[0];
-			dataCyclesLeft = BL / 2;
+			dataCyclesLeft = config.BL / 2;
 			totalTransactions++;
 			totalWritesPerBank[SEQUENTIAL(writeDataToSend[0]->rank,writeDataToSend[0]->bank)]++;
 
@@ -227,37 +283,42 @@ void MemoryController::updateCounter() {
 		}
 	}
 
+	//PCM is non-volatile, there is nothing to refresh
+	if (config.deviceType == PCMDevice) {
+		return;
+	}
+
 	//if its time for a refresh issue a refresh
 	// else pop from command queue if it's not empty
 	if (refreshCountdown[refreshRank] == 0) {
 		commandQueue.needRefresh(refreshRank);
 		//(*ranks)[refreshRank]->refreshWaiting = true;
-		refreshCountdown[refreshRank] = REFRESH_PERIOD / tCK;
+		refreshCountdown[refreshRank] = config.REFRESH_PERIOD / config.tCK;
 		refreshRank++;
-		if (refreshRank == NUM_RANKS) {
+		if (refreshRank == config.NUM_RANKS) {
 			refreshRank = 0;
 		}
 	}
 	//if a rank is powered down, make sure we power it up in time for a refresh
-	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= tXP) {
+	else if (powerDown[refreshRank] && refreshCountdown[refreshRank] <= config.tXP) {
 		//(*ranks)[refreshRank]->refreshWaiting = true;
 
 	}
 
 	//decrement refresh counters
-	for (size_t i = 0; i < NUM_RANKS; i++) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
 		refreshCountdown[i]--;
 	}
 }
 
 void MemoryController::updateCmdQueue() {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	//pass a pointer to a poppedBusPacket
 	//function returns true if there is something valid in poppedBusPacket
 
 	if (commandQueue.pop(&poppedBusPacket)) {
-		if (SET_IDLE) {
+		if (config.SET_IDLE) {
 			if (poppedBusPacket->busPacketType == BusPacket::WRITE
 					|| poppedBusPacket->busPacketType == BusPacket::WRITE_P) {
 				vector<BusPacket*> bsqueue = commandQueue.getCommandQueue(
@@ -271,8 +332,9 @@ void MemoryController::updateCmdQueue() {
 								Transaction::DATA_WRITE,
 								poppedBusPacket->physicalAddress,
 								poppedBusPacket->data, poppedBusPacket->len);
+						trans->dirtyMask = poppedBusPacket->dirtyMask;
 						trans->timeAdded =
-								Simulator::clockDomainDRAM->clockcycle;
+								clockDomainDRAM->clockcycle;
 						addPartialQueue(trans);
 						added = true;
 						break;
@@ -310,6 +372,8 @@ void MemoryController::updateCmdQueue() {
 			if(poppedBusPacket->busPacketType==BusPacket::SET_WRITE){
 				bpWrite->isSETWRITE=true;			
 			}
+			bpWrite->isScrub = poppedBusPacket->isScrub;
+			bpWrite->dirtyMask = poppedBusPacket->dirtyMask;
 			writeDataToSend.push_back(bpWrite);
 
 			writeDataCountdown.push_back(WL);
@@ -323,14 +387,52 @@ void MemoryController::updateCmdQueue() {
 		unsigned bank = poppedBusPacket->bank;
 		size_t len = poppedBusPacket->len;
 
+		if (poppedBusPacket->busPacketType == BusPacket::WRITE
+				|| poppedBusPacket->busPacketType == BusPacket::WRITE_P) {
+			poppedBusPacket->writeRecovery = config.tWR;
+		} else if (poppedBusPacket->busPacketType == BusPacket::SET_WRITE
+				|| poppedBusPacket->busPacketType == BusPacket::COM_WRITE) {
+			poppedBusPacket->writeRecovery = SET;
+		}
+		if (poppedBusPacket->dirtyMask != 0) {
+			//a cache write back that only programs the words it dirtied
+			uint64_t bytes = 8ULL * __builtin_popcountll(poppedBusPacket->dirtyMask);
+			if (bytes < config.TRANS_DATA_BYTES) {
+				partialWritesPerBank[SEQUENTIAL(poppedBusPacket->rank,poppedBusPacket->bank)]++;
+				partialBytesSavedPerBank[SEQUENTIAL(poppedBusPacket->rank,poppedBusPacket->bank)] += config.TRANS_DATA_BYTES - bytes;
+			}
+		}
+#if defined(DATA_STORAGE) && !defined(DATA_RELIABILITY_ECC)
+		//data-comparison write: the bank reads the old line first and only
+		//programs the cells that change, a write that changes nothing needs no
+		//write recovery and a SET is only needed if some cell goes to 1
+		uint64_t setBits, resetBits;
+		if (config.DATA_COMPARE_WRITE
+				&& (poppedBusPacket->busPacketType == BusPacket::WRITE
+						|| poppedBusPacket->busPacketType == BusPacket::WRITE_P
+						|| poppedBusPacket->busPacketType == BusPacket::SET_WRITE
+						|| poppedBusPacket->busPacketType == BusPacket::COM_WRITE)
+				&& (*ranks)[rank]->previewWrite(poppedBusPacket, setBits, resetBits)) {
+			if (setBits + resetBits == 0) {
+				poppedBusPacket->writeRecovery = 0;
+				silentWritesPerBank[SEQUENTIAL(rank,bank)]++;
+			} else if (setBits == 0
+					&& poppedBusPacket->writeRecovery == SET) {
+				poppedBusPacket->writeRecovery = config.tWR;
+				resetOnlyWritesPerBank[SEQUENTIAL(rank,bank)]++;
+			}
+		}
+#endif
+
 		switch (poppedBusPacket->busPacketType) {
 		case BusPacket::READ_P:
 		case BusPacket::READ:
 			//add energy to account for total
-			if (DEBUG_POWER) {
+			if (config.DEBUG_POWER) {
 				PRINT(" ++ Adding Read energy to total energy");
 			}
-			burstEnergy[rank] += (IDD4R - IDD3N) * BL / 2 * len;
+			burstEnergy[rank] += (config.IDD4R - config.IDD3N) * config.BL / 2 * len;
+			cellReadEnergy[rank] += config.RD_ENERGY_BIT * config.TRANS_DATA_BYTES * 8;
 			if (poppedBusPacket->busPacketType == BusPacket::READ_P) {
 				//Don't bother setting next read or write times because the bank is no longer active
 				//bankStates[rank][bank].currentBankState = Idle;
@@ -347,14 +449,14 @@ void MemoryController::updateCmdQueue() {
 
 			}
 
-			for (size_t i = 0; i < NUM_RANKS; i++) {
-				for (size_t j = 0; j < NUM_BANKS; j++) {
+			for (size_t i = 0; i < config.NUM_RANKS; i++) {
+				for (size_t j = 0; j < config.NUM_BANKS; j++) {
 					if (i != poppedBusPacket->rank) {
 						//check to make sure it is active before trying to set (save's time?)
 						if (bankStates[i][j].currentBankState
 								== BankState::RowActive) {
 							bankStates[i][j].nextRead = max(
-									currentClockCycle + BL / 2 + tRTRS,
+									currentClockCycle + config.BL / 2 + config.tRTRS,
 									bankStates[i][j].nextRead);
 							bankStates[i][j].nextWrite = max(
 									currentClockCycle + READ_TO_WRITE_DELAY,
@@ -362,7 +464,7 @@ void MemoryController::updateCmdQueue() {
 						}
 					} else {
 						bankStates[i][j].nextRead = max(
-								currentClockCycle + max(tCCD, BL / 2),
+								currentClockCycle + max(config.tCCD, config.BL / 2),
 								bankStates[i][j].nextRead);
 						bankStates[i][j].nextWrite = max(
 								currentClockCycle + READ_TO_WRITE_DELAY,
@@ -395,28 +497,28 @@ void MemoryController::updateCmdQueue() {
 
 			if (poppedBusPacket->busPacketType == BusPacket::WRITE_P) {
 				bankStates[rank][bank].nextActivate = max(
-						currentClockCycle + WRITE_AUTOPRE_DELAY,
+						currentClockCycle + WRITE_AUTOPRE_DELAY_N(poppedBusPacket->writeRecovery),
 						bankStates[rank][bank].nextActivate);
 				bankStates[rank][bank].lastCommand = BusPacket::WRITE_P;
 				bankStates[rank][bank].stateChangeCountdown =
-						WRITE_TO_PRE_DELAY;
+						WRITE_TO_PRE_DELAY_N(poppedBusPacket->writeRecovery);
 			} else if (poppedBusPacket->busPacketType == BusPacket::WRITE) {
 				bankStates[rank][bank].nextPrecharge = max(
-						currentClockCycle + WRITE_TO_PRE_DELAY,
+						currentClockCycle + WRITE_TO_PRE_DELAY_N(poppedBusPacket->writeRecovery),
 						bankStates[rank][bank].nextPrecharge);
 				bankStates[rank][bank].lastCommand = BusPacket::WRITE;
 			} else if (poppedBusPacket->busPacketType == BusPacket::SET_WRITE
 					|| poppedBusPacket->busPacketType == BusPacket::COM_WRITE) {
-				if (SET_CLOSE) {
+				if (config.SET_CLOSE) {
 					bankStates[rank][bank].nextActivate = max(
-							currentClockCycle + SET_AUTOPRE_DELAY,
+							currentClockCycle + WRITE_AUTOPRE_DELAY_N(poppedBusPacket->writeRecovery),
 							bankStates[rank][bank].nextActivate);
 					bankStates[rank][bank].lastCommand = BusPacket::SET_WRITE;
 					bankStates[rank][bank].stateChangeCountdown =
-							SET_TO_PRE_DELAY;
+							WRITE_TO_PRE_DELAY_N(poppedBusPacket->writeRecovery);
 				} else {
 					bankStates[rank][bank].nextPrecharge = max(
-							currentClockCycle + SET_TO_PRE_DELAY,
+							currentClockCycle + WRITE_TO_PRE_DELAY_N(poppedBusPacket->writeRecovery),
 							bankStates[rank][bank].nextPrecharge);
 					bankStates[rank][bank].lastCommand = BusPacket::SET_WRITE;
 
@@ -425,18 +527,18 @@ void MemoryController::updateCmdQueue() {
 			}
 
 			//add energy to account for total
-			if (DEBUG_POWER) {
+			if (config.DEBUG_POWER) {
 				PRINT(" ++ Adding Write energy to total energy");
 			}
-			burstEnergy[rank] += (IDD4W - IDD3N) * BL / 2 * len;
+			burstEnergy[rank] += (config.IDD4W - config.IDD3N) * config.BL / 2 * len;
 
-			for (size_t i = 0; i < NUM_RANKS; i++) {
-				for (size_t j = 0; j < NUM_BANKS; j++) {
+			for (size_t i = 0; i < config.NUM_RANKS; i++) {
+				for (size_t j = 0; j < config.NUM_BANKS; j++) {
 					if (i != poppedBusPacket->rank) {
 						if (bankStates[i][j].currentBankState
 								== BankState::RowActive) {
 							bankStates[i][j].nextWrite = max(
-									currentClockCycle + BL / 2 + tRTRS,
+									currentClockCycle + config.BL / 2 + config.tRTRS,
 									bankStates[i][j].nextWrite);
 							bankStates[i][j].nextRead = max(
 									currentClockCycle + WRITE_TO_READ_DELAY_R,
@@ -444,7 +546,7 @@ void MemoryController::updateCmdQueue() {
 						}
 					} else {
 						bankStates[i][j].nextWrite = max(
-								currentClockCycle + max(BL / 2, tCCD),
+								currentClockCycle + max(config.BL / 2, config.tCCD),
 								bankStates[i][j].nextWrite);
 						bankStates[i][j].nextRead = max(
 								currentClockCycle + WRITE_TO_READ_DELAY_B,
@@ -469,34 +571,34 @@ void MemoryController::updateCmdQueue() {
 			break;
 		case BusPacket::ACTIVATE:
 			//add energy to account for total
-			if (DEBUG_POWER) {
+			if (config.DEBUG_POWER) {
 				PRINT(
 						" ++ Adding Activate and Precharge energy to total energy");
 			}
-			actpreEnergy[rank] += ((IDD0 * tRC)
-					- ((IDD3N * tRAS) + (IDD2N * (tRC - tRAS)))) * len;
+			actpreEnergy[rank] += ((config.IDD0 * config.tRC)
+					- ((config.IDD3N * config.tRAS) + (config.IDD2N * (config.tRC - config.tRAS)))) * len;
 
 			bankStates[rank][bank].currentBankState = BankState::RowActive;
 			bankStates[rank][bank].lastCommand = BusPacket::ACTIVATE;
 			bankStates[rank][bank].openRowAddress = poppedBusPacket->row;
-			bankStates[rank][bank].nextActivate = max(currentClockCycle + tRC,
+			bankStates[rank][bank].nextActivate = max(currentClockCycle + config.tRC,
 					bankStates[rank][bank].nextActivate);
-			bankStates[rank][bank].nextPrecharge = max(currentClockCycle + tRAS,
+			bankStates[rank][bank].nextPrecharge = max(currentClockCycle + config.tRAS,
 					bankStates[rank][bank].nextPrecharge);
 
 			//if we are using posted-CAS, the next column access can be sooner than normal operation
 
 			bankStates[rank][bank].nextRead = max(
-					currentClockCycle + (tRCD - AL),
+					currentClockCycle + (config.tRCD - config.AL),
 					bankStates[rank][bank].nextRead);
 			bankStates[rank][bank].nextWrite = max(
-					currentClockCycle + (tRCD - AL),
+					currentClockCycle + (config.tRCD - config.AL),
 					bankStates[rank][bank].nextWrite);
 
-			for (size_t i = 0; i < NUM_BANKS; i++) {
+			for (size_t i = 0; i < config.NUM_BANKS; i++) {
 				if (i != poppedBusPacket->bank) {
 					bankStates[rank][i].nextActivate = max(
-							currentClockCycle + tRRD,
+							currentClockCycle + config.tRRD,
 							bankStates[rank][i].nextActivate);
 				}
 			}
@@ -506,24 +608,24 @@ void MemoryController::updateCmdQueue() {
 		case BusPacket::PRECHARGE:
 			bankStates[rank][bank].currentBankState = BankState::Precharging;
 			bankStates[rank][bank].lastCommand = BusPacket::PRECHARGE;
-			bankStates[rank][bank].stateChangeCountdown = tRP;
-			bankStates[rank][bank].nextActivate = max(currentClockCycle + tRP,
+			bankStates[rank][bank].stateChangeCountdown = config.tRP;
+			bankStates[rank][bank].nextActivate = max(currentClockCycle + config.tRP,
 					bankStates[rank][bank].nextActivate);
 
 			cmdStat.prechangeCounter++;
 			break;
 		case BusPacket::REFRESH:
 			//add energy to account for total
-			if (DEBUG_POWER) {
+			if (config.DEBUG_POWER) {
 				PRINT(" ++ Adding Refresh energy to total energy");
 			}
-			refreshEnergy[rank] += (IDD5 - IDD3N) * tRFC * NUM_DEVICES;
+			refreshEnergy[rank] += (config.IDD5 - config.IDD3N) * config.tRFC * config.NUM_DEVICES;
 
-			for (size_t i = 0; i < NUM_BANKS; i++) {
-				bankStates[rank][i].nextActivate = currentClockCycle + tRFC;
+			for (size_t i = 0; i < config.NUM_BANKS; i++) {
+				bankStates[rank][i].nextActivate = currentClockCycle + config.tRFC;
 				bankStates[rank][i].currentBankState = BankState::Refreshing;
 				bankStates[rank][i].lastCommand = BusPacket::REFRESH;
-				bankStates[rank][i].stateChangeCountdown = tRFC;
+				bankStates[rank][i].stateChangeCountdown = config.tRFC;
 			}
 
 			cmdStat.refreshCounter++;
@@ -535,8 +637,22 @@ void MemoryController::updateCmdQueue() {
 			exit(0);
 		}
 
+		if (scrubbing
+				&& (poppedBusPacket->busPacketType == BusPacket::WRITE
+						|| poppedBusPacket->busPacketType == BusPacket::WRITE_P
+						|| poppedBusPacket->busPacketType == BusPacket::SET_WRITE
+						|| poppedBusPacket->busPacketType == BusPacket::COM_WRITE)) {
+			if (poppedBusPacket->isScrub) {
+				scrubPending[SEQUENTIAL(rank,bank)] = false;
+				scrubBusyUntil[SEQUENTIAL(rank,bank)] =
+						bankStates[rank][bank].nextActivate;
+				scrubsPerBank[SEQUENTIAL(rank,bank)]++;
+			}
+			recordLineWrite(poppedBusPacket->physicalAddress);
+		}
+
 		//issue on bus and print debug
-		if (DEBUG_BUS) {
+		if (config.DEBUG_BUS) {
 			PRINTN(" -- MC Issuing On Command Bus : ");
 			poppedBusPacket->print();
 		}
@@ -547,7 +663,7 @@ void MemoryController::updateCmdQueue() {
 			exit(-1);
 		}
 		outgoingCmdPacket = poppedBusPacket;
-		cmdCyclesLeft = tCMD;
+		cmdCyclesLeft = config.tCMD;
 
 	}
 }
@@ -570,7 +686,7 @@ void MemoryController::updateTransQueue() {
 		//if we have room, break up the transaction into the appropriate commands
 		//and add them to the command queue
 		if (commandQueue.hasRoomFor(2, newRank, newBank)) {
-			if (DEBUG_ADDR_MAP) {
+			if (config.DEBUG_ADDR_MAP) {
 				PRINTN(
 						"== New Transaction - Mapping Address [0x" << hex << transaction->address << dec << "]");
 				if (transaction->transactionType == Transaction::DATA_READ) {
@@ -595,20 +711,29 @@ void MemoryController::updateTransQueue() {
 					transaction->data, transaction->len);
 
 			//create read or write command and enqueue it
-			BusPacket::BusPacketType bpType = transaction->getBusPacketType();
+			BusPacket::BusPacketType bpType = transaction->getBusPacketType(config.rowBufferPolicy);
 			BusPacket *command = new BusPacket(bpType, newRank, newBank, newRow,
 					newColumn, transaction->address, transaction->data,
 					transaction->len);
+			command->dirtyMask = transaction->dirtyMask;
 
 			commandQueue.enqueue(ACTcommand);
 			commandQueue.enqueue(command);
 
+			//the demand access has to wait for a scrub to the same bank
+			if (scrubbing
+					&& (scrubPending[SEQUENTIAL(newRank,newBank)]
+							|| clockDomainDRAM->clockcycle
+									< scrubBusyUntil[SEQUENTIAL(newRank,newBank)])) {
+				scrubCollisionsPerBank[SEQUENTIAL(newRank,newBank)]++;
+			}
+
 			// If we have a read, save the transaction so when the data comes back
 			// in a bus packet, we can staple it back into a transaction and return it
 			if (transaction->transactionType == Transaction::DATA_READ) {
 				pendingReadTransactions.push_back(transaction);
 			} else {
-				if (SET_IDLE) {
+				if (config.SET_IDLE) {
 					//cout << "add to Partial Queue\n";
 					//update the CMD queue, and the time
 					scheduleCMD(command, commandQueue);
@@ -635,13 +760,13 @@ void MemoryController::addPartialQueue(Transaction *trans) { //libing
 	if (PSQueue.size() >= MAX_DEPTH) { //todo: what if PQ full
 		/*		DEBUG("Partial Queue is FULL!");
 		 std::cout << " current cycle is "
-		 << Simulator::clockDomainCPU->clockcycle << std::endl;
+		 << clockDomainCPU->clockcycle << std::endl;
 		 //printPartialQueue();
 		 //commandQueue.print();
 		 //exit(0);*/
 		return;
 	}
-	trans->timeAdded = Simulator::clockDomainCPU->clockcycle;
+	trans->timeAdded = clockDomainCPU->clockcycle;
 	for (list<Transaction*>::iterator iter = PSQueue.begin();
 			iter != PSQueue.end(); ++iter) {
 		Transaction* transaction = *iter;
@@ -715,13 +840,13 @@ void MemoryController::updatePartialQueue() {
 			uint64_t interval =0 ;
 			if (lockBank[SEQUENTIAL(newRank,newBank)] == false) {
 				locktime[SEQUENTIAL(newRank,newRank)].push_back(
-						Simulator::clockDomainDRAM->clockcycle);
+						clockDomainDRAM->clockcycle);
 				lockBank[SEQUENTIAL(newRank,newBank)] = true;
 				//check the history
 			} else {
 				vector<uint64_t>::iterator timeiter =
 						locktime[SEQUENTIAL(newRank,newBank)].end();
-				interval = Simulator::clockDomainDRAM->clockcycle
+				interval = clockDomainDRAM->clockcycle
 						- *(--timeiter);
 				if (interval >= threshold || commandQueue.isEmpty(newRank)) {
 								BusPacket *ACTcommand = new BusPacket(BusPacket::ACTIVATE,
@@ -813,14 +938,14 @@ void MemoryController::getIdleInterval() {
 
 	//every bank : lock,empty time,
 	//uint64_t idleTime(0);
-	for (size_t i = 0; i < NUM_RANKS; i++) {
-		for (size_t j = 0; j < NUM_BANKS; j++) {
-			if (!SET_IDLE) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
+			if (!config.SET_IDLE) {
 				if (bankStates[i][j].currentBankState == BankState::Idle
 						&& commandQueue.isbankEmpty(i, j)) {
 					if (lockBank[SEQUENTIAL(i,j)] == false) {
 						locktime[SEQUENTIAL(i,j)].push_back(
-								Simulator::clockDomainDRAM->clockcycle);
+								clockDomainDRAM->clockcycle);
 						lockBank[SEQUENTIAL(i,j)] = true;
 					}
 /*					if (commandQueue.isEmpty(i)){
@@ -831,7 +956,7 @@ void MemoryController::getIdleInterval() {
 						lockBank[SEQUENTIAL(i,j)] = false;
 						vector<uint64_t>::iterator iter =
 								locktime[SEQUENTIAL(i,j)].end();
-						uint64_t idle = Simulator::clockDomainDRAM->clockcycle
+						uint64_t idle = clockDomainDRAM->clockcycle
 								- *(--iter);
 						Idletime[SEQUENTIAL(i,j)].push_back(idle);
 						if (commandQueue.isEmpty(i)){
@@ -843,14 +968,14 @@ void MemoryController::getIdleInterval() {
 					}
 				}
 			}
-			if (SET_IDLE) {
+			if (config.SET_IDLE) {
 				if (lockBank[SEQUENTIAL(i,j)] == true) {
 					if (!commandQueue.isbankEmpty(i, j)) {
 							lockBank[SEQUENTIAL(i,j)] = false;
 							vector<uint64_t>::iterator iter =
 									locktime[SEQUENTIAL(i,j)].end();
 							uint64_t idle =
-									Simulator::clockDomainDRAM->clockcycle
+									clockDomainDRAM->clockcycle
 											- *(--iter);
 							Idletime[SEQUENTIAL(i,j)].push_back(idle);
 							if (idle > SET_TO_PRE_DELAY) {
@@ -864,7 +989,7 @@ void MemoryController::getIdleInterval() {
 
 					 if (lockBank[SEQUENTIAL(i,j)] == false) {
 					 locktime[SEQUENTIAL(i,j)].push_back(
-					 Simulator::clockDomainDRAM->clockcycle);
+					 clockDomainDRAM->clockcycle);
 					 lockBank[SEQUENTIAL(i,j)] = true;
 					 }
 					 } else {  //there is no other packet then idle , else busy
@@ -873,7 +998,7 @@ void MemoryController::getIdleInterval() {
 					 == BusPacket::SET_WRITE) { //cmd is idle
 					 if (lockBank[SEQUENTIAL(i,j)] == false) {
 					 locktime[SEQUENTIAL(i,j)].push_back(
-					 Simulator::clockDomainDRAM->clockcycle);
+					 clockDomainDRAM->clockcycle);
 					 lockBank[SEQUENTIAL(i,j)] = true;
 					 }
 					 } else { //cmd is not idle
@@ -882,7 +1007,7 @@ void MemoryController::getIdleInterval() {
 					 vector<uint64_t>::iterator iter =
 					 locktime[SEQUENTIAL(i,j)].end();
 					 uint64_t idle =
-					 Simulator::clockDomainDRAM->clockcycle
+					 clockDomainDRAM->clockcycle
 					 - *(--iter);
 					 Idletime[SEQUENTIAL(i,j)].push_back(idle);
 					 if (idle > SET_TO_PRE_DELAY) {
@@ -904,7 +1029,7 @@ void MemoryController::getIdleInterval() {
 					 vector<uint64_t>::iterator iter =
 					 locktime[SEQUENTIAL(i,j)].end();
 					 uint64_t idle =
-					 Simulator::clockDomainDRAM->clockcycle
+					 clockDomainDRAM->clockcycle
 					 - *(--iter);
 					 Idletime[SEQUENTIAL(i,j)].push_back(idle);
 					 if (idle > SET_TO_PRE_DELAY) {
@@ -917,7 +1042,7 @@ void MemoryController::getIdleInterval() {
 					 if (n != 0 && (n == popcmd.size())) { //cmd is checked and no other packet, then idle
 					 if (lockBank[SEQUENTIAL(i,j)] == false) {
 					 locktime[SEQUENTIAL(i,j)].push_back(
-					 Simulator::clockDomainDRAM->clockcycle);
+					 clockDomainDRAM->clockcycle);
 					 lockBank[SEQUENTIAL(i,j)] = true;
 					 }
 					 }
@@ -928,7 +1053,7 @@ void MemoryController::getIdleInterval() {
 					 lockBank[SEQUENTIAL(i,j)] = false;
 					 vector<uint64_t>::iterator iter =
 					 locktime[SEQUENTIAL(i,j)].end();
-					 uint64_t idle = Simulator::clockDomainDRAM->clockcycle
+					 uint64_t idle = clockDomainDRAM->clockcycle
 					 - *(--iter);
 					 Idletime[SEQUENTIAL(i,j)].push_back(idle);
 					 if (idle > SET_TO_PRE_DELAY) {
@@ -952,7 +1077,7 @@ void MemoryController::scheduleCMD(BusPacket *busPacket,
 	/*	if (*busPacket != *(enditer - 1)) {
 	 return;
 	 }*/
-	if (queuingStructure == PerRankPerBank) {
+	if (config.queuingStructure == PerRankPerBank) {
 		for (vector<BusPacket*>::iterator iter = queue.begin();
 				iter < queue.end(); ++iter) {
 			BusPacket * bpacket = *iter;
@@ -988,7 +1113,7 @@ void MemoryController::scheduleCMD(BusPacket *busPacket,
 
 void MemoryController::issuePartialSET() {
 
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 	if (PSQueue.size() == 0) {
 		return;
 	}
@@ -1018,17 +1143,17 @@ void MemoryController::issuePartialSET() {
 	}
 }
 void MemoryController::updatePower() {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	//calculate power
 	//  this is done on a per-rank basis, since power characterization is done per device (not per bank)
-	for (size_t i = 0; i < NUM_RANKS; i++) {
-		if (USE_LOW_POWER) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
+		if (config.USE_LOW_POWER) {
 			//if there are no commands in the queue and that particular rank is not waiting for a refresh...
 			if (commandQueue.isEmpty(i) && !(*ranks)[i]->refreshWaiting) {
 				//check to make sure all banks are idle
 				bool allIdle = true;
-				for (size_t j = 0; j < NUM_BANKS; j++) {
+				for (size_t j = 0; j < config.NUM_BANKS; j++) {
 					if (bankStates[i][j].currentBankState != BankState::Idle) {
 						allIdle = false;
 						break;
@@ -1040,10 +1165,10 @@ void MemoryController::updatePower() {
 
 					powerDown[i] = true;
 					(*ranks)[i]->powerDown();
-					for (size_t j = 0; j < NUM_BANKS; j++) {
+					for (size_t j = 0; j < config.NUM_BANKS; j++) {
 						bankStates[i][j].currentBankState =
 								BankState::PowerDown;
-						bankStates[i][j].nextPowerUp = currentClockCycle + tCKE;
+						bankStates[i][j].nextPowerUp = currentClockCycle + config.tCKE;
 					}
 
 				}
@@ -1054,16 +1179,16 @@ void MemoryController::updatePower() {
 					{
 				powerDown[i] = false;
 				(*ranks)[i]->powerUp();
-				for (size_t j = 0; j < NUM_BANKS; j++) {
+				for (size_t j = 0; j < config.NUM_BANKS; j++) {
 					bankStates[i][j].currentBankState = BankState::Idle;
-					bankStates[i][j].nextActivate = currentClockCycle + tXP;
+					bankStates[i][j].nextActivate = currentClockCycle + config.tXP;
 				}
 			}
 		}
 
 		//check for open bank
 		bool bankOpen = false;
-		for (size_t j = 0; j < NUM_BANKS; j++) {
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
 			if (bankStates[i][j].currentBankState == BankState::Refreshing
 					|| bankStates[i][j].currentBankState
 							== BankState::RowActive) {
@@ -1074,24 +1199,24 @@ void MemoryController::updatePower() {
 
 		//background power is dependent on whether or not a bank is open or not
 		if (bankOpen) {
-			if (DEBUG_POWER) {
+			if (config.DEBUG_POWER) {
 				PRINT(" ++ Adding IDD3N to total energy [from rank "<< i <<"]");
 			}
-			backgroundEnergy[i] += IDD3N * NUM_DEVICES;
+			backgroundEnergy[i] += config.IDD3N * config.NUM_DEVICES;
 		} else {
 			//if we're in power-down mode, use the correct current
 			if (powerDown[i]) {
-				if (DEBUG_POWER) {
+				if (config.DEBUG_POWER) {
 					PRINT(
 							" ++ Adding IDD2P to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2P * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2P * config.NUM_DEVICES;
 			} else {
-				if (DEBUG_POWER) {
+				if (config.DEBUG_POWER) {
 					PRINT(
 							" ++ Adding IDD2N to total energy [from rank " << i << "]");
 				}
-				backgroundEnergy[i] += IDD2N * NUM_DEVICES;
+				backgroundEnergy[i] += config.IDD2N * config.NUM_DEVICES;
 			}
 		}
 	}
@@ -1100,7 +1225,7 @@ void MemoryController::updatePower() {
 void MemoryController::updateReturnTrans() {
 	//check for outstanding data to return to the CPU
 	if (returnTransaction.size() > 0) {
-		if (DEBUG_BUS) {
+		if (config.DEBUG_BUS) {
 			PRINTN(" -- MC Issuing to CPU bus : ");
 			returnTransaction[0]->print();
 		}
@@ -1122,11 +1247,11 @@ void MemoryController::updateReturnTrans() {
 						returnTransaction[0]->address, chan, rank, bank, row,
 						col);
 				insertHistogram(
-						Simulator::clockDomainCPU->clockcycle
+						clockDomainCPU->clockcycle
 								- pendingReadTransactions[i]->timeAdded, rank,
 						bank);
 				//return latency
-				if (DEBUG_ADDR_MAP)				// //added by libing 2013-4-23
+				if (config.DEBUG_ADDR_MAP)				// //added by libing 2013-4-23
 				{
 					if (pendingReadTransactions[i]->transactionType
 							== Transaction::DATA_READ)					//
@@ -1138,12 +1263,12 @@ void MemoryController::updateReturnTrans() {
 								"Write access Address [0x" << hex << pendingReadTransactions[i]->address << dec << "]");
 					}
 					PRINT(
-							"  Bank : " << bank <<"  issue  time: " << pendingReadTransactions[i]->timeAdded << " return time: " << Simulator::clockDomainDRAM->clockcycle); //added by libing 2013-4-23
+							"  Bank : " << bank <<"  issue  time: " << pendingReadTransactions[i]->timeAdded << " return time: " << clockDomainDRAM->clockcycle); //added by libing 2013-4-23
 				}
 				if (parentMemorySystem->ReadDataDone != NULL) {
 					(*parentMemorySystem->ReadDataDone)(channelID,
 							pendingReadTransactions[i]->address,
-							Simulator::clockDomainDRAM->clockcycle);
+							clockDomainDRAM->clockcycle);
 				}
 
 				delete pendingReadTransactions[i];
@@ -1158,18 +1283,20 @@ void MemoryController::updateReturnTrans() {
 					"Can't find a matching transaction for 0x"<<hex<<returnTransaction[0]->address<<dec);
 			abort();
 		}
+		//the read data has no other owner
+		delete returnTransaction[0]->data;
 		delete returnTransaction[0];
 		returnTransaction.erase(returnTransaction.begin());
 	}
 }
 
 void MemoryController::updatePrint() {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	//
 	//print debug
 	//
-	if (DEBUG_TRANS_Q) {
+	if (config.DEBUG_TRANS_Q) {
 		//	PRINT("== Printing transaction queue");
 		for (size_t i = 0; i < transactionQueue.size(); i++) {
 			PRINT("== Printing transaction queue");
@@ -1178,11 +1305,11 @@ void MemoryController::updatePrint() {
 		}
 	}
 
-	if (DEBUG_BANKSTATE) {
+	if (config.DEBUG_BANKSTATE) {
 		//TODO: move this to BankState.cpp
 		PRINT("== Printing bank states (According to MC)");
-		for (size_t i = 0; i < NUM_RANKS; i++) {
-			for (size_t j = 0; j < NUM_BANKS; j++) {
+		for (size_t i = 0; i < config.NUM_RANKS; i++) {
+			for (size_t j = 0; j < config.NUM_BANKS; j++) {
 				if (bankStates[i][j].currentBankState == BankState::RowActive) {
 					PRINTN("[" << bankStates[i][j].openRowAddress << "] ");
 				} else if (bankStates[i][j].currentBankState
@@ -1203,13 +1330,13 @@ void MemoryController::updatePrint() {
 		}
 	}
 
-	if (DEBUG_CMD_Q) {
+	if (config.DEBUG_CMD_Q) {
 		commandQueue.print();
 	}
 
 	//print stats if we're at the end of an epoch
-		if (EPOCH_LENGTH != 0 && currentClockCycle != 0
-	 && currentClockCycle % EPOCH_LENGTH == 0)
+		if (config.EPOCH_LENGTH != 0 && currentClockCycle != 0
+	 && currentClockCycle % config.EPOCH_LENGTH == 0)
 {
 
 		this->printStats();
@@ -1225,112 +1352,272 @@ void MemoryController::updatePrint() {
 		 */
 
 		totalTransactions = 0;
-		for (size_t i = 0; i < NUM_RANKS; i++) {
-			for (size_t j = 0; j < NUM_BANKS; j++) {
+		for (size_t i = 0; i < config.NUM_RANKS; i++) {
+			for (size_t j = 0; j < config.NUM_BANKS; j++) {
 				//XXX: this means the bank list won't be printed for partial epochs
 				totalReadsPerBank[SEQUENTIAL(i,j)] = 0;
 				totalWritesPerBank[SEQUENTIAL(i,j)] = 0;
 				totalEpochLatency[SEQUENTIAL(i,j)] = 0;
 				fullSETPerBank[SEQUENTIAL(i,j)] = 0;
+				setBitsPerBank[SEQUENTIAL(i,j)] = 0;
+				resetBitsPerBank[SEQUENTIAL(i,j)] = 0;
 
 			}
 
+			grandTotalEnergy[i] += epochEnergy(i);
 			burstEnergy[i] = 0;
 			actpreEnergy[i] = 0;
 			refreshEnergy[i] = 0;
 			backgroundEnergy[i] = 0;
+			cellWriteEnergy[i] = 0;
+			cellReadEnergy[i] = 0;
 			totalReadsPerRank[i] = 0;
 			totalWritesPerRank[i] = 0;
 		}
 	}
 }
 
+//energy a rank used this epoch, in pJ (IDD [mA] * Vdd [V] * tCK [ns])
+double MemoryController::epochEnergy(unsigned rank) const {
+	return (double) (backgroundEnergy[rank] + burstEnergy[rank] + actpreEnergy[rank] + refreshEnergy[rank]) * config.Vdd * config.tCK
+			+ cellWriteEnergy[rank] + cellReadEnergy[rank];
+}
+
+//called by the rank once the write data has reached the cells
+void MemoryController::updateCellWriteEnergy(const BusPacket *dataPacket,
+		uint64_t setBits, uint64_t resetBits) {
+	unsigned rank = dataPacket->rank;
+	unsigned bank = dataPacket->bank;
+
+	if (config.DEBUG_POWER) {
+		PRINT(" ++ Adding cell write energy ("<<setBits<<" SET, "<<resetBits<<" RESET bits) to total energy");
+	}
+	setBitsPerBank[SEQUENTIAL(rank,bank)] += setBits;
+	resetBitsPerBank[SEQUENTIAL(rank,bank)] += resetBits;
+	cellWriteEnergy[rank] += setBits * config.SET_ENERGY_BIT
+			+ resetBits * config.WR_ENERGY_BIT;
+}
+
+//a line was (re)written: its drift window starts again
+void MemoryController::recordLineWrite(uint64_t address) {
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
+	address &= ~(uint64_t) (config.TRANS_DATA_BYTES - 1);
+
+	map<uint64_t, list<ScrubLine>::iterator>::iterator it = scrubIndex.find(
+			address);
+	if (it != scrubIndex.end()) {
+		scrubLines.erase(it->second);
+	}
+	ScrubLine line = { address, currentClockCycle };
+	scrubIndex[address] = scrubLines.insert(scrubLines.end(), line);
+}
+
+//rewrite the lines whose drift window has run out, but only into banks that
+//have nothing else to do; the list is in write order, so only its head can
+//be due
+void MemoryController::updateScrub() {
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
+	size_t examined = 0;
+
+	for (list<ScrubLine>::iterator iter = scrubLines.begin();
+			iter != scrubLines.end() && examined < config.NUM_RANKS * config.NUM_BANKS;
+			++iter, ++examined) {
+		if (currentClockCycle - iter->lastWrite < driftCycles) {
+			break;
+		}
+		unsigned newChan, newRank, newBank, newRow, newColumn;
+		parentMemorySystem->addressMapping(iter->address, newChan, newRank,
+				newBank, newRow, newColumn);
+		if (scrubPending[SEQUENTIAL(newRank,newBank)]
+				|| (bankStates[newRank][newBank].currentBankState != BankState::Idle
+						&& bankStates[newRank][newBank].currentBankState != BankState::PowerDown)
+				|| !commandQueue.hasRoomFor(2, newRank, newBank)) {
+			continue;
+		}
+		vector<BusPacket *> &queue = commandQueue.getCommandQueue(newRank,
+				newBank);
+		bool bankBusy = false;
+		for (size_t i = 0; i < queue.size(); i++) {
+			if (queue[i]->bank == newBank) {
+				bankBusy = true;
+				break;
+			}
+		}
+		if (bankBusy) {
+			continue;
+		}
+
+		//the line is sensed by the activate and written back as it is
+		BusPacket *ACTcommand = new BusPacket(BusPacket::ACTIVATE, newRank,
+				newBank, newRow, newColumn, iter->address, NULL, LEN_DEF);
+		BusPacket *command = new BusPacket(
+				config.rowBufferPolicy == ClosePage ? BusPacket::WRITE_P : BusPacket::WRITE,
+				newRank, newBank, newRow, newColumn, iter->address, NULL,
+				LEN_DEF);
+		command->isScrub = true;
+		commandQueue.enqueue(ACTcommand);
+		commandQueue.enqueue(command);
+		scrubPending[SEQUENTIAL(newRank,newBank)] = true;
+
+		uint64_t lateness = currentClockCycle - iter->lastWrite - driftCycles;
+		maxScrubLateness = max(maxScrubLateness, lateness);
+	}
+}
+
+//result of the ECC check of a line read by a demand access or a scrub
+void MemoryController::recordEcc(unsigned rank, unsigned bank,
+		unsigned correctedWords, unsigned uncorrectableWords, bool scrub) {
+	if (scrub) {
+		scrubCorrectedPerBank[SEQUENTIAL(rank,bank)] += correctedWords;
+		scrubUncorrectablePerBank[SEQUENTIAL(rank,bank)] += uncorrectableWords;
+	} else {
+		eccCorrectedPerBank[SEQUENTIAL(rank,bank)] += correctedWords;
+		eccUncorrectablePerBank[SEQUENTIAL(rank,bank)] += uncorrectableWords;
+	}
+}
+
 void MemoryController::update() {
 
 	//PRINT(" ------------------------- [" << currentClockCycle << "] -------------------------");
 
+	PROFILE_START(profile);
 	updateBankState();
+	PROFILE_LAP(profile, BANK_STATE);
 
 	updateCounter();
+	PROFILE_LAP(profile, COUNTER);
 
 	updateCmdQueue();
+	PROFILE_LAP(profile, CMD_QUEUE);
 
 	updateTransQueue();
+	PROFILE_LAP(profile, TRANS_QUEUE);
+
+	if (scrubbing) {
+		updateScrub();
+		PROFILE_LAP(profile, SCRUB);
+	}
 
 	updateReturnTrans();
+	PROFILE_LAP(profile, RETURN_TRANS);
 
 	updatePower();
-	if (SET_IDLE) {
+	PROFILE_LAP(profile, POWER);
+	if (config.SET_IDLE) {
 
 		updatePartialQueue();
+		PROFILE_LAP(profile, PARTIAL_QUEUE);
 
 		issuePartialSET();
+		PROFILE_LAP(profile, PARTIAL_SET);
 	}
 	else {
 		getIdleInterval();
+		PROFILE_LAP(profile, IDLE_INTERVAL);
 	}
 
 	updatePrint();
+	PROFILE_LAP(profile, UPDATE_PRINT);
 
 }
 
 //allows outside source to make request of memory system
 bool MemoryController::addTransaction(Transaction *trans) {
-	if (transactionQueue.size() < TRANS_QUEUE_DEPTH) {
-		trans->timeAdded = Simulator::clockDomainCPU->clockcycle;
+	if (transactionQueue.size() < config.TRANS_QUEUE_DEPTH) {
+		trans->timeAdded = clockDomainCPU->clockcycle;
 		transactionQueue.push_back(trans);
 		return true;
 	} else {
 		return false;
 	}
 }
+//nothing queued or in flight, so the clock can jump without breaking the
+//timing of a command; partial SETs waiting for an idle bank do not count
+bool MemoryController::idle() {
+	if (!transactionQueue.empty() || outgoingCmdPacket != NULL || outgoingDataPacket != NULL
+			|| !writeDataToSend.empty() || !pendingReadTransactions.empty() || !returnTransaction.empty()) {
+		return false;
+	}
+	for (size_t r = 0; r < config.NUM_RANKS; r++) {
+		if (!commandQueue.isEmpty(r) || (*ranks)[r]->outgoingDataPacket != NULL
+				|| !(*ranks)[r]->readReturnPacket.empty()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//an access of the sampled simulation's fast forward: no commands, no timing,
+//the open page policy just leaves the row open. A bank that is busy with
+//anything (queued or in flight commands, precharge, refresh, power down) is
+//left alone
+void MemoryController::functionalAccess(unsigned rank, unsigned bank, unsigned row) {
+	if (config.rowBufferPolicy != OpenPage || !idle()) {
+		return;
+	}
+	BankState &state = bankStates[rank][bank];
+	BankState &rankState = (*ranks)[rank]->bankStates[bank];
+	if ((state.currentBankState != BankState::Idle && state.currentBankState != BankState::RowActive)
+			|| state.currentBankState != rankState.currentBankState
+			|| (state.currentBankState == BankState::RowActive && state.openRowAddress != rankState.openRowAddress)
+			|| state.stateChangeCountdown != 0
+			|| !commandQueue.getCommandQueue(rank, bank).empty()) {
+		return;
+	}
+	state.currentBankState = BankState::RowActive;
+	state.openRowAddress = row;
+	rankState.currentBankState = BankState::RowActive;
+	rankState.openRowAddress = row;
+}
 bool MemoryController::WillAcceptTransaction()
 	{
-	 return transactionQueue.size() < TRANS_QUEUE_DEPTH;
+	 return transactionQueue.size() < config.TRANS_QUEUE_DEPTH;
 	}
 //prints statistics at the end of an epoch or  simulation
 void MemoryController::printStats(bool finalStats) {
-	const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+	const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 	//if we are not at the end of the epoch, make sure to adjust for the actual number of cycles elapsed
 
 	uint64_t cyclesElapsed;
-	if (EPOCH_LENGTH == 0) {
+	if (config.EPOCH_LENGTH == 0) {
 //		cyclesElapsed = currentClockCycle - WarmupCycle;
 				cyclesElapsed = currentClockCycle;
-	} else if (currentClockCycle % EPOCH_LENGTH == 0) {
-		cyclesElapsed = EPOCH_LENGTH;
+	} else if (currentClockCycle % config.EPOCH_LENGTH == 0) {
+		cyclesElapsed = config.EPOCH_LENGTH;
 	} else {
-		cyclesElapsed = currentClockCycle % EPOCH_LENGTH;
+		cyclesElapsed = currentClockCycle % config.EPOCH_LENGTH;
 	}
 
-	unsigned bytesPerTransaction = (JEDEC_DATA_BUS_BITS * BL) / 8;
+	unsigned bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS * config.BL) / 8;
 	uint64_t totalBytesTransferred = totalTransactions * bytesPerTransaction;
-	double secondsThisEpoch = (double) cyclesElapsed * tCK * 1E-9;
+	double secondsThisEpoch = (double) cyclesElapsed * config.tCK * 1E-9;
 
 	// only per rank
-	vector<double> backgroundPower = vector<double>(NUM_RANKS, 0.0);
-	vector<double> burstPower = vector<double>(NUM_RANKS, 0.0);
-	vector<double> refreshPower = vector<double>(NUM_RANKS, 0.0);
-	vector<double> actprePower = vector<double>(NUM_RANKS, 0.0);
-	vector<double> averagePower = vector<double>(NUM_RANKS, 0.0);
-	vector<uint64_t> totalSETPerRank = vector<uint64_t>(NUM_RANKS, 0);
+	vector<double> backgroundPower = vector<double>(config.NUM_RANKS, 0.0);
+	vector<double> burstPower = vector<double>(config.NUM_RANKS, 0.0);
+	vector<double> refreshPower = vector<double>(config.NUM_RANKS, 0.0);
+	vector<double> actprePower = vector<double>(config.NUM_RANKS, 0.0);
+	vector<double> averagePower = vector<double>(config.NUM_RANKS, 0.0);
+	vector<uint64_t> totalSETPerRank = vector<uint64_t>(config.NUM_RANKS, 0);
 	// per bank variables
-	vector<double> averageLatency = vector<double>(NUM_RANKS * NUM_BANKS, 0.0);
-	vector<double> bandwidth = vector<double>(NUM_RANKS * NUM_BANKS, 0.0);
+	vector<double> averageLatency = vector<double>(config.NUM_RANKS * config.NUM_BANKS, 0.0);
+	vector<double> bandwidth = vector<double>(config.NUM_RANKS * config.NUM_BANKS, 0.0);
 
 	double totalBandwidth = 0.0;
-	for (size_t i = 0; i < NUM_RANKS; i++) {
-		for (size_t j = 0; j < NUM_BANKS; j++) {
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
 			bandwidth[SEQUENTIAL(i,j)] =
 					(((double) (totalReadsPerBank[SEQUENTIAL(i,j)]
 							+ totalWritesPerBank[SEQUENTIAL(i,j)])
 							* (double) bytesPerTransaction)
 							/ (1024.0 * 1024.0 * 1024.0)) / secondsThisEpoch;
-			averageLatency[SEQUENTIAL(i,j)] =
-					((float) totalEpochLatency[SEQUENTIAL(i,j)]
-							/ (float) (totalReadsPerBank[SEQUENTIAL(i,j)]))
-							* tCK;
+			if (totalReadsPerBank[SEQUENTIAL(i,j)] > 0) {
+				averageLatency[SEQUENTIAL(i,j)] =
+						((float) totalEpochLatency[SEQUENTIAL(i,j)]
+								/ (float) (totalReadsPerBank[SEQUENTIAL(i,j)]))
+								* config.tCK;
+			}
 			totalBandwidth += bandwidth[SEQUENTIAL(i,j)];
 			totalReadsPerRank[i] += totalReadsPerBank[SEQUENTIAL(i,j)];
 			totalWritesPerRank[i] += totalWritesPerBank[SEQUENTIAL(i,j)];
@@ -1339,18 +1626,22 @@ void MemoryController::printStats(bool finalStats) {
 							+ totalWritesPerBank[SEQUENTIAL(i,j)];
 		}
 	}
-	double tAveLatency;
-	for (size_t i = 0; i < NUM_RANKS; i++) {
-		for (size_t j = 0; j < NUM_BANKS; j++) {
-			tAveLatency += averageLatency[SEQUENTIAL(i,j)];
+	//weighted by reads, banks that returned nothing do not count
+	uint64_t totalLatency = 0, totalReads = 0;
+	for (size_t i = 0; i < config.NUM_RANKS; i++) {
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
+			totalLatency += totalEpochLatency[SEQUENTIAL(i,j)];
+			totalReads += totalReadsPerBank[SEQUENTIAL(i,j)];
 		}
 	}
+	double tAveLatency =
+			totalReads > 0 ? (double) totalLatency / totalReads * config.tCK : 0.0;
 #ifdef LOG_OUTPUT
 	SimulatorIO::logFile.precision(3);
 	SimulatorIO::logFile.setf(ios::fixed,ios::floatfield);
 #else
-	cout.precision(3);
-	cout.setf(ios::fixed, ios::floatfield);
+	simOutput->precision(3);
+	simOutput->setf(ios::fixed, ios::floatfield);
 #endif
 
 	PRINT(" =======================================================");
@@ -1361,26 +1652,47 @@ void MemoryController::printStats(bool finalStats) {
 			" ("<<totalBytesTransferred <<" bytes) aggregate average bandwidth "<<totalBandwidth<<"GB/s");
 	PRINT(
 			"  == Pending Transactions : "<<pendingReadTransactions.size()<<" ("<<currentClockCycle<<")==  CycleElapse: " << cyclesElapsed);
-	if (SET_IDLE) {
+	if (config.SET_IDLE) {
 		PRINT("== Partial Queue size is :"<< PSQueue.size()<<" == ");
 	}
 	PRINT(
-			"      -Total    Average    Latency  :\t\t\t"<< tAveLatency/(NUM_RANKS*NUM_BANKS) <<" ns");
+			"      -Total    Average    Latency  :\t\t\t"<< tAveLatency <<" ns");
 
 	// only the first memory channel should print the timestamp
-	if (VIS_FILE_OUTPUT && channelID == 0) {
-		csvOut << "ms" << currentClockCycle * tCK * 1E-6;
+	if (config.VIS_FILE_OUTPUT && channelID == 0) {
+		csvOut << "ms" << currentClockCycle * config.tCK * 1E-6;
 	}
 
 	double totalAggregateBandwidth = 0.0;
 
-	for (size_t r = 0; r < NUM_RANKS; r++) {
+	for (size_t r = 0; r < config.NUM_RANKS; r++) {
 
 		PRINT("    -Rank   "<<r<<" : ");
 		PRINTN("        -Reads  : " << totalReadsPerRank[r]);
 		PRINT(" ("<<totalReadsPerRank[r] * bytesPerTransaction<<" bytes)");
 		PRINTN("        -Writes : " << totalWritesPerRank[r]);
 		PRINT(" ("<<totalWritesPerRank[r] * bytesPerTransaction<<" bytes)");
+
+		uint64_t setBitsThisRank = 0, resetBitsThisRank = 0;
+		for (size_t j = 0; j < config.NUM_BANKS; j++) {
+			setBitsThisRank += setBitsPerBank[SEQUENTIAL(r,j)];
+			resetBitsThisRank += resetBitsPerBank[SEQUENTIAL(r,j)];
+		}
+		if (setBitsThisRank + resetBitsThisRank > 0) {
+			PRINT("        -Cell bits written : "<<setBitsThisRank<<" SET / "<<resetBitsThisRank<<" RESET");
+			for (size_t j = 0; j < config.NUM_BANKS; j++) {
+				PRINT("          bank "<<j<<": "<<setBitsPerBank[SEQUENTIAL(r,j)]<<" SET / "<<resetBitsPerBank[SEQUENTIAL(r,j)]<<" RESET");
+			}
+		}
+		// energies are accumulated in pJ
+		PRINT("        -Cell energy : write "<<cellWriteEnergy[r] / 1000.0<<" nJ, read "<<cellReadEnergy[r] / 1000.0<<" nJ");
+
+		if (config.VIS_FILE_OUTPUT) {
+			csvOut << CSVWriter::IndexedName("Cell_Write_Energy", channelID, r)
+					<< cellWriteEnergy[r];
+			csvOut << CSVWriter::IndexedName("Cell_Read_Energy", channelID, r)
+					<< cellReadEnergy[r];
+		}
 	}
 
 		/*	 for (size_t j = 0; j < NUM_BANKS; j++) {
@@ -1407,8 +1719,8 @@ void MemoryController::printStats(bool finalStats) {
 		 + refreshEnergy[r] + actpreEnergy[r]) / (double) cyclesElapsed)
 		 * Vdd / 1000.0;
 
-		 if (MemorySystem::ReportPower != NULL) {
-		 (*MemorySystem::ReportPower)(backgroundPower[r], burstPower[r],
+		 if (parentMemorySystem->ReportPower != NULL) {
+		 (*parentMemorySystem->ReportPower)(backgroundPower[r], burstPower[r],
 		 refreshPower[r], actprePower[r]);
 		 }
 
@@ -1450,11 +1762,11 @@ void MemoryController::printStats(bool finalStats) {
 		 }
 		 }*/
 
-		if (VIS_FILE_OUTPUT) {
+		if (config.VIS_FILE_OUTPUT) {
 			csvOut << CSVWriter::IndexedName("Aggregate_Bandwidth", channelID)
 					<< totalAggregateBandwidth;
 			csvOut << CSVWriter::IndexedName("Average_Bandwidth", channelID)
-					<< totalAggregateBandwidth / (NUM_RANKS * NUM_BANKS);
+					<< totalAggregateBandwidth / (config.NUM_RANKS * config.NUM_BANKS);
 			csvOut.finalize();
 		}
 
@@ -1498,12 +1810,12 @@ void MemoryController::printStats(bool finalStats) {
 			PRINT("	long idle has  "<<longidle <<" times, short idle has :"<<shortidle<<" times.");
 			}*/
 			PRINT(" --- Grand Total Bank usage list");
-			for (size_t i = 0; i < NUM_RANKS; i++) {
+			for (size_t i = 0; i < config.NUM_RANKS; i++) {
 
 				PRINT("  Rank "<<i<<":");
 
-					for (size_t j = 0; j < NUM_BANKS; j++) {
-						if (!SET_IDLE) {
+					for (size_t j = 0; j < config.NUM_BANKS; j++) {
+						if (!config.SET_IDLE) {
 						PRINT(
 								"	bank"<<j<<": "<<grandTotalBankAccesses[SEQUENTIAL(i,j)]);
 						PRINT(
@@ -1522,12 +1834,93 @@ void MemoryController::printStats(bool finalStats) {
 
 
 				}
-					if(SET_IDLE){
+					if(config.SET_IDLE){
 						PRINTN("	- flush SETs per rank: " << totalSETPerRank[i]);
 					}
 
 			}
-			if (SET_IDLE) {
+#ifdef DATA_STORAGE
+			PRINT(" --- Row storage : " << (backingStore->residentBytes() >> 10) << " KB populated");
+#endif
+			if (config.DATA_COMPARE_WRITE) {
+				uint64_t silentWrites = 0, resetOnlyWrites = 0;
+				for (size_t i = 0; i < config.NUM_RANKS * config.NUM_BANKS; i++) {
+					silentWrites += silentWritesPerBank[i];
+					resetOnlyWrites += resetOnlyWritesPerBank[i];
+				}
+				PRINT(" --- Data-comparison write"<<(config.FLIP_N_WRITE ? " (Flip-N-Write)" : ""));
+				PRINT("    writes that changed no cell : " << silentWrites);
+				PRINT("    SETs that only needed RESET : " << resetOnlyWrites);
+			}
+			if (config.PARTIAL_WRITE) {
+				uint64_t partialWrites = 0, bytesSaved = 0;
+				for (size_t i = 0; i < config.NUM_RANKS * config.NUM_BANKS; i++) {
+					partialWrites += partialWritesPerBank[i];
+					bytesSaved += partialBytesSavedPerBank[i];
+				}
+				PRINT(" --- Partial writes (8 byte words)");
+				PRINT("    writes of part of a line : " << partialWrites);
+				PRINT("    bytes not programmed : " << bytesSaved);
+			}
+			if (scrubbing) {
+				uint64_t scrubs = 0, collisions = 0;
+				for (size_t i = 0; i < config.NUM_RANKS * config.NUM_BANKS; i++) {
+					scrubs += scrubsPerBank[i];
+					collisions += scrubCollisionsPerBank[i];
+				}
+				double seconds = (double) currentClockCycle * config.tCK * 1E-9;
+				PRINT(" --- Drift scrubbing (window " << config.DRIFT_WINDOW << "ns, no refresh)");
+				PRINT("    scrub writes : " << scrubs << " ("
+						<< (seconds > 0 ? (double) scrubs * config.TRANS_DATA_BYTES / (1024.0 * 1024.0 * 1024.0) / seconds : 0.0)
+						<< " GB/s)");
+				PRINT("    demand accesses delayed by a scrub : " << collisions);
+				PRINT("    lines tracked : " << scrubLines.size()
+						<< "  max scrub lateness : " << maxScrubLateness * config.tCK << "ns");
+				for (size_t i = 0; i < config.NUM_RANKS; i++) {
+					for (size_t j = 0; j < config.NUM_BANKS; j++) {
+						PRINT("	bank" << j << " (rank " << i << "): " << scrubsPerBank[SEQUENTIAL(i,j)]
+								<< " scrubs, " << scrubCollisionsPerBank[SEQUENTIAL(i,j)] << " collisions");
+					}
+				}
+			}
+			if (faultInjector != NULL) {
+				faultInjector->printStats();
+			}
+#ifdef DATA_RELIABILITY_ECC
+			{
+				uint64_t corrected = 0, uncorrectable = 0;
+				uint64_t scrubCorrected = 0, scrubUncorrectable = 0;
+				for (size_t i = 0; i < config.NUM_RANKS * config.NUM_BANKS; i++) {
+					corrected += eccCorrectedPerBank[i];
+					uncorrectable += eccUncorrectablePerBank[i];
+					scrubCorrected += scrubCorrectedPerBank[i];
+					scrubUncorrectable += scrubUncorrectablePerBank[i];
+				}
+				PRINT(" --- ECC (72 bit words)");
+				PRINT("    reads  : " << corrected << " corrected, " << uncorrectable << " uncorrectable");
+				if (scrubbing) {
+					PRINT("    scrubs : " << scrubCorrected << " corrected, " << scrubUncorrectable << " uncorrectable");
+				}
+				for (size_t i = 0; i < config.NUM_RANKS; i++) {
+					for (size_t j = 0; j < config.NUM_BANKS; j++) {
+						PRINTN("	bank" << j << " (rank " << i << "): "
+								<< eccCorrectedPerBank[SEQUENTIAL(i,j)] << " corrected, "
+								<< eccUncorrectablePerBank[SEQUENTIAL(i,j)] << " uncorrectable");
+						if (faultInjector != NULL) {
+							PRINTN(", injected " << faultInjector->writeFaultsPerBank[SEQUENTIAL(i,j)]
+									<< " write / " << faultInjector->driftFaultsPerBank[SEQUENTIAL(i,j)]
+									<< " drift / " << faultInjector->busFaultsPerBank[SEQUENTIAL(i,j)] << " bus");
+						}
+						if (scrubbing) {
+							PRINTN(", scrubs " << scrubCorrectedPerBank[SEQUENTIAL(i,j)] << " corrected, "
+									<< scrubUncorrectablePerBank[SEQUENTIAL(i,j)] << " uncorrectable");
+						}
+						PRINT("");
+					}
+				}
+			}
+#endif
+			if (config.SET_IDLE) {
 				PRINT(
 						"   Reduece cmd by Schedule CMDqueue is :" << reducedcmd);
 				PRINT("    Completed SET one time :" << completedSET);
@@ -1592,8 +1985,11 @@ MemoryController::~MemoryController() {
 		delete pendingReadTransactions[i];
 	}
 	for (size_t i = 0; i < returnTransaction.size(); i++) {
+		delete returnTransaction[i]->data;
 		delete returnTransaction[i];
 	}
+	delete backingStore;
+	delete faultInjector;
 	/*		list<Transaction*>::iterator iter;
 	 iter a = PSQueue.begin();
 	 iter b = PSQueue.end();
@@ -1609,7 +2005,110 @@ void MemoryController::insertHistogram(unsigned latencyValue, unsigned rank,
 		unsigned bank) {
 	totalEpochLatency[SEQUENTIAL(rank,bank)] += latencyValue;
 	//poor man's way to bin things.
-	latencies[(latencyValue / HISTOGRAM_BIN_SIZE) * HISTOGRAM_BIN_SIZE]++;
+	latencies[(latencyValue / config.HISTOGRAM_BIN_SIZE) * config.HISTOGRAM_BIN_SIZE]++;
+}
+
+void MemoryController::checkpoint(Checkpoint &cp) {
+	if (faultInjector != NULL) {
+		faultInjector->checkpoint(cp);
+	}
+
+	cp.io(transactionQueue);
+	cp.io(PSQueue);
+	cp.io(backgroundEnergy);
+	cp.io(burstEnergy);
+	cp.io(actpreEnergy);
+	cp.io(refreshEnergy);
+	cp.io(cellWriteEnergy);
+	cp.io(cellReadEnergy);
+	cp.io(grandTotalEnergy);
+	cp.io(bankStates);
+	cp.io(refreshRank);
+	commandQueue.checkpoint(cp);
+	//poppedBusPacket only lives within updateCmdQueue()
+	cp.io(refreshCountdown);
+	cp.io(writeDataToSend);
+	cp.io(writeDataCountdown);
+	cp.io(returnTransaction);
+	cp.io(pendingReadTransactions);
+	cp.io(latencies);
+	cp.io(powerDown);
+	cp.io(outgoingCmdPacket);
+	cp.io(cmdCyclesLeft);
+	cp.io(outgoingDataPacket);
+	cp.io(dataCyclesLeft);
+
+	cp.io(totalTransactions);
+	cp.io(grandTotalBankAccesses);
+	cp.io(totalReadsPerBank);
+	cp.io(totalWritesPerBank);
+	cp.io(fullSETPerBank);
+	cp.io(flushSETPerBank);
+	cp.io(EmergePartailSET);
+	cp.io(setBitsPerBank);
+	cp.io(resetBitsPerBank);
+	cp.io(silentWritesPerBank);
+	cp.io(resetOnlyWritesPerBank);
+	cp.io(partialWritesPerBank);
+	cp.io(partialBytesSavedPerBank);
+
+	cp.io(scrubLines);
+	if (!cp.isSaving()) {
+		scrubIndex.clear();
+		for (list<ScrubLine>::iterator it = scrubLines.begin(); it != scrubLines.end(); it++) {
+			scrubIndex[it->address] = it;
+		}
+	}
+	cp.io(scrubPending);
+	cp.io(scrubBusyUntil);
+	cp.io(scrubsPerBank);
+	cp.io(scrubCollisionsPerBank);
+	cp.io(maxScrubLateness);
+	cp.io(eccCorrectedPerBank);
+	cp.io(eccUncorrectablePerBank);
+	cp.io(scrubCorrectedPerBank);
+	cp.io(scrubUncorrectablePerBank);
+
+	cp.io(totalReadsPerRank);
+	cp.io(totalWritesPerRank);
+	cp.io(totalEpochLatency);
+	cp.io(setChancePerBank);
+	cp.io(reducedcmd);
+	cp.io(completedSET);
+	cp.io(eraseSET);
+	cp.io(Idletime);
+	cp.io(lockBank);
+	cp.io(locktime);
+	cp.io(bingoPerBank);
+	cp.io(notbingoPerBank);
+	cp.io(accurancy);
+	cp.io(cmdStat);
+
+	for (size_t i = 0; i < ranks->size(); i++) {
+		(*ranks)[i]->checkpoint(cp);
+	}
+}
+
+void MemoryController::ScrubLine::checkpoint(Checkpoint &cp) {
+	cp.io(address);
+	cp.io(lastWrite);
+}
+
+void MemoryController::CmdStat::checkpoint(Checkpoint &cp) {
+	cp.io(readCounter);
+	cp.io(readpCounter);
+	cp.io(writeCounter);
+	cp.io(writepCounter);
+	cp.io(activateCounter);
+	cp.io(prechangeCounter);
+	cp.io(refreshCounter);
+	cp.io(readSum);
+	cp.io(readpSum);
+	cp.io(writeSum);
+	cp.io(writepSum);
+	cp.io(activateSum);
+	cp.io(prechangeSum);
+	cp.io(refreshSum);
 }
 
 //libing
@@ -43,10 +43,14 @@
 #include "BusPacket.h"
 #include "BankState.h"
 #include "Rank.h"
+#include "BackingStore.h"
+#include "FaultInjector.h"
 #include "CSVWriter.h"
+#include "ClockDomain.h"
+#include "PhaseProfile.h"
 #include <map>
 
-#define RETAIN_TIME 4E+9/tCK
+#define RETAIN_TIME 4E+9/config.tCK
 #define MAX_DEPTH 128
 
 using std::list;
@@ -58,6 +62,7 @@ namespace DRAMSim
 {
 
 	class MemorySystem;
+	class Checkpoint;
 	class MemoryController
 	{
 	public:
@@ -67,12 +72,23 @@ namespace DRAMSim
 
 		bool addTransaction(Transaction *trans);
 		bool WillAcceptTransaction();
+		//nothing is queued or in flight
+		bool idle();
+		//open the row the way the open page policy would, without simulating it
+		void functionalAccess(unsigned rank, unsigned bank, unsigned row);
 		void receiveFromBus(BusPacket *bpacket);
 		void update();
 		void printStats(bool finalStats = false);
+		//the controller and its ranks; the backing store is saved up front by the memory system
+		void checkpoint(Checkpoint &cp);
 
 
 		//fields
+		//the parameters and clocks of the parent memory system
+		const Config &config;
+		ClockDomain *clockDomainCPU;
+		ClockDomain *clockDomainDRAM;
+
 		vector<Transaction *> transactionQueue;
 		list<Transaction *> PSQueue;
 
@@ -81,10 +97,23 @@ namespace DRAMSim
 		vector< uint64_t > burstEnergy;
 		vector< uint64_t > actpreEnergy;
 		vector< uint64_t > refreshEnergy;
+		// PCM cell energy per rank, in pJ (bits programmed/sensed * *_ENERGY_BIT)
+		vector< double > cellWriteEnergy;
+		vector< double > cellReadEnergy;
+		// energy of the epochs already over, per rank, in pJ
+		vector< double > grandTotalEnergy;
 //	public:
 		MemorySystem *parentMemorySystem;
 		vector<Rank *> *ranks;
 		vector<  vector <BankState> > bankStates;
+		//row contents of the whole channel (DATA_STORAGE builds only)
+		BackingStore *backingStore;
+		//injected bit errors, NULL unless a FAULT_*_BER is set (DATA_STORAGE builds only)
+		FaultInjector *faultInjector;
+#ifdef PROFILE_PHASES
+		//the time of the update phases and of the Rank::updates of this channel
+		PhaseProfile profile;
+#endif
 		unsigned channelID;
 
 		//output file
@@ -126,12 +155,50 @@ namespace DRAMSim
 		vector<uint64_t> fullSETPerBank;
 		vector<uint64_t> flushSETPerBank;
 		vector<uint64_t> EmergePartailSET;
+
+		//cells programmed by WRITE/WRITE_P/SET_WRITE/COM_WRITE
+		vector<uint64_t> setBitsPerBank;
+		vector<uint64_t> resetBitsPerBank;
+		//data-comparison write
+		vector<uint64_t> silentWritesPerBank;
+		vector<uint64_t> resetOnlyWritesPerBank;
+		//PARTIAL_WRITE: write backs of part of a line and the bytes left alone
+		vector<uint64_t> partialWritesPerBank;
+		vector<uint64_t> partialBytesSavedPerBank;
+
+		//drift scrubbing (DEVICE_TYPE=PCM with a DRIFT_WINDOW): every written
+		//line, oldest write first, and an index to find a line in that list
+		struct ScrubLine
+		{
+			uint64_t address;
+			uint64_t lastWrite;
+			void checkpoint(Checkpoint &cp);
+		};
+		bool scrubbing;
+		uint64_t driftCycles;
+		list<ScrubLine> scrubLines;
+		map<uint64_t, list<ScrubLine>::iterator> scrubIndex;
+		vector<bool> scrubPending; //a scrub is in this bank's command queue
+		vector<uint64_t> scrubBusyUntil; //bank is recovering from a scrub write
+		vector<uint64_t> scrubsPerBank;
+		vector<uint64_t> scrubCollisionsPerBank;
+		uint64_t maxScrubLateness;
+
+		//ECC words corrected/uncorrectable on reads and on scrubs (DATA_RELIABILITY_ECC)
+		vector<uint64_t> eccCorrectedPerBank;
+		vector<uint64_t> eccUncorrectablePerBank;
+		vector<uint64_t> scrubCorrectedPerBank;
+		vector<uint64_t> scrubUncorrectablePerBank;
 		
 		vector<uint64_t> totalReadsPerRank;
 		vector<uint64_t> totalWritesPerRank;
 		vector<uint64_t> totalEpochLatency;
 //record the chance to set
 		vector<uint64_t> setChancePerBank;
+		//SET_IDLE: commands saved by the command queue, completed and erased SETs
+		uint64_t reducedcmd;
+		uint64_t completedSET;
+		uint64_t eraseSET;
 
 		vector< vector <uint64_t> > Idletime;
 
@@ -178,6 +245,7 @@ namespace DRAMSim
 			unsigned prechangeSum;
 			unsigned refreshSum;
 
+			void checkpoint(Checkpoint &cp);
 		} cmdStat;
 		/*		struct IdleInterval{
 			IdleInterval(){
@@ -205,6 +273,11 @@ namespace DRAMSim
 		void updatePower();
 		void updateReturnTrans();
 		void updatePrint();
+		void updateCellWriteEnergy(const BusPacket *dataPacket, uint64_t setBits, uint64_t resetBits);
+		double epochEnergy(unsigned rank) const;
+		void recordLineWrite(uint64_t address);
+		void updateScrub();
+		void recordEcc(unsigned rank, unsigned bank, unsigned correctedWords, unsigned uncorrectableWords, bool scrub);
 //libing
 		void addPartialQueue(Transaction * trans); //libing
 		void updatePartialQueue();
@@ -32,71 +32,102 @@
 
 //#include "SystemConfiguration.h"
 #include "MemorySystem.h"
-#include "IniReader.h"
 #include "SimulatorIO.h"
 #include "Simulator.h"
 #include "Callback.h"
+#include "Checkpoint.h"
 
 
 namespace DRAMSim
 {
-	PowerCB MemorySystem::ReportPower=NULL;
-
-	MemorySystem::MemorySystem(): ReadDataDone(NULL),WriteDataDone(NULL)
+	MemorySystem::MemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM):
+		config(cfg),clockDomainCPU(clockDomainCPU),clockDomainDRAM(clockDomainDRAM),
+		wearLeveler(NULL),ReadDataDone(NULL),WriteDataDone(NULL),ReportPower(NULL)
 	{
 
 #ifdef DATA_RELIABILITY_ECC
 		//ECC BUS BITS
-		JEDEC_DATA_BUS_BITS = JEDEC_DATA_BITS / BL;
-		ECC_DATA_BUS_BITS = ECC_DATA_BITS / BL;
-		NUM_DEVICES = ECC_DATA_BUS_BITS/DEVICE_WIDTH;
+		config.JEDEC_DATA_BUS_BITS = JEDEC_DATA_BITS / config.BL;
+		config.ECC_DATA_BUS_BITS = ECC_DATA_BITS / config.BL;
+		config.NUM_DEVICES = config.ECC_DATA_BUS_BITS/config.DEVICE_WIDTH;
 #else
-		NUM_DEVICES = JEDEC_DATA_BUS_BITS / DEVICE_WIDTH;
+		config.NUM_DEVICES = config.JEDEC_DATA_BUS_BITS / config.DEVICE_WIDTH;
 #endif
 
 #ifdef DATA_STORAGE_SSA
-		TRANS_DATA_BYTES = SUBARRAY_DATA_BYTES * NUM_DEVICES;
+		config.TRANS_DATA_BYTES = config.SUBARRAY_DATA_BYTES * config.NUM_DEVICES;
 #else
 	#ifdef DATA_RELIABILITY_ECC
-		TRANS_DATA_BYTES = ECC_DATA_BUS_BITS * BL / 8;
+		config.TRANS_DATA_BYTES = config.ECC_DATA_BUS_BITS * config.BL / 8;
 	#else
-		TRANS_DATA_BYTES = JEDEC_DATA_BUS_BITS * BL / 8;
+		config.TRANS_DATA_BYTES = config.JEDEC_DATA_BUS_BITS * config.BL / 8;
 	#endif
 #endif
 
-		for (size_t iChannel=0; iChannel<NUM_CHANS; iChannel++)
+		if (config.FLIP_N_WRITE && !config.DATA_COMPARE_WRITE)
+		{
+			PRINT("FLIP_N_WRITE needs the old line, turning on DATA_COMPARE_WRITE");
+			config.DATA_COMPARE_WRITE = true;
+		}
+#if !defined(DATA_STORAGE) || defined(DATA_RELIABILITY_ECC)
+		//the banks (and their energy) must not program cells the way a feature that is off would
+		if (config.DATA_COMPARE_WRITE)
+		{
+			PRINT("WARNING: DATA_COMPARE_WRITE/FLIP_N_WRITE need a DATA_STORAGE build without ECC, turning them off; all writes take the full write recovery");
+			config.DATA_COMPARE_WRITE = false;
+			config.FLIP_N_WRITE = false;
+		}
+#endif
+
+		if (config.wearLevelingScheme != NoWearLeveling || config.TRACK_WEAR)
+		{
+			wearLeveler = new WearLeveler(config);
+		}
+
+		pendingTransactions.resize(config.NUM_CHANS);
+		pendingBlockedCycles.resize(config.NUM_CHANS, 0);
+		pendingRejected.resize(config.NUM_CHANS, 0);
+		pendingMaxDepth.resize(config.NUM_CHANS, 0);
+		for (size_t iChannel=0; iChannel<config.NUM_CHANS; iChannel++)
 		{
-			unsigned long megsOfStoragePerRank = ( (long long)DEVICE_WIDTH * NUM_COLS * NUM_ROWS * NUM_BANKS * NUM_DEVICES / 8) >> 20;
-			TOTAL_STORAGE = (NUM_RANKS * megsOfStoragePerRank);
+			unsigned long megsOfStoragePerRank = ( (long long)config.DEVICE_WIDTH * config.NUM_COLS * config.NUM_ROWS * config.NUM_BANKS * config.NUM_DEVICES / 8) >> 20;
+			config.TOTAL_STORAGE = (config.NUM_RANKS * megsOfStoragePerRank);
 
 			ranks.push_back(new vector<Rank *>());
 			memoryControllers.push_back(new MemoryController(this,ranks[iChannel],iChannel));
 
-			for (size_t iRank=0; iRank< NUM_RANKS; iRank++)
+			for (size_t iRank=0; iRank< config.NUM_RANKS; iRank++)
 			{
 				ranks[iChannel]->push_back(new Rank(iRank,memoryControllers[iChannel]));
 			}
 
 			PRINTN("MemoryChannel "<<iChannel<<" :");
-			PRINT("CH. " <<iChannel<<" TOTAL_STORAGE : "<< TOTAL_STORAGE << "MB | "<<NUM_RANKS<<" Ranks | "<< NUM_DEVICES <<" Devices per rank");
+			PRINT("CH. " <<iChannel<<" TOTAL_STORAGE : "<< config.TOTAL_STORAGE << "MB | "<<config.NUM_RANKS<<" Ranks | "<< config.NUM_DEVICES <<" Devices per rank");
 		}
 	}
 
+	MemorySystem::MemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM, NoChannels):
+		config(cfg),clockDomainCPU(clockDomainCPU),clockDomainDRAM(clockDomainDRAM),
+		wearLeveler(NULL),ReadDataDone(NULL),WriteDataDone(NULL),ReportPower(NULL)
+	{
+	}
+
 	MemorySystem::~MemorySystem()
 	{
-		for (size_t iChannel=0; iChannel<NUM_CHANS; iChannel++)
+		for (size_t iChannel=0; iChannel<memoryControllers.size(); iChannel++)
 		{
 			delete(memoryControllers[iChannel]);
 
 			vector<Rank *> *channelRank = ranks[iChannel];
-			for (size_t iRank=0; iRank<NUM_RANKS; iRank++)
+			for (size_t iRank=0; iRank<channelRank->size(); iRank++)
 			{
 				delete (*channelRank)[iRank];
 			}
 			channelRank->clear();
 		}
+		delete wearLeveler;
 
-		if (VERIFICATION_OUTPUT)
+		if (config.VERIFICATION_OUTPUT)
 		{
 			SimulatorIO::verifyFile.flush();
 			SimulatorIO::verifyFile.close();
@@ -105,36 +136,41 @@ namespace DRAMSim
 
 	void MemorySystem::update()
 	{
-		for (size_t iChannel=0; iChannel<NUM_CHANS; iChannel++)
+		for (size_t iChannel=0; iChannel<config.NUM_CHANS; iChannel++)
 		{
-			for (size_t iRank=0;iRank<NUM_RANKS;iRank++)
+			PROFILE_START(memoryControllers[iChannel]->profile);
+			for (size_t iRank=0;iRank<config.NUM_RANKS;iRank++)
 			{
 				(*ranks[iChannel])[iRank]->update();
+				PROFILE_LAP(memoryControllers[iChannel]->profile, RANK_UPDATE);
 			}
 
-			if (pendingTransactions.size() > 0)
+			//one pending transaction per cycle moves into the transaction queue
+			deque<Transaction *> &pending = pendingTransactions[iChannel];
+			if (!pending.empty())
 			{
-				unsigned channelNum = findChannelNumber(pendingTransactions.front()->address);
-				if (channelNum == iChannel && memoryControllers[iChannel]->addTransaction(pendingTransactions.front()))
+				if (memoryControllers[iChannel]->addTransaction(pending.front()))
+				{
+					pending.pop_front();
+				}
+				else
 				{
-					pendingTransactions.pop_front();
+					pendingBlockedCycles[iChannel]++;
 				}
-				//cout<<"pendingTransactions size is " << pendingTransactions.size()<<endl;
 			}
 			memoryControllers[iChannel]->update();
-			//cout<<"pendingTransactions size is " << pendingTransactions.size()<<endl;
 		}
 	}
 
 	unsigned MemorySystem::findChannelNumber(uint64_t addr)
 	{
 		// Single channel case is a trivial shortcut case
-		if (NUM_CHANS == 1)
+		if (config.NUM_CHANS == 1)
 		{
 			return 0;
 		}
 
-		if (!isPowerOfTwo(NUM_CHANS))
+		if (!isPowerOfTwo(config.NUM_CHANS))
 		{
 			ERROR("We can only support power of two # of channels.\n" <<
 					"I don't know what Intel was thinking, but trying to address map half a bit is a neat trick that we're not sure how to do");
@@ -144,9 +180,9 @@ namespace DRAMSim
 		// only chan is used from this set
 		unsigned iChannel,rank,bank,row,column;
 		addressMapping(addr,iChannel,rank,bank,row,column);
-		if (iChannel >= NUM_CHANS)
+		if (iChannel >= config.NUM_CHANS)
 		{
-			ERROR("Got channel index "<<iChannel<<" but only "<<NUM_CHANS<<" exist");
+			ERROR("Got channel index "<<iChannel<<" but only "<<config.NUM_CHANS<<" exist");
 			abort();
 		}
 		//DEBUG("Channel idx = "<<channelNumber<<" totalbits="<<totalBits<<" channelbits="<<channelBits);
@@ -156,19 +192,55 @@ namespace DRAMSim
 
 	bool MemorySystem::addTransaction(Transaction *trans)
 	{
+		trans->alignAddress(config.TRANS_DATA_BYTES);
 		unsigned iChannel = findChannelNumber(trans->address);
+		bool isWrite = trans->transactionType == Transaction::DATA_WRITE;
 
 #ifdef MS_BUFFER
-		if (memoryControllers[iChannel]->addTransaction(trans))
+		//a channel with pending transactions keeps their order, a full pending
+		//queue pushes back on the producer
+		if ((!pendingTransactions[iChannel].empty() || !memoryControllers[iChannel]->WillAcceptTransaction())
+				&& config.PENDING_QUEUE_DEPTH > 0 && pendingTransactions[iChannel].size() >= config.PENDING_QUEUE_DEPTH)
 		{
-			return true;
+			pendingRejected[iChannel]++;
+			return false;
 		}
-		else
+		if (wearLeveler != NULL && isWrite)
+		{
+			//the gap move may relocate this very line: it goes to the channel
+			//that owns the line after the move, past PENDING_QUEUE_DEPTH like
+			//the move itself
+			wearLevelWrite(trans->address);
+			iChannel = findChannelNumber(trans->address);
+		}
+		deque<Transaction *> &pending = pendingTransactions[iChannel];
+		if (pending.empty() && memoryControllers[iChannel]->addTransaction(trans))
 		{
-			pendingTransactions.push_back(trans);
 			return true;
 		}
+		pending.push_back(trans);
+		if (pending.size() > pendingMaxDepth[iChannel])
+		{
+			pendingMaxDepth[iChannel] = pending.size();
+		}
+		return true;
 #else
+		if (wearLeveler != NULL && isWrite)
+		{
+			if (!memoryControllers[iChannel]->WillAcceptTransaction())
+			{
+				return false;
+			}
+			//the channel of the line after the gap move; when that one is full
+			//the write waits in its pending queue, behind the move
+			wearLevelWrite(trans->address);
+			iChannel = findChannelNumber(trans->address);
+			if (!memoryControllers[iChannel]->addTransaction(trans))
+			{
+				pendingTransactions[iChannel].push_back(trans);
+			}
+			return true;
+		}
 		return memoryControllers[iChannel]->addTransaction(trans);
 #endif
 	}
@@ -176,53 +248,171 @@ namespace DRAMSim
 
 	bool MemorySystem::addTransaction(bool isWrite, uint64_t addr)
 	{
-		unsigned iChannel = findChannelNumber(addr);
 		Transaction::TransactionType type = isWrite ? Transaction::DATA_WRITE : Transaction::DATA_READ;
-		Transaction *trans = new Transaction(type,addr,NULL,LEN_DEF,Simulator::clockDomainCPU->clockcycle);
-		// push_back in memoryController will make a copy of this during
-		// addTransaction so it's kosher for the reference to be local
-
-#ifdef MS_BUFFER
-		if (memoryControllers[iChannel]->addTransaction(trans))
+		Transaction *trans = new Transaction(type,addr,NULL,LEN_DEF,clockDomainCPU->clockcycle);
+		if (addTransaction(trans))
 		{
 			return true;
 		}
+		delete trans;
+		return false;
+	}
+
+	//the bank state change of an access that is not simulated in detail; the
+	//wear leveler does not count it and no data is stored
+	void MemorySystem::functionalAccess(bool isWrite, uint64_t addr)
+	{
+		unsigned chan, rank, bank, row, col;
+		addressMapping(addr, chan, rank, bank, row, col);
+		memoryControllers[chan]->functionalAccess(rank, bank, row);
+	}
+
+	bool MemorySystem::idle()
+	{
+		if (pendingCount() > 0)
+		{
+			return false;
+		}
+		for (size_t c=0; c<memoryControllers.size(); c++)
+		{
+			if (!memoryControllers[c]->idle())
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void MemorySystem::skipCycles(uint64_t cycles)
+	{
+		//the clock domains belong to the caller, nothing here counts time on its own
+	}
+
+	//count the write and, when its region is due, move the Start-Gap gap: the
+	//line next to the gap is rewritten at its new place by an extra write that
+	//goes through the controller like any other
+	void MemorySystem::wearLevelWrite(uint64_t addr)
+	{
+		unsigned region;
+		if (!wearLeveler->recordWrite(addr, region))
+		{
+			return;
+		}
+
+		uint64_t movedAddr = wearLeveler->movingLine(region);
+		DataPacket *movedData = NULL;
+#if defined(DATA_STORAGE) && !defined(DATA_STORAGE_SSA) && !defined(DATA_RELIABILITY_ECC)
+		//copy the line contents before the remap changes
+		unsigned chan, rank, bank, row, col;
+		addressMapping(movedAddr, chan, rank, bank, row, col);
+		BusPacket readPacket(BusPacket::READ, rank, bank, row, col, movedAddr);
+		(*ranks[chan])[rank]->banks[bank].read(&readPacket);
+		if (readPacket.data->hasNoData())
+		{
+			delete readPacket.data;
+		}
 		else
 		{
-			pendingTransactions.push_back(trans);
-			return true;
+			//a view of the row, the store copies it before the row is reused
+			movedData = readPacket.data;
 		}
-#else
-		return memoryControllers[iChannel]->addTransaction(trans);
+		readPacket.data = NULL;
 #endif
+		wearLeveler->moveGap(region);
+		//the move is not refused, it may go past PENDING_QUEUE_DEPTH
+		pendingTransactions[findChannelNumber(movedAddr)].push_back(new Transaction(Transaction::DATA_WRITE, movedAddr, movedData,
+				LEN_DEF, clockDomainCPU->clockcycle));
 	}
+	//whether a transaction would go straight into the transaction queue
 	bool MemorySystem::willAcceptTransaction()
 	{
-	for (size_t c=0; c<NUM_CHANS; c++) {
-		if (!memoryControllers[c]->WillAcceptTransaction())
+		for (size_t c=0; c<config.NUM_CHANS; c++)
+		{
+			if (!pendingTransactions[c].empty() || !memoryControllers[c]->WillAcceptTransaction())
 			{
-			return false; 
+				return false;
 			}
 		}
-	return true; 
+		return true;
 	}
-			
-		bool MemorySystem::willAcceptTransaction(uint64_t addr)
-			{
-				unsigned chan, rank,bank,row,col; 
-			addressMapping(addr, chan, rank, bank, row, col); 
-			return memoryControllers[chan]->WillAcceptTransaction(); 
 
-			}
+	bool MemorySystem::willAcceptTransaction(uint64_t addr)
+	{
+		unsigned chan = findChannelNumber(addr);
+		return pendingTransactions[chan].empty() && memoryControllers[chan]->WillAcceptTransaction();
+	}
+
+	size_t MemorySystem::pendingCount() const
+	{
+		size_t count = 0;
+		for (size_t c=0; c<pendingTransactions.size(); c++)
+		{
+			count += pendingTransactions[c].size();
+		}
+		return count;
+	}
 
 	void MemorySystem::printStats(bool finalStats)
 	{
-		for (size_t iChannel=0; iChannel<NUM_CHANS; iChannel++)
+		for (size_t iChannel=0; iChannel<config.NUM_CHANS; iChannel++)
 		{
 			PRINT("==== Channel ["<<iChannel<<"] ====");
 			memoryControllers[iChannel]->printStats(finalStats);
 			PRINT("//// Channel ["<<iChannel<<"] ////");
 		}
+#ifdef PROFILE_PHASES
+		if (finalStats && SHOW_SIM_OUTPUT)
+		{
+			for (size_t iChannel=0; iChannel<config.NUM_CHANS; iChannel++)
+			{
+				PRINT("==== Channel ["<<iChannel<<"] ====");
+				memoryControllers[iChannel]->profile.print(*simOutput);
+			}
+		}
+#endif
+#ifdef MS_BUFFER
+		if (finalStats)
+		{
+			PRINT(" --- Pending transactions (PENDING_QUEUE_DEPTH="<<config.PENDING_QUEUE_DEPTH<<")");
+			for (size_t iChannel=0; iChannel<pendingTransactions.size(); iChannel++)
+			{
+				PRINT("    channel "<<iChannel<<" : deepest "<<pendingMaxDepth[iChannel]<<", head blocked "
+						<<pendingBlockedCycles[iChannel]<<" cycles, refused "<<pendingRejected[iChannel]);
+			}
+		}
+#endif
+		if (finalStats && wearLeveler != NULL)
+		{
+			wearLeveler->printStats(clockDomainDRAM->clockcycle);
+		}
+	}
+
+	void MemorySystem::checkpointRows(Checkpoint &cp)
+	{
+		for (size_t iChannel=0; iChannel<memoryControllers.size(); iChannel++)
+		{
+			if (memoryControllers[iChannel]->backingStore != NULL)
+			{
+				memoryControllers[iChannel]->backingStore->checkpoint(cp);
+			}
+		}
+	}
+
+	void MemorySystem::checkpoint(Checkpoint &cp)
+	{
+		cp.io(pendingTransactions);
+		cp.io(pendingBlockedCycles);
+		cp.io(pendingRejected);
+		cp.io(pendingMaxDepth);
+		for (size_t iChannel=0; iChannel<memoryControllers.size(); iChannel++)
+		{
+			cp.section("channel");
+			memoryControllers[iChannel]->checkpoint(cp);
+		}
+		if (wearLeveler != NULL)
+		{
+			wearLeveler->checkpoint(cp);
+		}
 	}
 
 
@@ -244,24 +434,30 @@ namespace DRAMSim
 	{
 		uint64_t tempA, tempB;
 
-		uint64_t transactionMask =  TRANS_DATA_BYTES - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
-		unsigned  channelBitWidth = dramsim_log2(NUM_CHANS);
-		unsigned	 rankBitWidth = dramsim_log2(NUM_RANKS);
-		unsigned	 bankBitWidth = dramsim_log2(NUM_BANKS);
-		unsigned	  rowBitWidth = dramsim_log2(NUM_ROWS);
-		unsigned	  colBitWidth = dramsim_log2(NUM_COLS);
+		uint64_t transactionMask =  config.TRANS_DATA_BYTES - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
+		unsigned  channelBitWidth = dramsim_log2(config.NUM_CHANS);
+		unsigned	 rankBitWidth = dramsim_log2(config.NUM_RANKS);
+		unsigned	 bankBitWidth = dramsim_log2(config.NUM_BANKS);
+		unsigned	  rowBitWidth = dramsim_log2(config.NUM_ROWS);
+		unsigned	  colBitWidth = dramsim_log2(config.NUM_COLS);
 		// this forces the alignment to the width of a single burst (64 bits = 8 bytes = 3 address bits for DDR parts)
-		unsigned	byteOffsetWidth = dramsim_log2((JEDEC_DATA_BUS_BITS/8));
+		unsigned	byteOffsetWidth = dramsim_log2((config.JEDEC_DATA_BUS_BITS/8));
 		// Since we're assuming that a request is for BL*BUS_WIDTH, the bottom bits
 		// of this address *should* be all zeros if it's not, issue a warning
 
 		if ((physicalAddress & transactionMask) != 0)
 		{
-			DEBUG("WARNING: address 0x"<<std::hex<<physicalAddress<<std::dec<<" is not aligned to the request size of "<<TRANS_DATA_BYTES);
+			DEBUG("WARNING: address 0x"<<std::hex<<physicalAddress<<std::dec<<" is not aligned to the request size of "<<config.TRANS_DATA_BYTES);
 		}
 
 		// each burst will contain JEDEC_DATA_BUS_BITS/8 bytes of data, so the bottom bits (3 bits for a single channel DDR system) are
 		// 	thrown away before mapping the other bits
+		// wear leveling moves lines around before they are split into channel/rank/bank/row/col
+		if (wearLeveler != NULL)
+		{
+			physicalAddress = wearLeveler->remap(physicalAddress);
+		}
+
 		physicalAddress >>= byteOffsetWidth;
 
 		// The next thing we have to consider is that when a request is made for a
@@ -281,7 +477,7 @@ namespace DRAMSim
 		// from the bottom bits of the column
 		//
 		// For example: cowLowBits = log2(64bytes) - 3 bits = 3 bits
-		unsigned colLowBitWidth = dramsim_log2(TRANS_DATA_BYTES) - byteOffsetWidth;
+		unsigned colLowBitWidth = dramsim_log2(config.TRANS_DATA_BYTES) - byteOffsetWidth;
 
 		physicalAddress >>= colLowBitWidth;
 		unsigned colHighBitWidth = colBitWidth - colLowBitWidth;
@@ -298,7 +494,7 @@ namespace DRAMSim
 		}
 
 */		//perform various address mapping schemes
-		if (addressMappingScheme == Scheme1)
+		if (config.addressMappingScheme == Scheme1)
 		{
 			//chan:rank:row:col:bank
 			tempA = physicalAddress;
@@ -326,7 +522,7 @@ namespace DRAMSim
 			tempB = physicalAddress << channelBitWidth;
 			chan = tempA ^ tempB;
 		}
-		else if (addressMappingScheme == Scheme2)
+		else if (config.addressMappingScheme == Scheme2)
 		{
 			//chan:row:col:bank:rank
 			tempA = physicalAddress;
@@ -355,7 +551,7 @@ namespace DRAMSim
 			chan = tempA ^ tempB;
 
 		}
-		else if (addressMappingScheme == Scheme3)
+		else if (config.addressMappingScheme == Scheme3)
 		{
 			//chan:rank:bank:col:row
 			tempA = physicalAddress;
@@ -384,7 +580,7 @@ namespace DRAMSim
 			chan = tempA ^ tempB;
 
 		}
-		else if (addressMappingScheme == Scheme4)
+		else if (config.addressMappingScheme == Scheme4)
 		{
 			//chan:rank:bank:row:col
 			tempA = physicalAddress;
@@ -413,7 +609,7 @@ namespace DRAMSim
 			chan = tempA ^ tempB;
 
 		}
-		else if (addressMappingScheme == Scheme5)
+		else if (config.addressMappingScheme == Scheme5)
 		{
 			//chan:row:col:rank:bank
 
@@ -444,7 +640,7 @@ namespace DRAMSim
 
 
 		}
-		else if (addressMappingScheme == Scheme6)
+		else if (config.addressMappingScheme == Scheme6)
 		{
 			//chan:row:bank:rank:col
 
@@ -476,7 +672,7 @@ namespace DRAMSim
 
 		}
 		// clone of scheme 5, but channel moved to lower bits
-		else if (addressMappingScheme == Scheme7)
+		else if (config.addressMappingScheme == Scheme7)
 		{
 			//row:col:rank:bank:chan
 			tempA = physicalAddress;
@@ -35,26 +35,40 @@
 #include "Transaction.h"
 #include "MemoryController.h"
 #include "Rank.h"
-#include "IniReader.h"
 #include "ClockDomain.h"
 #include "Callback.h"
+#include "WearLeveler.h"
 
 using std::deque;
 namespace DRAMSim
 {
 	//class MemoryController;
 	//class Rank;
+	class Checkpoint;
 	class MemorySystem
 	{
 	public: 
-		MemorySystem();
+		//config is copied, the values derived from it are filled in; the clocks
+		//belong to the caller (the DRAM clock is the one that runs update())
+		MemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM);
 		virtual ~MemorySystem();
-		bool addTransaction(Transaction *trans);
-		bool addTransaction(bool isWrite, uint64_t addr);
-		bool willAcceptTransaction();
-		bool willAcceptTransaction(uint64_t addr);
-		void update();
-		void printStats(bool finalStats);
+		virtual bool addTransaction(Transaction *trans);
+		virtual bool addTransaction(bool isWrite, uint64_t addr);
+		//an access of the sampled simulation's fast forward: updates the row
+		//buffers (and the hybrid's tags) without queueing or timing anything
+		virtual void functionalAccess(bool isWrite, uint64_t addr);
+		//no request is queued or in flight, the clocks may jump
+		virtual bool idle();
+		//the caller moved the DRAM clock forward by cycles that were not simulated
+		virtual void skipCycles(uint64_t cycles);
+		virtual bool willAcceptTransaction();
+		virtual bool willAcceptTransaction(uint64_t addr);
+		virtual void update();
+		virtual void printStats(bool finalStats);
+		//the rows of DATA_STORAGE builds, before anything that may hold a view of them
+		virtual void checkpointRows(Checkpoint &cp);
+		//everything else but the clock domains, which belong to the caller
+		virtual void checkpoint(Checkpoint &cp);
 		void registerCallbacks( TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone,
 								void (*reportPower)(double bgpower, double burstpower, double refreshpower, double actprepower));
 
@@ -67,18 +81,38 @@ namespace DRAMSim
 				unsigned &col);
 
 		unsigned findChannelNumber(uint64_t addr);
+		//the pending transactions of every channel
+		size_t pendingCount() const;
+		void wearLevelWrite(uint64_t addr);
 
 		//fields
+		Config config;
+		ClockDomain *clockDomainCPU;
+		ClockDomain *clockDomainDRAM;
+
 		vector<MemoryController *> memoryControllers;
 		vector<vector<Rank *> *> ranks;
-		deque<Transaction *> pendingTransactions;
+		//MS_BUFFER: per channel, the transactions its full transaction queue
+		//could not take yet, in order; at most PENDING_QUEUE_DEPTH of them
+		vector<deque<Transaction *> > pendingTransactions;
+		//per channel: cycles its oldest pending transaction was refused by the
+		//controller, transactions refused for a full pending queue, the deepest queue
+		vector<uint64_t> pendingBlockedCycles;
+		vector<uint64_t> pendingRejected;
+		vector<uint64_t> pendingMaxDepth;
+		WearLeveler *wearLeveler; //NULL unless WEAR_LEVELING or TRACK_WEAR is set
 
 		//function pointers
 		TransactionCompleteCB* ReadDataDone;
 		TransactionCompleteCB* WriteDataDone;
 
 		//TODO: make this a functor as well?
-		static PowerCB ReportPower;
+		PowerCB ReportPower;
+
+	protected:
+		//for memory systems built out of other memory systems (HybridMemorySystem); creates no channels
+		struct NoChannels {};
+		MemorySystem(const Config &cfg, ClockDomain *clockDomainCPU, ClockDomain *clockDomainDRAM, NoChannels);
 
 	};
 }
@@ -0,0 +1,74 @@
+//PhaseProfile.cpp
+//
+//Time stamp counter accumulators of the memory controller update phases
+//
+
+#include "PhaseProfile.h"
+
+#ifdef PROFILE_PHASES
+
+#include <iomanip>
+
+namespace DRAMSim
+{
+	static const char *phaseNames[PhaseProfile::NUM_PHASES] =
+	{
+		"Rank::update",
+		"updateBankState",
+		"updateCounter",
+		"updateCmdQueue",
+		"updateTransQueue",
+		"updateScrub",
+		"updateReturnTrans",
+		"updatePower",
+		"updatePartialQueue",
+		"issuePartialSET",
+		"getIdleInterval",
+		"updatePrint"
+	};
+
+	PhaseProfile::PhaseProfile() :
+		lapStart(0)
+	{
+		for (size_t i = 0; i < NUM_PHASES; i++)
+		{
+			ticks[i] = 0;
+			calls[i] = 0;
+		}
+	}
+
+	void PhaseProfile::print(std::ostream &out) const
+	{
+		uint64_t total = 0;
+		for (size_t i = 0; i < NUM_PHASES; i++)
+		{
+			total += ticks[i];
+		}
+#ifdef PROFILE_X86
+		const char *unit = "TSC ticks";
+#else
+		const char *unit = "ns";
+#endif
+		out << " --- Update phases (" << unit << ", " << total << " in all)" << std::endl;
+		std::ios::fmtflags flags = out.flags();
+		std::streamsize precision = out.precision();
+		out.setf(std::ios::fixed, std::ios::floatfield);
+		out.precision(1);
+		for (size_t i = 0; i < NUM_PHASES; i++)
+		{
+			if (calls[i] == 0)
+			{
+				continue;
+			}
+			out << "    " << std::left << std::setw(20) << phaseNames[i] << std::right
+					<< std::setw(16) << ticks[i]
+					<< std::setw(7) << (total == 0 ? 0.0 : 100.0 * ticks[i] / total) << "%"
+					<< std::setw(10) << (double) ticks[i] / calls[i] << " per call"
+					<< std::setw(12) << calls[i] << " calls" << std::endl;
+		}
+		out.flags(flags);
+		out.precision(precision);
+	}
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef PHASEPROFILE_H
+#define PHASEPROFILE_H
+
+//PhaseProfile.h
+//
+//PROFILE_PHASES builds only (SystemConfiguration.h): the time each phase of
+//MemoryController::update and the Rank::update calls of its channel take,
+//read from the time stamp counter on x86 (nanoseconds of the steady clock
+//elsewhere). A phase is timed from the previous lap to its own, one counter
+//read per phase:
+//
+//  PROFILE_START(profile);
+//  updateBankState();
+//  PROFILE_LAP(profile, BANK_STATE);
+//
+//Without PROFILE_PHASES both macros are empty and nothing is compiled in. The
+//breakdown is printed with the final statistics of each channel.
+//
+
+#include "SystemConfiguration.h"
+
+#ifdef PROFILE_PHASES
+
+#include <ostream>
+#if defined(__x86_64__) || defined(__i386__)
+	#define PROFILE_X86
+	#include <x86intrin.h>
+#else
+	#include <chrono>
+#endif
+
+namespace DRAMSim
+{
+	class PhaseProfile
+	{
+	public:
+		typedef enum
+		{
+			RANK_UPDATE,
+			BANK_STATE,
+			COUNTER,
+			CMD_QUEUE,
+			TRANS_QUEUE,
+			SCRUB,
+			RETURN_TRANS,
+			POWER,
+			PARTIAL_QUEUE,
+			PARTIAL_SET,
+			IDLE_INTERVAL,
+			UPDATE_PRINT,
+			NUM_PHASES
+		} Phase;
+
+		PhaseProfile();
+
+		static uint64_t now()
+		{
+#ifdef PROFILE_X86
+			return __rdtsc();
+#else
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+		}
+
+		void start()
+		{
+			lapStart = now();
+		}
+		//the time since the last start or lap goes to phase
+		void lap(Phase phase)
+		{
+			uint64_t t = now();
+			ticks[phase] += t - lapStart;
+			calls[phase]++;
+			lapStart = t;
+		}
+
+		void print(std::ostream &out) const;
+
+	private:
+		uint64_t lapStart;
+		uint64_t ticks[NUM_PHASES];
+		uint64_t calls[NUM_PHASES];
+	};
+}
+
+#define PROFILE_START(profile) (profile).start()
+#define PROFILE_LAP(profile, phase) (profile).lap(PhaseProfile::phase)
+
+#else
+
+#define PROFILE_START(profile)
+#define PROFILE_LAP(profile, phase)
+
+#endif
+
+#endif
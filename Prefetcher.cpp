@@ -0,0 +1,299 @@
+#include <iostream>
+
+#include "Prefetcher.h"
+
+using std::endl;
+
+using DRAMSim::Transaction;
+
+BlSim::Prefetcher* BlSim::Prefetcher::Create(const DRAMSim::Config &config, uint32_t core,
+                                             CacheHierarchy* cache, MemorySystem* memory_system,
+                                             TransactionReceiver* receiver) {
+    if (config.PREFETCHER == "none") {
+        return NULL;
+    }
+    if (config.PREFETCH_DEGREE == 0 || config.PREFETCH_TABLE == 0
+        || config.PREFETCH_BUFFER == 0 || config.PREFETCH_QUEUE == 0) {
+        ERROR("PREFETCH_DEGREE, PREFETCH_TABLE, PREFETCH_BUFFER and PREFETCH_QUEUE must not be zero");
+        exit(-1);
+    }
+    if (config.PREFETCHER == "next_line") {
+        return new NextLinePrefetcher(config, core, cache, memory_system, receiver);
+    } else if (config.PREFETCHER == "stride") {
+        return new StridePrefetcher(config, core, cache, memory_system, receiver);
+    } else if (config.PREFETCHER == "stream") {
+        return new StreamPrefetcher(config, core, cache, memory_system, receiver);
+    }
+    ERROR("Unknown PREFETCHER '" << config.PREFETCHER << "'; valid options are 'none', 'next_line', 'stride' or 'stream'");
+    exit(-1);
+}
+
+BlSim::Prefetcher::Prefetcher(const std::string &name, const DRAMSim::Config &config, uint32_t core,
+                              CacheHierarchy* cache, MemorySystem* memory_system,
+                              TransactionReceiver* receiver) :
+    m_name(name),
+    m_core(core),
+    m_degree(config.PREFETCH_DEGREE),
+    m_block_size(config.CACHE_BLOCK_BYTES),
+    m_block_low_bits(FloorLog2(config.CACHE_BLOCK_BYTES)),
+    m_cache(cache),
+    m_memory_system(memory_system),
+    m_transaction_receiver(receiver),
+    m_queue_capacity(config.PREFETCH_QUEUE),
+    m_buffer(config.PREFETCH_BUFFER, INVALID_BLOCK),
+    m_issue_cycles(config.PREFETCH_BUFFER, 0),
+    m_buffer_next(0),
+    m_warmup_cycle(0),
+    m_issued_count(0),
+    m_useful_count(0),
+    m_late_count(0),
+    m_useless_count(0),
+    m_dropped_count(0),
+    m_throttled_count(0),
+    m_miss_count(0) {
+}
+
+int32_t BlSim::Prefetcher::FindBuffered(uint64_t block) const {
+    for (uint32_t i = 0; i < m_buffer.size(); i++) {
+        if (m_buffer[i] == block) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// a block that is cached, buffered or queued already is not queued again
+void BlSim::Prefetcher::Enqueue(uint64_t block) {
+    if (FindBuffered(block) >= 0 || m_cache->Holds(m_core, block << m_block_low_bits)) {
+        return;
+    }
+    for (size_t i = 0; i < m_queue.size(); i++) {
+        if (m_queue[i] == block) {
+            return;
+        }
+    }
+    if (m_queue.size() == m_queue_capacity) {
+        m_queue.pop_front();
+        m_dropped_count++;
+    }
+    m_queue.push_back(block);
+}
+
+bool BlSim::Prefetcher::Demand(uint64_t maddr, uint32_t memop, uint64_t clock_cycle) {
+    uint64_t block = maddr >> m_block_low_bits;
+    int32_t entry = FindBuffered(block);
+    if (memop == MEM_WRITE) {
+        // the written block is in the cache now
+        if (entry >= 0) {
+            m_buffer[entry] = INVALID_BLOCK;
+        }
+        return false;
+    }
+
+    // a prefetch is measured if it was issued after the warmup
+    if (entry >= 0) {
+        m_buffer[entry] = INVALID_BLOCK;
+        if (m_issue_cycles[entry] > m_warmup_cycle) {
+            m_useful_count++;
+            if (m_transaction_receiver->readPending(block << m_block_low_bits)) {
+                m_late_count++;
+            }
+        }
+    } else if (clock_cycle > m_warmup_cycle) {
+        m_miss_count++;
+    }
+    Train(block);
+    return entry >= 0;
+}
+
+void BlSim::Prefetcher::Issue(uint64_t clock_cycle) {
+    if (m_queue.empty()) {
+        return;
+    }
+    uint64_t block = m_queue.front();
+    uint64_t addr = block << m_block_low_bits;
+    // a demand miss may have loaded it since it was queued
+    if (m_cache->Holds(m_core, addr)) {
+        m_queue.pop_front();
+        return;
+    }
+    if (!m_memory_system->willAcceptTransaction(addr)) {
+        if (clock_cycle > m_warmup_cycle) {
+            m_throttled_count++;
+        }
+        return;
+    }
+    // the transaction comes from the pool of Transaction::operator new
+    Transaction* trans = new Transaction(Transaction::DATA_READ, addr, NULL, m_block_size, clock_cycle);
+    if (!m_memory_system->addTransaction(trans)) {
+        delete trans;
+        return;
+    }
+    m_transaction_receiver->addPending(trans, clock_cycle, m_core);
+    m_queue.pop_front();
+
+    if (m_buffer[m_buffer_next] != INVALID_BLOCK && m_issue_cycles[m_buffer_next] > m_warmup_cycle) {
+        m_useless_count++;
+    }
+    m_buffer[m_buffer_next] = block;
+    m_issue_cycles[m_buffer_next] = clock_cycle;
+    m_buffer_next = (m_buffer_next + 1) % m_buffer.size();
+    if (clock_cycle > m_warmup_cycle) {
+        m_issued_count++;
+    }
+}
+
+void BlSim::Prefetcher::DumpStatistic(std::ostream &out) {
+    // accuracy: used of issued; coverage: the demand misses a prefetch
+    // covered; lateness: the covered ones that still waited for it
+    float accuracy = m_issued_count == 0 ? 0.0f : (float)m_useful_count / m_issued_count;
+    float coverage = m_useful_count + m_miss_count == 0 ? 0.0f :
+        (float)m_useful_count / (m_useful_count + m_miss_count);
+    float lateness = m_useful_count == 0 ? 0.0f : (float)m_late_count / m_useful_count;
+    out << "prefetcher " << m_core
+         << "\t" << m_name
+         << "\tissued: " << m_issued_count
+         << "\tuseful: " << m_useful_count
+         << "\tlate: " << m_late_count
+         << "\tuseless: " << m_useless_count
+         << "\tdropped: " << m_dropped_count
+         << "\tthrottled: " << m_throttled_count
+         << "\taccuracy: " << accuracy
+         << "\tcoverage: " << coverage
+         << "\tlateness: " << lateness << endl;
+}
+
+void BlSim::Prefetcher::Serialize(DRAMSim::Checkpoint &cp) {
+    cp.section(m_name);
+    cp.io(m_queue);
+    cp.io(m_buffer);
+    cp.io(m_issue_cycles);
+    cp.io(m_buffer_next);
+    cp.io(m_warmup_cycle);
+    cp.io(m_issued_count);
+    cp.io(m_useful_count);
+    cp.io(m_late_count);
+    cp.io(m_useless_count);
+    cp.io(m_dropped_count);
+    cp.io(m_throttled_count);
+    cp.io(m_miss_count);
+    SerializeTable(cp);
+}
+
+void BlSim::NextLinePrefetcher::Train(uint64_t block) {
+    for (uint32_t i = 1; i <= m_degree; i++) {
+        Enqueue(block + i);
+    }
+}
+
+BlSim::StridePrefetcher::StridePrefetcher(const DRAMSim::Config &config, uint32_t core,
+                                          CacheHierarchy* cache, MemorySystem* memory_system,
+                                          TransactionReceiver* receiver) :
+    Prefetcher("stride", config, core, cache, memory_system, receiver),
+    m_regions(config.PREFETCH_TABLE, INVALID_BLOCK),
+    m_last_blocks(config.PREFETCH_TABLE, 0),
+    m_strides(config.PREFETCH_TABLE, 0),
+    m_confidences(config.PREFETCH_TABLE, 0) {
+    m_region_shift = REGION_BYTES > m_block_size ? FloorLog2(REGION_BYTES / m_block_size) : 0;
+}
+
+void BlSim::StridePrefetcher::Train(uint64_t block) {
+    uint64_t region = block >> m_region_shift;
+    uint32_t entry = region % m_regions.size();
+    if (m_regions[entry] != region) {
+        m_regions[entry] = region;
+        m_last_blocks[entry] = block;
+        m_strides[entry] = 0;
+        m_confidences[entry] = 0;
+        return;
+    }
+    int64_t stride = (int64_t)(block - m_last_blocks[entry]);
+    if (stride == 0) {
+        return;
+    }
+    m_last_blocks[entry] = block;
+    if (stride == m_strides[entry]) {
+        if (m_confidences[entry] < CONFIDENCE_MAX) {
+            m_confidences[entry]++;
+        }
+    } else if (m_confidences[entry] > 0) {
+        m_confidences[entry]--;
+    } else {
+        m_strides[entry] = stride;
+    }
+    if (m_confidences[entry] < CONFIDENCE_FOLLOW) {
+        return;
+    }
+    for (uint32_t i = 1; i <= m_degree; i++) {
+        int64_t next = (int64_t)block + stride * (int64_t)i;
+        if (next < 0) {
+            break;
+        }
+        Enqueue(next);
+    }
+}
+
+void BlSim::StridePrefetcher::SerializeTable(DRAMSim::Checkpoint &cp) {
+    cp.io(m_regions);
+    cp.io(m_last_blocks);
+    cp.io(m_strides);
+    cp.io(m_confidences);
+}
+
+BlSim::StreamPrefetcher::StreamPrefetcher(const DRAMSim::Config &config, uint32_t core,
+                                          CacheHierarchy* cache, MemorySystem* memory_system,
+                                          TransactionReceiver* receiver) :
+    Prefetcher("stream", config, core, cache, memory_system, receiver),
+    m_heads(config.PREFETCH_TABLE, INVALID_BLOCK),
+    m_directions(config.PREFETCH_TABLE, 0),
+    m_last_use(config.PREFETCH_TABLE, 0),
+    m_use_count(0) {
+}
+
+void BlSim::StreamPrefetcher::Train(uint64_t block) {
+    uint32_t stream = m_heads.size();
+    uint32_t lru = 0;
+    for (uint32_t i = 0; i < m_heads.size(); i++) {
+        if (m_last_use[i] < m_last_use[lru]) {
+            lru = i;
+        }
+        if (m_heads[i] == INVALID_BLOCK) {
+            continue;
+        }
+        int64_t distance = (int64_t)(block - m_heads[i]);
+        int8_t direction = distance > 0 ? 1 : (distance < 0 ? -1 : 0);
+        if ((uint64_t)(distance < 0 ? -distance : distance) <= STREAM_WINDOW
+            && (m_directions[i] == 0 || direction == 0 || direction == m_directions[i])) {
+            stream = i;
+            break;
+        }
+    }
+    m_last_use[stream == m_heads.size() ? lru : stream] = ++m_use_count;
+    if (stream == m_heads.size()) {
+        // a new stream in the least recently used entry
+        m_heads[lru] = block;
+        m_directions[lru] = 0;
+        return;
+    }
+    if (block == m_heads[stream]) {
+        return;
+    }
+    if (m_directions[stream] == 0) {
+        m_directions[stream] = block > m_heads[stream] ? 1 : -1;
+    }
+    m_heads[stream] = block;
+    for (uint32_t i = 1; i <= m_degree; i++) {
+        int64_t next = (int64_t)block + m_directions[stream] * (int64_t)i;
+        if (next < 0) {
+            break;
+        }
+        Enqueue(next);
+    }
+}
+
+void BlSim::StreamPrefetcher::SerializeTable(DRAMSim::Checkpoint &cp) {
+    cp.io(m_heads);
+    cp.io(m_directions);
+    cp.io(m_last_use);
+    cp.io(m_use_count);
+}
@@ -0,0 +1,150 @@
+#ifndef PREFETCHER_H_
+#define PREFETCHER_H_
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <ostream>
+#include "MemorySystem.h"
+#include "Transaction.h"
+#include "Checkpoint.h"
+#include "SimpleCache.h"
+
+namespace BlSim {
+
+    /*
+     * The prefetcher of a core, between its cache path and the memory
+     * system. It trains on the demand reads that miss every level and
+     * queues the blocks it predicts (PREFETCH_QUEUE of them, the oldest is
+     * dropped); one is issued per cycle while the memory system accepts it
+     * and the demand is not stalled. A returned block waits in a buffer of
+     * PREFETCH_BUFFER blocks until a demand miss takes it into the cache.
+     *
+     *   next_line  the PREFETCH_DEGREE blocks after the miss
+     *   stride     a table of PREFETCH_TABLE 4 KB regions, direct mapped,
+     *              each with its last block and a stride that has to be
+     *              seen twice before it is followed
+     *   stream     PREFETCH_TABLE streams, each found by a miss near its
+     *              head and ordered by their last use; the second miss of
+     *              a stream sets its direction
+     *
+     * The traces have no program counters, so the stride table is indexed
+     * by the region of the address instead of by the load.
+     */
+    class Prefetcher {
+        protected:
+            std::string m_name;
+            uint32_t m_core;
+            uint32_t m_degree;
+            uint32_t m_block_size;
+            uint32_t m_block_low_bits;
+
+            CacheHierarchy* m_cache;
+            MemorySystem* m_memory_system;
+            TransactionReceiver* m_transaction_receiver;
+
+            std::deque<uint64_t> m_queue;   //the blocks to issue, oldest first
+            uint32_t m_queue_capacity;
+            std::vector<uint64_t> m_buffer; //issued blocks, INVALID_BLOCK once taken
+            std::vector<uint64_t> m_issue_cycles; //of each buffer entry
+            uint32_t m_buffer_next;         //the next entry to replace, FIFO
+
+            uint64_t m_warmup_cycle;
+            uint64_t m_issued_count;
+            uint64_t m_useful_count;   //demand misses found in the buffer
+            uint64_t m_late_count;     //the ones whose read was still in flight
+            uint64_t m_useless_count;  //replaced in the buffer before any use
+            uint64_t m_dropped_count;  //pushed out of a full queue
+            uint64_t m_throttled_count; //cycles the memory system refused one
+            uint64_t m_miss_count;     //demand misses the buffer did not cover
+
+            Prefetcher(const std::string &name, const DRAMSim::Config &config, uint32_t core,
+                       CacheHierarchy* cache, MemorySystem* memory_system,
+                       TransactionReceiver* receiver);
+
+            // a demand miss of block to learn from; predictions go to Enqueue
+            virtual void Train(uint64_t block) = 0;
+            virtual void SerializeTable(DRAMSim::Checkpoint &cp) {}
+
+            void Enqueue(uint64_t block);
+            // the buffer entry of block, -1 if none
+            int32_t FindBuffered(uint64_t block) const;
+
+        public:
+            virtual ~Prefetcher() {}
+
+            // NULL for PREFETCHER=none
+            static Prefetcher* Create(const DRAMSim::Config &config, uint32_t core,
+                                      CacheHierarchy* cache, MemorySystem* memory_system,
+                                      TransactionReceiver* receiver);
+
+            // a demand access that missed the cache path; true if the block
+            // was prefetched, the demand then needs no memory access. A
+            // write only drops a buffered copy.
+            bool Demand(uint64_t maddr, uint32_t memop, uint64_t clock_cycle);
+            // issue the oldest queued block, once per cycle
+            void Issue(uint64_t clock_cycle);
+            void SetWarmupCycle(uint64_t cycle) {
+                m_warmup_cycle = cycle;
+            }
+            void DumpStatistic(std::ostream &out);
+            void Serialize(DRAMSim::Checkpoint &cp);
+
+        private:
+            Prefetcher(const Prefetcher &other);
+            Prefetcher &operator=(const Prefetcher &other);
+    };
+
+    class NextLinePrefetcher : public Prefetcher {
+        public:
+            NextLinePrefetcher(const DRAMSim::Config &config, uint32_t core, CacheHierarchy* cache,
+                               MemorySystem* memory_system, TransactionReceiver* receiver) :
+                Prefetcher("next_line", config, core, cache, memory_system, receiver) {}
+
+        protected:
+            virtual void Train(uint64_t block);
+    };
+
+    class StridePrefetcher : public Prefetcher {
+        public:
+            StridePrefetcher(const DRAMSim::Config &config, uint32_t core, CacheHierarchy* cache,
+                             MemorySystem* memory_system, TransactionReceiver* receiver);
+
+        protected:
+            static const uint32_t REGION_BYTES = 4096;
+            static const uint8_t CONFIDENCE_MAX = 3;
+            static const uint8_t CONFIDENCE_FOLLOW = 2;
+
+            // per table entry
+            std::vector<uint64_t> m_regions; //INVALID_BLOCK for an empty entry
+            std::vector<uint64_t> m_last_blocks;
+            std::vector<int64_t> m_strides;
+            std::vector<uint8_t> m_confidences;
+            uint32_t m_region_shift; //block number to region
+
+            virtual void Train(uint64_t block);
+            virtual void SerializeTable(DRAMSim::Checkpoint &cp);
+    };
+
+    class StreamPrefetcher : public Prefetcher {
+        public:
+            StreamPrefetcher(const DRAMSim::Config &config, uint32_t core, CacheHierarchy* cache,
+                             MemorySystem* memory_system, TransactionReceiver* receiver);
+
+        protected:
+            // how far, in blocks, a miss may be from the head of its stream
+            static const uint64_t STREAM_WINDOW = 16;
+
+            // per stream
+            std::vector<uint64_t> m_heads; //the last block, INVALID_BLOCK for a free stream
+            std::vector<int8_t> m_directions; //0 until the second miss
+            std::vector<uint64_t> m_last_use;
+            uint64_t m_use_count;
+
+            virtual void Train(uint64_t block);
+            virtual void SerializeTable(DRAMSim::Checkpoint &cp);
+    };
+
+}
+#endif
@@ -63,8 +63,8 @@ using std::ostream;
 	#define PRINT(str)  { SimulatorIO::logFile <<str<<std::endl; }
 		#define PRINTN(str) { SimulatorIO::logFile <<str; }
 	#else
-		#define PRINT(str)  if(SHOW_SIM_OUTPUT) { std::cout <<str<<std::endl; }
-		#define PRINTN(str) if(SHOW_SIM_OUTPUT) { std::cout <<str; }
+		#define PRINT(str)  if(SHOW_SIM_OUTPUT) { *simOutput <<str<<std::endl; }
+		#define PRINTN(str) if(SHOW_SIM_OUTPUT) { *simOutput <<str; }
 	#endif
 #endif
 
@@ -31,6 +31,7 @@
 #include "Rank.h"
 #include "MemoryController.h"
 #include "Simulator.h"
+#include "Checkpoint.h"
 
 
 namespace DRAMSim
@@ -39,16 +40,23 @@ using std::max;
 #ifndef DATA_STORAGE_SSA
 
 	Rank::Rank(int id,MemoryController *mc) :
+		config(mc->config),
+		clockDomainDRAM(mc->clockDomainDRAM),
 		id(id),
 		memoryController(mc),
 		isPowerDown(false),
 		refreshWaiting(false),
 		readReturnCountdown(0),
-		banks(NUM_BANKS,Bank()),
-		bankStates(NUM_BANKS, BankState()),
+		bankStates(config.NUM_BANKS, BankState()),
 		outgoingDataPacket(NULL),
 		dataCyclesLeft(0)
 	{
+		// the banks keep their rows in the channel's backing store
+		banks.reserve(config.NUM_BANKS);
+		for (size_t i=0; i<config.NUM_BANKS; i++)
+		{
+			banks.push_back(Bank(config, mc->backingStore, ((uint64_t)id * config.NUM_BANKS + i) * config.NUM_ROWS, mc->faultInjector));
+		}
 	}
 
 	Rank::~Rank()
@@ -63,14 +71,14 @@ using std::max;
 
 	void Rank::receiveFromBus(BusPacket *packet)
 	{
-		const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+		const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- R" << this->id << " Receiving On Bus    : ");
 			packet->print();
 		}
-		if (VERIFICATION_OUTPUT)
+		if (config.VERIFICATION_OUTPUT)
 		{
 			packet->print(currentClockCycle,false);
 		}
@@ -90,21 +98,16 @@ using std::max;
 
 			//update state table
 			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + READ_TO_PRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
-				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(tCCD, BL/2));
+				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.tCCD, config.BL/2));
 				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
 			}
 
 			//get the read data and put it in the storage which delays until the appropriate time (RL)
 #ifdef DATA_STORAGE
 			banks[packet->bank].read(packet);
-	#ifdef DATA_RELIABILITY_ECC
-			if (packet->DATA_CHECK()==false)
-				if(packet->DATA_CORRECTION()==false)
-					PRINT("CAN'T FIX DATA ERROR!");
-			packet->DATA_DECODE();
-	#endif
+			checkReadData(packet);
 #else
 			packet->busPacketType = BusPacket::DATA;
 #endif
@@ -124,10 +127,10 @@ using std::max;
 			//update state table
 			bankStates[packet->bank].currentBankState = BankState::Idle;
 			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + READ_AUTOPRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				//will set next read/write for all banks - including current (which shouldnt matter since its now idle)
-				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(BL/2, tCCD));
+				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.BL/2, config.tCCD));
 				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
 			}
 
@@ -135,12 +138,7 @@ using std::max;
 #ifdef DATA_STORAGE
 			banks[packet->bank].read(packet);
 
-	#ifdef DATA_RELIABILITY_ECC
-			if (packet->DATA_CHECK()==false)
-				if(packet->DATA_CORRECTION()==false)
-					PRINT("CAN'T FIX DATA ERROR!");
-			packet->DATA_DECODE();
-	#endif
+			checkReadData(packet);
 #else
 			packet->busPacketType = BusPacket::DATA;
 #endif
@@ -160,11 +158,11 @@ using std::max;
 			}
 
 			//update state table
-			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(BL/2, tCCD));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.BL/2, config.tCCD));
 			}
 
 			//take note of where data is going when it arrives
@@ -175,7 +173,7 @@ using std::max;
 			break;
 		case BusPacket::SET_WRITE:
 		case BusPacket::COM_WRITE:
-			if(SET_CLOSE){
+			if(config.SET_CLOSE){
 							if (bankStates[packet->bank].currentBankState != BankState::RowActive ||
 					currentClockCycle < bankStates[packet->bank].nextWrite ||
 					packet->row != bankStates[packet->bank].openRowAddress)
@@ -186,10 +184,10 @@ using std::max;
 
 			//update state table
 			bankStates[packet->bank].currentBankState = BankState::Idle;
-			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle +SET_AUTOPRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(tCCD, BL/2));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.tCCD, config.BL/2));
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
 			}
 
@@ -205,11 +203,11 @@ using std::max;
 			}
 
 			//update state table
-			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + SET_TO_PRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(BL/2, tCCD));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.BL/2, config.tCCD));
 			}
 
 				}
@@ -231,10 +229,10 @@ using std::max;
 
 			//update state table
 			bankStates[packet->bank].currentBankState = BankState::Idle;
-			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(tCCD, BL/2));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.tCCD, config.BL/2));
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
 			}
 
@@ -256,27 +254,27 @@ using std::max;
 			}
 
 			bankStates[packet->bank].currentBankState = BankState::RowActive;
-			bankStates[packet->bank].nextActivate = currentClockCycle + tRC;
+			bankStates[packet->bank].nextActivate = currentClockCycle + config.tRC;
 			bankStates[packet->bank].openRowAddress = packet->row;
 
 			//if AL is greater than one, then posted-cas is enabled - handle accordingly
-			if (AL>0)
+			if (config.AL>0)
 			{
-				bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-				bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+				bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+				bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 			}
 			else
 			{
-				bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-				bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+				bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+				bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 			}
 
-			bankStates[packet->bank].nextPrecharge = currentClockCycle + tRAS;
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextPrecharge = currentClockCycle + config.tRAS;
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				if (i != packet->bank)
 				{
-					bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + tRRD);
+					bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + config.tRRD);
 				}
 			}
 			delete(packet);
@@ -291,19 +289,19 @@ using std::max;
 			}
 
 			bankStates[packet->bank].currentBankState = BankState::Idle;
-			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + tRP);
+			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + config.tRP);
 			delete(packet);
 			break;
 		case BusPacket::REFRESH:
 			refreshWaiting = false;
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				if (bankStates[i].currentBankState != BankState::Idle)
 				{
 					ERROR("== Error - Rank " << id << " received a REF when not allowed");
 					exit(0);
 				}
-				bankStates[i].nextActivate = currentClockCycle + tRFC;
+				bankStates[i].nextActivate = currentClockCycle + config.tRFC;
 			}
 			delete(packet);
 			break;
@@ -320,12 +318,44 @@ using std::max;
 					exit(0);
 				}
 			*/
+		{
+			// without stored data there is nothing to compare against, so assume
+			// half of the line's cells end up SET and half RESET
+			uint64_t setBits = config.TRANS_DATA_BYTES*8/2;
+			uint64_t resetBits = config.TRANS_DATA_BYTES*8/2;
+			if (packet->dirtyMask != 0)
+			{
+				// a partial write only drives the words the cache dirtied
+				uint64_t bytes = 8ULL*__builtin_popcountll(packet->dirtyMask);
+				if (bytes < config.TRANS_DATA_BYTES)
+				{
+					setBits = resetBits = bytes*8/2;
+				}
+			}
 #ifdef DATA_STORAGE
+			if (packet->data != NULL || packet->isSETWRITE)
+			{
 	#ifdef DATA_RELIABILITY_ECC
-			packet->DATA_ENCODE();
+				if (packet->data != NULL)
+				{
+					packet->DATA_ENCODE(config);
+				}
 	#endif
-			subarrays[packet->bank].write(packet);
+				banks[packet->bank].write(packet, setBits, resetBits);
+			}
+			else if (packet->isScrub)
+			{
+				unsigned corrected, uncorrectable;
+				banks[packet->bank].scrub(packet, corrected, uncorrectable);
+				memoryController->recordEcc(id, packet->bank, corrected, uncorrectable, true);
+			}
 #endif
+			if (packet->isSETWRITE)
+			{
+				resetBits = 0;
+			}
+			memoryController->updateCellWriteEnergy(packet, setBits, resetBits);
+		}
 			delete(packet);
 			break;
 		default:
@@ -340,6 +370,28 @@ using std::max;
 		return this->id;
 	}
 
+	bool Rank::previewWrite(const BusPacket *packet, uint64_t &setBits, uint64_t &resetBits)
+	{
+		return banks[packet->bank].previewWrite(packet, setBits, resetBits);
+	}
+
+	void Rank::checkReadData(BusPacket *packet)
+	{
+		FaultInjector *faults = memoryController->faultInjector;
+		if (faults != NULL)
+		{
+			//a bus error must not reach the stored row through a view
+			packet->data->detach();
+			faults->transfer(id * config.NUM_BANKS + packet->bank, packet->data->getData(), packet->data->getNumBytes());
+		}
+#ifdef DATA_RELIABILITY_ECC
+		unsigned corrected = 0, uncorrectable = 0;
+		packet->DATA_CORRECTION(config, corrected, uncorrectable);
+		memoryController->recordEcc(id, packet->bank, corrected, uncorrectable, false);
+		packet->DATA_DECODE(config);
+#endif
+	}
+
 	void Rank::update()
 	{
 		// An outgoing packet is one that is currently sending on the bus
@@ -366,13 +418,13 @@ using std::max;
 			// RL time has passed since the read was issued; this packet is
 			// ready to go out on the bus
 			outgoingDataPacket = readReturnPacket[0];
-			dataCyclesLeft = BL/2;
+			dataCyclesLeft = config.BL/2;
 
 			// remove the packet from the ranks
 			readReturnPacket.erase(readReturnPacket.begin());
 			readReturnCountdown.erase(readReturnCountdown.begin());
 
-			if (DEBUG_BUS)
+			if (config.DEBUG_BUS)
 			{
 				PRINTN(" -- R" << this->id << " Issuing On Data Bus : ");
 				outgoingDataPacket->print();
@@ -386,7 +438,7 @@ using std::max;
 	void Rank::powerDown()
 	{
 		//perform checks
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (bankStates[i].currentBankState != BankState::Idle)
 			{
@@ -394,7 +446,7 @@ using std::max;
 				exit(0);
 			}
 
-			bankStates[i].nextPowerUp = Simulator::clockDomainDRAM->clockcycle + tCKE;
+			bankStates[i].nextPowerUp = clockDomainDRAM->clockcycle + config.tCKE;
 			bankStates[i].currentBankState = BankState::PowerDown;
 		}
 
@@ -404,7 +456,7 @@ using std::max;
 	//power up the rank
 	void Rank::powerUp()
 	{
-		const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+		const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 		if (!isPowerDown)
 		{
@@ -414,7 +466,7 @@ using std::max;
 
 		isPowerDown = false;
 
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (bankStates[i].nextPowerUp > currentClockCycle)
 			{
@@ -422,7 +474,7 @@ using std::max;
 				ERROR(bankStates[i].nextPowerUp << "    " << currentClockCycle);
 				exit(0);
 			}
-			bankStates[i].nextActivate = currentClockCycle + tXP;
+			bankStates[i].nextActivate = currentClockCycle + config.tXP;
 			bankStates[i].currentBankState = BankState::Idle;
 		}
 	}
@@ -430,16 +482,27 @@ using std::max;
 #else
 
 	Rank::Rank(int id,MemoryController *mc) :
+		config(mc->config),
+		clockDomainDRAM(mc->clockDomainDRAM),
 		id(id),
 		memoryController(mc),
 		isPowerDown(false),
 		refreshWaiting(false),
 		readReturnCountdown(0),
-		subarrays(NUM_BANKS,vector<Subarray>(NUM_SUBARRAYS)),
-		bankStates(NUM_BANKS),
+		subarrays(config.NUM_BANKS),
+		bankStates(config.NUM_BANKS),
 		outgoingDataPacket(NULL),
 		dataCyclesLeft(0)
 	{
+		// the subarrays keep their rows in the channel's backing store
+		for (size_t i=0; i<config.NUM_BANKS; i++)
+		{
+			subarrays[i].reserve(NUM_SUBARRAYS);
+			for (size_t j=0; j<NUM_SUBARRAYS; j++)
+			{
+				subarrays[i].push_back(Subarray(config, mc->backingStore, (((uint64_t)id * config.NUM_BANKS + i) * NUM_SUBARRAYS + j) * config.NUM_ROWS));
+			}
+		}
 	}
 
 	Rank::~Rank()
@@ -454,16 +517,16 @@ using std::max;
 
 	void Rank::receiveFromBus(BusPacket *packet)
 	{
-		const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+		const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 		const unsigned iBank = packet->bank;
 		const unsigned iSubarray = packet->subarray;
 
-		if (DEBUG_BUS)
+		if (config.DEBUG_BUS)
 		{
 			PRINTN(" -- R" << this->id << " Receiving On Bus    : ");
 			packet->print();
 		}
-		if (VERIFICATION_OUTPUT)
+		if (config.VERIFICATION_OUTPUT)
 		{
 			packet->print(currentClockCycle,false);
 		}
@@ -483,21 +546,16 @@ using std::max;
 
 			//update state table
 			bankStates[iBank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + READ_TO_PRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
-				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(tCCD, BL/2));
+				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.tCCD, config.BL/2));
 				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
 			}
 
 			//get the read data and put it in the storage which delays until the appropriate time (RL)
 #ifdef DATA_STORAGE
 			subarrays[iBank][iSubarray].read(packet);
-	#ifdef DATA_RELIABILITY_ECC
-			if (packet->DATA_CHECK()==false)
-				if(packet->DATA_CORRECTION()==false)
-					PRINT("CAN'T FIX DATA ERROR!");
-			packet->DATA_DECODE();
-	#endif
+			checkReadData(packet);
 #else
 			packet->busPacketType = BusPacket::DATA;
 #endif
@@ -517,10 +575,10 @@ using std::max;
 			//update state table
 			bankStates[packet->bank].currentBankState = BankState::Idle;
 			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + READ_AUTOPRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				//will set next read/write for all banks - including current (which shouldnt matter since its now idle)
-				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(BL/2, tCCD));
+				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + max(config.BL/2, config.tCCD));
 				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + READ_TO_WRITE_DELAY);
 			}
 
@@ -528,12 +586,7 @@ using std::max;
 #ifdef DATA_STORAGE
 			subarrays[iBank][iSubarray].read(packet);
 
-	#ifdef DATA_RELIABILITY_ECC
-			if (packet->DATA_CHECK()==false)
-				if(packet->DATA_CORRECTION()==false)
-					PRINT("CAN'T FIX DATA ERROR!");
-			packet->DATA_DECODE();
-	#endif
+			checkReadData(packet);
 #else
 			packet->busPacketType = BusPacket::DATA;
 #endif
@@ -553,11 +606,11 @@ using std::max;
 			}
 
 			//update state table
-			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextPrecharge = max(bankStates[packet->bank].nextPrecharge, currentClockCycle + WRITE_TO_PRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(BL/2, tCCD));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.BL/2, config.tCCD));
 			}
 
 			//take note of where data is going when it arrives
@@ -578,10 +631,10 @@ using std::max;
 
 			//update state table
 			bankStates[packet->bank].currentBankState = BankState::Idle;
-			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY);
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + WRITE_AUTOPRE_DELAY_N(packet->writeRecovery));
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
-				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(tCCD, BL/2));
+				bankStates[i].nextWrite = max(bankStates[i].nextWrite, currentClockCycle + max(config.tCCD, config.BL/2));
 				bankStates[i].nextRead = max(bankStates[i].nextRead, currentClockCycle + WRITE_TO_READ_DELAY_B);
 			}
 
@@ -603,27 +656,27 @@ using std::max;
 			}
 
 			bankStates[packet->bank].currentBankState = BankState::RowActive;
-			bankStates[packet->bank].nextActivate = currentClockCycle + tRC;
+			bankStates[packet->bank].nextActivate = currentClockCycle + config.tRC;
 			bankStates[packet->bank].openRowAddress = packet->row;
 
 			//if AL is greater than one, then posted-cas is enabled - handle accordingly
-			if (AL>0)
+			if (config.AL>0)
 			{
-				bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-				bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+				bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+				bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 			}
 			else
 			{
-				bankStates[packet->bank].nextWrite = currentClockCycle + (tRCD-AL);
-				bankStates[packet->bank].nextRead = currentClockCycle + (tRCD-AL);
+				bankStates[packet->bank].nextWrite = currentClockCycle + (config.tRCD-config.AL);
+				bankStates[packet->bank].nextRead = currentClockCycle + (config.tRCD-config.AL);
 			}
 
-			bankStates[packet->bank].nextPrecharge = currentClockCycle + tRAS;
-			for (size_t i=0;i<NUM_BANKS;i++)
+			bankStates[packet->bank].nextPrecharge = currentClockCycle + config.tRAS;
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				if (i != packet->bank)
 				{
-					bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + tRRD);
+					bankStates[i].nextActivate = max(bankStates[i].nextActivate, currentClockCycle + config.tRRD);
 				}
 			}
 			delete(packet);
@@ -638,19 +691,19 @@ using std::max;
 			}
 
 			bankStates[packet->bank].currentBankState = BankState::Idle;
-			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + tRP);
+			bankStates[packet->bank].nextActivate = max(bankStates[packet->bank].nextActivate, currentClockCycle + config.tRP);
 			delete(packet);
 			break;
 		case BusPacket::REFRESH:
 			refreshWaiting = false;
-			for (size_t i=0;i<NUM_BANKS;i++)
+			for (size_t i=0;i<config.NUM_BANKS;i++)
 			{
 				if (bankStates[i].currentBankState != BankState::Idle)
 				{
 					ERROR("== Error - Rank " << id << " received a REF when not allowed");
 					exit(0);
 				}
-				bankStates[i].nextActivate = currentClockCycle + tRFC;
+				bankStates[i].nextActivate = currentClockCycle + config.tRFC;
 			}
 			delete(packet);
 			break;
@@ -667,12 +720,38 @@ using std::max;
 					exit(0);
 				}
 			*/
+		{
+			// without stored data there is nothing to compare against, so assume
+			// half of the line's cells end up SET and half RESET
+			uint64_t setBits = config.TRANS_DATA_BYTES*8/2;
+			uint64_t resetBits = config.TRANS_DATA_BYTES*8/2;
+			if (packet->dirtyMask != 0)
+			{
+				// a partial write only drives the words the cache dirtied
+				uint64_t bytes = 8ULL*__builtin_popcountll(packet->dirtyMask);
+				if (bytes < config.TRANS_DATA_BYTES)
+				{
+					setBits = resetBits = bytes*8/2;
+				}
+			}
 #ifdef DATA_STORAGE
+			if (packet->data != NULL || packet->isSETWRITE)
+			{
 	#ifdef DATA_RELIABILITY_ECC
-			packet->DATA_ENCODE();
+				if (packet->data != NULL)
+				{
+					packet->DATA_ENCODE(config);
+				}
 	#endif
-			subarrays[iBank][iSubarray].write(packet);
+				subarrays[iBank][iSubarray].write(packet, setBits, resetBits);
+			}
 #endif
+			if (packet->isSETWRITE)
+			{
+				resetBits = 0;
+			}
+			memoryController->updateCellWriteEnergy(packet, setBits, resetBits);
+		}
 			delete(packet);
 			break;
 		default:
@@ -687,6 +766,29 @@ using std::max;
 		return this->id;
 	}
 
+	bool Rank::previewWrite(const BusPacket *packet, uint64_t &setBits, uint64_t &resetBits)
+	{
+		//data-comparison write is not modeled per subarray
+		return false;
+	}
+
+	void Rank::checkReadData(BusPacket *packet)
+	{
+		FaultInjector *faults = memoryController->faultInjector;
+		if (faults != NULL)
+		{
+			//a bus error must not reach the stored row through a view
+			packet->data->detach();
+			faults->transfer(id * config.NUM_BANKS + packet->bank, packet->data->getData(), packet->data->getNumBytes());
+		}
+#ifdef DATA_RELIABILITY_ECC
+		unsigned corrected = 0, uncorrectable = 0;
+		packet->DATA_CORRECTION(config, corrected, uncorrectable);
+		memoryController->recordEcc(id, packet->bank, corrected, uncorrectable, false);
+		packet->DATA_DECODE(config);
+#endif
+	}
+
 	void Rank::update()
 	{
 
@@ -716,13 +818,13 @@ using std::max;
 			// ready to go out on the bus
 
 			outgoingDataPacket = readReturnPacket[0];
-			dataCyclesLeft = BL/2;
+			dataCyclesLeft = config.BL/2;
 
 			// remove the packet from the ranks
 			readReturnPacket.erase(readReturnPacket.begin());
 			readReturnCountdown.erase(readReturnCountdown.begin());
 
-			if (DEBUG_BUS)
+			if (config.DEBUG_BUS)
 			{
 				PRINTN(" -- R" << this->id << " Issuing On Data Bus : ");
 				outgoingDataPacket->print();
@@ -736,7 +838,7 @@ using std::max;
 	void Rank::powerDown()
 	{
 		//perform checks
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (bankStates[i].currentBankState != BankState::Idle)
 			{
@@ -744,7 +846,7 @@ using std::max;
 				exit(0);
 			}
 
-			bankStates[i].nextPowerUp = Simulator::clockDomainDRAM->clockcycle + tCKE;
+			bankStates[i].nextPowerUp = clockDomainDRAM->clockcycle + config.tCKE;
 			bankStates[i].currentBankState = BankState::PowerDown;
 		}
 
@@ -754,7 +856,7 @@ using std::max;
 	//power up the rank
 	void Rank::powerUp()
 	{
-		const uint64_t currentClockCycle = Simulator::clockDomainDRAM->clockcycle;
+		const uint64_t currentClockCycle = clockDomainDRAM->clockcycle;
 
 		if (!isPowerDown)
 		{
@@ -764,7 +866,7 @@ using std::max;
 
 		isPowerDown = false;
 
-		for (size_t i=0;i<NUM_BANKS;i++)
+		for (size_t i=0;i<config.NUM_BANKS;i++)
 		{
 			if (bankStates[i].nextPowerUp > currentClockCycle)
 			{
@@ -772,7 +874,7 @@ using std::max;
 				ERROR(bankStates[i].nextPowerUp << "    " << currentClockCycle);
 				exit(0);
 			}
-			bankStates[i].nextActivate = currentClockCycle + tXP;
+			bankStates[i].nextActivate = currentClockCycle + config.tXP;
 			bankStates[i].currentBankState = BankState::Idle;
 		}
 	}
@@ -780,4 +882,18 @@ using std::max;
 
 #endif
 
+	void Rank::checkpoint(Checkpoint &cp)
+	{
+		cp.io(isPowerDown);
+		cp.io(incomingWriteBank);
+		cp.io(incomingWriteRow);
+		cp.io(incomingWriteColumn);
+		cp.io(refreshWaiting);
+		cp.io(dataCyclesLeft);
+		cp.io(outgoingDataPacket);
+		cp.io(readReturnPacket);
+		cp.io(readReturnCountdown);
+		cp.io(bankStates);
+	}
+
 } // end of namespace DRAMSim
@@ -39,23 +39,30 @@
 #include "SystemConfiguration.h"
 #include "Bank.h"
 #include "BankState.h"
+#include "ClockDomain.h"
 
 namespace DRAMSim
 {
 	using std::vector;
 
 	class MemoryController;  //forward declaration
+	class Checkpoint;
 
 #ifndef DATA_STORAGE_SSA
 
 	class Rank
 	{
 	private:
+		//the parameters and the DRAM clock of the memory system the rank is in
+		const Config &config;
+		ClockDomain *clockDomainDRAM;
 		bool isPowerDown;
 		int id;
 		unsigned incomingWriteBank;
 		unsigned incomingWriteRow;
 		unsigned incomingWriteColumn;
+		//bus errors, ECC check and decode of data read from a bank
+		void checkReadData(BusPacket *packet);
 
 	public:
 		//functions
@@ -63,9 +70,12 @@ namespace DRAMSim
 		virtual ~Rank();
 		void receiveFromBus(BusPacket *packet);
 		int getId() const;
+		bool previewWrite(const BusPacket *packet, uint64_t &setBits, uint64_t &resetBits);
 		void update();
 		void powerUp();
 		void powerDown();
+		//the rows are in the backing store, which the controller saves
+		void checkpoint(Checkpoint &cp);
 
 		//fields
 		bool refreshWaiting;
@@ -84,11 +94,16 @@ namespace DRAMSim
 	class Rank
 	{
 	private:
+		//the parameters and the DRAM clock of the memory system the rank is in
+		const Config &config;
+		ClockDomain *clockDomainDRAM;
 		bool isPowerDown;
 		int id;
 		unsigned incomingWriteBank;
 		unsigned incomingWriteRow;
 		unsigned incomingWriteColumn;
+		//bus errors, ECC check and decode of data read from a bank
+		void checkReadData(BusPacket *packet);
 
 	public:
 		//functions
@@ -96,9 +111,12 @@ namespace DRAMSim
 		virtual ~Rank();
 		void receiveFromBus(BusPacket *packet);
 		int getId() const;
+		bool previewWrite(const BusPacket *packet, uint64_t &setBits, uint64_t &resetBits);
 		void update();
 		void powerUp();
 		void powerDown();
+		//the rows are in the backing store, which the controller saves
+		void checkpoint(Checkpoint &cp);
 
 		//fields
 		bool refreshWaiting;
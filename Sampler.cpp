@@ -0,0 +1,111 @@
+//Sampler.cpp
+//
+//Periodic measurement windows and their confidence intervals
+//
+
+#include "Sampler.h"
+#include <math.h>
+
+namespace DRAMSim
+{
+	//two sided 95% confidence
+	static const double confidenceZ = 1.96;
+
+	bool Sampler::enabled(const Config &config)
+	{
+		return config.SAMPLE_PERIOD > 0;
+	}
+
+	Sampler::Sampler(const Config &config) :
+		config(config),
+		records(0),
+		detailedRecords(0),
+		windowComplete(false),
+		busyFastForwards(0),
+		startCycle(0),
+		startReads(0),
+		startWrites(0),
+		startReadCycles(0)
+	{
+		if (config.SAMPLE_WINDOW == 0 || (uint64_t)config.SAMPLE_WARMUP + config.SAMPLE_WINDOW > config.SAMPLE_PERIOD)
+		{
+			ERROR("SAMPLE_WINDOW="<<config.SAMPLE_WINDOW<<" must not be zero and SAMPLE_WARMUP+SAMPLE_WINDOW="
+					<<config.SAMPLE_WARMUP<<"+"<<config.SAMPLE_WINDOW<<" must fit in SAMPLE_PERIOD="<<config.SAMPLE_PERIOD);
+			exit(-1);
+		}
+	}
+
+	void Sampler::fetched(const TransactionReceiver &receiver, uint64_t cycle)
+	{
+		uint64_t position = records % config.SAMPLE_PERIOD;
+		if (position == config.SAMPLE_PERIOD - config.SAMPLE_WINDOW)
+		{
+			startCycle = cycle;
+			startReads = receiver.readsDone;
+			startWrites = receiver.writesDone;
+			startReadCycles = receiver.readCycles;
+		}
+		if (position >= config.SAMPLE_PERIOD - config.SAMPLE_WARMUP - config.SAMPLE_WINDOW)
+		{
+			detailedRecords++;
+		}
+		records++;
+		windowComplete = records % config.SAMPLE_PERIOD == 0;
+	}
+
+	void Sampler::endWindow(const TransactionReceiver &receiver, uint64_t cycle)
+	{
+		uint64_t reads = receiver.readsDone - startReads;
+		uint64_t requests = reads + receiver.writesDone - startWrites;
+		if (reads > 0)
+		{
+			latencies.push_back((double)(receiver.readCycles - startReadCycles) / reads * config.tCK);
+		}
+		if (cycle > startCycle)
+		{
+			//bytes per ns are GB/s
+			bandwidths.push_back((double)requests * config.TRANS_DATA_BYTES / ((cycle - startCycle) * config.tCK));
+		}
+	}
+
+	//mean and half width of the confidence interval of the samples
+	static void printInterval(const char *name, const char *unit, const std::vector<double> &samples)
+	{
+		size_t n = samples.size();
+		if (n < 2)
+		{
+			PRINT("    "<<name<<" : not enough windows ("<<n<<") for a confidence interval");
+			return;
+		}
+		double sum = 0.0, squares = 0.0;
+		for (size_t i=0; i<n; i++)
+		{
+			sum += samples[i];
+		}
+		double mean = sum / n;
+		for (size_t i=0; i<n; i++)
+		{
+			squares += (samples[i] - mean) * (samples[i] - mean);
+		}
+		double deviation = sqrt(squares / (n - 1));
+		double halfWidth = confidenceZ * deviation / sqrt((double)n);
+		double relative = mean > 0 ? halfWidth / mean : 0.0;
+		uint64_t needed = mean > 0 ? (uint64_t)ceil(pow(confidenceZ * deviation / mean / 0.03, 2)) : 0;
+		PRINT("    "<<name<<" : "<<mean<<" "<<unit<<" +- "<<halfWidth<<" "<<unit<<" (+-"<<relative * 100<<"%, 95% confidence, "
+				<<needed<<" windows for +-3%)");
+	}
+
+	void Sampler::printStats()
+	{
+		PRINT(" --- Sampled simulation (period "<<config.SAMPLE_PERIOD<<", warmup "<<config.SAMPLE_WARMUP
+				<<", window "<<config.SAMPLE_WINDOW<<" records)");
+		PRINT("    windows : "<<bandwidths.size()<<"  records in detail : "<<detailedRecords<<" / "<<records
+				<<" ("<<(records > 0 ? 100.0 * detailedRecords / records : 0.0)<<"%)");
+		if (busyFastForwards > 0)
+		{
+			PRINT("    fast forwards without a clock jump (memory system busy) : "<<busyFastForwards);
+		}
+		printInterval("average read latency", "ns", latencies);
+		printInterval("bandwidth", "GB/s", bandwidths);
+	}
+}
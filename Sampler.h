@@ -0,0 +1,84 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+//Sampler.h
+//
+//Sampled simulation of a trace, in the way of SMARTS (Wunderlich et al.,
+//ISCA 2003). The trace is cut into periods of SAMPLE_PERIOD records; only the
+//end of each period is simulated in detail:
+//
+//  | functional ........................ | warmup | window |
+//    PERIOD - WARMUP - WINDOW records      WARMUP   WINDOW
+//
+//Functional records go through the cache and, on a miss, only update the row
+//buffers (and the hybrid's tags) of the memory system; no command is issued
+//and the clock jumps to the time of the last one. The jump needs a memory
+//system with nothing in flight; one that is still busy after the window (fills,
+//scrubs) has its time simulated in detail instead. The warmup records run
+//through the controllers to fill the queues again, then the latency and
+//bandwidth of the window records are measured and the requests drained before
+//the next functional stretch.
+//
+//Each window is one sample; the report gives the mean of the samples and its
+//95% confidence interval, and the number of windows needed for +-3%.
+//
+
+#include "SystemConfiguration.h"
+#include "Transaction.h"
+#include <vector>
+
+namespace DRAMSim
+{
+	class Sampler
+	{
+	public:
+		Sampler(const Config &config);
+
+		//false when SAMPLE_PERIOD is zero
+		static bool enabled(const Config &config);
+
+		//a record was taken from the trace (functional or detailed) at cycle
+		void fetched(const TransactionReceiver &receiver, uint64_t cycle);
+		//the next record is only simulated functionally
+		bool functional() const
+		{
+			return !windowComplete && records % config.SAMPLE_PERIOD < config.SAMPLE_PERIOD - config.SAMPLE_WARMUP - config.SAMPLE_WINDOW;
+		}
+		//the last record of a window was fetched, nothing more until the next period
+		bool windowFetched() const
+		{
+			return windowComplete;
+		}
+		//every request of the window is done at cycle
+		void endWindow(const TransactionReceiver &receiver, uint64_t cycle);
+		//the memory system has settled, records may be fetched again
+		void nextPeriod()
+		{
+			windowComplete = false;
+		}
+		//the memory system was not idle after a window, the clock could not jump
+		void busyFastForward()
+		{
+			busyFastForwards++;
+		}
+
+		void printStats();
+
+	private:
+		const Config &config;
+		uint64_t records;
+		uint64_t detailedRecords;
+		bool windowComplete;
+		uint64_t busyFastForwards;
+		//the counters when the window started
+		uint64_t startCycle;
+		uint64_t startReads;
+		uint64_t startWrites;
+		uint64_t startReadCycles;
+		//one sample per window
+		std::vector<double> latencies; //ns
+		std::vector<double> bandwidths; //GB/s
+	};
+}
+
+#endif
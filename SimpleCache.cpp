@@ -8,114 +8,145 @@ using std::cout;
 using std::endl;
 
 using DRAMSim::Transaction;
-using DRAMSim::WarmupCycle;
 
-BlSim::CacheBlock* BlSim::CacheBlock::GetWriteBackBlock() {
-    // 鍙湁drity,骞朵笖鏈夋暟鎹殑鏃跺�鎵嶉渶瑕佷細鍐欏埌鍐呭瓨
-    if (m_dirty == 0 || m_block_addr == INVALID_BLOCK)
-        return NULL;
-    return new CacheBlock(m_block_size, m_block_addr, m_block_tag);
-}
+#if defined(__x86_64__) || defined(__i386__)
+    #define CACHE_X86
+    #include <immintrin.h>
+#endif
 
-void BlSim::CacheBlock::Refresh(const CacheAddress& cache_addr) {
-    m_block_addr = cache_addr.addr;
-    m_block_tag = cache_addr.tag;
-    m_dirty = 0;
-    m_next = NULL;
-    m_prev = NULL;
+#ifdef CACHE_X86
+// 4 tags per compare
+__attribute__((target("avx2")))
+static int32_t FindAVX2(const int64_t *tags, uint32_t way_count, int64_t tag) {
+    const __m256i key = _mm256_set1_epi64x(tag);
+    uint32_t i = 0;
+    for (; i + 4 <= way_count; i += 4) {
+        __m256i row = _mm256_loadu_si256((const __m256i *)(tags + i));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(row, key)));
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    for (; i < way_count; i++) {
+        if (tags[i] == tag) {
+            return i;
+        }
+    }
+    return -1;
 }
 
-void BlSim::CacheBlock::Access(uint32_t memop) {
-	if(memop == MEM_WRITE) {
-		m_dirty = 1;
-	}
+static bool HasAVX2() {
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    return avx2;
 }
+#endif
 
-BlSim::CacheSet::CacheSet(uint32_t way_count, uint32_t block_size):
-	m_way_count(way_count) {
-	CacheBlock* p_block = NULL;
-	CacheBlock* p_next_block = NULL;
-	p_block = new CacheBlock(block_size);
-	m_p_mru_block = p_block;
-
-	for (int i = 1; i < way_count; i++) {
-		p_next_block = new CacheBlock(block_size);
-		p_block->m_next = p_next_block;
-		p_next_block->m_prev = p_block;
-		p_block = p_next_block;		
+BlSim::CacheSet::CacheSet(uint32_t way_count, uint32_t set, ReplacementPolicy* policy, int64_t *tags,
+                          uint64_t *addrs, DirtyMask *dirty, uint8_t *repl):
+	m_way_count(way_count),
+	m_set(set),
+	m_policy(policy),
+	m_tags(tags),
+	m_addrs(addrs),
+	m_dirty(dirty),
+	m_repl(repl),
+	m_mru_way(0) {
+	for (uint32_t i = 0; i < way_count; i++) {
+		m_tags[i] = -1;
+		m_addrs[i] = INVALID_BLOCK;
+		m_dirty[i] = 0;
 	}
-	m_p_lru_block = p_next_block;
+	m_policy->Reset(m_set, m_repl, m_way_count);
 }
 
-BlSim::CacheSet::~CacheSet() {
-	CacheBlock* p_block = NULL;
-	CacheBlock* p_next_block = NULL;
-
-	p_block = m_p_mru_block;
-	while (p_block) {
-		p_next_block = p_block->m_next;
-		delete p_block;
-		p_block = p_next_block;
+int32_t BlSim::CacheSet::Find(int64_t tag) const {
+#ifdef CACHE_X86
+	if (HasAVX2()) {
+		return FindAVX2(m_tags, m_way_count, tag);
+	}
+#endif
+	for (uint32_t i = 0; i < m_way_count; i++) {
+		if (m_tags[i] == tag) {
+			return i;
+		}
 	}
+	return -1;
 }
 
 /*
  * 鏍规嵁tag鎵惧埌block
  */
 bool BlSim::CacheSet::FindToDo(int64_t tag) {
-	CacheBlock *p_block = m_p_mru_block;
-	while (p_block) {
-		if (tag == p_block->m_block_tag) {
-		    // 濡傛灉涓嶆槸mru鍧�
-            if (p_block->m_prev) {
-                p_block->m_prev->m_next = p_block->m_next;
-                if (p_block->m_next) {
-                    p_block->m_next->m_prev = p_block->m_prev;
-                } else {
-                    // 鏄痩ru鍧楋紝闇�鏇存柊lru鍧椾负prev
-                    m_p_lru_block = p_block->m_prev;
-                }
-                // 鏇存柊mru鍧楋紝璁惧綋鍓嶅潡涓簃ru鍧�
-                p_block->m_next = m_p_mru_block;
-                m_p_mru_block->m_prev = p_block;
-                p_block->m_prev = NULL;
-                m_p_mru_block = p_block;
-            }
-            return true;
-		}
-		p_block = p_block->m_next;
+	int32_t way = Find(tag);
+	if (way < 0) {
+		return false;
+	}
+	m_policy->Hit(m_set, m_repl, m_way_count, way);
+	m_mru_way = way;
+	return true;
+}
+
+bool BlSim::CacheSet::MarkDirty(int64_t tag, DirtyMask dirty) {
+	int32_t way = Find(tag);
+	if (way < 0) {
+		return false;
+	}
+	m_dirty[way] |= dirty;
+	return true;
+}
+
+BlSim::DirtyMask BlSim::CacheSet::Invalidate(int64_t tag) {
+	int32_t way = Find(tag);
+	if (way < 0) {
+		return 0;
 	}
-	return false;
+	DirtyMask dirty = m_dirty[way];
+	m_tags[way] = -1;
+	m_addrs[way] = INVALID_BLOCK;
+	m_dirty[way] = 0;
+	m_policy->Invalidate(m_set, m_repl, m_way_count, way);
+	return dirty;
 }
 
 /*
- * 鍏坋vict鐨刲ru鍧楋紝鍐嶈浇鍏ユ柊鐨勫潡锛屽苟璁剧疆涓簃ru鍧楋紝杩斿洖闇�鍐欏洖鐨勫潡
+ * 鍏坋vict鐨刲ru鍧楋紝鍐嶈浇鍏ユ柊鐨勫潡锛屽苟璁剧疆涓簃ru鍧楋紝杩斿洖闇�鍐欏洖鐨勫潡
  */
-BlSim::CacheBlock* BlSim::CacheSet::LoadNewBlock(const CacheAddress& cache_addr) {
+BlSim::CacheVictim BlSim::CacheSet::LoadNewBlock(const CacheAddress& cache_addr) {
     // evict lru鍧�
-    CacheBlock* p_block = m_p_lru_block;
-    m_p_lru_block = m_p_lru_block->m_prev;
-    m_p_lru_block->m_next = NULL;
-    // 鎶妉ru鍧楀啓鍥炲埌鍐呭瓨
-    CacheBlock* block = p_block->GetWriteBackBlock();
-    p_block->Refresh(cache_addr);
+    int32_t way = Find(-1);
+    if (way < 0) {
+        way = m_policy->Victim(m_set, m_repl, m_dirty, m_way_count);
+    }
+    // 鍙湁drity,骞朵笖鏈夋暟鎹殑鏃跺�鎵嶉渶瑕佷細鍐欏埌鍐呭瓨
+    CacheVictim victim(m_addrs[way], m_dirty[way]);
+    m_addrs[way] = cache_addr.addr;
+    m_tags[way] = cache_addr.tag;
+    m_dirty[way] = 0;
     // 璁剧疆褰撳墠鍧椾负mru鍧�
-    p_block->m_next = m_p_mru_block;
-    m_p_mru_block->m_prev = p_block;
-    m_p_mru_block = p_block;
-    return block;
+    m_policy->Insert(m_set, m_repl, m_way_count, way);
+    m_mru_way = way;
+    return victim;
 }
 
-BlSim::Cache::Cache(uint32_t cores,
-                    MemorySystem* memory_system,
-                    TransactionReceiver* receiver) :
-    m_memory_system(memory_system),
-    m_transaction_receiver(receiver) {
-    m_cache_capacity = (32UL << 20) * cores;
-    m_cache_way_count = 8;
-    m_block_size = 64;
+BlSim::Cache::Cache(const std::string &name, uint64_t capacity, uint32_t way_count,
+                    uint32_t block_size, const std::string &replacement) :
+    m_name(name) {
+    m_cache_capacity = capacity;
+    m_cache_way_count = way_count;
+    m_block_size = block_size;
     m_cache_set_capacity = m_block_size * m_cache_way_count;
-    m_cache_set_count = m_cache_capacity / m_cache_set_capacity;
+    m_cache_set_count = way_count == 0 ? 0 : m_cache_capacity / m_cache_set_capacity;
+
+    // the ages of a set are bytes, the set index and the block offset are
+    // masks, a dirty mask has a bit per word
+    if (way_count == 0 || way_count > 255 || block_size < CACHE_WORD_BYTES
+        || block_size > 64 * CACHE_WORD_BYTES || (block_size & (block_size - 1)) != 0
+        || m_cache_set_count == 0 || (m_cache_set_count & (m_cache_set_count - 1)) != 0
+        || (uint64_t)m_cache_set_count * m_cache_set_capacity != m_cache_capacity) {
+        ERROR("The " << m_name << " cache of " << capacity << " bytes, " << way_count << " ways and "
+              << block_size << " byte blocks needs 1 to 255 ways, 8 to 512 byte blocks and a power of two of blocks and of sets");
+        exit(-1);
+    }
 
     m_block_low_bits = FloorLog2(m_block_size);
     m_set_index_bits = FloorLog2(m_cache_set_count);
@@ -126,21 +157,44 @@ BlSim::Cache::Cache(uint32_t cores,
     m_hit_count = 0;
     m_writeback_count = 0;
     m_total_count = 0;
+    m_warmup_cycle = 0;
 
-    m_cache_sets = new CacheSet*[m_cache_set_count];
-    for (int i = 0; i < m_cache_set_count; ++i) {
-        m_cache_sets[i] = new CacheSet(m_cache_way_count, m_block_size);
+    m_policy = ReplacementPolicy::Create(replacement, m_cache_set_count);
+    if (m_policy == NULL) {
+        ERROR("Unknown replacement policy '" << replacement << "' of the " << m_name
+              << " cache; valid options are 'lru', 'srrip', 'brrip', 'drrip' or 'write_aware'");
+        exit(-1);
+    }
+    m_lru_shadow = NULL;
+    m_sample_shift = 0;
+    m_sampled_writeback_count = 0;
+    m_shadow_writeback_count = 0;
+    if (replacement != "lru") {
+        m_sample_shift = m_set_index_bits < 5 ? m_set_index_bits : 5;
+        m_lru_shadow = new Cache(m_name + " LRU", m_cache_capacity >> m_sample_shift,
+                                 m_cache_way_count, m_block_size, "lru");
+    }
+
+    size_t blocks = (size_t)m_cache_set_count * m_cache_way_count;
+    m_tags = new int64_t[blocks];
+    m_addrs = new uint64_t[blocks];
+    m_dirty = new DirtyMask[blocks];
+    m_repl = new uint8_t[blocks];
+    m_cache_sets.reserve(m_cache_set_count);
+    for (uint32_t i = 0; i < m_cache_set_count; ++i) {
+        size_t first = (size_t)i * m_cache_way_count;
+        m_cache_sets.push_back(CacheSet(m_cache_way_count, i, m_policy, m_tags + first,
+                                        m_addrs + first, m_dirty + first, m_repl + first));
     }
 }
 
 BlSim::Cache::~Cache() {
-    for (int i = 0; i < m_cache_set_count; ++i) {
-        if (m_cache_sets[i]) {
-            delete m_cache_sets[i];
-            m_cache_sets[i] = NULL;
-        }
-    }
-    delete [] m_cache_sets;
+    delete [] m_tags;
+    delete [] m_addrs;
+    delete [] m_dirty;
+    delete [] m_repl;
+    delete m_policy;
+    delete m_lru_shadow;
 }
 
 /*
@@ -159,53 +213,322 @@ BlSim::CacheAddress BlSim::Cache::GetCacheAddress(uint64_t maddr) {
 	return addr;
 }
 
-void BlSim::Cache::WriteBack(CacheBlock* block, uint64_t clock_cycle) {
-    Transaction* trans = new Transaction(Transaction::DATA_WRITE,
-                                         block->m_block_addr,
-                                         NULL,
-                                         block->m_block_size,
-                                         clock_cycle);
-    //cout << "write back. addr: " << block->m_block_addr
-    //     << "\tcycle: " << clock_cycle << endl;
-    if(clock_cycle > WarmupCycle){
-    	m_writeback_count++;
-    }
-    if (m_memory_system->addTransaction(trans))
-	m_transaction_receiver->addPending(trans, clock_cycle);
-}
-
-bool BlSim::Cache::Access(uint64_t maddr, uint32_t memop,
-                          uint64_t clock_cycle) {
-    //cout << "access addr:" << maddr << "\top:" << memop << endl;
-	if(clock_cycle > WarmupCycle){
+bool BlSim::Cache::Lookup(uint64_t maddr, uint64_t clock_cycle) {
+	if(clock_cycle > m_warmup_cycle){
 		m_total_count++;
 	}
     // 鑾峰彇缁勫亸绉诲拰tag
     CacheAddress cache_addr = GetCacheAddress(maddr);
-    // 鏍规嵁tag鍦ㄧ浉搴旂粍涓煡鎵綽lock
-    bool is_hit = m_cache_sets[cache_addr.index]->FindToDo(cache_addr.tag);
-    if (is_hit) {
-    	if(clock_cycle>WarmupCycle){
-            m_hit_count++;
-    	}
-    } else {
-        // 娌℃湁鍛戒腑鍒欓渶瑕佽浇鍏ache锛屽苟evict lru鍧�
-        CacheBlock* block = m_cache_sets[cache_addr.index]->LoadNewBlock(cache_addr);
-        if (block) {
-            WriteBack(block, clock_cycle);
-            delete block;
-        }
+    // 鏍规嵁tag鍦ㄧ浉搴旂粍涓煡鎵綽lock
+    bool is_hit = m_cache_sets[cache_addr.index].FindToDo(cache_addr.tag);
+    if (is_hit && clock_cycle > m_warmup_cycle) {
+        m_hit_count++;
+    }
+    if (IsSampled(cache_addr)) {
+        ShadowAccess(cache_addr, clock_cycle);
     }
-    // 璁块棶褰撳墠鍧�
-    m_cache_sets[cache_addr.index]->GetMruBlock()->Access(memop);
     return is_hit;
 }
 
-void BlSim::Cache::DumpStatistic() {
+bool BlSim::Cache::Holds(uint64_t maddr) {
+    CacheAddress cache_addr = GetCacheAddress(maddr);
+    return m_cache_sets[cache_addr.index].Holds(cache_addr.tag);
+}
+
+BlSim::CacheVictim BlSim::Cache::Fill(uint64_t maddr) {
+    // 娌℃湁鍛戒腑鍒欓渶瑕佽浇鍏ache锛屽苟evict lru鍧�
+    CacheAddress cache_addr = GetCacheAddress(maddr);
+    return m_cache_sets[cache_addr.index].LoadNewBlock(cache_addr);
+}
+
+void BlSim::Cache::AccessMru(uint64_t maddr, uint32_t memop) {
+    CacheAddress cache_addr = GetCacheAddress(maddr);
+    m_cache_sets[cache_addr.index].AccessMru(memop, (maddr & m_block_low_mask) / CACHE_WORD_BYTES);
+    if (memop == MEM_WRITE && IsSampled(cache_addr)) {
+        m_lru_shadow->AccessMru(ShadowAddress(cache_addr), memop);
+    }
+}
+
+bool BlSim::Cache::MarkDirty(uint64_t maddr, DirtyMask dirty, uint64_t clock_cycle) {
+    CacheAddress cache_addr = GetCacheAddress(maddr);
+    if (IsSampled(cache_addr)) {
+        ShadowWriteBack(cache_addr, dirty, clock_cycle);
+    }
+    return m_cache_sets[cache_addr.index].MarkDirty(cache_addr.tag, dirty);
+}
+
+BlSim::DirtyMask BlSim::Cache::Invalidate(uint64_t maddr) {
+    CacheAddress cache_addr = GetCacheAddress(maddr);
+    if (IsSampled(cache_addr)) {
+        m_lru_shadow->Invalidate(ShadowAddress(cache_addr));
+    }
+    return m_cache_sets[cache_addr.index].Invalidate(cache_addr.tag);
+}
+
+void BlSim::Cache::CountWriteBack(uint64_t maddr, uint64_t clock_cycle) {
+    if (clock_cycle > m_warmup_cycle) {
+        m_writeback_count++;
+        if (IsSampled(GetCacheAddress(maddr))) {
+            m_sampled_writeback_count++;
+        }
+    }
+}
+
+// the shadow misses and fills like this level would under LRU
+void BlSim::Cache::ShadowAccess(const CacheAddress &cache_addr, uint64_t clock_cycle) {
+    uint64_t addr = ShadowAddress(cache_addr);
+    if (!m_lru_shadow->Lookup(addr, clock_cycle)) {
+        CacheVictim victim = m_lru_shadow->Fill(addr);
+        if (victim.m_dirty && clock_cycle > m_warmup_cycle) {
+            m_shadow_writeback_count++;
+        }
+    }
+}
+
+// a write back from the level above; the second one of a block this level
+// had to fill first finds it in the shadow already
+void BlSim::Cache::ShadowWriteBack(const CacheAddress &cache_addr, DirtyMask dirty, uint64_t clock_cycle) {
+    uint64_t addr = ShadowAddress(cache_addr);
+    if (!m_lru_shadow->MarkDirty(addr, dirty, clock_cycle)) {
+        CacheVictim victim = m_lru_shadow->Fill(addr);
+        if (victim.m_dirty && clock_cycle > m_warmup_cycle) {
+            m_shadow_writeback_count++;
+        }
+        m_lru_shadow->MarkDirty(addr, dirty, clock_cycle);
+    }
+}
+
+void BlSim::Cache::DumpStatistic(std::ostream &out) {
     float hit_rate = (float)(m_hit_count) / m_total_count;
-    cout << "total: " << m_total_count
+    out << m_name
+         << "\ttotal: " << m_total_count
          << "\twrite back: " << m_writeback_count
          << "\thit: " << m_hit_count
+         << "\tmiss: " << m_total_count - m_hit_count
          << "\thit rate: " << hit_rate << endl;
+    if (m_lru_shadow != NULL) {
+        // in the sampled sets, against what LRU wrote back there
+        float reduction = m_shadow_writeback_count == 0 ? 0.0f :
+            100.0f * ((float)m_shadow_writeback_count - (float)m_sampled_writeback_count) / m_shadow_writeback_count;
+        out << m_name
+             << "\treplacement: " << m_policy->Name()
+             << "\tsampled sets: 1/" << (1U << m_sample_shift)
+             << "\twrite back: " << m_sampled_writeback_count
+             << "\tLRU write back: " << m_shadow_writeback_count
+             << "\twrite back reduction: " << reduction << "%" << endl;
+    }
+}
+
+void BlSim::CacheSet::Serialize(DRAMSim::Checkpoint &cp) {
+    for (uint32_t way = 0; way < m_way_count; way++) {
+        cp.io(m_addrs[way]);
+        cp.io(m_tags[way]);
+        cp.io(m_dirty[way]);
+        cp.io(m_repl[way]);
+    }
+    cp.io(m_mru_way);
 }
 
+void BlSim::Cache::Serialize(DRAMSim::Checkpoint &cp) {
+    cp.section(m_name);
+    cp.io(m_hit_count);
+    cp.io(m_writeback_count);
+    cp.io(m_total_count);
+    cp.io(m_warmup_cycle);
+    m_policy->Serialize(cp);
+    for (uint32_t i = 0; i < m_cache_set_count; ++i) {
+        m_cache_sets[i].Serialize(cp);
+    }
+    if (m_lru_shadow != NULL) {
+        cp.io(m_sampled_writeback_count);
+        cp.io(m_shadow_writeback_count);
+        m_lru_shadow->Serialize(cp);
+    }
+}
+
+BlSim::CacheHierarchy::CacheHierarchy(const DRAMSim::Config &config,
+                                      uint32_t cores,
+                                      MemorySystem* memory_system,
+                                      TransactionReceiver* receiver) :
+    m_paths(cores),
+    m_partial_write(config.PARTIAL_WRITE),
+    m_block_size(config.CACHE_BLOCK_BYTES),
+    m_memory_system(memory_system),
+    m_transaction_receiver(receiver) {
+    if (config.CACHE_INCLUSION == "non_inclusive") {
+        m_inclusive = false;
+    } else if (config.CACHE_INCLUSION == "inclusive") {
+        m_inclusive = true;
+    } else {
+        ERROR("Unknown CACHE_INCLUSION '" << config.CACHE_INCLUSION << "'; valid options are 'non_inclusive' or 'inclusive'");
+        exit(-1);
+    }
+    // a mask only says which words of a memory line to program if a block is one
+    if (m_partial_write && m_block_size != config.TRANS_DATA_BYTES) {
+        std::cerr << "WARNING: PARTIAL_WRITE needs CACHE_BLOCK_BYTES=" << m_block_size
+                  << " to be the memory line of " << config.TRANS_DATA_BYTES << " bytes; lines are written whole" << endl;
+        m_partial_write = false;
+    }
+
+    uint32_t block_size = m_block_size;
+    for (uint32_t core = 0; core < cores; ++core) {
+        std::ostringstream core_name;
+        core_name << " core " << core;
+        if (config.CACHE_L1_KB > 0) {
+            m_caches.push_back(new Cache("L1" + core_name.str(), (uint64_t)config.CACHE_L1_KB << 10,
+                                         config.CACHE_L1_ASSOC, block_size, config.CACHE_L1_REPLACEMENT));
+            m_paths[core].push_back(m_caches.back());
+        }
+        if (config.CACHE_L2_KB > 0) {
+            m_caches.push_back(new Cache("L2" + core_name.str(), (uint64_t)config.CACHE_L2_KB << 10,
+                                         config.CACHE_L2_ASSOC, block_size, config.CACHE_L2_REPLACEMENT));
+            m_paths[core].push_back(m_caches.back());
+        }
+    }
+    if (config.CACHE_LLC_KB > 0) {
+        m_caches.push_back(new Cache("LLC", (uint64_t)config.CACHE_LLC_KB << 10,
+                                     config.CACHE_LLC_ASSOC, block_size, config.CACHE_LLC_REPLACEMENT));
+        for (uint32_t core = 0; core < cores; ++core) {
+            m_paths[core].push_back(m_caches.back());
+        }
+    }
+}
+
+BlSim::CacheHierarchy::~CacheHierarchy() {
+    for (size_t i = 0; i < m_caches.size(); ++i) {
+        delete m_caches[i];
+    }
+    for (size_t i = 0; i < m_writebacks.size(); ++i) {
+        delete m_writebacks[i];
+    }
+}
+
+/*
+ * The first level holding maddr returns it, the levels above it load it
+ * from there (the lower ones first, so an inclusive level has it before
+ * the level above); a write dirties the copy in the first level.
+ */
+bool BlSim::CacheHierarchy::Access(uint32_t core, uint64_t maddr, uint32_t memop,
+                                   uint64_t clock_cycle, bool functional) {
+    std::vector<Cache*> &path = m_paths[core];
+    uint32_t hit_level = path.size();
+    for (uint32_t level = 0; level < path.size(); ++level) {
+        if (path[level]->Lookup(maddr, clock_cycle)) {
+            hit_level = level;
+            break;
+        }
+    }
+    for (uint32_t level = hit_level; level-- > 0;) {
+        Fill(core, level, maddr, clock_cycle, functional);
+    }
+    if (!path.empty()) {
+        path[0]->AccessMru(maddr, memop);
+    }
+    return hit_level < path.size();
+}
+
+void BlSim::CacheHierarchy::Fill(uint32_t core, uint32_t level, uint64_t maddr,
+                                 uint64_t clock_cycle, bool functional) {
+    CacheVictim victim = m_paths[core][level]->Fill(maddr);
+    if (!victim.Valid()) {
+        return;
+    }
+    DirtyMask dirty = victim.m_dirty;
+    if (m_inclusive) {
+        dirty |= BackInvalidate(core, level, victim.m_block_addr);
+    }
+    if (dirty != 0) {
+        m_paths[core][level]->CountWriteBack(victim.m_block_addr, clock_cycle);
+        WriteInto(core, level + 1, victim.m_block_addr, dirty, clock_cycle, functional);
+    }
+}
+
+void BlSim::CacheHierarchy::WriteInto(uint32_t core, uint32_t level, uint64_t maddr, DirtyMask dirty,
+                                      uint64_t clock_cycle, bool functional) {
+    if (level == m_paths[core].size()) {
+        WriteBack(maddr, dirty, clock_cycle, functional);
+        return;
+    }
+    // a non-inclusive level may not hold the block any more, it is allocated again
+    if (!m_paths[core][level]->MarkDirty(maddr, dirty, clock_cycle)) {
+        Fill(core, level, maddr, clock_cycle, functional);
+        m_paths[core][level]->MarkDirty(maddr, dirty, clock_cycle);
+    }
+}
+
+BlSim::DirtyMask BlSim::CacheHierarchy::BackInvalidate(uint32_t core, uint32_t level, uint64_t maddr) {
+    Cache *cache = m_paths[core][level];
+    DirtyMask dirty = 0;
+    // a shared level is on the path of every core
+    for (uint32_t other = 0; other < m_paths.size(); ++other) {
+        std::vector<Cache*> &path = m_paths[other];
+        if (level >= path.size() || path[level] != cache) {
+            continue;
+        }
+        for (uint32_t above = 0; above < level; ++above) {
+            dirty |= path[above]->Invalidate(maddr);
+        }
+    }
+    return dirty;
+}
+
+void BlSim::CacheHierarchy::WriteBack(uint64_t block_addr, DirtyMask dirty, uint64_t clock_cycle, bool functional) {
+    if (functional) {
+        // the victim only updates the state of its bank, nothing is queued
+        m_memory_system->functionalAccess(true, block_addr);
+        return;
+    }
+    // the transaction comes from the pool of Transaction::operator new
+    Transaction* trans = new Transaction(Transaction::DATA_WRITE,
+                                         block_addr,
+                                         NULL,
+                                         m_block_size,
+                                         clock_cycle);
+    if (m_partial_write) {
+        trans->dirtyMask = dirty;
+    }
+    // behind the ones already refused, in order
+    m_writebacks.push_back(trans);
+    Drain(clock_cycle);
+}
+
+bool BlSim::CacheHierarchy::Drain(uint64_t clock_cycle) {
+    while (!m_writebacks.empty()) {
+        Transaction* trans = m_writebacks.front();
+        if (!m_memory_system->addTransaction(trans)) {
+            return false;
+        }
+        m_transaction_receiver->addPending(trans, clock_cycle);
+        m_writebacks.pop_front();
+    }
+    return true;
+}
+
+bool BlSim::CacheHierarchy::Holds(uint32_t core, uint64_t maddr) {
+    std::vector<Cache*> &path = m_paths[core];
+    for (uint32_t level = 0; level < path.size(); ++level) {
+        if (path[level]->Holds(maddr)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BlSim::CacheHierarchy::SetWarmupCycle(uint64_t cycle) {
+    for (size_t i = 0; i < m_caches.size(); ++i) {
+        m_caches[i]->SetWarmupCycle(cycle);
+    }
+}
+
+void BlSim::CacheHierarchy::DumpStatistic(std::ostream &out) {
+    for (size_t i = 0; i < m_caches.size(); ++i) {
+        m_caches[i]->DumpStatistic(out);
+    }
+}
+
+void BlSim::CacheHierarchy::Serialize(DRAMSim::Checkpoint &cp) {
+    for (size_t i = 0; i < m_caches.size(); ++i) {
+        m_caches[i]->Serialize(cp);
+    }
+    cp.io(m_writebacks);
+}
@@ -2,9 +2,15 @@
 #define SIMPLE_CACHE_H_
 
 #include <stdint.h>
+#include <vector>
+#include <deque>
+#include <string>
+#include <sstream>
 //#include <stdlib.h>
 #include "MemorySystem.h"
 #include "Transaction.h"
+#include "Checkpoint.h"
+#include "CacheReplacement.h"
 
 #ifndef DEBUG_CACHE_SIMULATOR
 #define DEBUG_CACHE_SIMULATOR
@@ -68,64 +74,86 @@ namespace BlSim {
     };
 
 
-    class CacheBlock {
-        public:
-            uint32_t m_block_size; //it is usual 64B
-            uint64_t m_block_addr; //it is full addr, do not filter for it
-            int64_t m_block_tag;  //filter the inner-set addr and the set index
-            uint32_t m_dirty; //to mark if this block is written
-            CacheBlock* m_next;
-            CacheBlock* m_prev;
+    // the 8 byte words of a block, one bit each
+    typedef uint64_t DirtyMask;
+    #define CACHE_WORD_BYTES 8
 
-        public:
-            CacheBlock(uint32_t block_size) : m_block_size(block_size),
-                                              m_block_addr(INVALID_BLOCK),
-                                              m_block_tag(-1),
-                                              m_next(NULL),
-                                              m_prev(NULL),
-                                              m_dirty(0) {}
-            
-            CacheBlock(uint32_t size, int64_t addr, int64_t tag) :
-               m_block_size(size),
-               m_block_addr(addr),
-               m_block_tag(tag),
-               m_next(NULL),
-               m_prev(NULL),
-               m_dirty(0) {}
-
-            CacheBlock* GetWriteBackBlock();
-            void Refresh(const CacheAddress& cache_addr);
-            void Access(uint32_t memop);
+    // the block a fill evicted, returned by value; only a dirty one has
+    // to be written back
+    struct CacheVictim {
+        uint64_t m_block_addr; //it is full addr, do not filter for it
+        DirtyMask m_dirty;     //the words written since the block was loaded
+
+        CacheVictim(uint64_t addr, DirtyMask dirty) :
+            m_block_addr(addr),
+            m_dirty(dirty) {}
+
+        // false if the way was empty
+        bool Valid() const {
+            return m_block_addr != INVALID_BLOCK;
+        }
     };
 
+    /*
+     * The ways of a set are slices of arrays the Cache owns, so a lookup
+     * compares one contiguous row of tags (AVX2 where the CPU has it)
+     * instead of chasing a list. The replacement state is one byte per way
+     * that the ReplacementPolicy of the cache keeps (the age for LRU).
+     */
     class CacheSet {
 
         protected:
         uint32_t m_way_count;  //the cache associaticity
-        CacheBlock *m_p_mru_block;
-        CacheBlock *m_p_lru_block;
+        uint32_t m_set;        //the index of the set, for the set dueling
+        ReplacementPolicy* m_policy;
+        int64_t *m_tags;       //-1 for an invalid way
+        uint64_t *m_addrs;     //INVALID_BLOCK for an invalid way
+        DirtyMask *m_dirty;    //0 for a clean way
+        uint8_t *m_repl;
+        uint32_t m_mru_way;
+
+        // the way holding tag, -1 if none
+        int32_t Find(int64_t tag) const;
 
         public:
-        CacheSet(uint32_t way_count, uint32_t block_size);
-        ~CacheSet();
+        CacheSet(uint32_t way_count, uint32_t set, ReplacementPolicy* policy, int64_t *tags,
+                 uint64_t *addrs, DirtyMask *dirty, uint8_t *repl);
 
         bool FindToDo(int64_t tag);
+        // like FindToDo, but the replacement state is left alone
+        bool Holds(int64_t tag) const {
+            return Find(tag) >= 0;
+        }
 
-        CacheBlock* LoadNewBlock(const CacheAddress& cache_addr);
+        // load cache_addr into an empty way, or the victim of the policy,
+        // and return what the way held
+        CacheVictim LoadNewBlock(const CacheAddress& cache_addr);
 
-        CacheBlock* GetMruBlock() {
-            return m_p_mru_block;
-        }
+        // a dirty copy from the level above; false if tag is not held
+        bool MarkDirty(int64_t tag, DirtyMask dirty);
+
+        // drop tag, the way is the next one filled; the words it had dirty
+        DirtyMask Invalidate(int64_t tag);
 
-        CacheBlock* GetLruBlock() {
-            return m_p_lru_block;
+        // the MRU way, the one just looked up or loaded, is accessed;
+        // a write dirties word
+        void AccessMru(uint32_t memop, uint32_t word) {
+            if (memop == MEM_WRITE) {
+                m_dirty[m_mru_way] |= (DirtyMask)1 << word;
+            }
         }
 
-        void print_cache_set();
+        void Serialize(DRAMSim::Checkpoint &cp);
     };
 
+    /*
+     * One level of the hierarchy: capacity, ways and block size come from
+     * the CACHE_* keys of the system ini. A level only keeps its blocks and
+     * its statistics; CacheHierarchy moves the blocks between the levels.
+     */
     class Cache {
         protected:
+            std::string m_name;
             uint64_t m_cache_capacity;
             uint32_t m_cache_way_count;
             uint32_t m_block_size;
@@ -142,24 +170,136 @@ namespace BlSim {
             uint64_t m_hit_count;
             uint64_t m_writeback_count;
             uint64_t m_total_count;
-
-            CacheSet **m_cache_sets;
-
-            MemorySystem* m_memory_system;
-  	    TransactionReceiver* m_transaction_receiver;
+            uint64_t m_warmup_cycle; //accesses before this cycle are not counted
+
+            // m_cache_set_count x m_cache_way_count each
+            int64_t *m_tags;
+            uint64_t *m_addrs;
+            DirtyMask *m_dirty;
+            uint8_t *m_repl;
+            ReplacementPolicy* m_policy;
+            std::vector<CacheSet> m_cache_sets;
+
+            // an LRU tag directory of every 2^m_sample_shift-th set, given the
+            // same requests, for the write backs LRU would have made there;
+            // NULL when the level is LRU itself
+            Cache* m_lru_shadow;
+            uint32_t m_sample_shift;
+            uint64_t m_sampled_writeback_count; //write backs of the sampled sets
+            uint64_t m_shadow_writeback_count;  //the ones LRU made instead
 
             CacheAddress GetCacheAddress(uint64_t maddr);
-
-            void WriteBack(CacheBlock* block, uint64_t clock_cycle);
+            bool IsSampled(const CacheAddress &cache_addr) const {
+                return m_lru_shadow != NULL && (cache_addr.index & ((1U << m_sample_shift) - 1)) == 0;
+            }
+            // the address of a sampled block in the shadow, which has fewer sets
+            uint64_t ShadowAddress(const CacheAddress &cache_addr) const {
+                return (((uint64_t)cache_addr.tag << (m_set_index_bits - m_sample_shift))
+                        | (cache_addr.index >> m_sample_shift)) << m_block_low_bits;
+            }
+            void ShadowAccess(const CacheAddress &cache_addr, uint64_t clock_cycle);
+            void ShadowWriteBack(const CacheAddress &cache_addr, DirtyMask dirty, uint64_t clock_cycle);
 
         public:
-            Cache(uint32_t cores,
-                  MemorySystem* memory_system,
-                  TransactionReceiver* recevier);
+            Cache(const std::string &name, uint64_t capacity, uint32_t way_count,
+                  uint32_t block_size, const std::string &replacement);
             ~Cache();
 
-            bool Access(uint64_t maddr, uint32_t memop, uint64_t clock_cycle);
-            void DumpStatistic();
+            // a lookup by the level above or the core; a hit makes the
+            // block the MRU one of its set
+            bool Lookup(uint64_t maddr, uint64_t clock_cycle);
+            // a probe that is neither counted nor changes the replacement state
+            bool Holds(uint64_t maddr);
+            // load maddr into the LRU way of its set and return the victim
+            CacheVictim Fill(uint64_t maddr);
+            // the block of the last Lookup or Fill is accessed by memop,
+            // a write dirties the word of maddr
+            void AccessMru(uint64_t maddr, uint32_t memop);
+            // the dirty words of a block written back from the level above;
+            // false if maddr is not held here
+            bool MarkDirty(uint64_t maddr, DirtyMask dirty, uint64_t clock_cycle);
+            // back invalidation; the words the block had dirty here
+            DirtyMask Invalidate(uint64_t maddr);
+            // the dirty block maddr left this level
+            void CountWriteBack(uint64_t maddr, uint64_t clock_cycle);
+            void SetWarmupCycle(uint64_t cycle) {
+                m_warmup_cycle = cycle;
+                if (m_lru_shadow != NULL) {
+                    m_lru_shadow->SetWarmupCycle(cycle);
+                }
+            }
+            void DumpStatistic(std::ostream &out);
+            void Serialize(DRAMSim::Checkpoint &cp);
+
+        private:
+            // not copyable, it owns the block arrays
+            Cache(const Cache &other);
+            Cache &operator=(const Cache &other);
+    };
+
+    /*
+     * The caches in front of the memory system: a private L1 and L2 per
+     * core and a shared LLC, each left out when its capacity is 0. All
+     * levels allocate on a miss and write back dirty victims to the level
+     * below (the memory system after the LLC). With CACHE_INCLUSION=inclusive
+     * a level holds every block of the levels above it, its victims are
+     * invalidated there too and a dirty copy above makes the victim dirty.
+     * Dirty blocks keep a mask of the words written; with PARTIAL_WRITE the
+     * write back to memory carries it, so only those words are programmed.
+     */
+    class CacheHierarchy {
+        protected:
+            std::vector<Cache*> m_caches;            //every level of every core
+            std::vector<std::vector<Cache*> > m_paths; //the levels of each core, L1 first
+            bool m_inclusive;
+            bool m_partial_write; //write backs carry their dirty mask
+            uint32_t m_block_size;
+
+            MemorySystem* m_memory_system;
+            TransactionReceiver* m_transaction_receiver;
+            std::deque<DRAMSim::Transaction*> m_writebacks; //refused by the memory system, oldest first
+
+            bool Access(uint32_t core, uint64_t maddr, uint32_t memop,
+                        uint64_t clock_cycle, bool functional);
+            // load maddr into level of core's path, the victim goes down
+            void Fill(uint32_t core, uint32_t level, uint64_t maddr,
+                      uint64_t clock_cycle, bool functional);
+            // a dirty victim from the level above level
+            void WriteInto(uint32_t core, uint32_t level, uint64_t maddr, DirtyMask dirty,
+                           uint64_t clock_cycle, bool functional);
+            // drop a victim of level from the levels above; the words dirty there
+            DirtyMask BackInvalidate(uint32_t core, uint32_t level, uint64_t maddr);
+            void WriteBack(uint64_t block_addr, DirtyMask dirty, uint64_t clock_cycle, bool functional);
+
+        public:
+            CacheHierarchy(const DRAMSim::Config &config,
+                           uint32_t cores,
+                           MemorySystem* memory_system,
+                           TransactionReceiver* recevier);
+            ~CacheHierarchy();
+
+            // false if no level holds maddr, the request goes to memory
+            bool Access(uint32_t core, uint64_t maddr, uint32_t memop, uint64_t clock_cycle) {
+                return Access(core, maddr, memop, clock_cycle, false);
+            }
+            // like Access, but a dirty victim is written back functionally
+            // (sampled simulation between the detailed windows)
+            bool Warm(uint32_t core, uint64_t maddr, uint32_t memop, uint64_t clock_cycle) {
+                return Access(core, maddr, memop, clock_cycle, true);
+            }
+            // retry the write backs the memory system refused; false while
+            // some are left, the cores wait for them
+            bool Drain(uint64_t clock_cycle);
+            // whether a level of core's path holds maddr, without touching it
+            bool Holds(uint32_t core, uint64_t maddr);
+            void SetWarmupCycle(uint64_t cycle);
+            void DumpStatistic(std::ostream &out);
+            void Serialize(DRAMSim::Checkpoint &cp);
+
+        private:
+            // not copyable, it owns the levels
+            CacheHierarchy(const CacheHierarchy &other);
+            CacheHierarchy &operator=(const CacheHierarchy &other);
     };
 
 }
@@ -1,4 +1,3 @@
-<<<<<<< HEAD
 /*
  * Simulator.cpp
  *
@@ -14,39 +13,45 @@
 
 namespace DRAMSim {
 
-
-ClockDomain* Simulator::clockDomainCPU = NULL;
-ClockDomain* Simulator::clockDomainDRAM = NULL;
-ClockDomain* Simulator::clockDomainTREE = NULL;
-static uint64_t trans_count = 0;
-
 Simulator::~Simulator() {
-	if (trans != NULL) {
-		delete trans;
+	for (size_t i = 0; i < cores.size(); i++) {
+		delete cores[i];
+	}
+	for (size_t i = 0; i < prefetchers.size(); i++) {
+		delete prefetchers[i];
 	}
 	if (evicted_trans != NULL) {
 		delete evicted_trans;
 	}
 
 	delete simIO;
-	delete clockDomainDRAM;
-	delete clockDomainCPU;
 	delete (memorySystem);
 	delete myCache;
+	delete sampler;
+#ifdef RETURN_TRANSACTIONS
+	delete transReceiver;
+#endif
+	delete clockDomainDRAM;
+	delete clockDomainCPU;
 }
 
 void Simulator::setup() {
 //comment for marss
 	simIO->loadInputParams();
 	simIO->initOutputFiles();
-
-#ifdef DATA_RELIABILITY_ECC
-	//ECC BUS BITS
-	JEDEC_DATA_BUS_BITS = JEDEC_DATA_BITS / BL;
-	ECC_DATA_BUS_BITS = ECC_DATA_BITS / BL;
-#endif
-
-	memorySystem = new MemorySystem();
+	//the memory system keeps the clock domains, the callbacks are set once it exists
+	clockDomainCPU = new ClockDomain(NULL);
+	clockDomainDRAM = new ClockDomain(NULL);
+
+	if (simIO->config.HYBRID_CACHE_DEVICE.length() > 0) {
+		memorySystem = new HybridMemorySystem(simIO->config, clockDomainCPU, clockDomainDRAM, simIO->workingDirectory);
+	} else {
+		memorySystem = new MemorySystem(simIO->config, clockDomainCPU, clockDomainDRAM);
+	}
+	//the trace reader sizes the data of its transactions like the memory system
+	simIO->config = memorySystem->config;
+	//a sweep hands every simulation the traces it decoded up front
+	simIO->openTrace(memorySystem);
 #ifdef RETURN_TRANSACTIONS
 	transReceiver = new TransactionReceiver;
 	/* create and register our callback functions */
@@ -57,22 +62,42 @@ void Simulator::setup() {
 			unsigned, uint64_t, uint64_t>(transReceiver,
 			&TransactionReceiver::write_complete);
 	memorySystem->registerCallbacks(read_cb, write_cb, NULL);
+	transReceiver->coreReadDone = new CallbackP3<Simulator, void,
+			unsigned, uint64_t, uint64_t>(this, &Simulator::coreReadDone);
 #endif
 
-	clockDomainCPU = new ClockDomain(
-			new CallbackP0<MemorySystem, void>(memorySystem, &MemorySystem::update));
-
-//	clockDomainCPU = new ClockDomain(
-//			new CallbackP0<Simulator, void>(this, &Simulator::update));
-	clockDomainDRAM = new ClockDomain(
+	//the CPU side feeds the trace through the cache, the DRAM side runs the memory system
+	clockDomainCPU->callback =
+			new CallbackP0<Simulator, void>(this, &Simulator::update);
+	clockDomainDRAM->callback =
 			new CallbackP0<MemorySystem, void>(memorySystem,
-					&MemorySystem::update));
+					&MemorySystem::update);
 	clockDomainCPU->nextDomain = clockDomainDRAM;
 	clockDomainDRAM->previousDomain = clockDomainCPU;
 	clockDomainTREE = clockDomainCPU;
 
-	// create cache
-	myCache = new Cache(4, memorySystem, transReceiver);
+	// create the caches, the private levels and a prefetcher per trace
+	const Config &config = memorySystem->config;
+	if (!Core::validModel(config)) {
+		ERROR("Unknown CORE_MODEL '"<<config.CORE_MODEL<<"'; valid options are 'open_loop' or 'closed_loop'");
+		exit(-1);
+	}
+	size_t sourceCount = simIO->traces.size();
+	if (Sampler::enabled(config)) {
+		if (config.CORE_MODEL != "open_loop") {
+			ERROR("A sampled simulation replays its trace open loop");
+			exit(-1);
+		}
+		sampler = new Sampler(config);
+	}
+	myCache = new CacheHierarchy(config, sourceCount, memorySystem, transReceiver);
+	for (size_t i = 0; i < sourceCount; i++) {
+		prefetchers.push_back(Prefetcher::Create(config, i, myCache, memorySystem, transReceiver));
+	}
+	size_t coreCount = config.CORE_MODEL == "closed_loop" ? sourceCount : 1;
+	for (size_t i = 0; i < coreCount; i++) {
+		cores.push_back(new Core(i, config, simIO, myCache, prefetchers, memorySystem, transReceiver, sampler));
+	}
 
 	// for compatibility with the old marss code which assumed an sg15 part with a
 	// 2GHz CPU, the new code will reset this value later
@@ -87,9 +112,37 @@ void Simulator::setup() {
 }
 
 void Simulator::start() {
+	uint64_t warmupCycle = simIO->cycleNum == 0 ? 1e+6 : simIO->cycleNum / 2;
+	myCache->SetWarmupCycle(warmupCycle);
+	for (size_t i = 0; i < prefetchers.size(); i++) {
+		if (prefetchers[i] != NULL) {
+			prefetchers[i]->SetWarmupCycle(warmupCycle);
+		}
+	}
+	for (size_t i = 0; i < cores.size(); i++) {
+		cores[i]->setWarmupCycle(warmupCycle);
+	}
+	//the warmup cycle of a restored run is the one it was saved at
+	if (simIO->restoreCheckpointFilename.length() > 0) {
+		restoreCheckpoint(simIO->restoreCheckpointFilename);
+	}
+	if (simIO->saveCheckpointFilename.length() > 0) {
+		if (sampler != NULL) {
+			ERROR("A sampled simulation cannot be saved, its warmup is not simulated in detail");
+			exit(-1);
+		}
+		while (clockDomainTREE->clockcycle < warmupCycle
+				&& (pendingTrace || transReceiver->pendingTrans())) {
+			clockDomainTREE->tick();
+		}
+		saveCheckpoint(simIO->saveCheckpointFilename);
+		return;
+	}
+	if (sampler != NULL) {
+		runSampled();
+	} else
 #ifdef RETURN_TRANSACTIONS
 	if (simIO->cycleNum == 0) {
-		WarmupCycle=1e+6;
 		while (pendingTrace || transReceiver->pendingTrans())		//libing
 		//while (pendingTrace == true || transReceiver->pendingTrans() == true)
 		{
@@ -99,280 +152,155 @@ void Simulator::start() {
 	} else
 #endif
 	{
-		WarmupCycle = simIO->cycleNum / 2;
 		while (clockDomainTREE->clockcycle < simIO->cycleNum
 				&& (pendingTrace || transReceiver->pendingTrans())) {
 			clockDomainTREE->tick();
 		}
 	}
-	myCache->DumpStatistic();
+	myCache->DumpStatistic(*simOutput);
+	for (size_t i = 0; i < prefetchers.size(); i++) {
+		if (prefetchers[i] != NULL) {
+			prefetchers[i]->DumpStatistic(*simOutput);
+		}
+	}
+	for (size_t i = 0; i < cores.size(); i++) {
+		cores[i]->printStats(*simOutput);
+	}
 }
 
 void Simulator::update() {
-	bool hit = false;
-	if (trans == NULL) {
-		trans = simIO->nextTrans();
-		if (trans == NULL) {
-			pendingTrace = false;
-			return;
-		}
+	uint64_t clockCycle = clockDomainCPU->clockcycle;
+	//the cache's refused write backs go before anything else
+	if (!myCache->Drain(clockCycle)) {
+		return;
 	}
-
-	if ((clockDomainCPU->clockcycle >= trans->timeTraced))			//libing
-	{
-		//miss_count++;
-		//cout << trans << endl;
-		hit = myCache->Access(trans->address, trans->transactionType,
-				clockDomainCPU->clockcycle); //libing
-		//	#ifdef CACHE_WRITE_BACK_SIM
-		//#endif
-
-		if (!hit) {
-
-			if (memorySystem->addTransaction(trans)) {
-
-#ifdef RETURN_TRANSACTIONS
-				transReceiver->addPending(trans, clockDomainCPU->clockcycle);
-#endif
-				// the memory system accepted our request so now it takes ownership of it
-				trans = NULL;
-
-			}
-		} else {
-			delete trans;
-			trans = NULL;
-		}
-
+	//the core that goes first takes turns, so no core always gets the
+	//memory system's last free slot
+	pendingTrace = false;
+	for (size_t i = 0; i < cores.size(); i++) {
+		Core *core = cores[(clockCycle + i) % cores.size()];
+		core->update(clockCycle);
+		pendingTrace = pendingTrace || !core->done();
 	}
-
 }
 
-void Simulator::report(bool finalStats) {
-	memorySystem->printStats(finalStats);
-
+void Simulator::coreReadDone(unsigned core, uint64_t address, uint64_t cycle) {
+	cores[core]->readComplete(address);
 }
 
-void Simulator::setCPUClock(uint64_t cpuClkFreqHz) {
-	uint64_t dramsimClkFreqHz = (uint64_t) (1.0 / (tCK * 1e-9));
-	clockDomainDRAM->clock = dramsimClkFreqHz;
-	clockDomainCPU->clock =
-			(cpuClkFreqHz == 0) ? dramsimClkFreqHz : cpuClkFreqHz;
+void Simulator::runSampled() {
+	const uint64_t cycleNum = simIO->cycleNum;
+	while (pendingTrace
+			&& (cycleNum == 0 || clockDomainTREE->clockcycle < cycleNum)) {
+		fastForward();
+		//the warmup and the window in detail
+		uint64_t detailedStart = clockDomainTREE->clockcycle;
+		while (pendingTrace && !sampler->windowFetched()
+				&& (cycleNum == 0 || clockDomainTREE->clockcycle < cycleNum)) {
+			clockDomainTREE->tick();
+		}
+		while ((cores[0]->holdsRecord() || transReceiver->pendingTrans())
+				&& (cycleNum == 0 || clockDomainTREE->clockcycle < cycleNum)) {
+			clockDomainTREE->tick();
+		}
+		if (!sampler->windowFetched()) {
+			continue;
+		}
+		sampler->endWindow(*transReceiver, clockDomainCPU->clockcycle);
+		//the clocks can only jump when nothing is in flight; give the traffic
+		//the memory system makes on its own (fills, scrubs) as long again as
+		//the detailed part took to settle, no record is fetched meanwhile
+		uint64_t settleEnd = 2 * clockDomainTREE->clockcycle - detailedStart;
+		while (!memorySystem->idle() && clockDomainTREE->clockcycle < settleEnd
+				&& (cycleNum == 0 || clockDomainTREE->clockcycle < cycleNum)) {
+			clockDomainTREE->tick();
+		}
+		sampler->nextPeriod();
+	}
 }
 
-void Simulator::setClockRatio(double ratio) {
-	// Compute numerator and denominator for ratio, then pass that to other constructor.
-	double x = ratio;
-
-	const int MAX_ITER = 15;
-	size_t i;
-	unsigned ns[MAX_ITER], ds[MAX_ITER];
-	double zs[MAX_ITER];
-	ds[0] = 0;
-	ds[1] = 1;
-	zs[1] = x;
-	ns[1] = (int) x;
-
-	for (i = 1; i < MAX_ITER - 1; i++) {
-		if (fabs(x - (double) ns[i] / (double) ds[i]) < 0.00005) {
-			//printf("ANSWER= %u/%d\n",ns[i],ds[i]);
+//the records up to the next detailed part only warm the cache and the row
+//buffers; the clocks then jump to the time of the last one, unless the memory
+//system is still busy, then the detailed part waits for it in detail
+void Simulator::fastForward() {
+	uint64_t lastTime = clockDomainCPU->clockcycle;
+	while (sampler->functional()) {
+		Transaction *record = simIO->nextTrans();
+		if (record == NULL) {
+			pendingTrace = false;
 			break;
 		}
-		//TODO: or, if the answers are the same as the last iteration, stop
-
-		zs[i + 1] = 1.0f / (zs[i] - (int) floor(zs[i])); // 1/(fractional part of z_i)
-		ds[i + 1] = ds[i] * (int) floor(zs[i + 1]) + ds[i - 1];
-		double tmp = x * ds[i + 1];
-		double tmp2 = tmp - (int) tmp;
-		ns[i + 1] = tmp2 >= 0.5 ? ceil(tmp) : floor(tmp); // ghetto implementation of a rounding function
-		//printf("i=%lu, z=%20f n=%5u d=%5u\n",i,zs[i],ns[i],ds[i]);
+		sampler->fetched(*transReceiver, clockDomainCPU->clockcycle);
+		lastTime = std::max(lastTime, record->timeTraced);
+		if (!myCache->Warm(record->source, record->address, Core::cacheOperation(record), lastTime)) {
+			memorySystem->functionalAccess(record->transactionType == Transaction::DATA_WRITE, record->address);
+		}
+		delete record;
 	}
 
-	//printf("APPROXIMATION= %u/%d\n",ns[i],ds[i]);
-	clockDomainDRAM->clock = ns[i];
-	clockDomainCPU->clock = ds[i];
-
-	//cout << "CTOR: callback address: " << (uint64_t)(this->callback) << "\t ratio="<<clock1<<"/"<<clock2<< endl;
-}
-
-}
-namespace DRAMSim {
-Simulator* getMemorySimulator(const string &dev, const string &sys, const string &pwd, const string &trc, unsigned megsOfMemory, string *visfilename) 
-{
-		
-	SimulatorIO *simIO = new SimulatorIO(sys,dev,trc,"",pwd,"",NULL,megsOfMemory,0,true);
-/*	SimulatorIO *simIO = new SimulatorIO();
-	simIO->deviceIniFilename=dev;
-	simIO->visFilename= visfilename->c_str();
-	simIO->systemIniFilename=sys;
-	simIO->workingDirectory=pwd;
-	simIO->memorySize=megsOfMemory;
-	simIO->cycleNum=0;
-*/	std::cout <<" !! get the simulator object"<<std::endl;	
-	Simulator* simulator = new Simulator(simIO);
-	std::cout <<" ! get the simulator object"<<std::endl;	
-	simulator->setup();
-	simulator->start();
-	simulator->report(true);
-	return simulator;
-}
+	uint64_t cycles = lastTime - clockDomainCPU->clockcycle;
+	if (cycles > 0 && !memorySystem->idle()) {
+		sampler->busyFastForward();
+	} else if (cycles > 0) {
+		uint64_t dramCycles = cycles * clockDomainDRAM->clock / clockDomainCPU->clock;
+		clockDomainCPU->clockcycle += cycles;
+		clockDomainDRAM->clockcycle += dramCycles;
+		memorySystem->skipCycles(dramCycles);
+	}
 }
-// end of DRAMSim
-=======
-/*
- * Simulator.cpp
- *
- *  Created on: Jul 16, 2012
- *    l  Author: Shawn GAO
- */
-
-#include "Simulator.h"
-#include "SimulatorIO.h"
-#include "PrintMacros.h"
-#include "Callback.h"
-#include "ClockDomain.h"
-
-namespace DRAMSim {
-
 
-ClockDomain* Simulator::clockDomainCPU = NULL;
-ClockDomain* Simulator::clockDomainDRAM = NULL;
-ClockDomain* Simulator::clockDomainTREE = NULL;
-static uint64_t trans_count = 0;
-
-Simulator::~Simulator() {
-	if (trans != NULL) {
-		delete trans;
-	}
-	if (evicted_trans != NULL) {
-		delete evicted_trans;
+void Simulator::report(bool finalStats) {
+	memorySystem->printStats(finalStats);
+	if (finalStats && sampler != NULL) {
+		sampler->printStats();
 	}
 
-	delete simIO;
-	delete clockDomainDRAM;
-	delete clockDomainCPU;
-	delete (memorySystem);
-	delete myCache;
 }
 
-void Simulator::setup() {
-//comment for marss
-	simIO->loadInputParams();
-	simIO->initOutputFiles();
-
-#ifdef DATA_RELIABILITY_ECC
-	//ECC BUS BITS
-	JEDEC_DATA_BUS_BITS = JEDEC_DATA_BITS / BL;
-	ECC_DATA_BUS_BITS = ECC_DATA_BITS / BL;
-#endif
-
-	memorySystem = new MemorySystem();
-#ifdef RETURN_TRANSACTIONS
-	transReceiver = new TransactionReceiver;
-	/* create and register our callback functions */
-	TransactionCompleteCB *read_cb = new CallbackP3<TransactionReceiver, void,
-			unsigned, uint64_t, uint64_t>(transReceiver,
-			&TransactionReceiver::read_complete);
-	TransactionCompleteCB *write_cb = new CallbackP3<TransactionReceiver, void,
-			unsigned, uint64_t, uint64_t>(transReceiver,
-			&TransactionReceiver::write_complete);
-	memorySystem->registerCallbacks(read_cb, write_cb, NULL);
-#endif
-
-
-	clockDomainCPU = new ClockDomain(
-			new CallbackP0<Simulator, void>(this, &Simulator::update));
-	clockDomainDRAM = new ClockDomain(
-			new CallbackP0<MemorySystem, void>(memorySystem,
-					&MemorySystem::update));
-	clockDomainCPU->nextDomain = clockDomainDRAM;
-	clockDomainDRAM->previousDomain = clockDomainCPU;
-	clockDomainTREE = clockDomainCPU;
-
-	// create cache
-	myCache = new Cache(4, memorySystem, transReceiver);
-
-	// for compatibility with the old marss code which assumed an sg15 part with a
-	// 2GHz CPU, the new code will reset this value later
-	//setCPUClockSpeed(2000000000UL);
-	// Initialize the ClockDomainCrosser to use the CPU speed
-	// If cpuClkFreqHz == 0, then assume a 1:1 ratio (like for TraceBasedSim)
-	// set the frequency ratio to 1:1
-	setCPUClock(0);
-	PRINT(
-			"DRAMSim2 Clock Frequency ="<<clockDomainDRAM->clock<<"Hz, CPU Clock Frequency="<<clockDomainCPU->clock<<"Hz");
-
+void Simulator::saveCheckpoint(const string &filename) {
+	Checkpoint cp(filename, true);
+	checkpoint(cp);
+	PRINT("== Saved the state at cycle "<<clockDomainCPU->clockcycle<<" to "<<filename<<" ==");
 }
 
-void Simulator::start() {
-#ifdef RETURN_TRANSACTIONS
-	if (simIO->cycleNum == 0) {
-		WarmupCycle=0;
-		//std::cout<<"!start simulate!\n";
-		while (pendingTrace || transReceiver->pendingTrans())		//libing
-		//while (pendingTrace == true || transReceiver->pendingTrans() == true)
-		{
-			clockDomainTREE->tick();
-		}
-
-	} else
-#endif
-	{
-		WarmupCycle = simIO->cycleNum / 2;
-		while (clockDomainTREE->clockcycle < simIO->cycleNum
-				&& (pendingTrace || transReceiver->pendingTrans())) {
-			clockDomainTREE->tick();
-		}
-	}
-	myCache->DumpStatistic();
+void Simulator::restoreCheckpoint(const string &filename) {
+	Checkpoint cp(filename, false);
+	checkpoint(cp);
+	PRINT("== Restored the state at cycle "<<clockDomainCPU->clockcycle<<" from "<<filename<<" ==");
 }
 
-void Simulator::update() {
-	bool hit = false;
-/*	if (trans == NULL) {
-
-		trans = simIO->nextTrans();
-		if (trans == NULL) {
-			pendingTrace = false;
-			return;
+void Simulator::checkpoint(Checkpoint &cp) {
+	cp.check(simIO->checkpointDescription());
+	//the rows first, queued data packets may be views of them
+	memorySystem->checkpointRows(cp);
+	cp.section("clocks");
+	clockDomainCPU->checkpoint(cp);
+	clockDomainDRAM->checkpoint(cp);
+	cp.section("trace");
+	simIO->checkpoint(cp);
+	cp.io(pendingTrace);
+	cp.io(evicted_trans);
+	cp.section("cache");
+	myCache->Serialize(cp);
+	for (size_t i = 0; i < prefetchers.size(); i++) {
+		if (prefetchers[i] != NULL) {
+			prefetchers[i]->Serialize(cp);
 		}
 	}
-
-	if ((clockDomainCPU->clockcycle >= trans->timeTraced))			//libing
-	{
-		//miss_count++;
-		//cout << trans << endl;
-		hit = myCache->Access(trans->address, trans->transactionType,
-				clockDomainCPU->clockcycle); //libing
-		//	#ifdef CACHE_WRITE_BACK_SIM
-		//#endif
-
-		if (!hit) {
-
-			if (memorySystem->addTransaction(trans)) {
-
+	cp.section("cores");
+	for (size_t i = 0; i < cores.size(); i++) {
+		cores[i]->checkpoint(cp);
+	}
 #ifdef RETURN_TRANSACTIONS
-				transReceiver->addPending(trans, clockDomainCPU->clockcycle);
+	transReceiver->checkpoint(cp);
 #endif
-				// the memory system accepted our request so now it takes ownership of it
-				trans = NULL;
-
-			}
-		} else {
-			delete trans;
-			trans = NULL;
-		}
-
-	}
-*/
-}
-
-void Simulator::report(bool finalStats) {
-	memorySystem->printStats(finalStats);
-
+	cp.section("memory");
+	memorySystem->checkpoint(cp);
+	cp.section("end");
 }
 
 void Simulator::setCPUClock(uint64_t cpuClkFreqHz) {
-	uint64_t dramsimClkFreqHz = (uint64_t) (1.0 / (tCK * 1e-9));
+	uint64_t dramsimClkFreqHz = (uint64_t) (1.0 / (memorySystem->config.tCK * 1e-9));
 	clockDomainDRAM->clock = dramsimClkFreqHz;
 	clockDomainCPU->clock =
 			(cpuClkFreqHz == 0) ? dramsimClkFreqHz : cpuClkFreqHz;
@@ -419,10 +347,20 @@ Simulator* getMemorySimulator(const string &dev, const string &sys, const string
 {
 		
 	SimulatorIO *simIO = new SimulatorIO(sys,dev,trc,"",pwd,"",NULL,megsOfMemory,0,true);
+/*	SimulatorIO *simIO = new SimulatorIO();
+	simIO->deviceIniFilename=dev;
+	simIO->visFilename= visfilename->c_str();
+	simIO->systemIniFilename=sys;
+	simIO->workingDirectory=pwd;
+	simIO->memorySize=megsOfMemory;
+	simIO->cycleNum=0;
+*/	std::cout <<" !! get the simulator object"<<std::endl;	
 	Simulator* simulator = new Simulator(simIO);
+	std::cout <<" ! get the simulator object"<<std::endl;	
 	simulator->setup();
+	simulator->start();
+	simulator->report(true);
 	return simulator;
 }
 }
 // end of DRAMSim
->>>>>>> ca95697305ca6add4791981a097ec7be746744fa
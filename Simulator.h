@@ -4,9 +4,15 @@
 #include "SimulatorIO.h"
 #include "ClockDomain.h"
 #include "MemorySystem.h"
+#include "HybridMemorySystem.h"
 #include "SimpleCache.h"
+#include "Prefetcher.h"
+#include "Checkpoint.h"
+#include "Sampler.h"
+#include "Core.h"
 
-using BlSim::Cache;
+using BlSim::CacheHierarchy;
+using BlSim::Prefetcher;
 //#define WarmupCycle 1e+5
 
 namespace DRAMSim
@@ -14,11 +20,14 @@ namespace DRAMSim
 	class Simulator
 	{
 	public:
-		Simulator(SimulatorIO *simIO) : simIO(simIO),
+		Simulator(SimulatorIO *simIO) : clockDomainCPU(NULL),
+		                                clockDomainDRAM(NULL),
+		                                clockDomainTREE(NULL),
 		                                memorySystem(NULL),
+		                                simIO(simIO),
 		                                myCache(NULL),
-		                                trans(NULL),
 		                                evicted_trans(NULL),
+		                                sampler(NULL),
 		                                pendingTrace(true) {};
 		~Simulator();
 
@@ -26,22 +35,34 @@ namespace DRAMSim
 		void start();
 		void update();
 		void report(bool finalStats);
+		//the whole simulation state, after setup(); restoring needs the same
+		//build, ini files, overrides and trace as saving
+		void saveCheckpoint(const string &filename);
+		void restoreCheckpoint(const string &filename);
 
-		static ClockDomain* clockDomainCPU;
-		static ClockDomain* clockDomainDRAM;
-		static ClockDomain* clockDomainTREE;
+		ClockDomain* clockDomainCPU;
+		ClockDomain* clockDomainDRAM;
+		ClockDomain* clockDomainTREE;
 		MemorySystem *memorySystem;
 		void setCPUClock(uint64_t cpuClkFreqHz);
 
 
 	private:
 		void setClockRatio(double ratio);
+		void checkpoint(Checkpoint &cp);
+		//SAMPLE_PERIOD: functional fast forward between detailed windows
+		void runSampled();
+		void fastForward();
+		//a read a core waits for came back from the memory system
+		void coreReadDone(unsigned core, uint64_t address, uint64_t cycle);
 
 		SimulatorIO *simIO;
 
-		Cache *myCache;
-		Transaction *trans;
+		CacheHierarchy *myCache;
+		vector<Prefetcher*> prefetchers; //one per trace, NULL for PREFETCHER=none
+		vector<Core*> cores; //one per trace closed loop, one for all of them open loop
 		Transaction *evicted_trans;
+		Sampler *sampler; //NULL unless SAMPLE_PERIOD is set
 
 
 		bool pendingTrace;
@@ -3,15 +3,19 @@
 #include "Transaction.h"
 #include "IniReader.h"
 #include "DataPacket.h"
+#include "Checkpoint.h"
+#include "TraceGenerator.h"
 
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <cstdio>
 #include <errno.h>
+#include <string.h> //strerror
 #include <sstream> //stringstream
 #include <stdlib.h> // getenv()
+#include <algorithm> //the merge heap
+#include <thread>
 #define TRACE_LENGTH    8 //for hmtt trace
-static uint64_t pre;
 namespace DRAMSim {
 using std::ofstream;
 using std::cout;
@@ -22,13 +26,12 @@ using std::hex;
 using std::cerr;
 using std::ios;
 using std::ios_base;
-ofstream SimulatorIO::verifyFile;
-ofstream SimulatorIO::visFile;
-ofstream SimulatorIO::logFile;
-uint64_t *buf;   //tmp buffer for fetching traces from trace_file into memory
+thread_local ofstream SimulatorIO::verifyFile;
+thread_local ofstream SimulatorIO::visFile;
+thread_local ofstream SimulatorIO::logFile;
 SimulatorIO::~SimulatorIO() {
 	// flush our streams and close them up
-	if (VIS_FILE_OUTPUT) {
+	if (config.VIS_FILE_OUTPUT) {
 		visFile.flush();
 		visFile.close();
 	}
@@ -37,9 +40,12 @@ SimulatorIO::~SimulatorIO() {
 	logFile.close();
 #endif
 
-	traceFile.close();
-	fclose(fp);
-	free(buf);
+	for (size_t i = 0; i < traces.size(); i++) {
+		delete traces[i];
+	}
+	for (size_t i = 0; i < mergeHeads.size(); i++) {
+		delete mergeHeads[i];
+	}
 }
 
 void SimulatorIO::loadInputParams() {
@@ -52,7 +58,7 @@ void SimulatorIO::loadInputParams() {
 		usage();
 		exit(-1);
 	} else if (traceFilename.length() == 0) {
-		ERROR("Please provide a trace file");
+		ERROR("Please provide a trace file or a generator");
 		usage();
 		exit(-1);
 	}
@@ -73,50 +79,25 @@ void SimulatorIO::loadInputParams() {
 		if (deviceIniFilename[0] != '/') {
 			deviceIniFilename = workingDirectory + "/" + deviceIniFilename;
 		}
-
-		if (traceFilename[0] != '/') {
-			traceFilename = workingDirectory + "/" + traceFilename;
-		}
 	}
 
-// get the trace filename
-//comment for marss libing
-/*	string temp = traceFilename.substr(traceFilename.find_last_of("/") + 1);
-
-	//get the prefix of the trace name
-	temp = temp.substr(0, temp.find_first_of("_"));
-	if (temp == "mase") {
-		traceType = mase;
-	} else if (temp == "k6") {
-		traceType = k6;
-	} else if (temp == "k7") {
-		traceType = k7;
-	} else if (temp == "pin") {
-		traceType = pin;
-	} else if (temp == "DGpin") {
-		traceType = DGpin;
-	} else if (temp == "spec2006") {
-		traceType = spec;
-	} else {
-		ERROR("== Unknown Tracefile Type : "<<temp);
-		exit(0);
-	}
-*/
 	DEBUG("== Loading device model file '"<<deviceIniFilename<<"' == ");
-	IniReader::ReadIniFile(deviceIniFilename, IniReader::DEV_INI);
+	IniReader reader(config);
+	reader.ReadIniFile(deviceIniFilename, IniReader::DEV_INI);
 	DEBUG("== Loading system model file '"<<systemIniFilename<<"' == ");
-	IniReader::ReadIniFile(systemIniFilename, IniReader::SYS_INI);
+	reader.ReadIniFile(systemIniFilename, IniReader::SYS_INI);
 
 	// If we have any overrides, set them now before creating all of the memory objects
 	if (paramOverrides != NULL)
-		IniReader::OverrideKeys(paramOverrides);
+		reader.OverrideKeys(paramOverrides);
 
-	IniReader::InitEnumsFromStrings();
-	if (!IniReader::CheckIfAllSet()) {
+	//fill in the defaults of optional keys before the enums are derived from them
+	if (!reader.CheckIfAllSet()) {
 		exit(-1);
 	}
+	reader.InitEnumsFromStrings();
 
-	if (NUM_CHANS == 0) {
+	if (config.NUM_CHANS == 0) {
 		ERROR("Zero channels");
 		abort();
 	}
@@ -146,7 +127,6 @@ void SimulatorIO::initOutputFiles() {
 
 	size_t lastSlash;
 	size_t dLength = deviceIniFilename.length();
-	size_t tLength = traceFilename.length();
 	string deviceName, traceName;
 
 	//create output folders
@@ -155,17 +135,27 @@ void SimulatorIO::initOutputFiles() {
 		deviceName = deviceIniFilename.substr(0, dLength - 4);
 		dLength -= 4;
 	}
-	if (traceFilename.substr(tLength - 4) == ".trc") {
-		traceName = traceFilename.substr(0, tLength - 4);
-		tLength -= 4;
-	}
 	// chop off everything past the last / (i.e. leave filename only)
 	if ((lastSlash = deviceName.find_last_of("/")) != string::npos) {
 		deviceName = deviceName.substr(lastSlash + 1, dLength - lastSlash - 1);
 	}
-	// working backwards, chop off the next piece of the directory
-	if ((lastSlash = traceName.find_last_of("/")) != string::npos) {
-		traceName = traceName.substr(lastSlash + 1, tLength - lastSlash - 1);
+	//several traces are named after all of them, joined by '+'
+	vector<string> filenames = traceFilenames();
+	for (size_t i = 0; i < filenames.size(); i++) {
+		string name = filenames[i];
+		size_t tLength = name.length();
+		if (tLength > 4 && name.substr(tLength - 4) == ".trc") {
+			name = name.substr(0, tLength - 4);
+		}
+		// working backwards, chop off the next piece of the directory
+		if ((lastSlash = name.find_last_of("/")) != string::npos) {
+			name = name.substr(lastSlash + 1);
+		}
+		//gen:random is the directory gen_random
+		if (TraceGenerator::isGenerator(name)) {
+			name[TraceGenerator::PREFIX.length() - 1] = '_';
+		}
+		traceName += (i > 0 ? "+" : "") + name;
 	}
 	if (workingDirectory.length() > 0) {
 		outputFilePath = workingDirectory + "/" + outputFilePath;
@@ -180,7 +170,7 @@ void SimulatorIO::initOutputFiles() {
 
 	// create a properly named verification output file if need be and open it
 	// as the stream 'verifyOut'
-	if (VERIFICATION_OUTPUT) {
+	if (config.VERIFICATION_OUTPUT) {
 		string baseFilename = deviceIniFilename.substr(
 				deviceIniFilename.find_last_of("/") + 1);
 		string verifyFilename = "sim_out_" + baseFilename;
@@ -197,24 +187,24 @@ void SimulatorIO::initOutputFiles() {
 
 	// This sets up the vis file output along with the creating the result
 	// directory structure if it doesn't exist
-	if (VIS_FILE_OUTPUT) {
+	if (config.VIS_FILE_OUTPUT) {
 
 		if (visFilename.empty()) {
 			// finally, figure out the visFilename
 			string sched = "BtR";
 			string queue = "pRank";
-			if (schedulingPolicy == RankThenBankRoundRobin) {
+			if (config.schedulingPolicy == RankThenBankRoundRobin) {
 				sched = "RtB";
 			}
-			if (queuingStructure == PerRankPerBank) {
+			if (config.queuingStructure == PerRankPerBank) {
 				queue = "pRankpBank";
 			}
 
 			stringstream tmpOut;
-			tmpOut << (TOTAL_STORAGE >> 10) << "GB." << NUM_CHANS << "Ch."
-					<< NUM_RANKS << "R." << ADDRESS_MAPPING_SCHEME << "."
-					<< ROW_BUFFER_POLICY << "." << TRANS_QUEUE_DEPTH << "TQ."
-					<< CMD_QUEUE_DEPTH << "CQ." << sched << "." << queue;
+			tmpOut << (config.TOTAL_STORAGE >> 10) << "GB." << config.NUM_CHANS << "Ch."
+					<< config.NUM_RANKS << "R." << config.ADDRESS_MAPPING_SCHEME << "."
+					<< config.ROW_BUFFER_POLICY << "." << config.TRANS_QUEUE_DEPTH << "TQ."
+					<< config.CMD_QUEUE_DEPTH << "CQ." << sched << "." << queue;
 			visFilename = tmpOut.str();
 
 		}
@@ -232,7 +222,7 @@ void SimulatorIO::initOutputFiles() {
 			exit(-1);
 		}
 		//write out the ini config values for the visualizer tool
-		IniReader::WriteValuesOut(visFile);
+		IniReader(config).WriteValuesOut(visFile);
 
 		if (visFilename != "")
 			DEBUG("== creating vis file to " <<visFilename << " ==");
@@ -257,86 +247,351 @@ void SimulatorIO::initOutputFiles() {
 		exit(-1);
 	}
 #endif
-/*
-	DEBUG("== Loading trace file '"<<traceFilename<<"' == ");
-	traceFile.open(traceFilename.c_str());
+	PRINT(
+			"++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++");
 
-	if (!traceFile.is_open()) {
-		cout << "== Error - Could not open trace file" << endl;
-		exit(0);
+}
+
+//orders the merge heap: the trace whose next record comes later (or, at the
+//same time stamp, the trace with the higher number) is below
+struct LaterHead {
+	const vector<Transaction*> &heads;
+	LaterHead(const vector<Transaction*> &heads) : heads(heads) {}
+	bool operator()(size_t a, size_t b) const {
+		if (heads[a]->timeTraced != heads[b]->timeTraced) {
+			return heads[a]->timeTraced > heads[b]->timeTraced;
+		}
+		return a > b;
 	}
-	buf = (uint64_t*)malloc(TRACE_LENGTH);
-	if (!buf) {
-		printf("malloc failed\n");
-		exit(0);
+};
+
+Transaction* SimulatorIO::nextTrans() {
+	if (traces.size() == 1) {
+		return nextTrans(0);
 	}
-	if ((fp = fopen(traceFilename.c_str(), "r")) == NULL) {
-		printf("Open file  error\n");
-		exit(0);
+	if (!mergeStarted) {
+		mergeStarted = true;
+		mergeHeads.resize(traces.size());
+		for (size_t i = 0; i < traces.size(); i++) {
+			mergeHeads[i] = nextTrans(i);
+			if (mergeHeads[i] != NULL) {
+				mergeHeap.push_back(i);
+			}
+		}
+		std::make_heap(mergeHeap.begin(), mergeHeap.end(), LaterHead(mergeHeads));
+	}
+	if (mergeHeap.empty()) {
+		return NULL;
 	}
-*/	PRINT(
-			"++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++");
 
+	std::pop_heap(mergeHeap.begin(), mergeHeap.end(), LaterHead(mergeHeads));
+	size_t trace = mergeHeap.back();
+	Transaction *trans = mergeHeads[trace];
+	mergeHeads[trace] = nextTrans(trace);
+	if (mergeHeads[trace] != NULL) {
+		std::push_heap(mergeHeap.begin(), mergeHeap.end(), LaterHead(mergeHeads));
+	} else {
+		mergeHeap.pop_back();
+	}
+	return trans;
 }
 
-Transaction* SimulatorIO::nextTrans() {
-	string line = "";
-	int skipLine = 0;
-	static int lineNumber = 1;
+Transaction* SimulatorIO::nextTrans(size_t trace) {
+	TraceRecord record;
+	const byte *data;
+	if (!traces[trace]->next(record, data)) {
+		return NULL;
+	}
+	Transaction *trans = makeTransaction(record, data);
+	trans->source = trace;
+	return trans;
+}
 
-	uint64_t rd_cnt;  //the size of data fetched from file
-	uint64_t timer;
-	unsigned int r_w; //the read/write field of the trace, 1 is read, 0 is write
-	do {
-		rd_cnt = fread(buf, 1, TRACE_LENGTH, fp);
-		if (skipLine > 0||rd_cnt==0) {
-			//DEBUG(
-				//	"WARNING: Skipping line "<<lineNumber-1<< " ('" << line << "') in tracefile"<<" rd_cnt "<<rd_cnt);
+vector<string> SimulatorIO::traceFilenames() const {
+	vector<string> filenames;
+	size_t start = 0;
+	while (start <= traceFilename.length()) {
+		size_t comma = traceFilename.find(',', start);
+		if (comma == string::npos) {
+			comma = traceFilename.length();
 		}
+		if (comma > start) {
+			filenames.push_back(traceFilename.substr(start, comma - start));
+		}
+		start = comma + 1;
+	}
+	return filenames;
+}
+
+string SimulatorIO::tracePath(const string &filename) {
+	if (workingDirectory.length() > 0 && filename[0] != '/') {
+		return workingDirectory + "/" + filename;
+	}
+	return filename;
+}
 
-		// return NULL when EOF
-		if (!getline(traceFile, line) && feof(fp)) {
-			//	std::cout << "finished" <<std::endl;
-			return NULL;
+/**
+ * Opens a reader per trace file, or points them at the traces a sweep
+ * decoded; a generator gets made for every gen:<pattern>
+ **/
+void SimulatorIO::openTrace(MemorySystem *memorySystem) {
+	vector<string> filenames = traceFilenames();
+	if (sharedTraces != NULL && sharedTraces->size() != filenames.size()) {
+		ERROR("== "<<sharedTraces->size()<<" decoded traces for "<<filenames.size()<<" trace files");
+		exit(-1);
+	}
+	for (size_t i = 0; i < filenames.size(); i++) {
+		if (TraceGenerator::isGenerator(filenames[i])) {
+			TraceReader *reader = new TraceReader(filenames[i], useClockCycle);
+			reader->generate(new TraceGenerator(filenames[i].substr(TraceGenerator::PREFIX.length()),
+					i, config, memorySystem));
+			traces.push_back(reader);
+			continue;
+		}
+		TraceReader *reader = new TraceReader(tracePath(filenames[i]), useClockCycle);
+		if (sharedTraces != NULL) {
+			reader->share(&(*sharedTraces)[i]);
+		} else {
+			reader->open();
 		}
+		traces.push_back(reader);
+	}
+}
 
-		skipLine++;
-		lineNumber++;
-		if(rd_cnt!=0){
-			break;
+void SimulatorIO::decodeTrace(vector<DecodedTrace> &decoded) {
+	vector<string> filenames = traceFilenames();
+	decoded.resize(filenames.size());
+	vector<TraceReader*> readers(filenames.size(), (TraceReader*) NULL);
+	vector<std::thread> threads;
+	for (size_t i = 0; i < filenames.size(); i++) {
+		if (TraceGenerator::isGenerator(filenames[i])) {
+			continue;
+		}
+		readers[i] = new TraceReader(tracePath(filenames[i]), useClockCycle);
+		readers[i]->open();
+		threads.push_back(std::thread(&TraceReader::decode, readers[i], std::ref(decoded[i])));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	for (size_t i = 0; i < filenames.size(); i++) {
+		if (readers[i] != NULL) {
+			PRINT("== Decoded "<<decoded[i].records.size()<<" trace records ("<<decoded[i].data.size()<<" bytes of data) from "<<readers[i]->filename<<" ==");
+			delete readers[i];
 		}
-	} while (line.length() == 0 );
-	uint64_t addr;
+	}
+}
+
+void SimulatorIO::checkpoint(Checkpoint &cp) {
+	for (size_t i = 0; i < traces.size(); i++) {
+		traces[i]->checkpoint(cp);
+	}
+	cp.io(mergeStarted);
+	cp.io(mergeHeads);
+	cp.io(mergeHeap);
+}
+
+string SimulatorIO::checkpointDescription() {
+	stringstream description;
+	description << "build:";
+#ifdef DATA_STORAGE
+	description << " DATA_STORAGE";
+#endif
+#ifdef DATA_STORAGE_SSA
+	description << " DATA_STORAGE_SSA";
+#endif
+#ifdef DATA_RELIABILITY_ECC
+	description << " DATA_RELIABILITY_ECC";
+#endif
+#ifdef DATA_RELIABILITY_CHIPKILL
+	description << " DATA_RELIABILITY_CHIPKILL";
+#endif
+#ifdef RETURN_TRANSACTIONS
+	description << " RETURN_TRANSACTIONS";
+#endif
+	description << endl << "trace: " << traceFilename << endl;
+	IniReader(config).WriteValuesOut(description);
+	return description.str();
+}
+
+TraceReader::TraceReader(const string &filename, bool useClockCycle) :
+		filename(filename),
+		traceType(k6),
+		fp(NULL),
+		sharedTrace(NULL),
+		generator(NULL),
+		nextRecord(0),
+		useClockCycle(useClockCycle),
+		traceWord(0),
+		previousTimer(0),
+		lineNumber(0) {
+}
+
+TraceReader::~TraceReader() {
+	delete generator;
+	traceFile.close();
+	if (fp != NULL) {
+		fclose(fp);
+	}
+}
+
+/**
+ * Opens the trace file; the trace type is taken from the prefix of the file
+ * name (e.g. k6_aoe_02_short.trc)
+ **/
+void TraceReader::open() {
+	//get the prefix of the trace name
+	string temp = filename.substr(filename.find_last_of("/") + 1);
+	temp = temp.substr(0, temp.find_first_of("_"));
+	if (temp == "mase") {
+		traceType = mase;
+	} else if (temp == "k6") {
+		traceType = k6;
+	} else if (temp == "k7") {
+		traceType = k7;
+	} else if (temp == "pin") {
+		traceType = pin;
+	} else if (temp == "DGpin") {
+		traceType = DGpin;
+	} else if (temp == "spec2006") {
+		traceType = spec;
+	} else {
+		ERROR("== Unknown Tracefile Type : "<<temp);
+		exit(0);
+	}
+
+	DEBUG("== Loading trace file '"<<filename<<"' == ");
+	if (traceType == spec) {
+		//hmtt traces are binary, TRACE_LENGTH bytes per access
+		fp = fopen(filename.c_str(), "rb");
+		if (fp == NULL) {
+			ERROR("== Could not open trace file '"<<filename<<"'");
+			exit(0);
+		}
+	} else {
+		traceFile.open(filename.c_str());
+		if (!traceFile.is_open()) {
+			ERROR("== Could not open trace file '"<<filename<<"'");
+			exit(0);
+		}
+	}
+}
+
+bool TraceReader::next(TraceRecord &record, const byte *&data) {
+	if (generator != NULL) {
+		data = NULL;
+		return generator->next(record);
+	}
+	if (sharedTrace != NULL) {
+		if (nextRecord >= sharedTrace->records.size()) {
+			return false;
+		}
+		record = sharedTrace->records[nextRecord++];
+		data = record.dataBytes > 0 ? &sharedTrace->data[record.dataOffset] : NULL;
+		return true;
+	}
+
+	recordData.clear();
+	if (!readRecord(record, recordData)) {
+		return false;
+	}
+	data = recordData.empty() ? NULL : &recordData[0];
+	return true;
+}
+
+void TraceReader::decode(DecodedTrace &trace) {
+	TraceRecord record;
+	while (readRecord(record, trace.data)) {
+		trace.records.push_back(record);
+	}
+}
+
+void TraceReader::checkpoint(Checkpoint &cp) {
+	if (generator != NULL) {
+		generator->checkpoint(cp);
+		return;
+	}
+	int64_t position = 0;
+	if (cp.isSaving() && sharedTrace == NULL) {
+		position = traceType == spec ? (int64_t) ftello(fp) : (int64_t) traceFile.tellg();
+	}
+	cp.io(position);
+	cp.io(nextRecord);
+	cp.io(traceWord);
+	cp.io(previousTimer);
+	cp.io(lineNumber);
+	if (cp.isSaving() || sharedTrace != NULL) {
+		return;
+	}
+	//a trace that was read to the end has no position any more
+	if (traceType == spec) {
+		if (position < 0 ? fseeko(fp, 0, SEEK_END) : fseeko(fp, position, SEEK_SET)) {
+			ERROR("Cannot seek in the trace: "<<strerror(errno));
+			exit(-1);
+		}
+	} else {
+		if (position < 0) {
+			traceFile.seekg(0, ios::end);
+		} else {
+			traceFile.seekg(position);
+		}
+		if (!traceFile) {
+			ERROR("Cannot seek to "<<position<<" in the trace");
+			exit(-1);
+		}
+	}
+}
+
+/**
+ * Parses the next access of the trace file; the data of a write (DATA_STORAGE
+ * builds) is appended to 'data'. Returns false at the end of the trace.
+ **/
+bool TraceReader::readRecord(TraceRecord &record, vector<byte> &data) {
+	string line = "";
+	uint64_t addr = 0;
 	uint64_t clockCycle = 0;
 	Transaction::TransactionType transType = Transaction::DATA_READ; //by default
 
 	size_t previousIndex = 0;
 	size_t spaceIndex = 0;
-	byte *dataBuffer = NULL;
-	DataPacket *dataPacket = NULL;
 	string addressStr = "", cmdStr = "", dataStr = "", ccStr = "";
 	size_t subrankLen = LEN_DEF;
 
+	if (traceType == spec) {
+		if (fread(&traceWord, 1, TRACE_LENGTH, fp) != TRACE_LENGTH) {
+			return false;
+		}
+	} else {
+		do {
+			if (!getline(traceFile, line)) {
+				return false;
+			}
+			lineNumber++;
+		} while (line.length() == 0);
+	}
+
+	record.dataOffset = data.size();
+	record.dataBytes = 0;
+
 	switch (traceType) {
 	case spec: {									//hmtt file parse branch
-	//	rd_cnt = fread(buf, 1, TRACE_LENGTH, fp);
-		timer = (uint64_t) (((*buf) >> 30) & 0xfffffULL);
-		r_w = (unsigned int) (((*buf) >> 29) & 0x1ULL);
-		addr = (uint64_t) ((*buf) & 0xfffffffcULL);
-		if (pre == 0) {
-			pre = timer;
+		uint64_t timer = (uint64_t) ((traceWord >> 30) & 0xfffffULL);
+		unsigned int r_w = (unsigned int) ((traceWord >> 29) & 0x1ULL); //1 is read, 0 is write
+		addr = (uint64_t) (traceWord & 0xfffffffcULL);
+		//the timer counts from the previous access
+		if (previousTimer == 0) {
+			previousTimer = timer;
 			clockCycle = 0;
 		} else {
-			pre = pre + timer;
-			clockCycle = pre;
+			previousTimer = previousTimer + timer;
+			clockCycle = previousTimer;
 		}
-		
+
 		if (r_w) {
 			transType = Transaction::DATA_READ;
 		} else {
 			transType = Transaction::DATA_WRITE;
 		}
-		//cout <<"Timer is "<< timer <<" clockCycle is " <<clockCycle <<" addr is  "<< addr << endl;
 		break;
 	}
 	case k6: {
@@ -426,55 +681,28 @@ Transaction* SimulatorIO::nextTrans() {
 		a >> hex >> addr;
 
 		//parse data
-		//if we are running in a no storage mode, don't allocate space, just return NULL
+		//if we are running in a no storage mode, don't keep the data
 #ifdef DATA_STORAGE
 		if (dataStr.size() > 0 && transType == Transaction::DATA_WRITE)
 		{
 			// two hex characters = 1 byte
 			if (dataStr.size() % 2 != 0)
 			{
-				ERROR("Could you please give me the data in whole bytes?");
-				exit(-1);
-			}
-
-			size_t stringBytes = dataStr.size()/2;
-			// if we have more bytes than the size of a transaction, there's a problem
-			if (stringBytes > TRANS_DATA_BYTES)
-			{
-				ERROR("Can't put "<<stringBytes<<" bytes into a single transaction");
+				ERROR("Could you please give me the data in whole bytes? (line "<<lineNumber<<")");
 				exit(-1);
 			}
 
-#ifdef DATA_STORAGE_SSA
-			size_t transBytes = SUBARRAY_DATA_BYTES*subrankLen;
-			stringBytes = transBytes;
-#else
-			size_t transBytes = TRANS_DATA_BYTES;
-#endif
-
 			unsigned chr;
-			dataBuffer = (byte *)calloc(sizeof(byte),transBytes);
-			for (size_t i=0; i < transBytes; i++)
+			for (size_t i=0; i < dataStr.size()/2; i++)
 			{
-				if (i < stringBytes)
-				{
-					string piece = dataStr.substr(i*2,2);
-					//PRINT("now on piece ("<<i<<") "<<piece);
-					istringstream iss(piece);
-					// because of the way isstringstream works I can't directly insert
-					// into a char, I have to go through an unsigned and then cast
-					iss >> hex >> chr;
-					dataBuffer[i] = (byte) chr;
-				}
-				else
-				{
-					dataBuffer[i] = 0x00;
-				}
+				string piece = dataStr.substr(i*2,2);
+				// because of the way isstringstream works I can't directly insert
+				// into a char, I have to go through an unsigned and then cast
+				istringstream iss(piece);
+				iss >> hex >> chr;
+				data.push_back((byte) chr);
 			}
-
-			dataPacket = new DataPacket(dataBuffer, stringBytes, addr);
-
-			//PRINT("ds="<<dataStr <<", bytes="<<stringBytes<<"\ndp="<<*dataPacket);
+			record.dataBytes = dataStr.size()/2;
 		}
 #endif
 
@@ -524,7 +752,43 @@ Transaction* SimulatorIO::nextTrans() {
 	}
 	} // end of SWITCH
 
-	return new Transaction(transType, addr, dataPacket, subrankLen, clockCycle);
+	record.address = addr;
+	record.clockCycle = clockCycle;
+	record.transactionType = transType;
+	record.len = subrankLen;
+	return true;
+}
+
+/**
+ * Builds the transaction of a trace record, padding its data to the
+ * transaction size of this memory system
+ **/
+Transaction* SimulatorIO::makeTransaction(const TraceRecord &record, const byte *data) {
+	DataPacket *dataPacket = NULL;
+#ifdef DATA_STORAGE
+	if (record.dataBytes > 0)
+	{
+		size_t stringBytes = record.dataBytes;
+		// if we have more bytes than the size of a transaction, there's a problem
+		if (stringBytes > config.TRANS_DATA_BYTES)
+		{
+			ERROR("Can't put "<<stringBytes<<" bytes into a single transaction");
+			exit(-1);
+		}
+
+#ifdef DATA_STORAGE_SSA
+		size_t transBytes = config.SUBARRAY_DATA_BYTES*record.len;
+		stringBytes = transBytes;
+#else
+		size_t transBytes = config.TRANS_DATA_BYTES;
+#endif
+
+		byte *dataBuffer = (byte *)calloc(sizeof(byte),transBytes);
+		memcpy(dataBuffer, data, record.dataBytes < transBytes ? record.dataBytes : transBytes);
+		dataPacket = new DataPacket(dataBuffer, stringBytes, record.address);
+	}
+#endif
+	return new Transaction(record.transactionType, record.address, dataPacket, record.len, record.clockCycle);
 }
 
 /**
@@ -566,7 +830,8 @@ void SimulatorIO::mkdirIfNotExist(string path) {
 			// set permissions dwxr-xr-x on the results directories
 			mode_t mode = (S_IXOTH | S_IXGRP | S_IXUSR | S_IROTH | S_IRGRP
 					| S_IRUSR | S_IWUSR);
-			if (mkdir(path.c_str(), mode) != 0) {
+			//another simulation of a sweep may have just created it
+			if (mkdir(path.c_str(), mode) != 0 && errno != EEXIST) {
 				perror("Error Has occurred while trying to make directory: ");
 				cerr << path << endl;
 				abort();
@@ -624,9 +889,12 @@ bool SimulatorIO::fileExists(string &path) {
 void SimulatorIO::usage() {
 	cout << "DRAMSim2 Usage: " << endl;
 	cout
-			<< "DRAMSim -t tracefile -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-o OPTION_A=1234,tRC=14,tFAW=19]"
+			<< "DRAMSim -t tracefile|-g pattern -s system.ini -d ini/device.ini [-c #] [-p pwd] [-q] [-S 2048] [-n] [-o OPTION_A=1234,tRC=14,tFAW=19]"
+			<< endl;
+	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run, or several separated by commas (merged by time stamp, or one per core with CORE_MODEL=closed_loop)  " << endl;
+	cout
+			<< "\t-g, --generate=PATTERN \tsynthetic traffic in place of a trace: stream, random, stride, zipf or conflict (GEN_* options); several separated by commas"
 			<< endl;
-	cout << "\t-t, --tracefile=FILENAME \tspecify a tracefile to run  " << endl;
 	cout
 			<< "\t-s, --systemini=FILENAME \tspecify an ini file that describes the memory system parameters  "
 			<< endl;
@@ -652,6 +920,21 @@ void SimulatorIO::usage() {
 			<< "\t-n, --notiming \t\t\tDo not use the clock cycle information in the trace file"
 			<< endl;
 	cout << "\t-v, --visfile \t\t\tVis output filename" << endl;
+	cout
+			<< "\t-w, --sweep=FILENAME \t\trun one simulation per line of FILENAME (-o syntax), sharing the decoded trace"
+			<< endl;
+	cout
+			<< "\t-j, --jobs=# \t\t\tthreads of a sweep [default=number of cores]"
+			<< endl;
+	cout
+			<< "\t-l, --load-curve=RATES \tload-latency curve of each sweep configuration: runs at each GEN_RATE of RATES (a,b,c or start:stop:step) until saturation, writes load_latency.csv"
+			<< endl;
+	cout
+			<< "\t-k, --checkpoint=FILENAME \trun the warmup only and save the state to FILENAME"
+			<< endl;
+	cout
+			<< "\t-r, --restore=FILENAME \t\tcontinue from the state saved in FILENAME (same ini files, -o and trace)"
+			<< endl;
 }
 }
 
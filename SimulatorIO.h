@@ -9,6 +9,74 @@ namespace DRAMSim
 
 	using std::string;
 	using std::ifstream;
+	using std::vector;
+	class Checkpoint;
+	class MemorySystem;
+	class TraceGenerator;
+
+	//one access of a trace; the data of a write (DATA_STORAGE builds) is
+	//kept outside the record, at dataOffset of the trace's data
+	struct TraceRecord
+	{
+		uint64_t address;
+		uint64_t clockCycle;
+		Transaction::TransactionType transactionType;
+		size_t len;
+		uint64_t dataOffset;
+		size_t dataBytes;
+	};
+
+	//a whole trace decoded once; a sweep shares it, read only, between the
+	//simulations it runs in parallel
+	class DecodedTrace
+	{
+	public:
+		vector<TraceRecord> records;
+		vector<byte> data;
+	};
+
+	//one trace file and how far the simulation has read it; with a decoded
+	//copy of the trace shared, it replays that instead of reading the file,
+	//and with a generator it hands out the generator's records
+	class TraceReader
+	{
+	public:
+		TraceReader(const string &filename, bool useClockCycle);
+		~TraceReader();
+
+		//the trace type is taken from the prefix of the file name
+		void open();
+		void share(const DecodedTrace *trace) { sharedTrace = trace; }
+		//the reader owns the generator
+		void generate(TraceGenerator *generator) { this->generator = generator; }
+		//the next access, false at the end of the trace; data is NULL for a
+		//record without data
+		bool next(TraceRecord &record, const byte *&data);
+		void decode(DecodedTrace &trace);
+		//the position in the trace; it has to be open already (or shared)
+		void checkpoint(Checkpoint &cp);
+
+		string filename;
+
+	private:
+		bool readRecord(TraceRecord &record, vector<byte> &data);
+
+		TraceType traceType;
+		ifstream traceFile;
+		FILE *fp; //binary (spec) traces
+		const DecodedTrace *sharedTrace;
+		TraceGenerator *generator;
+		size_t nextRecord;
+		bool useClockCycle;
+
+		vector<byte> recordData; //data of the record just read from the file
+		uint64_t traceWord; //access of a binary trace
+		uint64_t previousTimer; //spec traces count time from the previous access
+		uint64_t lineNumber;
+
+		TraceReader(const TraceReader &other);
+		TraceReader &operator=(const TraceReader &other);
+	};
 
 	class SimulatorIO
 	{
@@ -32,14 +100,32 @@ namespace DRAMSim
 								paramOverrides(po),
 								memorySize(ms),
 								cycleNum(cn),
-								useClockCycle(cc){
+								useClockCycle(cc),
+								sharedTraces(NULL),
+								config(),
+								mergeStarted(false){
 			std::cout<<" get the SimulatorIO object! "<<std::endl;};
 		~SimulatorIO();
 
 		void loadInputParams();
 		void initOutputFiles();
 
+		//traceFilename may name several traces, separated by commas; a
+		//generator is a trace named gen:<pattern>
+		vector<string> traceFilenames() const;
+		//the generators need the memory system for its address mapping
+		void openTrace(MemorySystem *memorySystem);
+		//decodes the trace files side by side, a thread each; a generator is
+		//left empty, every simulation runs its own
+		void decodeTrace(vector<DecodedTrace> &decoded);
+		//the next access of all the traces, in the order of their time stamps
 		Transaction* nextTrans();
+		//the next access of trace number 'trace', its source
+		Transaction* nextTrans(size_t trace);
+		//the positions in the traces
+		void checkpoint(Checkpoint &cp);
+		//what a checkpoint of this run belongs to: build, parameters and trace
+		string checkpointDescription();
 
 		IniReader::OverrideMap* parseParamOverrides(const string &kv_str);
 		string FilenameWithNumberSuffix(const string &filename, const string &extension, unsigned maxNumber = 100);
@@ -57,18 +143,41 @@ namespace DRAMSim
 		string workingDirectory;
 		string outputFilePath;
 
-		ifstream traceFile;
-		FILE *fp;
-		static ofstream verifyFile; //used in Rank.cpp and MemoryController.cpp if VERIFICATION_OUTPUT is set
-		static ofstream visFile; 	//mostly used in MemoryController
-		static ofstream logFile;
+		//the output files are per thread, so the simulations of a sweep can
+		//run side by side
+		static thread_local ofstream verifyFile; //used in Rank.cpp and MemoryController.cpp if VERIFICATION_OUTPUT is set
+		static thread_local ofstream visFile; 	//mostly used in MemoryController
+		static thread_local ofstream logFile;
 
-		TraceType traceType;
 		IniReader::OverrideMap *paramOverrides;
 
 		unsigned memorySize;
 		uint64_t cycleNum;
 		bool useClockCycle;
+
+		//one reader per trace file, opened by openTrace()
+		vector<TraceReader*> traces;
+		//when set, the readers replay these traces instead of reading the files
+		const vector<DecodedTrace> *sharedTraces;
+
+		//warm up and save the state there / continue from a saved state
+		string saveCheckpointFilename;
+		string restoreCheckpointFilename;
+
+		//the parameters read by loadInputParams; the simulator copies back the
+		//derived sizes once the memory system has computed them
+		Config config;
+
+	private:
+		Transaction* makeTransaction(const TraceRecord &record, const byte *data);
+		//a trace file is looked up in the working directory unless its path is absolute
+		string tracePath(const string &filename);
+
+		//the k-way merge of nextTrans(): the next record of every trace (NULL
+		//once it ended) and a heap of the traces that have one, earliest first
+		bool mergeStarted;
+		vector<Transaction*> mergeHeads;
+		vector<size_t> mergeHeap;
 	};
 
 
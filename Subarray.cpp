@@ -20,13 +20,13 @@ namespace DRAMSim
 		// for BL=4) plus the column offset
 
 #ifdef DATA_RELIABILITY_ECC
-		unsigned transactionSize = (ECC_DATA_BUS_BITS/8)*BL;
+		unsigned transactionSize = (config.ECC_DATA_BUS_BITS/8)*config.BL;
 #else
-		unsigned transactionSize = (JEDEC_DATA_BUS_BITS/8)*BL;
+		unsigned transactionSize = (config.JEDEC_DATA_BUS_BITS/8)*config.BL;
 #endif
 		uint64_t transactionMask =  transactionSize - 1; //ex: (64 bit bus width) x (8 Burst Length) - 1 = 64 bytes - 1 = 63 = 0x3f mask
 		unsigned byteOffset = busPacket->data->getAddr() & transactionMask;
-		unsigned columnOffset = (busPacket->column * DEVICE_WIDTH)/8;
+		unsigned columnOffset = (busPacket->column * config.DEVICE_WIDTH)/8;
 		unsigned offset = columnOffset + byteOffset;
 
 		DEBUG("[DPKT] "<< *(busPacket->data) << " \t r="<<busPacket->row<<" c="<<busPacket->column<<" byte offset="<< byteOffset<< "-> "<<offset);
@@ -34,37 +34,49 @@ namespace DRAMSim
 		return offset;
 	}
 
-	void Subarray::write(const BusPacket *busPacket)
+	void Subarray::write(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits)
 	{
-		unsigned byteOffset = getByteOffsetInRow(busPacket);
-		RowMapType::iterator it;
-		it = rowEntries.find(busPacket->row);
-		byte *rowData;
-		if (it == rowEntries.end())
-		{
-			// row doesn't exist yet, allocate it
-			rowData = (byte *)calloc((NUM_COLS*DEVICE_WIDTH)/8,sizeof(byte));
-			rowEntries[busPacket->row] = rowData;
-		}
-		else
+		setBits = 0;
+		resetBits = 0;
+
+		// SET_WRITE carries no data, it finishes the SET of the cells holding a 1
+		if (busPacket->data == NULL)
 		{
-			rowData = it->second;
+			const byte *rowData = getRow(busPacket->row);
+			unsigned offset = (busPacket->column * config.DEVICE_WIDTH)/8 + (busPacket->physicalAddress & (config.TRANS_DATA_BYTES - 1));
+			for (size_t i=0; i<config.TRANS_DATA_BYTES && offset+i < (config.NUM_COLS*config.DEVICE_WIDTH)/8; i++)
+			{
+				setBits += __builtin_popcount(rowData[offset+i]);
+			}
+			return;
 		}
 
+		unsigned byteOffset = getByteOffsetInRow(busPacket);
+		byte *rowData = getRowForWrite(busPacket->row);
+
 #ifdef DATA_RELIABILITY_ECC
-		size_t transactionSize = ECC_DATA_BUS_BITS * BL / 8;
+		size_t transactionSize = config.ECC_DATA_BUS_BITS * config.BL / 8;
 #else
 		size_t transactionSize = busPacket->data->getNumBytes();
 #endif
 
 		// if we out of bound a row, this is a problem
-		if (byteOffset + transactionSize > NUM_COLS*DEVICE_WIDTH)
+		if (byteOffset + transactionSize > config.NUM_COLS*config.DEVICE_WIDTH)
 		{
 			ERROR("Transaction out of bounds a row, check alignment of the address");
 			exit(-1);
 		}
+		// only the cells whose value changes are programmed
+		const byte *newData = busPacket->data->getData();
+		for (size_t i=0; i<transactionSize; i++)
+		{
+			byte changed = rowData[byteOffset+i] ^ newData[i];
+			setBits += __builtin_popcount(changed & newData[i]);
+			resetBits += __builtin_popcount(changed & rowData[byteOffset+i]);
+		}
+
 		// copy data to the row
-		memcpy(rowData + byteOffset, busPacket->data->getData(), transactionSize);
+		memcpy(rowData + byteOffset, newData, transactionSize);
 	}
 
 
@@ -73,33 +85,23 @@ namespace DRAMSim
 		assert(busPacket->data == NULL);
 
 #ifdef DATA_RELIABILITY_ECC
-		size_t transactionSize = ECC_DATA_BUS_BITS *BL /8;
+		size_t transactionSize = config.ECC_DATA_BUS_BITS *config.BL /8;
 #else
-		size_t transactionSize = JEDEC_DATA_BUS_BITS * BL /8;
+		size_t transactionSize = config.JEDEC_DATA_BUS_BITS * config.BL /8;
 #endif
 
 		busPacket->busPacketType = BusPacket::DATA;
 		busPacket->data = new DataPacket(NULL, transactionSize, busPacket->physicalAddress);
 
-		RowMapType::iterator it = rowEntries.find(busPacket->row);
-		if (it != rowEntries.end())
-		{
-			byte *rowData = it->second;
-			byte *dataBuf = (byte *)calloc(sizeof(byte), transactionSize);
-			memcpy(dataBuf, rowData + (busPacket->column*DEVICE_WIDTH)/8, transactionSize);
-			busPacket->data->setData(dataBuf, transactionSize, false);
-			DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
-		}
-		else
-		{
-#ifdef RETURN_TRANSACTIONS
-			byte *dataBuf = (byte *)calloc(sizeof(byte), transactionSize);
-			busPacket->data->setData(dataBuf, transactionSize, false);
-			DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
+		// rows that were never written read back as zeros
+		byte *rowData = getRow(busPacket->row) + (busPacket->column*config.DEVICE_WIDTH)/8;
+#ifdef DATA_RELIABILITY_ECC
+		// the ECC decoder works in place, so it gets a copy
+		busPacket->data->setData(rowData, transactionSize, true);
+#else
+		busPacket->data->setView(rowData, transactionSize, store);
 #endif
-		}
-
-
+		DEBUG("[DPKT] Rank returning: "<<*(busPacket->data));
 	}
 
 } // end of namespace DRAMSim
@@ -11,7 +11,7 @@
 #include "SystemConfiguration.h"
 #include "BankState.h"
 #include "BusPacket.h"
-#include <map>
+#include "BackingStore.h"
 
 
 namespace DRAMSim
@@ -20,18 +20,30 @@ namespace DRAMSim
 	{
 	public:
 		//functions
-		Subarray() {};
+		//the subarray's rows are rows firstRow.. of the channel's backing store
+		Subarray(const Config &config, BackingStore *store, uint64_t firstRow) :
+			config(config), store(store), firstRow(firstRow) {};
 		void read(BusPacket *busPacket);
-		void write(const BusPacket *busPacket);
+		void write(const BusPacket *busPacket, uint64_t &setBits, uint64_t &resetBits);
 
 		//fields
 		BankState currentState;
 
 	private:
 		unsigned getByteOffsetInRow(const BusPacket *busPacket);
-		typedef std::map<uint64_t, byte *> RowMapType;
-
-		RowMapType rowEntries;
+		byte *getRow(unsigned row) const
+		{
+			return store->getRow(firstRow + row);
+		}
+		//the views handed out by earlier reads of the row become copies
+		byte *getRowForWrite(unsigned row)
+		{
+			return store->getRowForWrite(firstRow + row);
+		}
+
+		const Config &config;
+		BackingStore *store;
+		uint64_t firstRow;
 	};
 }
 
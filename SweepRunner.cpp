@@ -0,0 +1,464 @@
+//SweepRunner.cpp
+//
+//Parallel simulations of a sweep over ini parameters, sharing one decoded trace,
+//and the load-latency curves of the configurations of a sweep
+//
+
+#include "SweepRunner.h"
+#include "Simulator.h"
+#include "TraceGenerator.h"
+#include <thread>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace DRAMSim
+{
+	using std::ifstream;
+	using std::ofstream;
+	using std::stringstream;
+
+	const double SweepRunner::SATURATION = 0.9;
+
+	SweepRunner::SweepRunner(SimulatorIO *base, const string &sweepFilename, unsigned jobs) :
+		base(base),
+		jobs(jobs),
+		nextPoint(0)
+	{
+		init(sweepFilename);
+	}
+
+	SweepRunner::SweepRunner(SimulatorIO *base, const string &sweepFilename, unsigned jobs, const vector<double> &rates) :
+		base(base),
+		jobs(jobs),
+		rates(rates),
+		nextPoint(0)
+	{
+		init(sweepFilename);
+	}
+
+	void SweepRunner::init(const string &sweepFilename)
+	{
+		if (base->traceFilename.length() == 0)
+		{
+			ERROR("Please provide a trace file");
+			base->usage();
+			exit(-1);
+		}
+		if (!rates.empty())
+		{
+			if (sweepFilename.length() > 0)
+			{
+				loadPoints(sweepFilename);
+			}
+			loadCurvePoints();
+		}
+		else
+		{
+			loadPoints(sweepFilename);
+		}
+		if (this->jobs == 0)
+		{
+			this->jobs = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+		}
+		if (this->jobs > points.size())
+		{
+			this->jobs = points.size();
+		}
+	}
+
+	void SweepRunner::loadPoints(const string &sweepFilename)
+	{
+		ifstream sweepFile(sweepFilename.c_str());
+		if (!sweepFile.is_open())
+		{
+			ERROR("Unable to load sweep file "<<sweepFilename);
+			exit(-1);
+		}
+
+		string line;
+		size_t lineNumber = 0;
+		while (getline(sweepFile, line))
+		{
+			lineNumber++;
+			//trim the line
+			size_t first = line.find_first_not_of(" \t\r");
+			if (first == string::npos || line[first] == '#')
+			{
+				continue;
+			}
+			line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+			Point point;
+			IniReader::OverrideMap *own = base->parseParamOverrides(line);
+			if (own->empty())
+			{
+				ERROR("Line "<<lineNumber<<" of "<<sweepFilename<<" has no key=value overrides");
+				exit(-1);
+			}
+			if (base->paramOverrides != NULL)
+			{
+				point.overrides = *base->paramOverrides;
+			}
+			for (IniReader::OverrideIterator it = own->begin(); it != own->end(); it++)
+			{
+				point.overrides[it->first] = it->second;
+			}
+			delete own;
+
+			//the directory name: line number and overrides, e.g. 3_tRCD=12.SET_IDLE=false
+			stringstream name;
+			name << lineNumber << "_";
+			for (size_t i = 0; i < line.length(); i++)
+			{
+				char c = line[i];
+				name << (c == ',' ? '.' : (c == '/' || c == ' ') ? '_' : c);
+			}
+			point.name = name.str();
+			points.push_back(point);
+		}
+
+		if (points.empty())
+		{
+			ERROR("No configurations in sweep file "<<sweepFilename);
+			exit(-1);
+		}
+	}
+
+	vector<double> SweepRunner::parseRates(const string &list)
+	{
+		vector<double> result;
+		if (list.find(':') != string::npos)
+		{
+			double start, stop, step;
+			char colon1, colon2;
+			stringstream range(list);
+			if (!(range >> start >> colon1 >> stop >> colon2 >> step) || colon1 != ':' || colon2 != ':' || step <= 0)
+			{
+				ERROR("Bad rate range '"<<list<<"', expected start:stop:step");
+				exit(-1);
+			}
+			//multiples of the step, the sum would drift
+			for (unsigned k = 0; start + k * step <= stop * (1 + 1E-9); k++)
+			{
+				result.push_back(start + k * step);
+			}
+		}
+		else
+		{
+			stringstream items(list);
+			string item;
+			while (getline(items, item, ','))
+			{
+				char *end;
+				double rate = strtod(item.c_str(), &end);
+				if (end == item.c_str() || *end != '\0')
+				{
+					ERROR("Bad rate '"<<item<<"' in '"<<list<<"'");
+					exit(-1);
+				}
+				result.push_back(rate);
+			}
+		}
+
+		std::sort(result.begin(), result.end());
+		result.erase(std::unique(result.begin(), result.end()), result.end());
+		if (result.empty() || result[0] <= 0)
+		{
+			ERROR("The rates of a load-latency curve must be above 0 ("<<list<<")");
+			exit(-1);
+		}
+		return result;
+	}
+
+	void SweepRunner::loadCurvePoints()
+	{
+		vector<string> traceNames = base->traceFilenames();
+		bool generated = false;
+		for (size_t i = 0; i < traceNames.size(); i++)
+		{
+			generated = generated || TraceGenerator::isGenerator(traceNames[i]);
+		}
+		if (!generated)
+		{
+			ERROR("A load-latency curve needs a -g generator to vary the rate of");
+			exit(-1);
+		}
+		if (base->cycleNum == 0)
+		{
+			ERROR("A load-latency curve needs -c, its generators do not end");
+			exit(-1);
+		}
+
+		//without a sweep file, the command line is the only configuration
+		if (points.empty())
+		{
+			Point point;
+			point.name = "load_curve";
+			if (base->paramOverrides != NULL)
+			{
+				point.overrides = *base->paramOverrides;
+			}
+			points.push_back(point);
+		}
+		//the curves are measured on the channels of a single memory system
+		string systemIniFilename = base->systemIniFilename;
+		if (base->workingDirectory.length() > 0 && systemIniFilename[0] != '/')
+		{
+			systemIniFilename = base->workingDirectory + "/" + systemIniFilename;
+		}
+		for (size_t c = 0; c < points.size(); c++)
+		{
+			Config config;
+			IniReader reader(config);
+			reader.ReadIniFile(systemIniFilename, IniReader::SYS_INI);
+			reader.OverrideKeys(&points[c].overrides);
+			if (config.HYBRID_CACHE_DEVICE.length() > 0)
+			{
+				ERROR("Load-latency curves need the channels of a single memory system, not a hybrid one ("<<points[c].name<<")");
+				exit(-1);
+			}
+		}
+
+		configurations = points;
+		points.clear();
+		saturatedRates = vector<double>(configurations.size(), HUGE_VAL);
+
+		//the memory system sees every request, for as long as -c says
+		IniReader::OverrideMap defaults;
+		defaults["CACHE_L1_KB"] = "0";
+		defaults["CACHE_L2_KB"] = "0";
+		defaults["CACHE_LLC_KB"] = "0";
+		defaults["GEN_REQUESTS"] = "0";
+
+		for (size_t r = 0; r < rates.size(); r++)
+		{
+			for (size_t c = 0; c < configurations.size(); c++)
+			{
+				Point point = configurations[c];
+				for (IniReader::OverrideIterator it = defaults.begin(); it != defaults.end(); it++)
+				{
+					if (point.overrides.find(it->first) == point.overrides.end())
+					{
+						point.overrides[it->first] = it->second;
+					}
+				}
+				stringstream rate;
+				rate << rates[r];
+				point.overrides["GEN_RATE"] = rate.str();
+				point.configuration = c;
+				point.rate = rates[r];
+				point.name = configurations[c].name + "/rate_" + rate.str();
+				points.push_back(point);
+			}
+		}
+	}
+
+	void SweepRunner::run()
+	{
+		//the parent of the per configuration directories, before the threads race to create it
+		string outputPath = base->outputFilePath;
+		if (base->workingDirectory.length() > 0)
+		{
+			outputPath = base->workingDirectory + "/" + outputPath;
+		}
+		base->mkdirIfNotExist(outputPath);
+		for (size_t i = 0; i < configurations.size(); i++)
+		{
+			base->mkdirIfNotExist(outputPath + configurations[i].name);
+		}
+
+		base->decodeTrace(traces);
+		if (rates.empty())
+		{
+			PRINT("== Sweeping "<<points.size()<<" configurations on "<<jobs<<" threads ==");
+		}
+		else
+		{
+			PRINT("== Load-latency curves of "<<configurations.size()<<" configurations at "<<rates.size()
+					<<" rates on "<<jobs<<" threads ==");
+		}
+
+		vector<std::thread> workers;
+		for (unsigned i = 0; i < jobs; i++)
+		{
+			workers.push_back(std::thread(&SweepRunner::work, this));
+		}
+		for (size_t i = 0; i < workers.size(); i++)
+		{
+			workers[i].join();
+		}
+
+		if (!rates.empty())
+		{
+			writeCurves(outputPath);
+		}
+	}
+
+	void SweepRunner::work()
+	{
+		size_t i;
+		while ((i = nextPoint++) < points.size())
+		{
+			//nothing beyond the rate a configuration saturated at
+			if (!rates.empty())
+			{
+				std::lock_guard<std::mutex> lock(progressLock);
+				if (points[i].rate > saturatedRates[points[i].configuration])
+				{
+					continue;
+				}
+			}
+			runPoint(points[i]);
+		}
+	}
+
+	void SweepRunner::runPoint(Point &point)
+	{
+		SimulatorIO *simIO = new SimulatorIO(base->systemIniFilename, base->deviceIniFilename,
+				base->traceFilename, base->visFilename, base->workingDirectory,
+				base->outputFilePath + point.name + "/", new IniReader::OverrideMap(point.overrides),
+				base->memorySize, base->cycleNum, base->useClockCycle);
+		simIO->sharedTraces = &traces;
+
+		string pointPath = simIO->outputFilePath;
+		if (simIO->workingDirectory.length() > 0)
+		{
+			pointPath = simIO->workingDirectory + "/" + pointPath;
+		}
+		simIO->mkdirIfNotExist(pointPath);
+		string outFilename = pointPath + "sim.out";
+		ofstream out(outFilename.c_str());
+		if (!out)
+		{
+			ERROR("Cannot open "<<outFilename);
+			exit(-1);
+		}
+
+		//everything this thread PRINT()s until the simulation is done goes to sim.out
+		simOutput = &out;
+		Simulator *simulator = new Simulator(simIO);
+		simulator->setup();
+		simulator->start();
+		simulator->report(true);
+		if (!rates.empty())
+		{
+			measure(simulator, point);
+		}
+		delete simulator;
+		simOutput = &std::cout;
+
+		std::lock_guard<std::mutex> lock(progressLock);
+		if (rates.empty())
+		{
+			PRINT("== Done "<<point.name<<" ==");
+			return;
+		}
+		PRINT("== Done "<<point.name<<": "<<point.achievedBandwidth<<" of "<<point.offeredBandwidth
+				<<" GB/s, average read latency "<<point.averageLatency<<" ns"<<(point.saturated ? ", saturated" : "")<<" ==");
+		if (point.saturated && point.rate < saturatedRates[point.configuration])
+		{
+			saturatedRates[point.configuration] = point.rate;
+		}
+	}
+
+	//the latency of the read at fraction of the histogram, at the middle of its bin
+	static double histogramPercentile(const map<unsigned, uint64_t> &histogram, uint64_t reads, double fraction, double halfBin)
+	{
+		uint64_t seen = 0;
+		for (map<unsigned, uint64_t>::const_iterator it = histogram.begin(); it != histogram.end(); it++)
+		{
+			seen += it->second;
+			if (seen >= fraction * reads)
+			{
+				return it->first + halfBin;
+			}
+		}
+		return 0;
+	}
+
+	void SweepRunner::measure(Simulator *simulator, Point &point)
+	{
+		//loadCurvePoints turned hybrid memory systems away
+		MemorySystem *memorySystem = simulator->memorySystem;
+		const Config &config = memorySystem->config;
+
+		//the read latencies of all the channels, in cycles; the trace based
+		//simulator runs the CPU at the clock of the memory
+		map<unsigned, uint64_t> histogram;
+		uint64_t accesses = 0;
+		for (size_t c = 0; c < memorySystem->memoryControllers.size(); c++)
+		{
+			MemoryController *controller = memorySystem->memoryControllers[c];
+			for (map<unsigned, unsigned>::const_iterator it = controller->latencies.begin(); it != controller->latencies.end(); it++)
+			{
+				histogram[it->first] += it->second;
+			}
+			for (size_t b = 0; b < controller->grandTotalBankAccesses.size(); b++)
+			{
+				accesses += controller->grandTotalBankAccesses[b];
+			}
+		}
+		double halfBin = config.HISTOGRAM_BIN_SIZE / 2.0;
+		double totalLatency = 0;
+		point.reads = 0;
+		for (map<unsigned, uint64_t>::const_iterator it = histogram.begin(); it != histogram.end(); it++)
+		{
+			point.reads += it->second;
+			totalLatency += (it->first + halfBin) * it->second;
+		}
+		if (point.reads > 0)
+		{
+			point.averageLatency = totalLatency / point.reads * config.tCK;
+			point.p50Latency = histogramPercentile(histogram, point.reads, 0.50, halfBin) * config.tCK;
+			point.p95Latency = histogramPercentile(histogram, point.reads, 0.95, halfBin) * config.tCK;
+			point.p99Latency = histogramPercentile(histogram, point.reads, 0.99, halfBin) * config.tCK;
+		}
+
+		//bandwidth as printStats computes it, over the whole run; every
+		//generator offers GEN_RATE transactions a cycle
+		vector<string> traceNames = base->traceFilenames();
+		unsigned generators = 0;
+		for (size_t i = 0; i < traceNames.size(); i++)
+		{
+			generators += TraceGenerator::isGenerator(traceNames[i]);
+		}
+		double bytesPerTransaction = (config.JEDEC_DATA_BUS_BITS * config.BL) / 8;
+		double gigabyte = 1024.0 * 1024.0 * 1024.0;
+		double seconds = (double) memorySystem->clockDomainDRAM->clockcycle * config.tCK * 1E-9;
+		point.achievedBandwidth = accesses * bytesPerTransaction / gigabyte / seconds;
+		point.offeredBandwidth = point.rate * generators * bytesPerTransaction / gigabyte / (config.tCK * 1E-9);
+		point.saturated = point.achievedBandwidth < SATURATION * point.offeredBandwidth;
+		point.ran = true;
+	}
+
+	void SweepRunner::writeCurves(const string &outputPath)
+	{
+		for (size_t c = 0; c < configurations.size(); c++)
+		{
+			string csvFilename = outputPath + configurations[c].name + "/load_latency.csv";
+			ofstream csv(csvFilename.c_str());
+			if (!csv)
+			{
+				ERROR("Cannot open "<<csvFilename);
+				exit(-1);
+			}
+			csv << "rate,offered_GBps,achieved_GBps,reads,average_latency_ns,p50_latency_ns,p95_latency_ns,p99_latency_ns,saturated" << std::endl;
+			//the points are in increasing rate order; the ones past the first
+			//saturated rate may have run before it was known
+			for (size_t i = 0; i < points.size(); i++)
+			{
+				const Point &point = points[i];
+				if (point.configuration != c || !point.ran || point.rate > saturatedRates[c])
+				{
+					continue;
+				}
+				csv << point.rate << "," << point.offeredBandwidth << "," << point.achievedBandwidth << ","
+						<< point.reads << "," << point.averageLatency << "," << point.p50Latency << ","
+						<< point.p95Latency << "," << point.p99Latency << "," << point.saturated << std::endl;
+			}
+			PRINT("== Wrote "<<csvFilename<<(saturatedRates[c] == HUGE_VAL ? ", not saturated" : "")<<" ==");
+		}
+	}
+}
@@ -0,0 +1,98 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+//SweepRunner.h
+//
+//Runs one trace based simulation per line of a sweep file, side by side on a
+//pool of threads. A line holds ini overrides in the syntax of -o
+//(tRCD=12,SET_IDLE=false) and is applied on top of the -o overrides; blank
+//lines and lines starting with # are skipped.
+//
+//The trace is decoded once, before the threads start, and every simulation
+//replays it from the shared, read only, buffer. Each line writes its results
+//into its own directory under the output path, named after its line number
+//and its overrides, and everything it PRINT()s goes to sim.out in there.
+//
+//Load-latency curves (-l): every configuration, a line of the sweep file or,
+//without one, the command line alone, runs with each GEN_RATE of a list, so
+//the -g generators offer more and more traffic. The caches are off and the
+//generators endless unless -o or the line says otherwise; -c sets the length
+//of a run. The rates run in increasing order, those of all the
+//configurations side by side, and a configuration stops at its first rate
+//the memory system cannot keep up with: less than SATURATION of the offered
+//bandwidth comes back. Each configuration writes load_latency.csv in its
+//directory, one row per rate: the offered and achieved bandwidth, and the
+//average and tail read latency from the latency histograms of the channels.
+//A configuration with a hybrid memory system is refused before anything runs.
+//
+
+#include "SimulatorIO.h"
+#include <atomic>
+#include <mutex>
+
+namespace DRAMSim
+{
+	class Simulator;
+
+	class SweepRunner
+	{
+	public:
+		//base holds the command line (ini files, trace, -o, -c ...) of every run
+		SweepRunner(SimulatorIO *base, const string &sweepFilename, unsigned jobs);
+		//load-latency curves over the GEN_RATEs in rates; sweepFilename may be empty
+		SweepRunner(SimulatorIO *base, const string &sweepFilename, unsigned jobs, const vector<double> &rates);
+
+		//"0.01,0.02,0.05" or start:stop:step, "0.01:0.1:0.01"
+		static vector<double> parseRates(const string &list);
+		//the fraction of the offered bandwidth below which a rate saturates
+		static const double SATURATION;
+
+		void run();
+
+	private:
+		struct Point
+		{
+			Point() : configuration(0), rate(0), ran(false), saturated(false), reads(0),
+				offeredBandwidth(0), achievedBandwidth(0), averageLatency(0),
+				p50Latency(0), p95Latency(0), p99Latency(0) {}
+
+			string name;
+			IniReader::OverrideMap overrides;
+
+			//load-latency curves
+			size_t configuration;
+			double rate;
+			bool ran;
+			bool saturated;
+			uint64_t reads;
+			double offeredBandwidth; //GB/s
+			double achievedBandwidth;
+			double averageLatency; //ns
+			double p50Latency;
+			double p95Latency;
+			double p99Latency;
+		};
+
+		void init(const string &sweepFilename);
+		void loadPoints(const string &sweepFilename);
+		//one point per configuration and rate, the lowest rates first
+		void loadCurvePoints();
+		void work();
+		void runPoint(Point &point);
+		//the load-latency results of a finished simulation
+		void measure(Simulator *simulator, Point &point);
+		void writeCurves(const string &outputPath);
+
+		SimulatorIO *base;
+		unsigned jobs;
+		vector<Point> points;
+		vector<double> rates; //empty unless load-latency curves
+		vector<Point> configurations;
+		vector<double> saturatedRates; //per configuration, the first rate that saturated
+		vector<DecodedTrace> traces;
+		std::atomic<size_t> nextPoint;
+		std::mutex progressLock;
+	};
+}
+
+#endif
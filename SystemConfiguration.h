@@ -1,4 +1,3 @@
-<<<<<<< HEAD
 /*********************************************************************************
 *  Copyright (c) 2010-2011, Elliott Cooper-Balis
 *                             Paul Rosenfeld
@@ -58,6 +57,8 @@
 //#define DATA_STORAGE_SSA
 //#define DATA_RELIABILITY_ECC
 //#define DATA_RELIABILITY_CHIPKILL
+//time stamp counter accumulators of the update phases of each channel (PhaseProfile.h)
+//#define PROFILE_PHASES
 
 #ifdef DATA_STORAGE_SSA
 	#define DATA_STORAGE
@@ -77,113 +78,12 @@ namespace DRAMSim
 
 	typedef unsigned char byte;
 
+	//process wide settings, shared by every memory system
 	extern bool SHOW_SIM_OUTPUT;
-
-	extern bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
-
 	extern bool DEBUG_INI_READER;
-
-	extern bool DEBUG_TRANS_Q;
-	extern bool DEBUG_CMD_Q;
-	extern bool DEBUG_ADDR_MAP;
-	extern bool DEBUG_BANKSTATE;
-	extern bool SET_IDLE; //libing
-	extern bool SET_CLOSE; //libing
-	extern bool DEBUG_BUS;
-	extern bool DEBUG_BANKS;
-	extern bool DEBUG_POWER;
-	extern bool USE_LOW_POWER;
-	extern bool VIS_FILE_OUTPUT;
-
-	extern uint64_t TOTAL_STORAGE;
-	extern unsigned NUM_BANKS;
-	extern unsigned NUM_RANKS;
-	extern unsigned NUM_CHANS;
-	extern unsigned NUM_ROWS;
-	extern unsigned NUM_COLS;
-	extern unsigned DEVICE_WIDTH;
-
-	extern unsigned SUBARRAY_DATA_BYTES;
-	extern unsigned TRANS_DATA_BYTES;
-
-	//in nanoseconds
-	extern unsigned REFRESH_PERIOD;
-	extern float tCK;
-
-	extern unsigned CL;
-	extern unsigned AL;
-	#define RL (CL+AL)
-	#define WL (RL-1)
-	extern unsigned BL;
-	extern unsigned tRAS;
-	extern unsigned tRCD;
-	extern unsigned tRRD;
-	extern unsigned tRC;
-	extern unsigned tRP;
-	extern unsigned tCCD;
-	extern unsigned tRTP;
-	extern unsigned tWTR;
-	extern unsigned tWR;
-	#define SET (tWR*8)
-	extern unsigned tRTRS;
-	extern unsigned tRFC;
-	extern unsigned tFAW;
-	extern unsigned tCKE;
-	extern unsigned tXP;
-
-	extern unsigned tCMD;
-
-	extern unsigned IDD0;
-	extern unsigned IDD1;
-	extern unsigned IDD2P;
-	extern unsigned IDD2Q;
-	extern unsigned IDD2N;
-	extern unsigned IDD3Pf;
-	extern unsigned IDD3Ps;
-	extern unsigned IDD3N;
-	extern unsigned IDD4W;
-	extern unsigned IDD4R;
-	extern unsigned IDD5;
-	extern unsigned IDD6;
-	extern unsigned IDD6L;
-	extern unsigned IDD7;
-	extern float Vdd;
-	extern uint64_t WarmupCycle;
-	extern unsigned NUM_DEVICES;
-
-	//same bank
-	#define READ_TO_PRE_DELAY (AL+BL/2+max(((int)tRTP),2)-2)
-	#define WRITE_TO_PRE_DELAY (WL+BL/2+tWR)
-
-	#define SET_TO_PRE_DELAY (WL+BL/2+SET)
-
-	#define READ_TO_WRITE_DELAY (RL+BL/2+tRTRS-WL)
-	#define READ_AUTOPRE_DELAY (AL+tRTP+tRP)
-	#define WRITE_AUTOPRE_DELAY (WL+BL/2+tWR+tRP)
-
-	#define SET_AUTOPRE_DELAY (WL+BL/2+SET+tRP)
-
-
-	#define WRITE_TO_READ_DELAY_B (WL+BL/2+tWTR) //interbank
-	#define WRITE_TO_READ_DELAY_R (WL+BL/2+tRTRS-RL) //interrank
-
-	//for PCM energy libing
-	#define WR_ENERGY_BIT 					//RESET energy
-	#define RD_ENERGY_BIT
-	#define SET_ENERGY_BIT (8*WR_ENERGY_BIT)
-
-	extern unsigned ECC_DATA_BUS_BITS;
-	extern unsigned JEDEC_DATA_BUS_BITS;
-
-	//Memory Controller related parameters
-	extern unsigned TRANS_QUEUE_DEPTH;
-	extern unsigned CMD_QUEUE_DEPTH;
-
-	extern uint64_t EPOCH_LENGTH;
-	extern unsigned HISTOGRAM_BIN_SIZE;
-
-	extern unsigned TOTAL_ROW_ACCESSES;
-
+	//where PRINT() goes on this thread; a sweep points every simulation at
+	//its own results directory
+	extern thread_local std::ostream *simOutput;
 
 	typedef enum
 	{
@@ -226,281 +126,221 @@ namespace DRAMSim
 		BankThenRankRoundRobin
 	} SchedulingPolicy;
 
+	typedef enum
+	{
+		NoWearLeveling,
+		StartGap,
+		RandomStartGap
+	} WearLevelingScheme;
 
-	extern std::string ROW_BUFFER_POLICY;
-	extern std::string SCHEDULING_POLICY;
-	extern std::string ADDRESS_MAPPING_SCHEME;
-	extern std::string QUEUING_STRUCTURE;
+	typedef enum
+	{
+		DRAMDevice,
+		PCMDevice
+	} DeviceType;
 
-	extern RowBufferPolicy rowBufferPolicy;
-	extern SchedulingPolicy schedulingPolicy;
-	extern AddressMappingScheme addressMappingScheme;
-	extern QueuingStructure queuingStructure;
 
+	//Config: the parameters of one memory system, read from its device and
+	//system ini files (IniReader), plus the enums derived from the strings and
+	//the values MemorySystem derives from the geometry. Every MemorySystem owns
+	//a copy and hands a reference to its controllers, ranks and banks, so
+	//differently configured memory systems can live in one process.
 	//
-	//FUNCTIONS
-	//
-
-	unsigned inline dramsim_log2(unsigned value)
-	{
-		unsigned logbase2 = 0;
-		unsigned orig = value;
-		value>>=1;
-		while (value>0)
-		{
-			value >>= 1;
-			logbase2++;
-		}
-		if ((unsigned)1<<logbase2<orig)logbase2++;
-		return logbase2;
-	}
-	inline bool isPowerOfTwo(unsigned long x)
+	//A value initialized Config (Config()) starts out all zero.
+	class Config
 	{
-		return (1UL<<dramsim_log2(x)) == x;
-	}
-
-};
-
-
-#endif
-
-=======
-/*********************************************************************************
-*  Copyright (c) 2010-2011, Elliott Cooper-Balis
-*                             Paul Rosenfeld
-*                             Bruce Jacob
-*                             University of Maryland 
-*                             dramninjas [at] gmail [dot] com
-*  All rights reserved.
-*  
-*  Redistribution and use in source and binary forms, with or without
-*  modification, are permitted provided that the following conditions are met:
-*  
-*     * Redistributions of source code must retain the above copyright notice,
-*        this list of conditions and the following disclaimer.
-*  
-*     * Redistributions in binary form must reproduce the above copyright notice,
-*        this list of conditions and the following disclaimer in the documentation
-*        and/or other materials provided with the distribution.
-*  
-*  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-*  ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-*  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-*  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
-*  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
-*  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
-*  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
-*  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
-*  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
-*  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-*********************************************************************************/
-
-
-
-#ifndef SYSCONFIG_H
-#define SYSCONFIG_H
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <cstdlib>
-#include <stdint.h>
-#include "PrintMacros.h"
-#ifdef __APPLE__
-#include <sys/types.h>
-#endif
-
-//SystemConfiguration.h
-//
-
-
-#define LEN_DEF 8
-#define MS_BUFFER
-
-#define RETURN_TRANSACTIONS
-//#define DATA_STORAGE
-//#define DATA_STORAGE_SSA
-//#define DATA_RELIABILITY_ECC
-//#define DATA_RELIABILITY_CHIPKILL
-
-#ifdef DATA_STORAGE_SSA
-	#define DATA_STORAGE
-#endif
-
-#ifdef DATA_RELIABILITY_CHIPKILL
-	#define DATA_RELIABILITY_ECC
-#endif
-
-#ifdef DATA_RELIABILITY_ECC
-	#define DATA_STORAGE
-#endif
-
-
-namespace DRAMSim
-{
-
-	typedef unsigned char byte;
-
-	extern bool SHOW_SIM_OUTPUT;
-
-	extern bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
-
-	extern bool DEBUG_INI_READER;
-
-	extern bool DEBUG_TRANS_Q;
-	extern bool DEBUG_CMD_Q;
-	extern bool DEBUG_ADDR_MAP;
-	extern bool DEBUG_BANKSTATE;
-	extern bool SET_IDLE; //libing
-	extern bool SET_CLOSE; //libing
-	extern bool DEBUG_BUS;
-	extern bool DEBUG_BANKS;
-	extern bool DEBUG_POWER;
-	extern bool USE_LOW_POWER;
-	extern bool VIS_FILE_OUTPUT;
-
-	extern uint64_t TOTAL_STORAGE;
-	extern unsigned NUM_BANKS;
-	extern unsigned NUM_RANKS;
-	extern unsigned NUM_CHANS;
-	extern unsigned NUM_ROWS;
-	extern unsigned NUM_COLS;
-	extern unsigned DEVICE_WIDTH;
-
-	extern unsigned SUBARRAY_DATA_BYTES;
-	extern unsigned TRANS_DATA_BYTES;
-
-	//in nanoseconds
-	extern unsigned REFRESH_PERIOD;
-	extern float tCK;
-
-	extern unsigned CL;
-	extern unsigned AL;
-	#define RL (CL+AL)
+	public:
+		bool VERIFICATION_OUTPUT; // output suitable to feed to modelsim
+
+		bool DEBUG_TRANS_Q;
+		bool DEBUG_CMD_Q;
+		bool DEBUG_ADDR_MAP;
+		bool DEBUG_BANKSTATE;
+		bool SET_IDLE; //libing
+		bool SET_CLOSE; //libing
+		bool DATA_COMPARE_WRITE; //only program the cells a write changes (DATA_STORAGE)
+		bool FLIP_N_WRITE;
+		bool PARTIAL_WRITE; //cache write backs only program their dirty words
+		bool TRACK_WEAR; //count writes per line without wear leveling
+		bool DEBUG_BUS;
+		bool DEBUG_BANKS;
+		bool DEBUG_POWER;
+		bool USE_LOW_POWER;
+		bool VIS_FILE_OUTPUT;
+
+		uint64_t TOTAL_STORAGE;
+		unsigned NUM_BANKS;
+		unsigned NUM_RANKS;
+		unsigned NUM_CHANS;
+		unsigned NUM_ROWS;
+		unsigned NUM_COLS;
+		unsigned DEVICE_WIDTH;
+
+		unsigned SUBARRAY_DATA_BYTES;
+		unsigned TRANS_DATA_BYTES;
+
+		//in nanoseconds
+		unsigned REFRESH_PERIOD;
+		float tCK;
+		//PCM: time after a write until the cells have to be rewritten (0 = no scrubbing)
+		float DRIFT_WINDOW;
+		//fault injection (DATA_STORAGE): per-bit error rates, 0 = off
+		float FAULT_WRITE_BER; //per programmed bit
+		float FAULT_DRIFT_BER; //per stored bit and second since it was programmed
+		float FAULT_BUS_BER; //per transferred bit
+		unsigned FAULT_SEED;
+
+		unsigned CL;
+		unsigned AL;
+		unsigned BL;
+		unsigned tRAS;
+		unsigned tRCD;
+		unsigned tRRD;
+		unsigned tRC;
+		unsigned tRP;
+		unsigned tCCD;
+		unsigned tRTP;
+		unsigned tWTR;
+		unsigned tWR;
+		unsigned tRTRS;
+		unsigned tRFC;
+		unsigned tFAW;
+		unsigned tCKE;
+		unsigned tXP;
+
+		unsigned tCMD;
+
+		unsigned IDD0;
+		unsigned IDD1;
+		unsigned IDD2P;
+		unsigned IDD2Q;
+		unsigned IDD2N;
+		unsigned IDD3Pf;
+		unsigned IDD3Ps;
+		unsigned IDD3N;
+		unsigned IDD4W;
+		unsigned IDD4R;
+		unsigned IDD5;
+		unsigned IDD6;
+		unsigned IDD6L;
+		unsigned IDD7;
+		float Vdd;
+		unsigned NUM_DEVICES;
+
+		//for PCM energy libing, in pJ per programmed/sensed bit
+		float WR_ENERGY_BIT;		//RESET energy
+		float SET_ENERGY_BIT;
+		float RD_ENERGY_BIT;
+
+		unsigned ECC_DATA_BUS_BITS;
+		unsigned JEDEC_DATA_BUS_BITS;
+
+		//Memory Controller related parameters
+		unsigned TRANS_QUEUE_DEPTH;
+		unsigned CMD_QUEUE_DEPTH;
+		unsigned PENDING_QUEUE_DEPTH; //MS_BUFFER overflow queue of each channel, 0 = unbounded
+
+		uint64_t EPOCH_LENGTH;
+		unsigned HISTOGRAM_BIN_SIZE;
+
+		unsigned TOTAL_ROW_ACCESSES;
+
+		//wear leveling
+		unsigned GAP_MOVE_INTERVAL;
+		unsigned START_GAP_REGION_LINES;
+		unsigned WEAR_LEVELING_SEED;
+		float PCM_ENDURANCE;
+
+		//hybrid DRAM cache + PCM (HybridMemorySystem)
+		std::string HYBRID_CACHE_DEVICE;
+		std::string HYBRID_CACHE_SYSTEM;
+		unsigned HYBRID_CACHE_MEGS;
+		unsigned HYBRID_CACHE_ASSOC;
+		unsigned HYBRID_CACHE_BLOCK_BYTES;
+		std::string HYBRID_TAG_STORE;
+		std::string HYBRID_FILL_POLICY;
+		std::string HYBRID_WRITE_POLICY;
+
+		//sampled simulation (trace records), SAMPLE_PERIOD = 0 simulates every record in detail
+		unsigned SAMPLE_PERIOD;
+		unsigned SAMPLE_WINDOW;
+		unsigned SAMPLE_WARMUP;
+
+		//caches in front of the memory system (BlSim::CacheHierarchy), sizes in KB, 0 = no such level
+		unsigned CACHE_BLOCK_BYTES;
+		unsigned CACHE_L1_KB;
+		unsigned CACHE_L1_ASSOC;
+		unsigned CACHE_L2_KB;
+		unsigned CACHE_L2_ASSOC;
+		unsigned CACHE_LLC_KB;
+		unsigned CACHE_LLC_ASSOC;
+		std::string CACHE_L1_REPLACEMENT;
+		std::string CACHE_L2_REPLACEMENT;
+		std::string CACHE_LLC_REPLACEMENT;
+		std::string CACHE_INCLUSION;
+
+		//prefetcher of each core, between its caches and the memory system
+		std::string PREFETCHER;
+		unsigned PREFETCH_DEGREE;
+		unsigned PREFETCH_TABLE;
+		unsigned PREFETCH_BUFFER;
+		unsigned PREFETCH_QUEUE;
+
+		//how the cores replay their traces
+		std::string CORE_MODEL;
+		unsigned CORE_WIDTH; //closed loop: instructions dispatched and retired per cycle
+		unsigned CORE_ROB;   //instructions in flight behind the oldest read miss
+		unsigned CORE_MSHR;  //read misses in flight
+
+		//synthetic traffic of the -g generators
+		uint64_t GEN_REQUESTS; //per generator, 0 = no end
+		float GEN_RATE;        //requests per CPU cycle (per instruction closed loop)
+		float GEN_READ_FRACTION;
+		unsigned GEN_FOOTPRINT_MB;
+		unsigned GEN_STRIDE;   //bytes
+		float GEN_ZIPF;        //skew of the zipf pattern
+		unsigned GEN_SEED;
+
+		std::string ROW_BUFFER_POLICY;
+		std::string SCHEDULING_POLICY;
+		std::string ADDRESS_MAPPING_SCHEME;
+		std::string QUEUING_STRUCTURE;
+		std::string WEAR_LEVELING;
+		std::string DEVICE_TYPE;
+
+		RowBufferPolicy rowBufferPolicy;
+		SchedulingPolicy schedulingPolicy;
+		AddressMappingScheme addressMappingScheme;
+		QueuingStructure queuingStructure;
+		WearLevelingScheme wearLevelingScheme;
+		DeviceType deviceType;
+	};
+
+	//The timing shorthands below read the Config named 'config' of the scope
+	//they are used in (every class that schedules commands has one)
+	#define RL (config.CL+config.AL)
 	#define WL (RL-1)
-	extern unsigned BL;
-	extern unsigned tRAS;
-	extern unsigned tRCD;
-	extern unsigned tRRD;
-	extern unsigned tRC;
-	extern unsigned tRP;
-	extern unsigned tCCD;
-	extern unsigned tRTP;
-	extern unsigned tWTR;
-	extern unsigned tWR;
-	#define SET (tWR*8)
-	extern unsigned tRTRS;
-	extern unsigned tRFC;
-	extern unsigned tFAW;
-	extern unsigned tCKE;
-	extern unsigned tXP;
-
-	extern unsigned tCMD;
-
-	extern unsigned IDD0;
-	extern unsigned IDD1;
-	extern unsigned IDD2P;
-	extern unsigned IDD2Q;
-	extern unsigned IDD2N;
-	extern unsigned IDD3Pf;
-	extern unsigned IDD3Ps;
-	extern unsigned IDD3N;
-	extern unsigned IDD4W;
-	extern unsigned IDD4R;
-	extern unsigned IDD5;
-	extern unsigned IDD6;
-	extern unsigned IDD6L;
-	extern unsigned IDD7;
-	extern float Vdd;
-	extern uint64_t WarmupCycle;
-	extern unsigned NUM_DEVICES;
+	#define SET (config.tWR*8)
 
 	//same bank
-	#define READ_TO_PRE_DELAY (AL+BL/2+max(((int)tRTP),2)-2)
-	#define WRITE_TO_PRE_DELAY (WL+BL/2+tWR)
-
-	#define SET_TO_PRE_DELAY (WL+BL/2+SET)
-
-	#define READ_TO_WRITE_DELAY (RL+BL/2+tRTRS-WL)
-	#define READ_AUTOPRE_DELAY (AL+tRTP+tRP)
-	#define WRITE_AUTOPRE_DELAY (WL+BL/2+tWR+tRP)
-
-	#define SET_AUTOPRE_DELAY (WL+BL/2+SET+tRP)
-
-
-	#define WRITE_TO_READ_DELAY_B (WL+BL/2+tWTR) //interbank
-	#define WRITE_TO_READ_DELAY_R (WL+BL/2+tRTRS-RL) //interrank
+	#define READ_TO_PRE_DELAY (config.AL+config.BL/2+max(((int)config.tRTP),2)-2)
+	#define WRITE_TO_PRE_DELAY (WL+config.BL/2+config.tWR)
 
-	//for PCM energy libing
-	#define WR_ENERGY_BIT 					//RESET energy
-	#define RD_ENERGY_BIT
-	#define SET_ENERGY_BIT (8*WR_ENERGY_BIT)
+	#define SET_TO_PRE_DELAY (WL+config.BL/2+SET)
 
-	extern unsigned ECC_DATA_BUS_BITS;
-	extern unsigned JEDEC_DATA_BUS_BITS;
+	#define READ_TO_WRITE_DELAY (RL+config.BL/2+config.tRTRS-WL)
+	#define READ_AUTOPRE_DELAY (config.AL+config.tRTP+config.tRP)
+	#define WRITE_AUTOPRE_DELAY (WL+config.BL/2+config.tWR+config.tRP)
 
-	//Memory Controller related parameters
-	extern unsigned TRANS_QUEUE_DEPTH;
-	extern unsigned CMD_QUEUE_DEPTH;
-
-	extern uint64_t EPOCH_LENGTH;
-	extern unsigned HISTOGRAM_BIN_SIZE;
-
-	extern unsigned TOTAL_ROW_ACCESSES;
-
-
-	typedef enum
-	{
-		k6,
-		k7,
-		mase,
-		pin,
-		spec,
-		DGpin
-	} TraceType;
-
-	typedef enum
-	{
-		Scheme1,
-		Scheme2,
-		Scheme3,
-		Scheme4,
-		Scheme5,
-		Scheme6,
-		Scheme7
-	} AddressMappingScheme;
-
-	// used in MemoryController and CommandQueue
-	typedef enum
-	{
-		OpenPage,
-		ClosePage
-	} RowBufferPolicy;
-
-	// Only used in CommandQueue
-	typedef enum
-	{
-		PerRank,
-		PerRankPerBank
-	} QueuingStructure;
-
-	typedef enum
-	{
-		RankThenBankRoundRobin,
-		BankThenRankRoundRobin
-	} SchedulingPolicy;
+	#define SET_AUTOPRE_DELAY (WL+config.BL/2+SET+config.tRP)
 
 
-	extern std::string ROW_BUFFER_POLICY;
-	extern std::string SCHEDULING_POLICY;
-	extern std::string ADDRESS_MAPPING_SCHEME;
-	extern std::string QUEUING_STRUCTURE;
+	//the same two delays for a write whose cells take 'recovery' cycles to program
+	#define WRITE_TO_PRE_DELAY_N(recovery) (WL+config.BL/2+(recovery))
+	#define WRITE_AUTOPRE_DELAY_N(recovery) (WL+config.BL/2+(recovery)+config.tRP)
 
-	extern RowBufferPolicy rowBufferPolicy;
-	extern SchedulingPolicy schedulingPolicy;
-	extern AddressMappingScheme addressMappingScheme;
-	extern QueuingStructure queuingStructure;
+	#define WRITE_TO_READ_DELAY_B (WL+config.BL/2+config.tWTR) //interbank
+	#define WRITE_TO_READ_DELAY_R (WL+config.BL/2+config.tRTRS-RL) //interrank
 
 	//
 	//FUNCTIONS
@@ -529,4 +369,3 @@ namespace DRAMSim
 
 #endif
 
->>>>>>> ca95697305ca6add4791981a097ec7be746744fa
@@ -38,12 +38,18 @@
 #include <getopt.h>
 #include "Simulator.h"
 #include "SimulatorIO.h"
+#include "SweepRunner.h"
+#include "TraceGenerator.h"
 
 using namespace DRAMSim;
 int main(int argc, char **argv)
 {
 
 	SimulatorIO *simIO = new SimulatorIO();
+	string sweepFilename;
+	string generators;
+	string loadRates;
+	unsigned jobs = 0;
 
 	//getopt stuff
 	while (1)
@@ -52,6 +58,7 @@ int main(int argc, char **argv)
 		{
 			{"deviceini", required_argument, 0, 'd'},
 			{"tracefile", required_argument, 0, 't'},
+			{"generate", required_argument, 0, 'g'},
 			{"systemini", required_argument, 0, 's'},
 
 			{"pwd", required_argument, 0, 'p'},
@@ -61,11 +68,16 @@ int main(int argc, char **argv)
 			{"help", no_argument, 0, 'h'},
 			{"size", required_argument, 0, 'S'},
 			{"visfile", required_argument, 0, 'v'},
+			{"sweep", required_argument, 0, 'w'},
+			{"jobs", required_argument, 0, 'j'},
+			{"load-curve", required_argument, 0, 'l'},
+			{"checkpoint", required_argument, 0, 'k'},
+			{"restore", required_argument, 0, 'r'},
 			{0, 0, 0, 0}
 		};
 
 		int option_index=0; //for getopt
-		int c = getopt_long (argc, argv, "t:s:c:d:o:p:S:v:qn", long_options, &option_index);
+		int c = getopt_long (argc, argv, "t:g:s:c:d:o:p:S:v:w:j:l:k:r:qn", long_options, &option_index);
 		if (c == -1)
 		{
 			break;
@@ -92,6 +104,9 @@ int main(int argc, char **argv)
 		case 't':
 			simIO->traceFilename = string(optarg);
 			break;
+		case 'g':
+			generators += (generators.length() > 0 ? "," : "") + string(optarg);
+			break;
 		case 's':
 			simIO->systemIniFilename = string(optarg);
 			break;
@@ -119,6 +134,21 @@ int main(int argc, char **argv)
 		case 'v':
 			simIO->visFilename = string(optarg);
 			break;
+		case 'w':
+			sweepFilename = string(optarg);
+			break;
+		case 'j':
+			jobs = atoi(optarg);
+			break;
+		case 'l':
+			loadRates = string(optarg);
+			break;
+		case 'k':
+			simIO->saveCheckpointFilename = string(optarg);
+			break;
+		case 'r':
+			simIO->restoreCheckpointFilename = string(optarg);
+			break;
 		case '?':
 			simIO->usage();
 			exit(-1);
@@ -127,10 +157,45 @@ int main(int argc, char **argv)
 	}
 
 
+	//the generators come after the trace files, each one more trace
+	size_t start = 0;
+	while (start < generators.length())
+	{
+		size_t comma = generators.find(',', start);
+		if (comma == string::npos)
+		{
+			comma = generators.length();
+		}
+		if (simIO->traceFilename.length() > 0)
+		{
+			simIO->traceFilename += ",";
+		}
+		simIO->traceFilename += TraceGenerator::PREFIX + generators.substr(start, comma - start);
+		start = comma + 1;
+	}
+
+	if (loadRates.length() > 0)
+	{
+		SweepRunner curves(simIO, sweepFilename, jobs, SweepRunner::parseRates(loadRates));
+		curves.run();
+		return 0;
+	}
+
+	if (sweepFilename.length() > 0)
+	{
+		SweepRunner sweep(simIO, sweepFilename, jobs);
+		sweep.run();
+		return 0;
+	}
+
 	Simulator *simulator = new Simulator(simIO);
 	simulator->setup();
 	simulator->start();
 
-	simulator->report(true);
+	//a checkpoint run stops after the warmup, the runs restoring it report
+	if (simIO->saveCheckpointFilename.length() == 0)
+	{
+		simulator->report(true);
+	}
 
 }
@@ -0,0 +1,193 @@
+//TraceGenerator.cpp
+//
+//Synthetic trace records: stream, random, stride, zipf and row conflicts
+//
+
+#include "TraceGenerator.h"
+#include "Checkpoint.h"
+#include <cmath>
+#include <algorithm>
+
+namespace DRAMSim
+{
+	const string TraceGenerator::PREFIX = "gen:";
+
+	//the random numbers of the addresses and of the read/write mix
+	static uint64_t splitmix64(uint64_t &state)
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	TraceGenerator::TraceGenerator(const string &name, unsigned source, const Config &config, MemorySystem *memorySystem) :
+		requests(config.GEN_REQUESTS),
+		rate(config.GEN_RATE),
+		readFraction(config.GEN_READ_FRACTION),
+		blockBytes(config.TRANS_DATA_BYTES),
+		strideBytes(config.GEN_STRIDE),
+		count(0),
+		theta(config.GEN_ZIPF),
+		zetaN(0),
+		alpha(0),
+		eta(0)
+	{
+		if (name == "stream")
+		{
+			pattern = STREAM;
+		}
+		else if (name == "random")
+		{
+			pattern = RANDOM;
+		}
+		else if (name == "stride")
+		{
+			pattern = STRIDE;
+		}
+		else if (name == "zipf")
+		{
+			pattern = ZIPF;
+		}
+		else if (name == "conflict")
+		{
+			pattern = CONFLICT;
+		}
+		else
+		{
+			ERROR("Unknown generator '"<<name<<"'; valid options are 'stream', 'random', 'stride', 'zipf' or 'conflict'");
+			exit(-1);
+		}
+		if (rate <= 0 || readFraction < 0 || readFraction > 1)
+		{
+			ERROR("GEN_RATE must be above 0 and GEN_READ_FRACTION between 0 and 1");
+			exit(-1);
+		}
+		uint64_t footprint = (uint64_t) config.GEN_FOOTPRINT_MB << 20;
+		if (!isPowerOfTwo(config.GEN_FOOTPRINT_MB) || footprint < blockBytes)
+		{
+			ERROR("GEN_FOOTPRINT_MB must be a power of two (got "<<config.GEN_FOOTPRINT_MB<<")");
+			exit(-1);
+		}
+		blocks = footprint / blockBytes;
+		base = footprint * source;
+		rngState = (uint64_t) config.GEN_SEED * 0x100000001B3ULL + source;
+
+		if (pattern == STRIDE && (strideBytes == 0 || strideBytes % blockBytes != 0))
+		{
+			ERROR("GEN_STRIDE must be a multiple of the transaction size, "<<blockBytes<<" bytes");
+			exit(-1);
+		}
+		if (pattern == ZIPF)
+		{
+			if (theta <= 0 || theta >= 1)
+			{
+				ERROR("GEN_ZIPF must be between 0 and 1 (got "<<theta<<")");
+				exit(-1);
+			}
+			for (uint64_t i = 1; i <= blocks; i++)
+			{
+				zetaN += 1.0 / pow((double) i, theta);
+			}
+			double zeta2 = 1.0 + 1.0 / pow(2.0, theta);
+			alpha = 1.0 / (1.0 - theta);
+			eta = (1.0 - pow(2.0 / blocks, 1.0 - theta)) / (1.0 - zeta2 / zetaN);
+		}
+		if (pattern == CONFLICT)
+		{
+			//the smallest power of two step that stays in the bank of the
+			//first block but moves to another row
+			unsigned chan, rank, bank, row, col;
+			unsigned chan2, rank2, bank2, row2, col2;
+			memorySystem->addressMapping(base, chan, rank, bank, row, col);
+			strideBytes = 0;
+			for (uint64_t step = blockBytes; step != 0 && step < (1ULL << 48); step <<= 1)
+			{
+				memorySystem->addressMapping(base + step, chan2, rank2, bank2, row2, col2);
+				if (chan2 == chan && rank2 == rank && bank2 == bank && row2 != row)
+				{
+					strideBytes = step;
+					break;
+				}
+			}
+			if (strideBytes == 0)
+			{
+				ERROR("The address mapping has no step to another row of the same bank");
+				exit(-1);
+			}
+			//the rows of the bank, from the first block on
+			blocks = config.NUM_ROWS;
+		}
+	}
+
+	double TraceGenerator::uniform()
+	{
+		return (splitmix64(rngState) >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	uint64_t TraceGenerator::nextBlock()
+	{
+		switch (pattern)
+		{
+		case STREAM:
+			return count & (blocks - 1);
+		case RANDOM:
+			return splitmix64(rngState) & (blocks - 1);
+		case STRIDE:
+			return (count * (strideBytes / blockBytes)) & (blocks - 1);
+		case ZIPF:
+		{
+			double u = uniform();
+			double uz = u * zetaN;
+			uint64_t rank;
+			if (uz < 1.0)
+			{
+				rank = 0;
+			}
+			else if (uz < 1.0 + pow(0.5, theta))
+			{
+				rank = 1;
+			}
+			else
+			{
+				rank = (uint64_t) (blocks * pow(eta * u - eta + 1.0, alpha));
+			}
+			//an odd multiplier is a permutation of the blocks: the hot
+			//ones do not all sit in the same rows
+			return (std::min(rank, blocks - 1) * 0x9E3779B97F4A7C15ULL) & (blocks - 1);
+		}
+		case CONFLICT:
+		default:
+			return 0;
+		}
+	}
+
+	bool TraceGenerator::next(TraceRecord &record)
+	{
+		if (requests != 0 && count >= requests)
+		{
+			return false;
+		}
+		if (pattern == CONFLICT)
+		{
+			record.address = base + (count % blocks) * strideBytes;
+		}
+		else
+		{
+			record.address = base + nextBlock() * blockBytes;
+		}
+		record.clockCycle = (uint64_t) (count / rate);
+		record.transactionType = uniform() < readFraction ? Transaction::DATA_READ : Transaction::DATA_WRITE;
+		record.len = LEN_DEF;
+		record.dataOffset = 0;
+		record.dataBytes = 0;
+		count++;
+		return true;
+	}
+
+	void TraceGenerator::checkpoint(Checkpoint &cp)
+	{
+		cp.io(count);
+		cp.io(rngState);
+	}
+}
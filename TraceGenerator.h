@@ -0,0 +1,83 @@
+#ifndef TRACEGENERATOR_H
+#define TRACEGENERATOR_H
+
+//TraceGenerator.h
+//
+//Synthetic traffic in place of a trace file. A generator is a trace named
+//"gen:<pattern>" (-g <pattern> on the command line); it makes its records as
+//they are needed, so it merges with trace files and other generators like any
+//trace. Request k comes at cycle k / GEN_RATE (the instruction number, closed
+//loop); it is a read with probability GEN_READ_FRACTION. The addresses are
+//transaction aligned, within GEN_FOOTPRINT_MB; generator number i starts at
+//i times the footprint, so the generators of a mix do not share data.
+//
+//  stream    one block after the other
+//  random    uniformly distributed blocks
+//  stride    GEN_STRIDE bytes apart
+//  zipf      hot spots: block ranks with a zipf distribution of skew
+//            GEN_ZIPF (Gray et al., SIGMOD 1994), scattered over the footprint
+//  conflict  a new row of the same bank every time, the worst case of the
+//            row buffers
+//
+//The records go through the caches like those of a trace; set the cache
+//sizes to 0 for the memory system to see every one of them.
+//
+
+#include "SimulatorIO.h"
+#include "MemorySystem.h"
+
+namespace DRAMSim
+{
+	class TraceGenerator
+	{
+	public:
+		//name is the pattern; source is the number of the generator among the traces
+		TraceGenerator(const string &name, unsigned source, const Config &config, MemorySystem *memorySystem);
+
+		//the trace name of a generator starts with this
+		static const string PREFIX;
+		static bool isGenerator(const string &traceName)
+		{
+			return traceName.compare(0, PREFIX.length(), PREFIX) == 0;
+		}
+
+		//false once GEN_REQUESTS were made
+		bool next(TraceRecord &record);
+		void checkpoint(Checkpoint &cp);
+
+	private:
+		typedef enum
+		{
+			STREAM,
+			RANDOM,
+			STRIDE,
+			ZIPF,
+			CONFLICT
+		} Pattern;
+
+		//the block number of request 'count'
+		uint64_t nextBlock();
+		//53 random bits, in [0,1)
+		double uniform();
+
+		Pattern pattern;
+		uint64_t requests;
+		double rate;
+		double readFraction;
+		unsigned blockBytes;
+		uint64_t base;
+		uint64_t blocks; //in the footprint, a power of two
+		uint64_t strideBytes; //the distance of stride and conflict requests
+
+		uint64_t count; //the requests made so far
+		uint64_t rngState;
+
+		//the zipf sampler: the constants of Gray et al.
+		double theta;
+		double zetaN;
+		double alpha;
+		double eta;
+	};
+}
+
+#endif
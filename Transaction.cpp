@@ -39,21 +39,70 @@
 #include "BusPacket.h"
 
 #include "SimulatorIO.h"
+#include "Checkpoint.h"
 namespace DRAMSim
 {
 using std::hex;
 using std::dec;
+	//a freed transaction holds the link to the next free one; each thread
+	//(one simulation of a sweep) has its own list, so no locking is needed
+	struct TransactionPool
+	{
+		void *freeList;
+		bool open;
+		TransactionPool() : freeList(NULL), open(true) {}
+		~TransactionPool()
+		{
+			while (freeList != NULL)
+			{
+				void *next = *(void **)freeList;
+				::operator delete(freeList);
+				freeList = next;
+			}
+			open = false;
+		}
+	};
+	static thread_local TransactionPool transactionPool;
+
+	void *Transaction::operator new(size_t size)
+	{
+		TransactionPool &pool = transactionPool;
+		if (size != sizeof(Transaction) || pool.freeList == NULL)
+		{
+			return ::operator new(size);
+		}
+		void *p = pool.freeList;
+		pool.freeList = *(void **)p;
+		return p;
+	}
+
+	void Transaction::operator delete(void *p)
+	{
+		TransactionPool &pool = transactionPool;
+		if (p == NULL)
+		{
+			return;
+		}
+		if (!pool.open)
+		{
+			//freed while the thread exits
+			::operator delete(p);
+			return;
+		}
+		*(void **)p = pool.freeList;
+		pool.freeList = p;
+	}
+
 	Transaction::Transaction(TransactionType transType, uint64_t addr, DataPacket *dat, size_t len, uint64_t time) :
-		transactionType(transType),	address(addr), data(dat), len(len), timeTraced(time)
+		transactionType(transType),	address(addr), data(dat), len(len), timeTraced(time), dirtyMask(0), source(0)
 	{
-		alignAddress();
 	}
 
 
-	void Transaction::alignAddress()
+	void Transaction::alignAddress(unsigned transactionBytes)
 	{
 		// zero out the low order bits which correspond to the size of a transaction
-		unsigned throwAwayBits = dramsim_log2(TRANS_DATA_BYTES);
+		unsigned throwAwayBits = dramsim_log2(transactionBytes);
 
 		address >>= throwAwayBits;
 		address <<= throwAwayBits;
@@ -65,7 +114,9 @@ using std::dec;
 		  data(NULL),
 		  timeAdded(t.timeAdded),
 		  timeReturned(t.timeReturned),
-		  timeTraced(t.timeTraced)
+		  timeTraced(t.timeTraced),
+		  dirtyMask(t.dirtyMask),
+		  source(t.source)
 	{
 #ifdef DATA_STORAGE
 		ERROR("Data storage is really outdated and these copies happen in an \n improper way, which will eventually cause problems. Please send an \n email to dramninjas [at] gmail [dot] com if you need data storage");
@@ -89,7 +140,7 @@ using std::dec;
 		}
 	}
 
-	BusPacket::BusPacketType Transaction::getBusPacketType()
+	BusPacket::BusPacketType Transaction::getBusPacketType(RowBufferPolicy rowBufferPolicy)
 	{
 		switch (transactionType)
 		{
@@ -130,5 +181,31 @@ using std::dec;
 		}
 		exit(1);
 	}
+
+	void Transaction::checkpoint(Checkpoint &cp)
+	{
+		cp.io(transactionType);
+		cp.io(address);
+		cp.io(len);
+		cp.io(data);
+		cp.io(timeAdded);
+		cp.io(timeReturned);
+		cp.io(timeTraced);
+		cp.io(dirtyMask);
+		cp.io(source);
+	}
+
+#ifdef RETURN_TRANSACTIONS
+	void TransactionReceiver::checkpoint(Checkpoint &cp)
+	{
+		cp.io(pendingReadRequests);
+		cp.io(pendingWriteRequests);
+		cp.io(pendingReadCores);
+		cp.io(counter);
+		cp.io(readsDone);
+		cp.io(writesDone);
+		cp.io(readCycles);
+	}
+#endif
 }
 
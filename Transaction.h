@@ -38,6 +38,7 @@
 #include "SystemConfiguration.h"
 #include "BusPacket.h"
 #include "DataPacket.h"
+#include "Callback.h"
 #include <map>
 #include <list>
 
@@ -49,6 +50,7 @@ namespace DRAMSim
 
 	using std::list;
 	using std::map;
+	class Checkpoint;
 	class Transaction
 	{
 		Transaction();
@@ -68,14 +70,27 @@ namespace DRAMSim
 		uint64_t timeAdded;
 		uint64_t timeReturned;
 		uint64_t timeTraced;
+		//the 8 byte words of the line a write changes (PARTIAL_WRITE), 0 for the whole line
+		uint64_t dirtyMask;
+		//the trace (core) a trace record came from
+		unsigned source;
 		//functions
 		Transaction(TransactionType transType, uint64_t addr, DataPacket *data, size_t len=LEN_DEF, uint64_t time = 0);
 		Transaction(const Transaction &t);
 
-		void alignAddress();
-		BusPacket::BusPacketType getBusPacketType();
+		//zero the address bits below the transaction size of the memory system
+		//the transaction goes to (done when it is added to one)
+		void alignAddress(unsigned transactionBytes);
+		BusPacket::BusPacketType getBusPacketType(RowBufferPolicy rowBufferPolicy);
 
 		void print();
+		void checkpoint(Checkpoint &cp);
+
+		//transactions are made and freed once per request (trace records,
+		//write backs, hybrid fills), so freed ones are kept on a per thread
+		//list and handed out again instead of going back to the heap
+		static void *operator new(size_t size);
+		static void operator delete(void *p);
 	};
 
 
@@ -85,18 +100,32 @@ namespace DRAMSim
 		private:
 			map<uint64_t, list<uint64_t> > pendingReadRequests;
 			map<uint64_t, list<uint64_t> > pendingWriteRequests;
+			//the core each pending read belongs to, in the same order
+			map<uint64_t, list<unsigned> > pendingReadCores;
 			unsigned counter;
 
 		public:
-			TransactionReceiver():counter(0){};
+			static const unsigned NO_CORE = (unsigned)-1;
+
+			TransactionReceiver():counter(0),coreReadDone(NULL),readsDone(0),writesDone(0),readCycles(0){};
+			~TransactionReceiver() { delete coreReadDone; }
+
+			//called with (core, address, cycle) when a read of a core completes
+			TransactionCompleteCB *coreReadDone;
 
-			void addPending(const Transaction *t, uint64_t cycle)
+			//completed requests and the summed read latency, for the sampled windows
+			uint64_t readsDone;
+			uint64_t writesDone;
+			uint64_t readCycles;
+
+			void addPending(const Transaction *t, uint64_t cycle, unsigned core = NO_CORE)
 			{
 				// C++ lists are ordered, so the list will always push to the back and
 				// remove at the front to ensure ordering
 					if (t->transactionType == Transaction::DATA_READ)
 					{
 							pendingReadRequests[t->address].push_back(cycle);
+							pendingReadCores[t->address].push_back(core);
 					//		cout<<"pendingReadRequests  size is "<<pendingWriteRequests.size()<<endl;
 					}
 					else if (t->transactionType == Transaction::DATA_WRITE)
@@ -131,10 +160,19 @@ namespace DRAMSim
 					}
 				}
 
-				//uint64_t added_cycle = pendingReadRequests[address].front();
+				uint64_t added_cycle = it->second.front();
 				//uint64_t latency = done_cycle - added_cycle;
+				readCycles += done_cycle - added_cycle;
+				readsDone++;
 
 				pendingReadRequests[address].pop_front();
+				list<unsigned> &cores = pendingReadCores[address];
+				unsigned core = cores.front();
+				cores.pop_front();
+				if (core != NO_CORE && coreReadDone != NULL)
+				{
+					(*coreReadDone)(core, address, done_cycle);
+				}
 				//cout << "Read Callback:  0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<added_cycle<<")"<<endl;
 				counter--;
 			}
@@ -163,6 +201,7 @@ namespace DRAMSim
 			//	uint64_t latency = done_cycle - added_cycle;
 
 				pendingWriteRequests[address].pop_front();
+				writesDone++;
 		/*		if (DEBUG_ADDR_MAP)
 				{
 				cout << "Write Callback: 0x"<< std::hex << address << std::dec << " latency="<<latency<<"cycles ("<< done_cycle<< "->"<<added_cycle<<")"<<std::endl;
@@ -174,6 +213,33 @@ namespace DRAMSim
 			{
 				return (counter==0)?false:true;
 			}
+
+			//a read of address was added and has not completed yet
+			bool readPending(uint64_t address) const
+			{
+				map<uint64_t, list<uint64_t> >::const_iterator it = pendingReadRequests.find(address);
+				return it != pendingReadRequests.end() && !it->second.empty();
+			}
+
+			//a read of address was added for core and has not completed yet
+			bool readPending(uint64_t address, unsigned core) const
+			{
+				map<uint64_t, list<unsigned> >::const_iterator it = pendingReadCores.find(address);
+				if (it == pendingReadCores.end())
+				{
+					return false;
+				}
+				for (list<unsigned>::const_iterator c = it->second.begin(); c != it->second.end(); c++)
+				{
+					if (*c == core)
+					{
+						return true;
+					}
+				}
+				return false;
+			}
+
+			void checkpoint(Checkpoint &cp);
 	};
 #endif
 
@@ -0,0 +1,274 @@
+//WearLeveler.cpp
+//
+//Start-Gap / region based randomized Start-Gap wear leveling and per line
+//write counters
+//
+
+#include "WearLeveler.h"
+#include "Checkpoint.h"
+
+namespace DRAMSim
+{
+	//seeds the keys of the address randomizer
+	static uint64_t splitmix64(uint64_t &state)
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	WearLeveler::WearLeveler(const Config &config) :
+		config(config),
+		wearShift(0),
+		wearRandom(config.WEAR_LEVELING_SEED),
+		demandWrites(0),
+		wrappedWrites(0),
+		gapMoves(0)
+	{
+		//same line granularity as MemorySystem::addressMapping
+		unsigned byteOffsetWidth = dramsim_log2(config.JEDEC_DATA_BUS_BITS/8);
+		unsigned colLowBitWidth = dramsim_log2(config.TRANS_DATA_BYTES) - byteOffsetWidth;
+		lineOffsetBits = dramsim_log2(config.TRANS_DATA_BYTES);
+		lineBits = dramsim_log2(config.NUM_CHANS) + dramsim_log2(config.NUM_RANKS) + dramsim_log2(config.NUM_BANKS)
+			+ dramsim_log2(config.NUM_ROWS) + dramsim_log2(config.NUM_COLS) - colLowBitWidth;
+		lineMask = (1ULL << lineBits) - 1;
+
+		regionBits = lineBits;
+		if (config.START_GAP_REGION_LINES != 0)
+		{
+			regionBits = dramsim_log2(config.START_GAP_REGION_LINES);
+			if (!isPowerOfTwo(config.START_GAP_REGION_LINES) || regionBits < 2 || regionBits > lineBits)
+			{
+				ERROR("START_GAP_REGION_LINES must be a power of two between 4 and "<<(1ULL << lineBits)<<" (got "<<config.START_GAP_REGION_LINES<<")");
+				exit(-1);
+			}
+		}
+		if (config.wearLevelingScheme != NoWearLeveling && config.GAP_MOVE_INTERVAL == 0)
+		{
+			ERROR("GAP_MOVE_INTERVAL must be at least 1");
+			exit(-1);
+		}
+		regionMask = (1ULL << regionBits) - 1;
+		regionLines = regionMask;
+
+		uint64_t numRegions = 1ULL << (lineBits - regionBits);
+		capacity = config.wearLevelingScheme == NoWearLeveling ? 1ULL << lineBits : numRegions * regionLines;
+		start = vector<uint64_t>(numRegions, 0);
+		//the gap starts at the spare (last) line of every region
+		gap = vector<uint64_t>(numRegions, regionLines);
+		writesSinceMove = vector<unsigned>(numRegions, 0);
+		wear = vector<uint16_t>(1ULL << lineBits, 0);
+
+		//x ^= k0; x *= m0; x ^= x >> s; x *= m1; x ^= x >> s; x ^= k1 (mod 2^lineBits)
+		//each step is invertible, and x ^= x >> s undoes itself for s >= lineBits/2
+		uint64_t seed = config.WEAR_LEVELING_SEED;
+		shiftBits = (lineBits + 1) / 2;
+		for (size_t i=0; i<2; i++)
+		{
+			key[i] = splitmix64(seed) & lineMask;
+			mult[i] = splitmix64(seed) | 1;
+			//Newton iteration for the inverse of an odd number mod 2^64
+			multInverse[i] = mult[i];
+			for (size_t j=0; j<5; j++)
+			{
+				multInverse[i] *= 2 - mult[i] * multInverse[i];
+			}
+		}
+
+		if (config.wearLevelingScheme != NoWearLeveling)
+		{
+			PRINT("Wear leveling: "<<config.WEAR_LEVELING<<", "<<numRegions<<" region(s) of "<<(1ULL << regionBits)
+					<<" lines, gap moves every "<<config.GAP_MOVE_INTERVAL<<" writes; "<<capacity<<" of "
+					<<(1ULL << lineBits)<<" lines usable, one per region is the gap; the lines beyond wrap around");
+		}
+	}
+
+	//a bijection of the usable lines: the bijection of all the lines, again
+	//until it lands on a usable one
+	uint64_t WearLeveler::scramble(uint64_t x) const
+	{
+		do
+		{
+			x ^= key[0];
+			x = (x * mult[0]) & lineMask;
+			x ^= x >> shiftBits;
+			x = (x * mult[1]) & lineMask;
+			x ^= x >> shiftBits;
+			x ^= key[1];
+		} while (x >= capacity);
+		return x;
+	}
+
+	uint64_t WearLeveler::unscramble(uint64_t x) const
+	{
+		do
+		{
+			x ^= key[1];
+			x ^= x >> shiftBits;
+			x = (x * multInverse[1]) & lineMask;
+			x ^= x >> shiftBits;
+			x = (x * multInverse[0]) & lineMask;
+			x ^= key[0];
+		} while (x >= capacity);
+		return x;
+	}
+
+	uint64_t WearLeveler::physicalLine(uint64_t line) const
+	{
+		if (config.wearLevelingScheme == NoWearLeveling)
+		{
+			return line;
+		}
+		//the lines beyond wrap around, like the addresses beyond the memory size
+		if (line >= capacity)
+		{
+			line -= capacity;
+		}
+		if (config.wearLevelingScheme == RandomStartGap)
+		{
+			line = scramble(line);
+		}
+		uint64_t region = line / regionLines;
+		uint64_t la = line % regionLines;
+		uint64_t pa = la + start[region];
+		if (pa >= regionLines)
+		{
+			pa -= regionLines;
+		}
+		if (pa >= gap[region])
+		{
+			pa++;
+		}
+		return (region << regionBits) | pa;
+	}
+
+	uint64_t WearLeveler::remap(uint64_t addr) const
+	{
+		uint64_t line = (addr >> lineOffsetBits) & lineMask;
+		return (addr & ~(lineMask << lineOffsetBits)) | (physicalLine(line) << lineOffsetBits);
+	}
+
+	bool WearLeveler::recordWrite(uint64_t addr, unsigned &region)
+	{
+		uint64_t logicalLine = (addr >> lineOffsetBits) & lineMask;
+		uint64_t line = physicalLine(logicalLine);
+		addWear(line);
+		demandWrites++;
+		wrappedWrites += logicalLine >= capacity;
+
+		if (config.wearLevelingScheme == NoWearLeveling)
+		{
+			return false;
+		}
+		region = line >> regionBits;
+		if (++writesSinceMove[region] < config.GAP_MOVE_INTERVAL)
+		{
+			return false;
+		}
+		writesSinceMove[region] = 0;
+		return true;
+	}
+
+	uint64_t WearLeveler::movingLine(unsigned region) const
+	{
+		//the physical line above the gap (or the spare line when the gap is at the bottom)
+		uint64_t pa = gap[region] == 0 ? regionLines : gap[region] - 1;
+		if (pa > gap[region])
+		{
+			pa--;
+		}
+		uint64_t la = pa + regionLines - start[region];
+		if (la >= regionLines)
+		{
+			la -= regionLines;
+		}
+		uint64_t line = region * regionLines + la;
+		if (config.wearLevelingScheme == RandomStartGap)
+		{
+			line = unscramble(line);
+		}
+		return line << lineOffsetBits;
+	}
+
+	void WearLeveler::moveGap(unsigned region)
+	{
+		uint64_t destination = ((uint64_t)region << regionBits) | gap[region];
+		if (gap[region] == 0)
+		{
+			gap[region] = regionLines;
+			start[region] = start[region] + 1 == regionLines ? 0 : start[region] + 1;
+		}
+		else
+		{
+			gap[region]--;
+		}
+		addWear(destination);
+		gapMoves++;
+	}
+
+	void WearLeveler::addWear(uint64_t line)
+	{
+		if (wearShift > 0 && (splitmix64(wearRandom) & ((1ULL << wearShift) - 1)) != 0)
+		{
+			return;
+		}
+		if (wear[line] == UINT16_MAX)
+		{
+			for (size_t i=0; i<wear.size(); i++)
+			{
+				wear[i] >>= 1;
+			}
+			wearShift++;
+			if ((splitmix64(wearRandom) & 1) != 0)
+			{
+				return;
+			}
+		}
+		wear[line]++;
+	}
+
+	void WearLeveler::printStats(uint64_t elapsedCycles) const
+	{
+		uint64_t maxWear = 0, linesWritten = 0;
+		for (size_t i=0; i<wear.size(); i++)
+		{
+			maxWear = wear[i] > maxWear ? wear[i] : maxWear;
+			linesWritten += wear[i] != 0;
+		}
+		maxWear <<= wearShift;
+		double meanWear = (double)(demandWrites + gapMoves) / wear.size();
+		double seconds = elapsedCycles * config.tCK * 1E-9;
+		const double secondsPerYear = 365.0 * 24 * 3600;
+
+		PRINT(" --- Wear ("<<config.WEAR_LEVELING<<")");
+		PRINT("    demand writes : "<<demandWrites<<"  gap moves : "<<gapMoves<<" ("<<gapMoves<<" extra line writes)");
+		PRINT("    lines written : "<<linesWritten<<" / "<<wear.size());
+		if (wrappedWrites > 0)
+		{
+			PRINT("    writes beyond the "<<capacity<<" usable lines, wrapped around : "<<wrappedWrites);
+		}
+		PRINT("    max wear : "<<maxWear<<(wearShift > 0 ? " (approximate)" : "")<<"  mean wear : "<<meanWear);
+		if (maxWear != 0 && seconds > 0)
+		{
+			double lifetime = config.PCM_ENDURANCE / maxWear * seconds;
+			double idealLifetime = config.PCM_ENDURANCE / meanWear * seconds;
+			PRINT("    max/mean wear : "<<maxWear / meanWear<<" (endurance "<<config.PCM_ENDURANCE<<" writes)");
+			PRINT("    projected lifetime : "<<lifetime<<" s = "<<lifetime / secondsPerYear<<" years, "
+					<<idealLifetime / secondsPerYear<<" years with perfect leveling");
+		}
+	}
+
+	void WearLeveler::checkpoint(Checkpoint &cp)
+	{
+		cp.io(start);
+		cp.io(gap);
+		cp.io(writesSinceMove);
+		cp.io(wear);
+		cp.io(wearShift);
+		cp.io(wearRandom);
+		cp.io(demandWrites);
+		cp.io(wrappedWrites);
+		cp.io(gapMoves);
+	}
+}
@@ -0,0 +1,97 @@
+#ifndef WEARLEVELER_H
+#define WEARLEVELER_H
+
+//WearLeveler.h
+//
+//Start-Gap wear leveling (Qureshi et al., MICRO 2009) placed in front of the
+//address mapping. Every region of 2^n lines keeps one spare line (the gap);
+//every GAP_MOVE_INTERVAL writes to a region the line next to the gap is copied
+//into it and the gap moves down by one, so over time every logical line
+//rotates through every physical line of the region. The remap is two
+//registers per region, so it is O(1) per access.
+//
+//The gap is a real line: a region of 2^n physical lines holds 2^n - 1
+//logical ones, so the memory seen through the wear leveler is one line per
+//region smaller. Logical line i is in region i / (2^n - 1); the lines at the
+//top of the address space that are left over wrap around to the bottom, the
+//way addresses beyond the memory size do, and the report counts the writes
+//that did.
+//
+//With region_start_gap the line address is first passed through a keyed
+//bijection so that hot regions of the address space are spread over all the
+//regions (randomized Start-Gap); it is applied until the result is a usable
+//line (cycle walking), which keeps it a bijection of the usable lines.
+//
+//The wear of a line is a 16 bit counter in units of 2^wearShift writes. When
+//one reaches its maximum all of them are halved and wearShift grows; from then
+//on a write adds a unit with probability 2^-wearShift. The mean wear is
+//counted exactly.
+//
+
+#include "SystemConfiguration.h"
+#include <vector>
+
+namespace DRAMSim
+{
+	using std::vector;
+	class Checkpoint;
+
+	class WearLeveler
+	{
+	public:
+		WearLeveler(const Config &config);
+
+		//logical -> physical address, bits above the memory size are kept
+		uint64_t remap(uint64_t addr) const;
+		//lines usable through the wear leveler
+		uint64_t usableLines() const
+		{
+			return capacity;
+		}
+
+		//count a write to addr; returns true (and the region) if that region's gap has to move
+		bool recordWrite(uint64_t addr, unsigned &region);
+		//logical address of the line the next gap move of this region copies
+		uint64_t movingLine(unsigned region) const;
+		void moveGap(unsigned region);
+
+		void printStats(uint64_t elapsedCycles) const;
+		//the gaps and the wear; the key and the geometry come from the config
+		void checkpoint(Checkpoint &cp);
+
+	private:
+		uint64_t physicalLine(uint64_t line) const;
+		uint64_t scramble(uint64_t line) const;
+		uint64_t unscramble(uint64_t line) const;
+		void addWear(uint64_t physicalLine);
+
+		const Config &config;
+		unsigned lineOffsetBits;
+		unsigned lineBits;
+		uint64_t lineMask;
+		unsigned regionBits;
+		uint64_t regionMask;
+		uint64_t regionLines; //logical lines that rotate in a region (one less than its size)
+		uint64_t capacity; //usable logical lines, regionLines per region
+
+		//keyed bijection for region_start_gap
+		unsigned shiftBits;
+		uint64_t key[2];
+		uint64_t mult[2];
+		uint64_t multInverse[2];
+
+		vector<uint64_t> start;
+		vector<uint64_t> gap;
+		vector<unsigned> writesSinceMove;
+
+		//writes per physical line, in units of 2^wearShift
+		vector<uint16_t> wear;
+		unsigned wearShift;
+		uint64_t wearRandom;
+		uint64_t demandWrites;
+		uint64_t wrappedWrites; //to lines beyond the usable ones
+		uint64_t gapMoves;
+	};
+}
+
+#endif
@@ -0,0 +1,359 @@
+//ecc_bench.cpp
+//
+//Microbenchmark and self check of the ECC kernels (EccKernels.cpp).
+//
+//The reference implementation below is the bit-serial std::bitset code that
+//BusPacket used before the kernels, with its loop running over all 64 data
+//bits (it used to stop at 63, which left the last data bit without check
+//bits); the new kernels must produce the same bytes for ENCODE, DECODE and
+//the chipkill interleaving. Single bit errors at every codeword position
+//must be corrected and double bit errors detected; how many triple bit
+//errors slip through as miscorrections is reported.
+//
+//  make bench && ./bench/ecc_bench [iterations] [deviceWidth]
+//
+
+#include "../EccKernels.h"
+#include <bitset>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+using namespace DRAMSim;
+using std::bitset;
+
+#define DATA_BYTES 64
+#define CODE_BYTES 72
+#define WORDS (CODE_BYTES / SECDED_CODE_BYTES)
+#define CHIPKILL_BITS 2304
+
+namespace Reference
+{
+	#define POSITION_REVISE(i) ((1 << (i)) - (i) - 2)
+
+	template <size_t N>
+	static void fromBytes(bitset<N> &bits, const byte *bytes, size_t len)
+	{
+		for (size_t i=0; i<len*8; i++)
+		{
+			if (bytes[i/8] & (1<<(7-i%8)))
+			{
+				bits.set(i);
+			}
+		}
+	}
+
+	template <size_t N>
+	static void toBytes(const bitset<N> &bits, byte *bytes)
+	{
+		memset(bytes, 0, N/8);
+		for (size_t i=0; i<N; i++)
+		{
+			if (bits.test(i))
+			{
+				bytes[i/8] |= 1<<(7-i%8);
+			}
+		}
+	}
+
+	static void encode(const byte *plain, byte *coded)
+	{
+		const int n = 72, m = 64, c = 8;
+		bitset<DATA_BYTES*8> plainDataBits;
+		bitset<CODE_BYTES*8> eccDataBits;
+		bitset<8> eccCheckBits;
+		fromBytes(plainDataBits, plain, DATA_BYTES);
+
+		for (int iLoop=0; iLoop < (int)WORDS; iLoop++)
+		{
+			eccCheckBits.reset();
+			for (int iCheck = 0; iCheck < c-1; iCheck++)
+			{
+				int checkBitCounter = (iCheck == 0) ? (2) : (iCheck + 1);
+				int positionIncrement = 1 << iCheck;
+				int iCounter = 1;
+				int iData = POSITION_REVISE(iCheck) + iCounter;
+				bool first = true;
+				while (iData < m)
+				{
+					if (first)
+					{
+						eccCheckBits[iCheck] = plainDataBits[iLoop*m + iData];
+						first = false;
+					}
+					else
+					{
+						eccCheckBits[iCheck] = eccCheckBits[iCheck]^plainDataBits[iLoop*m + iData];
+					}
+					iData++;
+					iCounter++;
+					if (iCounter % positionIncrement == 0)
+					{
+						iData += positionIncrement;
+						iCounter = 0;
+					}
+					while (iData > POSITION_REVISE(checkBitCounter))
+					{
+						checkBitCounter++;
+						iData--;
+					}
+				}
+			}
+
+			for (int iData = 0; iData < n-1; iData++)
+			{
+				int iCheck = iData - m;
+				eccDataBits[iLoop*n + iData] = (iCheck < 0) ? plainDataBits[iLoop*m + iData] : eccCheckBits[iCheck];
+				if (iData == 0)
+				{
+					eccDataBits[iLoop*n + (n-1)] = eccDataBits[iLoop*n + iData];
+				}
+				else
+				{
+					eccDataBits[iLoop*n + (n-1)] = eccDataBits[iLoop*n + (n-1)] ^ eccDataBits[iLoop*n + iData];
+				}
+			}
+		}
+		toBytes(eccDataBits, coded);
+	}
+
+	static void decode(const byte *coded, byte *plain)
+	{
+		bitset<CODE_BYTES*8> eccDataBits;
+		bitset<DATA_BYTES*8> plainDataBits;
+		fromBytes(eccDataBits, coded, CODE_BYTES);
+		for (int iLoop = 0; iLoop < (int)WORDS; iLoop++)
+		{
+			for (int iData = 0; iData < 64; iData++)
+			{
+				plainDataBits[iLoop*64 + iData] = eccDataBits[iLoop*72 + iData];
+			}
+		}
+		toBytes(plainDataBits, plain);
+	}
+
+	static void interleave(const byte *ecc, byte *chipkill, unsigned deviceWidth)
+	{
+		bitset<CHIPKILL_BITS> chipkillDataBits;
+		bitset<CHIPKILL_BITS> eccDataBits;
+		fromBytes(eccDataBits, ecc, CHIPKILL_BITS/8);
+		for (unsigned iWord = 0; iWord < deviceWidth; iWord++)
+		{
+			for (unsigned iData = 0; iData < 72; iData++)
+			{
+				chipkillDataBits[iData*deviceWidth + iWord] = eccDataBits[iWord*72 + iData];
+			}
+		}
+		toBytes(chipkillDataBits, chipkill);
+	}
+
+	static void deinterleave(const byte *chipkill, byte *ecc, unsigned deviceWidth)
+	{
+		bitset<CHIPKILL_BITS> chipkillDataBits;
+		bitset<CHIPKILL_BITS> eccDataBits;
+		fromBytes(chipkillDataBits, chipkill, CHIPKILL_BITS/8);
+		for (unsigned iWord = 0; iWord < deviceWidth; iWord++)
+		{
+			for (unsigned iData = 0; iData < 72; iData++)
+			{
+				eccDataBits[iWord*72 + iData] = chipkillDataBits[iData*deviceWidth + iWord];
+			}
+		}
+		toBytes(eccDataBits, ecc);
+	}
+}
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+static void randomFill(byte *buf, size_t len)
+{
+	for (size_t i=0; i<len; i++)
+	{
+		buf[i] = rand();
+	}
+}
+
+static unsigned failures = 0;
+
+static void expect(bool ok, const char *what, unsigned detail)
+{
+	if (!ok)
+	{
+		if (failures < 10)
+		{
+			printf("FAIL: %s (%u)\n", what, detail);
+		}
+		failures++;
+	}
+}
+
+static void checkExact(unsigned iterations, unsigned deviceWidth)
+{
+	byte plain[DATA_BYTES], refCoded[CODE_BYTES], coded[CODE_BYTES];
+	byte refPlain[DATA_BYTES], decoded[DATA_BYTES];
+	byte ecc[CHIPKILL_BITS/8], refChip[CHIPKILL_BITS/8], chip[CHIPKILL_BITS/8];
+	byte refBack[CHIPKILL_BITS/8], back[CHIPKILL_BITS/8];
+
+	for (unsigned it=0; it<iterations; it++)
+	{
+		randomFill(plain, DATA_BYTES);
+		Reference::encode(plain, refCoded);
+		secdedEncode(plain, coded, WORDS);
+		expect(memcmp(refCoded, coded, CODE_BYTES) == 0, "encode", it);
+
+		Reference::decode(coded, refPlain);
+		secdedDecode(coded, decoded, WORDS);
+		expect(memcmp(refPlain, decoded, DATA_BYTES) == 0, "decode", it);
+
+		randomFill(ecc, sizeof(ecc));
+		Reference::interleave(ecc, refChip, deviceWidth);
+		chipkillInterleave(ecc, chip, deviceWidth, CHIPKILL_BITS);
+		expect(memcmp(refChip, chip, sizeof(chip)) == 0, "chipkill interleave", it);
+
+		Reference::deinterleave(chip, refBack, deviceWidth);
+		chipkillDeinterleave(chip, back, deviceWidth, CHIPKILL_BITS);
+		expect(memcmp(refBack, back, sizeof(back)) == 0, "chipkill deinterleave", it);
+	}
+}
+
+static void checkCorrection()
+{
+	byte plain[DATA_BYTES], coded[CODE_BYTES], damaged[CODE_BYTES];
+	randomFill(plain, DATA_BYTES);
+	secdedEncode(plain, coded, WORDS);
+
+	unsigned corrected = 0, uncorrectable = 0;
+	secdedCheck(coded, WORDS, false, corrected, uncorrectable);
+	expect(corrected == 0 && uncorrectable == 0, "clean codeword", 0);
+
+	for (unsigned bit=0; bit<SECDED_CODE_BITS; bit++)
+	{
+		memcpy(damaged, coded, CODE_BYTES);
+		damaged[bit/8] ^= 0x80 >> (bit%8);
+		corrected = uncorrectable = 0;
+		secdedCheck(damaged, WORDS, true, corrected, uncorrectable);
+		expect(corrected == 1 && uncorrectable == 0, "single error reported", bit);
+		expect(memcmp(damaged, coded, CODE_BYTES) == 0, "single error corrected", bit);
+		//the bit-serial code left the last data bit without check bits, a
+		//flip there was taken for a flipped overall parity bit
+		if (bit == 63)
+		{
+			printf("data bit 63: %s\n", memcmp(damaged, coded, CODE_BYTES) == 0 ? "corrected" : "MISCORRECTED");
+		}
+
+		for (unsigned other=bit+1; other<SECDED_CODE_BITS; other++)
+		{
+			memcpy(damaged, coded, CODE_BYTES);
+			damaged[bit/8] ^= 0x80 >> (bit%8);
+			damaged[other/8] ^= 0x80 >> (other%8);
+			corrected = uncorrectable = 0;
+			secdedCheck(damaged, WORDS, true, corrected, uncorrectable);
+			expect(corrected == 0 && uncorrectable == 1, "double error detected", bit*SECDED_CODE_BITS + other);
+		}
+	}
+
+	//beyond the code's distance: an odd number of flips can look like a
+	//single error, which is then miscorrected and counted as corrected
+	unsigned triples = 0, miscorrected = 0;
+	for (unsigned a=0; a<SECDED_CODE_BITS; a++)
+	{
+		for (unsigned b=a+1; b<SECDED_CODE_BITS; b++)
+		{
+			for (unsigned c=b+1; c<SECDED_CODE_BITS; c++)
+			{
+				memcpy(damaged, coded, CODE_BYTES);
+				damaged[a/8] ^= 0x80 >> (a%8);
+				damaged[b/8] ^= 0x80 >> (b%8);
+				damaged[c/8] ^= 0x80 >> (c%8);
+				corrected = uncorrectable = 0;
+				secdedCheck(damaged, WORDS, true, corrected, uncorrectable);
+				triples++;
+				miscorrected += corrected;
+			}
+		}
+	}
+	printf("triple errors: %u of %u miscorrected as single errors (known SECDED limit)\n", miscorrected, triples);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned iterations = argc > 1 ? atoi(argv[1]) : 100000;
+	unsigned deviceWidth = argc > 2 ? atoi(argv[2]) : 4;
+	if (deviceWidth == 0 || deviceWidth * 72 > CHIPKILL_BITS)
+	{
+		printf("deviceWidth must be between 1 and %d\n", CHIPKILL_BITS / 72);
+		return 1;
+	}
+	srand(1);
+
+	checkExact(iterations < 10000 ? iterations : 10000, deviceWidth);
+	checkCorrection();
+	printf("self check: %s\n", failures ? "FAILED" : "ok");
+
+	byte plain[DATA_BYTES], coded[CODE_BYTES], chip[CHIPKILL_BITS/8], ecc[CHIPKILL_BITS/8];
+	randomFill(plain, DATA_BYTES);
+	randomFill(ecc, sizeof(ecc));
+	unsigned sink = 0;
+	double t;
+
+	t = now();
+	for (unsigned it=0; it<iterations; it++)
+	{
+		plain[it % DATA_BYTES] ^= it;
+		Reference::encode(plain, coded);
+		sink += coded[DATA_BYTES];
+	}
+	double refEncode = now() - t;
+
+	t = now();
+	for (unsigned it=0; it<iterations; it++)
+	{
+		plain[it % DATA_BYTES] ^= it;
+		secdedEncode(plain, coded, WORDS);
+		sink += coded[DATA_BYTES];
+	}
+	double newEncode = now() - t;
+
+	t = now();
+	for (unsigned it=0; it<iterations; it++)
+	{
+		unsigned corrected = 0, uncorrectable = 0;
+		coded[it % CODE_BYTES] ^= 1;
+		secdedCheck(coded, WORDS, true, corrected, uncorrectable);
+		sink += corrected;
+	}
+	double newCheck = now() - t;
+
+	t = now();
+	for (unsigned it=0; it<iterations; it++)
+	{
+		ecc[it % sizeof(ecc)] ^= it;
+		Reference::interleave(ecc, chip, deviceWidth);
+		sink += chip[0];
+	}
+	double refChipkill = now() - t;
+
+	t = now();
+	for (unsigned it=0; it<iterations; it++)
+	{
+		ecc[it % sizeof(ecc)] ^= it;
+		chipkillInterleave(ecc, chip, deviceWidth, CHIPKILL_BITS);
+		sink += chip[0];
+	}
+	double newChipkill = now() - t;
+
+	printf("%u bursts of %d bytes (sink %u)\n", iterations, DATA_BYTES, sink);
+	printf("  secded encode   : reference %8.1f ns  kernel %8.1f ns  speedup %6.1fx\n",
+			refEncode * 1e9 / iterations, newEncode * 1e9 / iterations, refEncode / newEncode);
+	printf("  secded correct  : kernel %8.1f ns\n", newCheck * 1e9 / iterations);
+	printf("  chipkill x%-2u    : reference %8.1f ns  kernel %8.1f ns  speedup %6.1fx\n", deviceWidth,
+			refChipkill * 1e9 / iterations, newChipkill * 1e9 / iterations, refChipkill / newChipkill);
+
+	return failures ? 1 : 0;
+}
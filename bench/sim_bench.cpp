@@ -0,0 +1,272 @@
+//sim_bench.cpp
+//
+//Throughput of the simulator itself: fixed workloads on representative
+//configurations, each run in a process of its own. Prints one CSV row per
+//configuration and workload:
+//
+//  config,workload,cycles,transactions,setup_s,simulate_s,report_s,
+//  cycles_per_s,transactions_per_s,peak_rss_kb
+//
+//cycles are simulated CPU cycles, transactions those the memory controllers
+//returned; the rates are over the simulate phase (Simulator::start), the
+//fastest of the repeats. peak_rss_kb is the high water mark of the process of
+//that run.
+//
+//The workloads are the random, stream and zipf generators without caches, the
+//zipf one once more through the default cache hierarchy, and an HMTT trace:
+//a synthetic one written at start (results/bench/spec2006_sample.trc) plus
+//any spec2006_* trace given on the command line.
+//
+//  make bench && ./bench/sim_bench [requests] [repeats] [spec2006_trace ...]
+//
+//Run it from the top of the tree, the ini files are looked up from there. What
+//the simulations print to stderr goes to results/bench/sim_bench.log.
+//
+
+#include "../Simulator.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace DRAMSim;
+
+#define OUTPUT_PATH "results/bench/"
+#define SAMPLE_TRACE OUTPUT_PATH "spec2006_sample.trc"
+#define LOG_FILE OUTPUT_PATH "sim_bench.log"
+
+struct BenchConfig
+{
+	const char *name;
+	const char *systemIni;
+	const char *deviceIni;
+};
+
+static const BenchConfig configs[] =
+{
+	{"DDR3_micron_32M_8B_x8_sg15", "ini/system.ini", "ini/DDR3_micron_32M_8B_x8_sg15.ini"},
+	{"PCM", "ini/system.ini", "ini/PCM.ini"},
+	{"4G_PCM", "ini/system.ini", "ini/4G_PCM.ini"},
+	{"sys_4R", "ini/sys_4R.ini", "ini/PCM.ini"},
+};
+
+struct Workload
+{
+	string name;
+	string trace;
+	string overrides;
+};
+
+struct Result
+{
+	uint64_t cycles;
+	uint64_t transactions;
+	double setup;
+	double simulate;
+	double report;
+	long peakRss;
+};
+
+static double now()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+//an HMTT trace: 8 byte words of address, read bit (29) and the cycles since
+//the previous access (from bit 30); mostly short runs of neighbouring blocks
+static void writeSampleTrace(unsigned requests)
+{
+	FILE *fp = fopen(SAMPLE_TRACE, "wb");
+	if (fp == NULL)
+	{
+		printf("cannot write %s\n", SAMPLE_TRACE);
+		exit(1);
+	}
+	uint64_t state = 1;
+	uint64_t address = 0;
+	for (unsigned i=0; i<requests; i++)
+	{
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		unsigned bits = state >> 33;
+		if (bits % 8 == 0)
+		{
+			address = (bits * 64ULL) & 0x1fffffc0ULL;
+		}
+		else
+		{
+			address = (address + 64) & 0x1fffffc0ULL;
+		}
+		uint64_t gap = 1 + (bits >> 8) % 20;
+		uint64_t read = (bits >> 4) % 10 < 7;
+		uint64_t word = (gap << 30) | (read << 29) | address;
+		if (fwrite(&word, 8, 1, fp) != 1)
+		{
+			printf("cannot write %s\n", SAMPLE_TRACE);
+			exit(1);
+		}
+	}
+	fclose(fp);
+}
+
+static Result simulate(const BenchConfig &config, const Workload &workload)
+{
+	Result result;
+	//the statistics of the simulation are not what is measured
+	std::ofstream discard("/dev/null");
+	simOutput = &discard;
+
+	double t = now();
+	SimulatorIO *simIO = new SimulatorIO(config.systemIni, config.deviceIni, workload.trace, "", "",
+			OUTPUT_PATH, NULL, 2048, 0, true);
+	simIO->paramOverrides = simIO->parseParamOverrides(workload.overrides);
+	Simulator *simulator = new Simulator(simIO);
+	simulator->setup();
+	result.setup = now() - t;
+
+	t = now();
+	simulator->start();
+	result.simulate = now() - t;
+
+	t = now();
+	simulator->report(true);
+	result.report = now() - t;
+
+	result.cycles = simulator->clockDomainCPU->clockcycle;
+	result.transactions = 0;
+	MemorySystem *memorySystem = simulator->memorySystem;
+	for (size_t c=0; c<memorySystem->memoryControllers.size(); c++)
+	{
+		MemoryController *controller = memorySystem->memoryControllers[c];
+		for (size_t b=0; b<controller->grandTotalBankAccesses.size(); b++)
+		{
+			result.transactions += controller->grandTotalBankAccesses[b];
+		}
+	}
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	result.peakRss = usage.ru_maxrss;
+	delete simulator;
+	return result;
+}
+
+//a fresh process every run, for its peak RSS and a cold heap
+static bool simulateInChild(const BenchConfig &config, const Workload &workload, Result &result)
+{
+	int fds[2];
+	if (pipe(fds) != 0)
+	{
+		return false;
+	}
+	//nothing buffered is to be written twice
+	fflush(stdout);
+	pid_t pid = fork();
+	if (pid == 0)
+	{
+		close(fds[0]);
+		//the simulator greets on cout, the CSV goes there too; its warnings go to the log
+		if (freopen("/dev/null", "w", stdout) == NULL || freopen(LOG_FILE, "a", stderr) == NULL)
+		{
+			_exit(1);
+		}
+		Result r = simulate(config, workload);
+		ssize_t written = write(fds[1], &r, sizeof(r));
+		_exit(written == sizeof(r) ? 0 : 1);
+	}
+	close(fds[1]);
+	bool ok = pid > 0 && read(fds[0], &result, sizeof(result)) == sizeof(result);
+	close(fds[0]);
+	int status = 0;
+	if (pid > 0)
+	{
+		waitpid(pid, &status, 0);
+	}
+	return ok && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned requests = argc > 1 ? atoi(argv[1]) : 200000;
+	unsigned repeats = argc > 2 ? atoi(argv[2]) : 3;
+	if (requests == 0 || repeats == 0)
+	{
+		printf("usage: %s [requests] [repeats] [spec2006_trace ...]\n", argv[0]);
+		return 1;
+	}
+
+	mkdir("results", 0755);
+	mkdir(OUTPUT_PATH, 0755);
+	remove(LOG_FILE);
+	writeSampleTrace(requests);
+
+	char generated[128];
+	snprintf(generated, sizeof(generated), "GEN_REQUESTS=%u,CACHE_LLC_KB=0", requests);
+	vector<Workload> workloads;
+	Workload w;
+	w.name = "random";
+	w.trace = "gen:random";
+	w.overrides = generated;
+	workloads.push_back(w);
+	w.name = "stream";
+	w.trace = "gen:stream";
+	workloads.push_back(w);
+	w.name = "zipf";
+	w.trace = "gen:zipf";
+	workloads.push_back(w);
+	w.name = "zipf_cached";
+	snprintf(generated, sizeof(generated), "GEN_REQUESTS=%u", requests);
+	w.overrides = generated;
+	workloads.push_back(w);
+	w.name = "hmtt_sample";
+	w.trace = SAMPLE_TRACE;
+	w.overrides = "CACHE_LLC_KB=0";
+	workloads.push_back(w);
+	for (int i=3; i<argc; i++)
+	{
+		string path = argv[i];
+		w.name = "hmtt_" + path.substr(path.find_last_of("/") + 1);
+		w.trace = path;
+		workloads.push_back(w);
+	}
+
+	printf("config,workload,cycles,transactions,setup_s,simulate_s,report_s,cycles_per_s,transactions_per_s,peak_rss_kb\n");
+	int failures = 0;
+	for (size_t c=0; c<sizeof(configs)/sizeof(configs[0]); c++)
+	{
+		for (size_t i=0; i<workloads.size(); i++)
+		{
+			Result best = Result();
+			bool ran = false;
+			for (unsigned r=0; r<repeats; r++)
+			{
+				Result result;
+				if (!simulateInChild(configs[c], workloads[i], result))
+				{
+					fprintf(stderr, "%s/%s failed, see %s\n", configs[c].name, workloads[i].name.c_str(), LOG_FILE);
+					failures++;
+					break;
+				}
+				if (!ran || result.simulate < best.simulate)
+				{
+					best = result;
+				}
+				ran = true;
+			}
+			if (!ran)
+			{
+				continue;
+			}
+			printf("%s,%s,%llu,%llu,%.4f,%.4f,%.4f,%.0f,%.0f,%ld\n", configs[c].name, workloads[i].name.c_str(),
+					(unsigned long long) best.cycles, (unsigned long long) best.transactions,
+					best.setup, best.simulate, best.report,
+					best.cycles / best.simulate, best.transactions / best.simulate, best.peakRss);
+			fflush(stdout);
+		}
+	}
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,118 @@
+//wear_leveler_test.cpp
+//
+//Start-Gap keeps every line: a small memory whose lines hold their own
+//contents is written through the wear leveler, with the gap moves copying the
+//lines like MemorySystem::wearLevelWrite does. The first and the last line of
+//a region are written over and over, for both schemes; after every write each
+//line must read back what was last written to it, and no two lines may share
+//a physical line.
+//
+//  make test
+//
+
+#include "../WearLeveler.h"
+#include <cstdio>
+#include <vector>
+
+using namespace DRAMSim;
+using std::vector;
+
+#define LINE_BYTES 64
+#define REGION_LINES 16
+
+static unsigned failures = 0;
+
+static void expect(bool ok, const char *what, uint64_t detail)
+{
+	if (!ok)
+	{
+		if (failures < 10)
+		{
+			printf("FAIL: %s (%llu)\n", what, (unsigned long long) detail);
+		}
+		failures++;
+	}
+}
+
+static uint64_t physicalLine(const WearLeveler &leveler, uint64_t line)
+{
+	return leveler.remap(line * LINE_BYTES) / LINE_BYTES;
+}
+
+static void check(const WearLeveler &leveler, const vector<uint64_t> &cells, const vector<uint64_t> &written)
+{
+	vector<bool> used(cells.size(), false);
+	for (uint64_t line=0; line<leveler.usableLines(); line++)
+	{
+		uint64_t pa = physicalLine(leveler, line);
+		expect(pa < cells.size() && !used[pa], "two lines share a physical line", line);
+		if (pa < cells.size())
+		{
+			used[pa] = true;
+			expect(cells[pa] == written[line], "line reads back what was written", line);
+		}
+	}
+}
+
+static void write(WearLeveler &leveler, vector<uint64_t> &cells, vector<uint64_t> &written, uint64_t line, uint64_t value)
+{
+	unsigned region;
+	if (leveler.recordWrite(line * LINE_BYTES, region))
+	{
+		uint64_t moved = leveler.movingLine(region) / LINE_BYTES;
+		uint64_t contents = cells[physicalLine(leveler, moved)];
+		leveler.moveGap(region);
+		cells[physicalLine(leveler, moved)] = contents;
+	}
+	cells[physicalLine(leveler, line)] = value;
+	written[line] = value;
+}
+
+static void run(const char *scheme, WearLevelingScheme wearLevelingScheme)
+{
+	Config config = Config();
+	config.JEDEC_DATA_BUS_BITS = 64;
+	config.TRANS_DATA_BYTES = LINE_BYTES;
+	config.NUM_CHANS = 1;
+	config.NUM_RANKS = 1;
+	config.NUM_BANKS = 2;
+	config.NUM_ROWS = 16;
+	config.NUM_COLS = 32;
+	config.WEAR_LEVELING = scheme;
+	config.wearLevelingScheme = wearLevelingScheme;
+	config.GAP_MOVE_INTERVAL = 1;
+	config.START_GAP_REGION_LINES = REGION_LINES;
+	config.WEAR_LEVELING_SEED = 1;
+
+	WearLeveler leveler(config);
+	//2 banks x 16 rows x 32 columns / 8 columns per line
+	vector<uint64_t> cells(128, 0);
+	vector<uint64_t> written(leveler.usableLines(), 0);
+	expect(leveler.usableLines() == 128 - 128 / REGION_LINES, "one gap line per region", leveler.usableLines());
+
+	for (uint64_t line=0; line<leveler.usableLines(); line++)
+	{
+		write(leveler, cells, written, line, 1000 + line);
+	}
+	check(leveler, cells, written);
+
+	//the first and the last line of region 1, for several rotations of the region
+	uint64_t first = REGION_LINES - 1;
+	uint64_t last = first + REGION_LINES - 2;
+	for (unsigned i=0; i<10 * REGION_LINES * REGION_LINES; i++)
+	{
+		write(leveler, cells, written, i % 2 ? last : first, 2000 + i);
+		check(leveler, cells, written);
+	}
+	expect(written[first] != written[last], "first and last line keep their own data", first);
+	printf("%s: %llu usable lines\n", scheme, (unsigned long long) leveler.usableLines());
+}
+
+int main()
+{
+	SHOW_SIM_OUTPUT = false;
+	run("start_gap", StartGap);
+	run("region_start_gap", RandomStartGap);
+	printf("wear leveler: %s\n", failures ? "FAILED" : "ok");
+	return failures ? 1 : 0;
+}